@@ -47,4 +47,7 @@
 #define ITTI_QUEUE_MAX_ELEMENTS (64 * 1024)
 #define ITTI_DUMP_MAX_CON (5) /* Max connections in parallel */
 
+/* Messages served in a row from a priority level before lower levels get one */
+#define ITTI_STARVATION_LIMIT_DEFAULT (32)
+
 #endif /* FILE_INTERTASK_INTERFACE_CONF_SEEN */
@@ -38,6 +38,7 @@
 #include "nas_messages_types.h"
 #include "s11_messages_types.h"
 #include "sctp_messages_types.h"
+#include "sctp_rx_buffer.h"
 
 //------------------------------------------------------------------------------
 void itti_free_msg_content(MessageDef *const message_p)
@@ -222,7 +223,7 @@ void itti_free_msg_content(MessageDef *const message_p)
       break;
 
     case SCTP_DATA_IND:
-      bdestroy_wrapper(&message_p->ittiMsg.sctp_data_ind.payload);
+      sctp_rx_buffer_unref(&message_p->ittiMsg.sctp_data_ind.buffer);
       break;
 
     case SCTP_DATA_CNF:
@@ -63,6 +63,14 @@
 #define SCTP_OUT_STREAMS (32)
 #define SCTP_IN_STREAMS (32)
 #define SCTP_MAX_ATTEMPTS (5)
+// Max number of sctp_recvmsg() done on one socket per receiver wake-up
+#define SCTP_RECV_MSGS_PER_WAKEUP (16)
+#define SCTP_EPOLL_MAX_EVENTS (64)
+// Max number of receive buffers kept for reuse, see sctp_rx_buffer.h
+#define SCTP_RX_BUFFER_POOL_SIZE (128)
+// Size of the pooled receive buffers, enough for most S1AP PDUs. A larger
+// message is completed in a buffer of its own size.
+#define SCTP_RX_BUFFER_SIZE (2048)
 
 /*******************************************************************************
  * MME global definitions
@@ -77,6 +85,12 @@
 
 #define RELATIVE_CAPACITY (15)
 
+/*******************************************************************************
+ * NAS Constants
+ ******************************************************************************/
+#define EPS_AUTH_VECTORS_DEFAULT_VALUE (1) ///< Auth vectors per AIR
+#define AUTH_VECTOR_TTL_DEFAULT_VALUE (3600) ///< Lifetime of unused vectors (s)
+
 /*******************************************************************************
  * Service 303 Constants
  ******************************************************************************/
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file sctp_rx_buffer.c
+   \brief Pool of reference counted SCTP receive buffers.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <liblfds710.h>
+
+#include "bstrlib.h"
+#include "assertions.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "sctp_rx_buffer.h"
+
+typedef struct sctp_rx_buffer_pool_s {
+  struct lfds710_stack_state free_buffers; ///< Thread safe buffer pool
+  // Number of buffers allocated for the pool, in use or free
+  uint32_t nb_buffers;
+  uint32_t max_buffers;
+  bool running;
+} sctp_rx_buffer_pool_t;
+
+static sctp_rx_buffer_pool_t g_sctp_rx_buffer_pool = {0};
+
+//------------------------------------------------------------------------------
+int sctp_rx_buffer_pool_init(const int max_buffers)
+{
+  lfds710_stack_init_valid_on_current_logical_core(
+    &g_sctp_rx_buffer_pool.free_buffers, NULL);
+  g_sctp_rx_buffer_pool.nb_buffers = 0;
+  g_sctp_rx_buffer_pool.max_buffers = (max_buffers > 0) ? max_buffers : 0;
+  g_sctp_rx_buffer_pool.running = true;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void sctp_rx_buffer_free_element(
+  __attribute__((unused)) struct lfds710_stack_state *ss,
+  struct lfds710_stack_element *se)
+{
+  sctp_rx_buffer_t *buffer = LFDS710_STACK_GET_VALUE_FROM_ELEMENT(*se);
+  free_wrapper((void **) &buffer);
+}
+
+//------------------------------------------------------------------------------
+void sctp_rx_buffer_pool_exit(void)
+{
+  if (!g_sctp_rx_buffer_pool.running) {
+    return;
+  }
+  // Buffers still carried by messages are freed when they are released
+  g_sctp_rx_buffer_pool.running = false;
+  lfds710_stack_cleanup(
+    &g_sctp_rx_buffer_pool.free_buffers, sctp_rx_buffer_free_element);
+}
+
+//------------------------------------------------------------------------------
+static sctp_rx_buffer_t *sctp_rx_buffer_alloc(const uint32_t size)
+{
+  sctp_rx_buffer_t *buffer = malloc(sizeof(sctp_rx_buffer_t) + size);
+
+  AssertFatal(buffer, "Allocation of SCTP receive buffer failed");
+  buffer->is_pooled = false;
+  buffer->size = size;
+  buffer->ref_count = 1;
+  blk2tbstr(buffer->payload, buffer->data, 0);
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+sctp_rx_buffer_t *sctp_rx_buffer_get(void)
+{
+  sctp_rx_buffer_t *buffer = NULL;
+  struct lfds710_stack_element *se = NULL;
+
+  if (
+    g_sctp_rx_buffer_pool.running &&
+    lfds710_stack_pop(&g_sctp_rx_buffer_pool.free_buffers, &se)) {
+    buffer = LFDS710_STACK_GET_VALUE_FROM_ELEMENT(*se);
+    buffer->ref_count = 1;
+    blk2tbstr(buffer->payload, buffer->data, 0);
+    return buffer;
+  }
+
+  buffer = sctp_rx_buffer_alloc(SCTP_RX_BUFFER_SIZE);
+  if (
+    __sync_add_and_fetch(&g_sctp_rx_buffer_pool.nb_buffers, 1) <=
+    g_sctp_rx_buffer_pool.max_buffers) {
+    buffer->is_pooled = true;
+  } else {
+    __sync_fetch_and_sub(&g_sctp_rx_buffer_pool.nb_buffers, 1);
+  }
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+void sctp_rx_buffer_grow(
+  sctp_rx_buffer_t **buffer,
+  const int length,
+  const uint32_t size)
+{
+  sctp_rx_buffer_t *large = NULL;
+
+  DevAssert((length >= 0) && ((uint32_t) length <= size));
+  large = sctp_rx_buffer_alloc(size);
+  memcpy(large->data, (*buffer)->data, length);
+  sctp_rx_buffer_unref(buffer);
+  *buffer = large;
+}
+
+//------------------------------------------------------------------------------
+void sctp_rx_buffer_set_length(sctp_rx_buffer_t **buffer, const int length)
+{
+  sctp_rx_buffer_t *buffer_p = *buffer;
+
+  DevAssert((length >= 0) && ((uint32_t) length <= buffer_p->size));
+  if ((!buffer_p->is_pooled) && (buffer_p->size > SCTP_RX_BUFFER_SIZE)) {
+    // Only the receiver holds a grown buffer, it can still move
+    DevAssert(buffer_p->ref_count == 1);
+    buffer_p = realloc(buffer_p, sizeof(sctp_rx_buffer_t) + length);
+    AssertFatal(buffer_p, "Shrinking of SCTP receive buffer failed");
+    buffer_p->size = length;
+    *buffer = buffer_p;
+  }
+  blk2tbstr(buffer_p->payload, buffer_p->data, length);
+}
+
+//------------------------------------------------------------------------------
+uint32_t sctp_rx_buffer_pool_size(void)
+{
+  return g_sctp_rx_buffer_pool.nb_buffers;
+}
+
+//------------------------------------------------------------------------------
+void sctp_rx_buffer_ref(sctp_rx_buffer_t *const buffer)
+{
+  __sync_fetch_and_add(&buffer->ref_count, 1);
+}
+
+//------------------------------------------------------------------------------
+void sctp_rx_buffer_unref(sctp_rx_buffer_t **buffer)
+{
+  if ((!buffer) || (!*buffer)) {
+    return;
+  }
+  sctp_rx_buffer_t *buffer_p = *buffer;
+  *buffer = NULL;
+
+  if (__sync_sub_and_fetch(&buffer_p->ref_count, 1) > 0) {
+    return;
+  }
+  if (buffer_p->is_pooled && g_sctp_rx_buffer_pool.running) {
+    LFDS710_STACK_SET_VALUE_IN_ELEMENT(buffer_p->se, buffer_p);
+    lfds710_stack_push(&g_sctp_rx_buffer_pool.free_buffers, &buffer_p->se);
+  } else {
+    if (buffer_p->is_pooled) {
+      __sync_fetch_and_sub(&g_sctp_rx_buffer_pool.nb_buffers, 1);
+    }
+    free_wrapper((void **) &buffer_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+int sctp_rx_buffer_recv(
+  const int sd,
+  sctp_rx_recv_t recv_fn,
+  sctp_rx_partial_t *const partial,
+  struct sctp_sndrcvinfo *const sinfo,
+  int *const flags,
+  sctp_rx_buffer_t **const message)
+{
+  int n = 0;
+
+  *message = NULL;
+  if (!partial->buffer) {
+    // The message is received straight into the buffer sent to S1AP
+    partial->buffer = sctp_rx_buffer_get();
+    partial->length = 0;
+  }
+
+  do {
+    /*
+     * The message did not fit in the pooled buffer, complete it in a buffer
+     * of SCTP_RECV_BUFFER_SIZE bytes, shrunk to the message length once read.
+     */
+    if ((uint32_t) partial->length == partial->buffer->size) {
+      if (partial->buffer->size >= SCTP_RECV_BUFFER_SIZE) {
+        OAILOG_ERROR(
+          LOG_SCTP,
+          "Message longer than %d bytes received on sd %d\n",
+          SCTP_RECV_BUFFER_SIZE,
+          sd);
+        sctp_rx_buffer_unref(&partial->buffer);
+        return SCTP_RX_RECV_ERROR;
+      }
+      sctp_rx_buffer_grow(
+        &partial->buffer, partial->length, SCTP_RECV_BUFFER_SIZE);
+    }
+
+    *flags = 0;
+    n = recv_fn(
+      sd,
+      (void *) (partial->buffer->data + partial->length),
+      partial->buffer->size - partial->length,
+      sinfo,
+      flags);
+
+    if (n < 0) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        // Do not hold a pooled buffer for an idle socket
+        if (partial->length == 0) {
+          sctp_rx_buffer_unref(&partial->buffer);
+        }
+        return SCTP_RX_RECV_WOULD_BLOCK;
+      }
+      OAILOG_ERROR(
+        LOG_SCTP, "[%d] sctp_recvmsg: %s:%d\n", sd, strerror(errno), errno);
+      sctp_rx_buffer_unref(&partial->buffer);
+      return SCTP_RX_RECV_ERROR;
+    }
+    if (n == 0) {
+      // One-to-one socket, the peer has closed it
+      sctp_rx_buffer_unref(&partial->buffer);
+      return SCTP_RX_RECV_CLOSED;
+    }
+    partial->length += n;
+  } while (!(*flags & MSG_EOR));
+
+  sctp_rx_buffer_set_length(&partial->buffer, partial->length);
+  *message = partial->buffer;
+  partial->buffer = NULL;
+  partial->length = 0;
+  return SCTP_RX_RECV_MESSAGE;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file sctp_rx_buffer.h
+   \brief Pool of reference counted buffers SCTP messages are received in.
+   \ The receiver thread reads a message directly into a buffer taken from the
+   \ pool, the buffer is then carried by SCTP_DATA_IND up to the S1AP decoder
+   \ which hands it back to the pool, no copy of the PDU is done on the way.
+   \ Pooled buffers hold SCTP_RX_BUFFER_SIZE bytes. The rare message larger
+   \ than that is completed in a buffer allocated outside of the pool, which is
+   \ shrunk to the size of the message before it is queued.
+   \ A message that is not fully queued on the non-blocking socket yet is kept
+   \ as a partial message of its association until the rest is received.
+*/
+
+#ifndef FILE_SCTP_RX_BUFFER_SEEN
+#define FILE_SCTP_RX_BUFFER_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <netinet/sctp.h>
+#include <liblfds710.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "mme_default_values.h"
+
+typedef struct sctp_rx_buffer_s {
+  struct lfds710_stack_element se;
+  uint32_t ref_count;
+  bool is_pooled; ///< false if allocated outside of the pool
+  uint32_t size;  ///< Capacity of data
+  // Read only view on the received bytes (mlen is -1), never bdestroy() it
+  struct tagbstring payload;
+  uint8_t data[];
+} sctp_rx_buffer_t;
+
+int sctp_rx_buffer_pool_init(const int max_buffers);
+void sctp_rx_buffer_pool_exit(void);
+
+/*
+ * Returns a buffer of SCTP_RX_BUFFER_SIZE bytes with a reference count of 1
+ * and an empty payload, never NULL: when the pool is exhausted a buffer is
+ * allocated outside of it.
+ */
+sctp_rx_buffer_t *sctp_rx_buffer_get(void);
+
+/*
+ * Moves the length bytes received in buffer to a buffer of size bytes
+ * allocated outside of the pool, to receive the rest of a large message.
+ */
+void sctp_rx_buffer_grow(
+  sctp_rx_buffer_t **buffer,
+  const int length,
+  const uint32_t size);
+
+/*
+ * Sets the payload once length bytes have been written in data. A buffer
+ * allocated by sctp_rx_buffer_grow() is shrunk to length, so that a queued
+ * message never holds more memory than its size.
+ */
+void sctp_rx_buffer_set_length(sctp_rx_buffer_t **buffer, const int length);
+
+/* Number of buffers allocated for the pool, in use or free */
+uint32_t sctp_rx_buffer_pool_size(void);
+
+void sctp_rx_buffer_ref(sctp_rx_buffer_t *const buffer);
+
+/* Drops a reference, the last one gives the buffer back to the pool */
+void sctp_rx_buffer_unref(STOLEN_REF sctp_rx_buffer_t **buffer);
+
+/* Results of sctp_rx_buffer_recv() */
+#define SCTP_RX_RECV_ERROR -1
+#define SCTP_RX_RECV_MESSAGE 0
+#define SCTP_RX_RECV_WOULD_BLOCK 1
+#define SCTP_RX_RECV_CLOSED 2
+
+/* Message of an association received up to length bytes */
+typedef struct sctp_rx_partial_s {
+  sctp_rx_buffer_t *buffer; ///< NULL if no message is in progress
+  int length;
+} sctp_rx_partial_t;
+
+/* Reads on sd, as sctp_recvmsg() without the peer address */
+typedef int (*sctp_rx_recv_t)(
+  int sd,
+  void *data,
+  size_t size,
+  struct sctp_sndrcvinfo *sinfo,
+  int *flags);
+
+/*
+ * Receives the rest of the partial message of the association of sd, or a
+ * new message if none is in progress.
+ * Returns SCTP_RX_RECV_MESSAGE with the complete message in *message and its
+ * last sinfo and flags, or SCTP_RX_RECV_WOULD_BLOCK if the end of the message
+ * is not queued on the socket yet, partial then keeps what has been read for
+ * the next call. On SCTP_RX_RECV_CLOSED (the peer closed the socket) and
+ * SCTP_RX_RECV_ERROR the partial message is dropped.
+ */
+int sctp_rx_buffer_recv(
+  const int sd,
+  sctp_rx_recv_t recv_fn,
+  sctp_rx_partial_t *const partial,
+  struct sctp_sndrcvinfo *const sinfo,
+  int *const flags,
+  sctp_rx_buffer_t **const message);
+
+#endif /* FILE_SCTP_RX_BUFFER_SEEN */
@@ -82,6 +82,8 @@
 
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG "INTERTASK_INTERFACE"
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE "ITTI_QUEUE_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_STARVATION_LIMIT                 \
+  "ITTI_STARVATION_LIMIT"
 
 #define MME_CONFIG_STRING_S6A_CONFIG "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH "S6A_CONF"
@@ -133,6 +135,8 @@
 #define MME_CONFIG_STRING_NAS_FORCE_REJECT_SR "FORCE_REJECT_SR"
 #define MME_CONFIG_STRING_NAS_DISABLE_ESM_INFORMATION_PROCEDURE                \
   "DISABLE_ESM_INFORMATION_PROCEDURE"
+#define MME_CONFIG_STRING_NAS_EPS_AUTH_VECTORS "EPS_AUTH_VECTORS"
+#define MME_CONFIG_STRING_NAS_AUTH_VECTOR_TTL "AUTH_VECTOR_TTL"
 #define MME_CONFIG_STRING_NAS_FORCE_PUSH_DEDICATED_BEARER                      \
   "FORCE_PUSH_DEDICATED_BEARER"
 
@@ -207,6 +211,7 @@ typedef struct s6a_config_s {
 
 typedef struct itti_config_s {
     uint32_t queue_size;
+    uint32_t starvation_limit;
     bstring log_file;
 } itti_config_t;
 
@@ -223,6 +228,9 @@ typedef struct nas_config_s {
     uint32_t t3486_sec;
     uint32_t t3489_sec;
     uint32_t t3495_sec;
+    // authentication vectors fetched per AIR, and lifetime of unused vectors
+    uint8_t eps_auth_vectors;
+    uint32_t auth_vector_ttl_sec;
     // non standard features
     bool force_reject_tau;
     bool force_reject_sr;
@@ -38,3 +38,8 @@ MESSAGE_DEF(
   MESSAGE_PRIORITY_MED,
   itti_s5_create_bearer_response_t,
   s5_create_bearer_response)
+MESSAGE_DEF(
+  S5_IP_ALLOCATION_RESPONSE,
+  MESSAGE_PRIORITY_MED,
+  itti_s5_ip_allocation_response_t,
+  s5_ip_allocation_response)
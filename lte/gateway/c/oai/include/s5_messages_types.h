@@ -35,6 +35,8 @@
   (mSGpTR)->ittiMsg.s5_create_bearer_request
 #define S5_CREATE_BEARER_RESPONSE(mSGpTR)                                      \
   (mSGpTR)->ittiMsg.s5_create_bearer_response
+#define S5_IP_ALLOCATION_RESPONSE(mSGpTR)                                      \
+  (mSGpTR)->ittiMsg.s5_ip_allocation_response
 
 typedef struct itti_s5_create_bearer_request_s {
   teid_t context_teid; ///< local SGW S11 Tunnel Endpoint Identifier
@@ -52,4 +54,12 @@ typedef struct itti_s5_create_bearer_response_s {
   enum s5_failure_cause failure_cause;
 } itti_s5_create_bearer_response_t;
 
+// Answer of mobilityd to the UE IP address allocation done for a bearer request
+typedef struct itti_s5_ip_allocation_response_s {
+  itti_s5_create_bearer_request_t bearer_request;
+  char imsi[IMSI_BCD_DIGITS_MAX + 1];
+  int status; ///< 0 or gRPC status code of the allocation
+  struct in_addr ipv4_address;
+} itti_s5_ip_allocation_response_t;
+
 #endif /* FILE_S5_MESSAGES_TYPES_SEEN*/
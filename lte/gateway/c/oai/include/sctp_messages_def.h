@@ -39,14 +39,18 @@ MESSAGE_DEF(SCTP_INIT_MSG, MESSAGE_PRIORITY_MED, sctp_init_t, sctpInit)
 MESSAGE_DEF(SCTP_DATA_REQ, MESSAGE_PRIORITY_MED, sctp_data_req_t, sctp_data_req)
 MESSAGE_DEF(SCTP_DATA_IND, MESSAGE_PRIORITY_MED, sctp_data_ind_t, sctp_data_ind)
 MESSAGE_DEF(SCTP_DATA_CNF, MESSAGE_PRIORITY_MED, sctp_data_cnf_t, sctp_data_cnf)
+/* The association events are on the same level as SCTP_DATA_IND: a close
+ * must not overtake the data of the association still queued for S1AP, and
+ * the new association of a reconnecting eNB must not overtake the close of
+ * the association it reuses */
 MESSAGE_DEF(
   SCTP_NEW_ASSOCIATION,
-  MESSAGE_PRIORITY_MAX,
+  MESSAGE_PRIORITY_MED,
   sctp_new_peer_t,
   sctp_new_peer)
 MESSAGE_DEF(
   SCTP_CLOSE_ASSOCIATION,
-  MESSAGE_PRIORITY_MAX,
+  MESSAGE_PRIORITY_MED,
   sctp_close_association_t,
   sctp_close_association)
 MESSAGE_DEF(
@@ -67,7 +67,8 @@ typedef struct sctp_data_req_s {
 } sctp_data_req_t;
 
 typedef struct sctp_data_ind_s {
-  bstring payload;          ///< SCTP buffer
+  // SCTP receive buffer, payload is the received PDU, see sctp_rx_buffer.h
+  struct sctp_rx_buffer_s *buffer;
   sctp_assoc_id_t assoc_id; ///< SCTP physical association ID
   sctp_stream_id_t stream;  ///< Stream number on which data had been received
   uint16_t
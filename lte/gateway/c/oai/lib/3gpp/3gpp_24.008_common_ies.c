@@ -1106,7 +1106,8 @@ int encode_ms_network_feature_support_ie(
     buffer, MS_NETWORK_FEATURE_SUPPORT_IE_MAX_LENGTH, len);
 
   *(buffer + encoded) =
-    0x00 | ((msnetworkfeaturesupport->spare_bits & 0x7) << 3) |
+    (iei_present ? C_MS_NETWORK_FEATURE_SUPPORT_IEI : 0x00) |
+    ((msnetworkfeaturesupport->spare_bits & 0x7) << 3) |
     (msnetworkfeaturesupport->extended_periodic_timers & 0x1);
   encoded++;
   return encoded;
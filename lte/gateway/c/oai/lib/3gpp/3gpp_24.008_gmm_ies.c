@@ -168,7 +168,10 @@ int decode_p_tmsi_signature_ie(
       buffer, (P_TMSI_SIGNATURE_IE_MAX_LENGTH - 1), len);
   }
 
-  IES_DECODE_U32(buffer, decoded, *ptmsisignature);
+  /* The signature is 3 octets, DECODE_U24 would read 4 */
+  *ptmsisignature = (buffer[decoded] << 16) | (buffer[decoded + 1] << 8) |
+                    buffer[decoded + 2];
+  decoded += 3;
   return decoded;
 }
 
@@ -191,7 +194,9 @@ int encode_p_tmsi_signature_ie(
       buffer, (P_TMSI_SIGNATURE_IE_MAX_LENGTH - 1), len);
   }
 
-  IES_ENCODE_U32(buffer, encoded, ptmsisignature);
+  buffer[encoded++] = (ptmsisignature >> 16) & 0xff;
+  buffer[encoded++] = (ptmsisignature >> 8) & 0xff;
+  buffer[encoded++] = ptmsisignature & 0xff;
   return encoded;
 }
 
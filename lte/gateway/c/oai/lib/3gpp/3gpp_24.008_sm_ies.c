@@ -80,6 +80,11 @@ int decode_access_point_name_ie(
   if (1 < ielen) {
     int length_apn = *(buffer + decoded);
     decoded++;
+    // the labels come from the UE, they must fit in the IE
+    if (length_apn > ielen - 1) {
+      errorCodeDecoder = TLV_VALUE_DOESNT_MATCH;
+      return TLV_VALUE_DOESNT_MATCH;
+    }
     *access_point_name = blk2bstr((void *) (buffer + decoded), length_apn);
     decoded += length_apn;
     ielen = ielen - 1 - length_apn;
@@ -91,11 +96,11 @@ int decode_access_point_name_ie(
 
       // apn terminated by '.' ?
       if (length_apn > 0) {
-        AssertFatal(
-          ielen >= length_apn,
-          "Mismatch in lengths remaining ielen %d apn length %d",
-          ielen,
-          length_apn);
+        if (ielen < length_apn) {
+          bdestroy_wrapper(access_point_name);
+          errorCodeDecoder = TLV_VALUE_DOESNT_MATCH;
+          return TLV_VALUE_DOESNT_MATCH;
+        }
         bcatblk(*access_point_name, (void *) (buffer + decoded), length_apn);
         decoded += length_apn;
         ielen = ielen - length_apn;
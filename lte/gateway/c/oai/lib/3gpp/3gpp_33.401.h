@@ -62,6 +62,10 @@
  * management scheme, by immediately using an authentication vector retrieved from the HSS in an
  * authentication procedure between UE and MME.
  */
-#define MAX_EPS_AUTH_VECTORS 1
+/* The MME can still be configured to fetch several vectors per AIR (see EPS_AUTH_VECTORS in the NAS
+ * configuration) to serve repeated authentications locally. The vectors are used in the order they were
+ * received, and unused vectors are discarded after AUTH_VECTOR_TTL.
+ */
+#define MAX_EPS_AUTH_VECTORS 5
 
 #endif /* FILE_3GPP_33_401_SEEN */
@@ -87,13 +87,40 @@ typedef struct hash_table_s {
   bool log_enabled;
 } hash_table_t;
 
-typedef struct hash_table_ts_s {
-  pthread_mutex_t mutex;
-  hash_size_t size;
+/*
+ * Open addressing table shared by the thread safe hashtables.
+ * Keys are spread over a power of two number of stripes by the upper bits of
+ * their mixed hash, each stripe being a Robin Hood linear probing table with
+ * its own read-write lock. A stripe grows on its own when its load factor is
+ * exceeded, so a resize only stalls the callers hitting that stripe.
+ * The number of stripes is fixed at init from the size hint, see
+ * hashtable_rh.h: a table filled far beyond its hint grows its stripes but
+ * keeps the locks of its initial size.
+ */
+typedef struct hash_rh_slot_s {
+  hash_key_t key;
+  uint64_t data;
+  uint32_t dib; // distance to initial bucket + 1, 0 means empty
+} hash_rh_slot_t;
+
+typedef struct hash_rh_stripe_s {
+  pthread_rwlock_t lock;
+  hash_size_t capacity;
   hash_size_t num_elements;
-  struct hash_node_s **nodes;
-  pthread_mutex_t *lock_nodes;
+  struct hash_rh_slot_s *slots;
+} __attribute__((aligned(64))) hash_rh_stripe_t;
+
+typedef struct hash_rh_table_s {
+  unsigned int stripe_bits;
+  hash_size_t nb_stripes;
+  hash_size_t num_elements;
+  struct hash_rh_stripe_s *stripes;
   hash_size_t (*hashfunc)(const hash_key_t);
+} hash_rh_table_t;
+
+typedef struct hash_table_ts_s {
+  hash_size_t size;
+  hash_rh_table_t rh;
   void (*freefunc)(void **);
   bstring name;
   bool is_allocated_by_malloc;
@@ -110,12 +137,8 @@ typedef struct hash_table_uint64_s {
 } hash_table_uint64_t;
 
 typedef struct hash_table_uint64_ts_s {
-  pthread_mutex_t mutex;
   hash_size_t size;
-  hash_size_t num_elements;
-  struct hash_node_uint64_s **nodes;
-  pthread_mutex_t *lock_nodes;
-  hash_size_t (*hashfunc)(const hash_key_t);
+  hash_rh_table_t rh;
   bstring name;
   bool is_allocated_by_malloc;
   bool log_enabled;
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file hashtable_rh.c
+  \brief Striped Robin Hood table backing hashtable_ts_* and hashtable_uint64_ts_*
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "hashtable_rh.h"
+
+//------------------------------------------------------------------------------
+// Keys are mostly sequential ids (S1AP ids, TEIDs, ...): the user hash function
+// output is scrambled (murmur3 finalizer) so that both the stripe (upper bits)
+// and the slot (lower bits) selections are well spread.
+static inline uint64_t rh_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+//------------------------------------------------------------------------------
+static inline hash_size_t rh_round_up_pow2(hash_size_t v)
+{
+  hash_size_t p = 1;
+  while (p < v) {
+    p <<= 1;
+  }
+  return p;
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t rh_hash(const hash_rh_table_t *const rh, hash_key_t key)
+{
+  return rh_mix((uint64_t) rh->hashfunc(key));
+}
+
+//------------------------------------------------------------------------------
+static inline hash_rh_stripe_t *rh_stripe(
+  const hash_rh_table_t *const rh,
+  uint64_t hash)
+{
+  if (rh->stripe_bits) {
+    return &rh->stripes[hash >> (64 - rh->stripe_bits)];
+  }
+  return &rh->stripes[0];
+}
+
+//------------------------------------------------------------------------------
+// Max load factor is 7/8, Robin Hood probing keeps probe lengths short there.
+static inline bool rh_stripe_overloaded(
+  const hash_rh_stripe_t *const stripe,
+  hash_size_t num_elements)
+{
+  return (num_elements * 8) > (stripe->capacity * 7);
+}
+
+//------------------------------------------------------------------------------
+static hash_rh_slot_t *rh_stripe_lookup(
+  const hash_rh_stripe_t *const stripe,
+  uint64_t hash,
+  hash_key_t key)
+{
+  const hash_size_t mask = stripe->capacity - 1;
+  hash_size_t idx = hash & mask;
+  uint32_t dib = 1;
+
+  for (;;) {
+    hash_rh_slot_t *slot = &stripe->slots[idx];
+    // an empty slot (dib 0) or a richer resident ends the probe sequence
+    if (slot->dib < dib) {
+      return NULL;
+    }
+    if (slot->key == key) {
+      return slot;
+    }
+    idx = (idx + 1) & mask;
+    dib++;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void rh_stripe_place(
+  hash_rh_slot_t *const slots,
+  hash_size_t capacity,
+  uint64_t hash,
+  hash_key_t key,
+  uint64_t data)
+{
+  const hash_size_t mask = capacity - 1;
+  hash_size_t idx = hash & mask;
+  hash_rh_slot_t entry = {.key = key, .data = data, .dib = 1};
+
+  for (;;) {
+    hash_rh_slot_t *slot = &slots[idx];
+    if (!slot->dib) {
+      *slot = entry;
+      return;
+    }
+    if (slot->dib < entry.dib) {
+      hash_rh_slot_t tmp = *slot;
+      *slot = entry;
+      entry = tmp;
+    }
+    idx = (idx + 1) & mask;
+    entry.dib++;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Called with the stripe write lock held, only this stripe is rehashed.
+static hashtable_rc_t rh_stripe_rehash(
+  const hash_rh_table_t *const rh,
+  hash_rh_stripe_t *const stripe,
+  hash_size_t capacity)
+{
+  hash_rh_slot_t *slots = calloc(capacity, sizeof(hash_rh_slot_t));
+
+  if (!slots) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  for (hash_size_t i = 0; i < stripe->capacity; i++) {
+    hash_rh_slot_t *slot = &stripe->slots[i];
+    if (slot->dib) {
+      rh_stripe_place(
+        slots, capacity, rh_hash(rh, slot->key), slot->key, slot->data);
+    }
+  }
+  free_wrapper((void **) &stripe->slots);
+  stripe->slots = slots;
+  stripe->capacity = capacity;
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t hashtable_rh_init(
+  hash_rh_table_t *const rh,
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t))
+{
+  hash_size_t total = rh_round_up_pow2(size ? size : 1);
+  hash_size_t nb_stripes = total / HASHTABLE_RH_SLOTS_PER_STRIPE;
+  hash_size_t capacity = 0;
+
+  if (nb_stripes < 1) {
+    nb_stripes = 1;
+  } else if (nb_stripes > HASHTABLE_RH_MAX_STRIPES) {
+    nb_stripes = HASHTABLE_RH_MAX_STRIPES;
+  }
+  capacity = total / nb_stripes;
+  if (capacity < HASHTABLE_RH_MIN_STRIPE_CAPACITY) {
+    capacity = HASHTABLE_RH_MIN_STRIPE_CAPACITY;
+  }
+
+  memset(rh, 0, sizeof(*rh));
+  if (posix_memalign(
+        (void **) &rh->stripes,
+        64,
+        nb_stripes * sizeof(hash_rh_stripe_t))) {
+    rh->stripes = NULL;
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  memset(rh->stripes, 0, nb_stripes * sizeof(hash_rh_stripe_t));
+  rh->nb_stripes = nb_stripes;
+  while ((1UL << rh->stripe_bits) < nb_stripes) {
+    rh->stripe_bits++;
+  }
+  rh->hashfunc = hashfunc;
+
+  for (hash_size_t i = 0; i < nb_stripes; i++) {
+    hash_rh_stripe_t *stripe = &rh->stripes[i];
+    if (!(stripe->slots = calloc(capacity, sizeof(hash_rh_slot_t)))) {
+      rh->nb_stripes = i;
+      hashtable_rh_destroy(rh, NULL);
+      return HASH_TABLE_SYSTEM_ERROR;
+    }
+    stripe->capacity = capacity;
+    pthread_rwlock_init(&stripe->lock, NULL);
+  }
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+void hashtable_rh_destroy(hash_rh_table_t *const rh, void (*freefunc)(void **))
+{
+  if (!rh->stripes) {
+    return;
+  }
+  for (hash_size_t i = 0; i < rh->nb_stripes; i++) {
+    hash_rh_stripe_t *stripe = &rh->stripes[i];
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    for (hash_size_t n = 0; freefunc && (n < stripe->capacity); n++) {
+      hash_rh_slot_t *slot = &stripe->slots[n];
+      if (slot->dib && slot->data) {
+        void *data = (void *) (uintptr_t) slot->data;
+        freefunc(&data);
+      }
+    }
+    free_wrapper((void **) &stripe->slots);
+    stripe->capacity = 0;
+    stripe->num_elements = 0;
+    pthread_rwlock_unlock(&stripe->lock);
+    pthread_rwlock_destroy(&stripe->lock);
+  }
+  free(rh->stripes);
+  rh->stripes = NULL;
+  rh->nb_stripes = 0;
+  rh->num_elements = 0;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t hashtable_rh_get(
+  const hash_rh_table_t *const rh,
+  const hash_key_t key,
+  uint64_t *const data)
+{
+  const uint64_t hash = rh_hash(rh, key);
+  hash_rh_stripe_t *stripe = rh_stripe(rh, hash);
+  hash_rh_slot_t *slot = NULL;
+  hashtable_rc_t rc = HASH_TABLE_KEY_NOT_EXISTS;
+
+  pthread_rwlock_rdlock(&stripe->lock);
+  if ((slot = rh_stripe_lookup(stripe, hash, key))) {
+    if (data) {
+      *data = slot->data;
+    }
+    rc = HASH_TABLE_OK;
+  }
+  pthread_rwlock_unlock(&stripe->lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t hashtable_rh_insert(
+  hash_rh_table_t *const rh,
+  const hash_key_t key,
+  const uint64_t data,
+  void (*freefunc)(void **))
+{
+  const uint64_t hash = rh_hash(rh, key);
+  hash_rh_stripe_t *stripe = rh_stripe(rh, hash);
+  hash_rh_slot_t *slot = NULL;
+  hashtable_rc_t rc = HASH_TABLE_OK;
+
+  pthread_rwlock_wrlock(&stripe->lock);
+  if ((slot = rh_stripe_lookup(stripe, hash, key))) {
+    if (slot->data != data) {
+      if (!freefunc) {
+        rc = HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+      } else if (slot->data) {
+        void *old = (void *) (uintptr_t) slot->data;
+        freefunc(&old);
+        rc = HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+      }
+      slot->data = data;
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+    return rc;
+  }
+
+  if (rh_stripe_overloaded(stripe, stripe->num_elements + 1)) {
+    rc = rh_stripe_rehash(rh, stripe, stripe->capacity << 1);
+    if (HASH_TABLE_OK != rc) {
+      pthread_rwlock_unlock(&stripe->lock);
+      return rc;
+    }
+  }
+  rh_stripe_place(stripe->slots, stripe->capacity, hash, key, data);
+  stripe->num_elements++;
+  __sync_fetch_and_add(&rh->num_elements, 1);
+  pthread_rwlock_unlock(&stripe->lock);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t hashtable_rh_remove(
+  hash_rh_table_t *const rh,
+  const hash_key_t key,
+  uint64_t *const data)
+{
+  const uint64_t hash = rh_hash(rh, key);
+  hash_rh_stripe_t *stripe = rh_stripe(rh, hash);
+  hash_rh_slot_t *slot = NULL;
+
+  pthread_rwlock_wrlock(&stripe->lock);
+  if (!(slot = rh_stripe_lookup(stripe, hash, key))) {
+    pthread_rwlock_unlock(&stripe->lock);
+    return HASH_TABLE_KEY_NOT_EXISTS;
+  }
+  if (data) {
+    *data = slot->data;
+  }
+
+  // backward shift deletion, no tombstones
+  const hash_size_t mask = stripe->capacity - 1;
+  hash_size_t idx = slot - stripe->slots;
+  hash_size_t next = (idx + 1) & mask;
+  while (stripe->slots[next].dib > 1) {
+    stripe->slots[idx] = stripe->slots[next];
+    stripe->slots[idx].dib--;
+    idx = next;
+    next = (next + 1) & mask;
+  }
+  memset(&stripe->slots[idx], 0, sizeof(hash_rh_slot_t));
+  stripe->num_elements--;
+  __sync_fetch_and_sub(&rh->num_elements, 1);
+  pthread_rwlock_unlock(&stripe->lock);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+// Stripes are only grown, and one at a time, readers of other stripes are not
+// blocked.
+hashtable_rc_t hashtable_rh_resize(
+  hash_rh_table_t *const rh,
+  const hash_size_t size)
+{
+  hash_size_t capacity = rh_round_up_pow2(size / rh->nb_stripes);
+  hashtable_rc_t rc = HASH_TABLE_OK;
+
+  for (hash_size_t i = 0; (i < rh->nb_stripes) && (HASH_TABLE_OK == rc); i++) {
+    hash_rh_stripe_t *stripe = &rh->stripes[i];
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    if (capacity > stripe->capacity) {
+      rc = rh_stripe_rehash(rh, stripe, capacity);
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hash_size_t hashtable_rh_collect(
+  const hash_rh_table_t *const rh,
+  hash_rh_slot_t **entries)
+{
+  hash_size_t allocated = rh->num_elements + 1;
+  hash_size_t count = 0;
+
+  *entries = malloc(allocated * sizeof(hash_rh_slot_t));
+  if (!*entries) {
+    return 0;
+  }
+  for (hash_size_t i = 0; i < rh->nb_stripes; i++) {
+    hash_rh_stripe_t *stripe = &rh->stripes[i];
+
+    pthread_rwlock_rdlock(&stripe->lock);
+    if ((count + stripe->num_elements) > allocated) {
+      // the table grew since we sized the array
+      hash_size_t new_allocated = (count + stripe->num_elements) * 2;
+      hash_rh_slot_t *e =
+        realloc(*entries, new_allocated * sizeof(hash_rh_slot_t));
+      if (!e) {
+        pthread_rwlock_unlock(&stripe->lock);
+        break;
+      }
+      *entries = e;
+      allocated = new_allocated;
+    }
+    for (hash_size_t n = 0; n < stripe->capacity; n++) {
+      if (stripe->slots[n].dib) {
+        (*entries)[count++] = stripe->slots[n];
+      }
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+  }
+  return count;
+}
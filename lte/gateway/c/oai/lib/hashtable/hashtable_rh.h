@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file hashtable_rh.h
+  \brief Striped Robin Hood table backing hashtable_ts_* and hashtable_uint64_ts_*
+*/
+#ifndef FILE_HASHTABLE_RH_SEEN
+#define FILE_HASHTABLE_RH_SEEN
+
+#include "hashtable.h"
+
+/*
+ * hashtable_rh_init() creates one stripe per HASHTABLE_RH_SLOTS_PER_STRIPE
+ * slots of the size hint rounded up to a power of two, from 1 up to
+ * HASHTABLE_RH_MAX_STRIPES. The number of stripes never changes afterwards,
+ * neither hashtable_rh_resize() nor the growth of the stripes add any, so a
+ * table shared between tasks should be given its expected size at init (e.g.
+ * the configured maximum number of UEs) to get its full lock striping.
+ */
+#define HASHTABLE_RH_MAX_STRIPES 64
+#define HASHTABLE_RH_MIN_STRIPE_CAPACITY 8
+#define HASHTABLE_RH_SLOTS_PER_STRIPE 64
+
+hashtable_rc_t hashtable_rh_init(
+  hash_rh_table_t *const rh,
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t));
+
+/* Releases the stripes, calling freefunc (if any) on every non null data */
+void hashtable_rh_destroy(hash_rh_table_t *const rh, void (*freefunc)(void **));
+
+hashtable_rc_t hashtable_rh_get(
+  const hash_rh_table_t *const rh,
+  const hash_key_t key,
+  uint64_t *const data);
+
+/*
+ * Inserts or updates key. When an existing data is replaced by a different one
+ * and freefunc is provided, freefunc is called on the old data (if not null).
+ */
+hashtable_rc_t hashtable_rh_insert(
+  hash_rh_table_t *const rh,
+  const hash_key_t key,
+  const uint64_t data,
+  void (*freefunc)(void **));
+
+hashtable_rc_t hashtable_rh_remove(
+  hash_rh_table_t *const rh,
+  const hash_key_t key,
+  uint64_t *const data);
+
+hashtable_rc_t hashtable_rh_resize(
+  hash_rh_table_t *const rh,
+  const hash_size_t size);
+
+/*
+ * Copies all entries, one stripe at a time, into a newly allocated array
+ * the caller has to free. Callbacks are run on such a copy so that they can
+ * safely call back into the table.
+ */
+hash_size_t hashtable_rh_collect(
+  const hash_rh_table_t *const rh,
+  hash_rh_slot_t **entries);
+
+#endif /* FILE_HASHTABLE_RH_SEEN */
@@ -43,6 +43,7 @@
 #include "bstrlib.h"
 #include "dynamic_memory_check.h"
 #include "hashtable.h"
+#include "hashtable_rh.h"
 
 #if TRACE_HASHTABLE
 #define PRINT_HASHTABLE(hTbLe, ...)                                            \
@@ -145,9 +146,12 @@ hash_table_uint64_t *hashtable_uint64_create(
 //------------------------------------------------------------------------------
 /*
    Initialization
-   hashtable_uint64_ts_init() sets up the initial structure of the thread safe hash table. The user specified size will be allocated and initialized to NULL.
+   hashtable_uint64_ts_init() sets up the initial structure of the thread safe hash table.
+   Elements are stored in place (open addressing, Robin Hood probing) in lock
+   striped sub-tables, sized from the user specified size rounded up to a power
+   of two. Sub-tables grow automatically, the size is just a hint.
    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
-   If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_t pointer should be released with hashtable_uint64_destroy().
+   If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_ts_t pointer should be released with hashtable_uint64_ts_destroy().
 */
 hash_table_uint64_ts_t *hashtable_uint64_ts_init(
   hash_table_uint64_ts_t *const hashtblP,
@@ -155,50 +159,15 @@ hash_table_uint64_ts_t *hashtable_uint64_ts_init(
   hash_size_t (*hashfuncP)(const hash_key_t),
   bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
   memset(hashtblP, 0, sizeof(*hashtblP));
 
-  if (!(hashtblP->nodes = calloc(size, sizeof(hash_node_uint64_t *)))) {
-    free_wrapper((void **) &hashtblP);
-    return NULL;
-  }
-
-  if (!(hashtblP->lock_nodes = calloc(size, sizeof(pthread_mutex_t)))) {
-    free_wrapper((void **) &hashtblP->nodes);
-    free_wrapper((void **) &hashtblP->name);
-    free_wrapper((void **) &hashtblP);
+  if (HASH_TABLE_OK != hashtable_rh_init(
+                         &hashtblP->rh,
+                         sizeP,
+                         (hashfuncP) ? hashfuncP : def_hashfunc)) {
     return NULL;
   }
-
-  pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
-
-  hashtblP->size = size;
-
-  if (hashfuncP)
-    hashtblP->hashfunc = hashfuncP;
-  else
-    hashtblP->hashfunc = def_hashfunc;
+  hashtblP->size = sizeP;
 
   if (display_name_pP) {
     hashtblP->name = bstrcpy(display_name_pP);
@@ -209,12 +178,13 @@ hash_table_uint64_ts_t *hashtable_uint64_ts_init(
   hashtblP->log_enabled = true;
   return hashtblP;
 }
+
 //------------------------------------------------------------------------------
 /*
    Initialization
-   hashtable_uint64_ts_create() allocate and sets up the initial structure of the thread safe hash table. The user specified size will be allocated and initialized to NULL.
-   The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
-   If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_t pointer should be released with hashtable_uint64_destroy().
+   hashtable_uint64_ts_create() allocate and sets up the initial structure of the thread safe hash table.
+   See hashtable_uint64_ts_init().
+   If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_ts_t pointer should be released with hashtable_uint64_ts_destroy().
 */
 hash_table_uint64_ts_t *hashtable_uint64_ts_create(
   const hash_size_t sizeP,
@@ -226,8 +196,10 @@ hash_table_uint64_ts_t *hashtable_uint64_ts_create(
   if (!(hashtbl = calloc(1, sizeof(hash_table_uint64_ts_t)))) {
     return NULL;
   }
-  hashtbl =
-    hashtable_uint64_ts_init(hashtbl, sizeP, hashfuncP, display_name_pP);
+  if (!hashtable_uint64_ts_init(hashtbl, sizeP, hashfuncP, display_name_pP)) {
+    free_wrapper((void **) &hashtbl);
+    return NULL;
+  }
   hashtbl->is_allocated_by_malloc = true;
   return hashtbl;
 }
@@ -267,34 +239,17 @@ hashtable_rc_t hashtable_uint64_destroy(hash_table_uint64_t *hashtblP)
 //------------------------------------------------------------------------------
 /*
    Cleanup
-   The hashtable_uint64_destroy() walks through the linked lists for each possible hash value, and releases the elements. It also releases the nodes array and the hash_table_uint64_t.
+   The hashtable_uint64_ts_destroy() releases the sub-tables and the
+   hash_table_uint64_ts_t if it was allocated by hashtable_uint64_ts_create().
 */
 hashtable_rc_t hashtable_uint64_ts_destroy(hash_table_uint64_ts_t *hashtblP)
 {
-  hash_size_t n = 0;
-  hash_node_uint64_t *node = NULL, *oldnode = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-      free_wrapper((void **) &oldnode);
-    }
-
-    pthread_mutex_unlock(&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy(&hashtblP->lock_nodes[n]);
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
+  hashtable_rh_destroy(&hashtblP->rh, NULL);
   bdestroy_wrapper(&hashtblP->name);
-  free_wrapper((void **) &hashtblP->lock_nodes);
   if (hashtblP->is_allocated_by_malloc) {
     free_wrapper((void **) &hashtblP);
   }
@@ -343,39 +298,21 @@ hashtable_rc_t hashtable_uint64_ts_is_key_exists(
   const hash_table_uint64_ts_t *const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t *node = NULL;
-  hash_size_t hash = 0;
+  hashtable_rc_t rc = HASH_TABLE_KEY_NOT_EXISTS;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 ") return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
-  }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  rc = hashtable_rh_get(&hashtblP->rh, keyP, NULL);
   PRINT_HASHTABLE(
     hashtblP,
-    "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
+    "%s(%s,key 0x%" PRIx64 ") return %s\n",
     __FUNCTION__,
     bdata(hashtblP->name),
-    keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
+    keyP,
+    hashtable_rc_code2string(rc));
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -420,28 +357,21 @@ hashtable_rc_t hashtable_uint64_apply_callback_on_elements(
 hashtable_key_array_t *hashtable_uint64_ts_get_keys(
   hash_table_uint64_ts_t *const hashtblP)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
+  hash_rh_slot_t *entries = NULL;
+  hash_size_t n = 0;
   hashtable_key_array_t *ka = NULL;
 
-  if ((!hashtblP) || !(hashtblP->num_elements)) {
+  if ((!hashtblP) || !(hashtblP->rh.num_elements)) {
     return NULL;
   }
-  ka = calloc(1, sizeof(hashtable_key_array_t));
-  ka->keys = calloc(hashtblP->num_elements, sizeof(hash_key_t *));
 
-  while ((ka->num_keys < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ka->keys[ka->num_keys++] = node->key;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+  n = hashtable_rh_collect(&hashtblP->rh, &entries);
+  ka = calloc(1, sizeof(hashtable_key_array_t));
+  ka->keys = calloc(n + 1, sizeof(hash_key_t));
+  for (hash_size_t i = 0; i < n; i++) {
+    ka->keys[ka->num_keys++] = entries[i].key;
   }
+  free_wrapper((void **) &entries);
   return ka;
 }
 
@@ -450,29 +380,21 @@ hashtable_key_array_t *hashtable_uint64_ts_get_keys(
 hashtable_uint64_element_array_t *hashtable_uint64_ts_get_elements(
   hash_table_uint64_ts_t *const hashtblP)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
+  hash_rh_slot_t *entries = NULL;
+  hash_size_t n = 0;
   hashtable_uint64_element_array_t *ea = NULL;
 
-  if ((!hashtblP) || !(hashtblP->num_elements)) {
+  if ((!hashtblP) || !(hashtblP->rh.num_elements)) {
     return NULL;
   }
 
+  n = hashtable_rh_collect(&hashtblP->rh, &entries);
   ea = calloc(1, sizeof(hashtable_uint64_element_array_t));
-  ea->elements = calloc(hashtblP->num_elements, sizeof(uint64_t *));
-
-  while ((ea->num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ea->elements[ea->num_elements++] = node->data;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+  ea->elements = calloc(n + 1, sizeof(uint64_t));
+  for (hash_size_t i = 0; i < n; i++) {
+    ea->elements[ea->num_elements++] = entries[i].data;
   }
+  free_wrapper((void **) &entries);
   return ea;
 }
 
@@ -480,6 +402,7 @@ hashtable_uint64_element_array_t *hashtable_uint64_ts_get_elements(
 // may cost a lot CPU...
 // Also useful if we want to find an element in the collection based on compare criteria different than the single key
 // The compare criteria in implemented in the funct_cb function
+// The callback is run on a copy of the entries, no lock is held while it runs.
 hashtable_rc_t hashtable_uint64_ts_apply_callback_on_elements(
   hash_table_uint64_ts_t *const hashtblP,
   bool funct_cb(
@@ -490,32 +413,23 @@ hashtable_rc_t hashtable_uint64_ts_apply_callback_on_elements(
   void *parameterP,
   void **resultP)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
-  unsigned int num_elements = 0;
+  hash_rh_slot_t *entries = NULL;
+  hash_size_t n = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
+  if (!hashtblP->rh.num_elements) {
+    return HASH_TABLE_OK;
+  }
 
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb(node->key, node->data, parameterP, resultP)) {
-          pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-          return HASH_TABLE_OK;
-        }
-        node = node->next;
-      }
+  n = hashtable_rh_collect(&hashtblP->rh, &entries);
+  for (hash_size_t i = 0; i < n; i++) {
+    if (funct_cb(entries[i].key, entries[i].data, parameterP, resultP)) {
+      break;
     }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
   }
-
+  free_wrapper((void **) &entries);
   return HASH_TABLE_OK;
 }
 
@@ -561,38 +475,29 @@ hashtable_rc_t hashtable_uint64_ts_dump_content(
   const hash_table_uint64_ts_t *const hashtblP,
   bstring str)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
+  hash_rh_slot_t *entries = NULL;
+  hash_size_t n = 0;
 
   if (!hashtblP) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat(
-          "Key 0x%" PRIx64 " Element %" PRIx64 " Node %p Next %p\n",
-          node->key,
-          node->data,
-          node,
-          node->next);
-        if (!b0) {
-          PRINT_HASHTABLE(hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy_wrapper(&b0);
-        }
-        node = node->next;
-      }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
+  n = hashtable_rh_collect(&hashtblP->rh, &entries);
+  for (hash_size_t i = 0; i < n; i++) {
+    bstring b0 = bformat(
+      "Key 0x%" PRIx64 " Element %" PRIx64 " Probe %u\n",
+      entries[i].key,
+      entries[i].data,
+      (unsigned int) entries[i].dib);
+    if (!b0) {
+      PRINT_HASHTABLE(hashtblP, "Error while dumping hashtable content");
+    } else {
+      bconcat(str, b0);
+      bdestroy_wrapper(&b0);
     }
-    i += 1;
   }
+  free_wrapper((void **) &entries);
   return HASH_TABLE_OK;
 }
 
@@ -671,77 +576,29 @@ hashtable_rc_t hashtable_uint64_insert(
 //------------------------------------------------------------------------------
 /*
    Adding a new element
-   To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   An already present key gets its element replaced.
 */
 hashtable_rc_t hashtable_uint64_ts_insert(
   hash_table_uint64_ts_t *const hashtblP,
   const hash_key_t keyP,
   const uint64_t dataP)
 {
-  hash_node_uint64_t *node = NULL;
-  hash_size_t hash = 0;
+  hashtable_rc_t rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data != dataP) {
-        node->data = dataP;
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE(
-          hashtblP,
-          "%s(%s,key 0x%" PRIx64 " data %" PRIx64
-          ") return INSERT_OVERWRITTEN_DATA\n",
-          __FUNCTION__,
-          bdata(hashtblP->name),
-          keyP,
-          dataP);
-        return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
-      }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 " data %" PRIx64 ") return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP,
-        dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
-  }
-
-  if (!(node = malloc(sizeof(hash_node_uint64_t)))) return -1;
-
-  node->key = keyP;
-  node->data = dataP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
-  hashtblP->nodes[hash] = node;
-  __sync_fetch_and_add(&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  rc = hashtable_rh_insert(&hashtblP->rh, keyP, dataP, NULL);
   PRINT_HASHTABLE(
     hashtblP,
-    "%s(%s,key 0x%" PRIx64 " data %p) next %p return OK\n",
+    "%s(%s,key 0x%" PRIx64 " data %" PRIx64 ") return %s\n",
     __FUNCTION__,
     bdata(hashtblP->name),
     keyP,
     dataP,
-    node->next);
-  return HASH_TABLE_OK;
+    hashtable_rc_code2string(rc));
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -796,55 +653,14 @@ hashtable_rc_t hashtable_uint64_free(
 
 //------------------------------------------------------------------------------
 /*
-   To free_wrapper an element from the hash table, we just search for it in the linked list for that hash value,
-   and free_wrapper it if it is found. If it was not found, it is an error and -1 is returned.
+   Elements are stored in place, there is nothing to release, same as
+   hashtable_uint64_ts_remove().
 */
 hashtable_rc_t hashtable_uint64_ts_free(
   hash_table_uint64_ts_t *const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t *node, *prevnode = NULL;
-  hash_size_t hash = 0;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub(&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 ") return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
-  }
-
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE(
-    hashtblP,
-    "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
-    __FUNCTION__,
-    bdata(hashtblP->name),
-    keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
+  return hashtable_uint64_ts_remove(hashtblP, keyP);
 }
 
 //------------------------------------------------------------------------------
@@ -899,55 +715,28 @@ hashtable_rc_t hashtable_uint64_remove(
 
 //------------------------------------------------------------------------------
 /*
-   To remove an element from the hash table, we just search for it in the linked list for that hash value,
-   and remove it if it is found. If it was not found, it is an error and -1 is returned.
+   To remove an element from the hash table, we just remove it from its
+   sub-table. If it was not found, HASH_TABLE_KEY_NOT_EXISTS is returned.
 */
 hashtable_rc_t hashtable_uint64_ts_remove(
   hash_table_uint64_ts_t *const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t *node, *prevnode = NULL;
-  hash_size_t hash = 0;
+  hashtable_rc_t rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub(&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 ") return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
-  }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-
+  rc = hashtable_rh_remove(&hashtblP->rh, keyP, NULL);
   PRINT_HASHTABLE(
     hashtblP,
-    "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
+    "%s(%s,key 0x%" PRIx64 ") return %s\n",
     __FUNCTION__,
     bdata(hashtblP->name),
-    keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
+    keyP,
+    hashtable_rc_code2string(rc));
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -997,50 +786,28 @@ hashtable_rc_t hashtable_uint64_get(
 
 //------------------------------------------------------------------------------
 /*
-   Searching for an element is easy. We just search through the linked list for the corresponding hash value.
-   NULL is returned if we didn't find it.
+   Searching for an element only takes the read lock of the key's sub-table.
 */
 hashtable_rc_t hashtable_uint64_ts_get(
   const hash_table_uint64_ts_t *const hashtblP,
   const hash_key_t keyP,
   uint64_t *const dataP)
 {
-  hash_node_uint64_t *node = NULL;
-  hash_size_t hash = 0;
+  hashtable_rc_t rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 " data %p) return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP,
-        *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
-  }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  rc = hashtable_rh_get(&hashtblP->rh, keyP, dataP);
   PRINT_HASHTABLE(
     hashtblP,
-    "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
+    "%s(%s,key 0x%" PRIx64 ") return %s\n",
     __FUNCTION__,
     bdata(hashtblP->name),
-    keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
+    keyP,
+    hashtable_rc_code2string(rc));
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -1107,74 +874,18 @@ hashtable_rc_t hashtable_uint64_resize(
 //------------------------------------------------------------------------------
 /*
    Resizing
-   The number of elements in a hash table is not always known when creating the table.
-   If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
-   If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
-   Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_uint64_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_uint64_insert() and hashtable_uint64_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
-   Dangerous not really thread safe.
+   Sub-tables already grow on their own when their load factor is exceeded,
+   this is only useful to pre-size the table for an expected number of elements.
+   Sub-tables are rehashed one at a time, under their own write lock, and are
+   never shrunk.
 */
-
 hashtable_rc_t hashtable_uint64_ts_resize(
   hash_table_uint64_ts_t *const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_uint64_ts_t newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t n = 0;
-  hash_node_uint64_t *node = NULL, *next = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc(size, sizeof(hash_node_uint64_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc(size, sizeof(pthread_mutex_t)))) {
-    free_wrapper((void **) &newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_uint64_ts_remove(hashtblP, node->key);
-      hashtable_uint64_ts_insert(&newtbl, node->key, node->data);
-    }
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  free_wrapper((void **) &hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
-  return HASH_TABLE_OK;
+  hashtblP->size = sizeP;
+  return hashtable_rh_resize(&hashtblP->rh, sizeP);
 }
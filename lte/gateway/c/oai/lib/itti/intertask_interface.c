@@ -137,6 +137,19 @@ typedef struct thread_desc_s {
 
   int epoll_nb_events;
 
+  /*
+   * Set by a sender once it has written task_event_fd, cleared by the
+   * receiver when it consumes the eventfd counter. Senders finding it set
+   * skip the write, the receiver drains the whole queue per wake-up anyway.
+   */
+  volatile uint32_t event_fd_signalled;
+
+  /*
+   * Only accessed by the task thread: the queue may still hold messages that
+   * were signalled on task_event_fd but not dequeued yet.
+   */
+  bool messages_queued;
+
   //#ifdef RTAI
   /*
    * Flag to mark real time thread
@@ -152,11 +165,23 @@ typedef struct thread_desc_s {
 
 typedef struct task_desc_s {
   /*
-   * Queue of messages belonging to the task
+   * Queues of messages belonging to the task, one per priority level
    */
-  struct lfds710_queue_bmm_state message_queue
+  struct lfds710_queue_bmm_state message_queue[ITTI_PRIORITY_LEVEL_MAX]
     __attribute__((aligned(LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
-  struct lfds710_queue_bmm_element *qbmme;
+  struct lfds710_queue_bmm_element *qbmme[ITTI_PRIORITY_LEVEL_MAX];
+
+  /*
+   * Number of messages waiting on each level. Incremented by senders before
+   * enqueuing, decremented by the receiver after dequeuing.
+   */
+  volatile int32_t queue_depth[ITTI_PRIORITY_LEVEL_MAX];
+
+  /*
+   * Only accessed by the receiver: messages dequeued in a row from a level
+   * while lower levels had messages waiting.
+   */
+  uint32_t served_in_row[ITTI_PRIORITY_LEVEL_MAX];
 } task_desc_t;
 
 typedef struct itti_desc_s {
@@ -188,6 +213,12 @@ typedef struct itti_desc_s {
 
   memory_pools_handle_t memory_pools_handle;
 
+  /*
+   * Messages served in a row from a level before a lower level gets one,
+   * 0 means strict priority
+   */
+  uint32_t starvation_limit;
+
   uint64_t vcd_poll_msg;
   uint64_t vcd_receive_msg;
   uint64_t vcd_send_msg;
@@ -255,6 +286,16 @@ static inline uint32_t itti_get_message_priority(MessagesIds message_id)
   return (itti_desc.messages_info[message_id].priority);
 }
 
+static inline itti_priority_level_t itti_get_priority_level(uint32_t priority)
+{
+  if (priority >= MESSAGE_PRIORITY_MED_PLUS) {
+    return ITTI_PRIORITY_LEVEL_HIGH;
+  } else if (priority >= MESSAGE_PRIORITY_MED_LEAST) {
+    return ITTI_PRIORITY_LEVEL_MED;
+  }
+  return ITTI_PRIORITY_LEVEL_LOW;
+}
+
 const char *itti_get_message_name(MessagesIds message_id)
 {
   AssertFatal(
@@ -409,6 +450,7 @@ int itti_send_msg_to_task(
   task_id_t origin_task_id;
   message_list_t *new;
   uint32_t priority;
+  itti_priority_level_t level;
   message_number_t message_number;
   uint32_t message_id;
 
@@ -435,6 +477,7 @@ int itti_send_msg_to_task(
     itti_desc.messages_id_max);
   origin_task_id = ITTI_MSG_ORIGIN_ID(message);
   priority = itti_get_message_priority(message_id);
+  level = itti_get_priority_level(priority);
   /*
    * Increment the global message number
    */
@@ -486,10 +529,29 @@ int itti_send_msg_to_task(
       new->message_number = message_number;
       new->message_priority = priority;
       /*
-       * Enqueue message in destination task queue
+       * Enqueue message in destination task queue, the depth is accounted
+       * first so that the receiver never sees it go negative
        */
-      lfds710_queue_bmm_enqueue(
-        &itti_desc.tasks[destination_task_id].message_queue, NULL, new);
+      __sync_fetch_and_add(
+        &itti_desc.tasks[destination_task_id].queue_depth[level], 1);
+      if (
+        lfds710_queue_bmm_enqueue(
+          &itti_desc.tasks[destination_task_id].message_queue[level],
+          NULL,
+          new) == 0) {
+        __sync_fetch_and_sub(
+          &itti_desc.tasks[destination_task_id].queue_depth[level], 1);
+        OAILOG_ERROR(
+          LOG_ITTI,
+          "Queue (%u:%s) level %d is full, dropping message %s\n",
+          destination_task_id,
+          itti_get_task_name(destination_task_id),
+          level,
+          itti_desc.messages_info[message_id].name);
+        itti_free(origin_task_id, new);
+        itti_free(origin_task_id, message);
+        return -1;
+      }
       VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME(
         VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
       {
@@ -500,19 +562,31 @@ int itti_send_msg_to_task(
           ssize_t write_ret;
           eventfd_t sem_counter = 1;
 
+#if ITTI_EVENT_FD_COALESCING
           /*
-           * Call to write for an event fd must be of 8 bytes
+           * Skip the write if the receiver has not consumed the previous
+           * signal yet, it will find this message when draining the queue.
            */
-          write_ret = write(
-            itti_desc.threads[destination_thread_id].task_event_fd,
-            &sem_counter,
-            sizeof(sem_counter));
-          AssertFatal(
-            write_ret == sizeof(sem_counter),
-            "Write to task message FD (%d) failed (%d/%d)\n",
-            destination_thread_id,
-            (int) write_ret,
-            (int) sizeof(sem_counter));
+          if (
+            __sync_fetch_and_or(
+              &itti_desc.threads[destination_thread_id].event_fd_signalled,
+              1) == 0)
+#endif
+          {
+            /*
+             * Call to write for an event fd must be of 8 bytes
+             */
+            write_ret = write(
+              itti_desc.threads[destination_thread_id].task_event_fd,
+              &sem_counter,
+              sizeof(sem_counter));
+            AssertFatal(
+              write_ret == sizeof(sem_counter),
+              "Write to task message FD (%d) failed (%d/%d)\n",
+              destination_thread_id,
+              (int) write_ret,
+              (int) sizeof(sem_counter));
+          }
         }
       }
 
@@ -544,6 +618,26 @@ int itti_send_msg_to_task(
   return 0;
 }
 
+void itti_set_starvation_limit(uint32_t starvation_limit)
+{
+  itti_desc.starvation_limit = starvation_limit;
+}
+
+int itti_get_queue_depth(task_id_t task_id, itti_priority_level_t level)
+{
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(
+    level < ITTI_PRIORITY_LEVEL_MAX,
+    "Priority level (%d) is out of range (%d)!\n",
+    level,
+    ITTI_PRIORITY_LEVEL_MAX);
+  return itti_desc.tasks[task_id].queue_depth[level];
+}
+
 void itti_subscribe_event_fd(task_id_t task_id, int fd)
 {
   thread_id_t thread_id;
@@ -639,44 +733,111 @@ int itti_get_events(task_id_t task_id, struct epoll_event **events)
   return itti_desc.threads[thread_id].epoll_nb_events;
 }
 
-static inline void itti_receive_msg_internal_event_fd(
-  task_id_t task_id,
-  uint8_t polling,
-  MessageDef **received_msg)
+static inline bool itti_lower_levels_pending(
+  const task_desc_t *task,
+  itti_priority_level_t level)
 {
-  thread_id_t thread_id;
-  int epoll_ret = 0;
-  int epoll_timeout = 0;
-  int i;
+  itti_priority_level_t lower;
 
-  AssertFatal(
-    task_id < itti_desc.task_max,
-    "Task id (%d) is out of range (%d)!\n",
-    task_id,
-    itti_desc.task_max);
-  AssertFatal(received_msg != NULL, "Received message is NULL!\n");
-  thread_id = TASK_GET_THREAD_ID(task_id);
-  *received_msg = NULL;
+  for (lower = level + 1; lower < ITTI_PRIORITY_LEVEL_MAX; lower++) {
+    if (task->queue_depth[lower] > 0) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  if (polling) {
+static inline MessageDef *itti_dequeue_msg_from_level(
+  task_desc_t *task,
+  itti_priority_level_t level)
+{
+  struct message_list_s *message = NULL;
+  MessageDef *msg = NULL;
+  int result;
+
+  if (
+    lfds710_queue_bmm_dequeue(
+      &task->message_queue[level], NULL, (void **) &message) == 0) {
     /*
-     * In polling mode we set the timeout to 0 causing epoll_wait to return
-     * * * immediately.
+     * Empty, or a sender accounted the message but has not enqueued it yet
      */
-    epoll_timeout = 0;
+    return NULL;
+  }
+  __sync_fetch_and_sub(&task->queue_depth[level], 1);
+
+  if (itti_lower_levels_pending(task, level)) {
+    task->served_in_row[level]++;
   } else {
-    /*
-     * timeout = -1 causes the epoll_wait to wait indefinitely.
-     */
-    epoll_timeout = -1;
+    task->served_in_row[level] = 0;
+  }
+
+  AssertFatal(message != NULL, "Message from message queue is NULL!\n");
+  msg = message->msg;
+  result = itti_free(ITTI_MSG_ORIGIN_ID(msg), message);
+  AssertFatal(result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
+  return msg;
+}
+
+/*
+ * Dequeues the next message of the task, highest priority level first. A
+ * level that has been served starvation_limit times in a row while lower
+ * levels were waiting is skipped once.
+ */
+static inline MessageDef *itti_dequeue_msg(task_id_t task_id)
+{
+  task_desc_t *task = &itti_desc.tasks[task_id];
+  itti_priority_level_t skipped = ITTI_PRIORITY_LEVEL_MAX;
+  itti_priority_level_t level;
+  MessageDef *msg = NULL;
+
+  for (level = ITTI_PRIORITY_LEVEL_HIGH; level < ITTI_PRIORITY_LEVEL_MAX;
+       level++) {
+    if (task->queue_depth[level] <= 0) {
+      task->served_in_row[level] = 0;
+      continue;
+    }
+
+    if (
+      itti_desc.starvation_limit && skipped == ITTI_PRIORITY_LEVEL_MAX &&
+      task->served_in_row[level] >= itti_desc.starvation_limit &&
+      itti_lower_levels_pending(task, level)) {
+      task->served_in_row[level] = 0;
+      skipped = level;
+      continue;
+    }
+
+    if ((msg = itti_dequeue_msg_from_level(task, level)) != NULL) {
+      return msg;
+    }
   }
 
+  /*
+   * The lower levels were not ready after all, do not leave the skipped
+   * level unserved until the next wake-up.
+   */
+  if (skipped != ITTI_PRIORITY_LEVEL_MAX) {
+    msg = itti_dequeue_msg_from_level(task, skipped);
+  }
+  return msg;
+}
+
+/*
+ * Waits on the epoll fd of the thread, consuming the ITTI event fd if it is
+ * signalled. Returns the number of events on fds subscribed by the task.
+ */
+static int itti_wait_events(
+  task_id_t task_id,
+  thread_id_t thread_id,
+  int epoll_timeout)
+{
+  thread_desc_t *thread = &itti_desc.threads[thread_id];
+  int epoll_ret = 0;
+  int task_events = 0;
+  int i;
+
   do {
     epoll_ret = epoll_wait(
-      itti_desc.threads[thread_id].epoll_fd,
-      itti_desc.threads[thread_id].events,
-      itti_desc.threads[thread_id].nb_events,
-      epoll_timeout);
+      thread->epoll_fd, thread->events, thread->nb_events, epoll_timeout);
   } while (epoll_ret < 0 && errno == EINTR);
 
   if (epoll_ret < 0) {
@@ -687,71 +848,155 @@ static inline void itti_receive_msg_internal_event_fd(
       strerror(errno));
   }
 
-  if (epoll_ret == 0 && polling) {
-    /*
-     * No data to read -> return
-     */
-    return;
-  }
-
-  itti_desc.threads[thread_id].epoll_nb_events = epoll_ret;
+  thread->epoll_nb_events = epoll_ret;
 
   for (i = 0; i < epoll_ret; i++) {
     /*
      * Check if there is an event for ITTI for the event fd
      */
     if (
-      (itti_desc.threads[thread_id].events[i].events & EPOLLIN) &&
-      (itti_desc.threads[thread_id].events[i].data.fd ==
-       itti_desc.threads[thread_id].task_event_fd)) {
-      struct message_list_s *message = NULL;
+      (thread->events[i].events & EPOLLIN) &&
+      (thread->events[i].data.fd == thread->task_event_fd)) {
       eventfd_t sem_counter;
       ssize_t read_ret;
-      int result;
 
       /*
-       * Read will always return 1
+       * The event fd is a plain counter: one read returns and resets all
+       * the signals accumulated since the previous wake-up.
        */
-      read_ret = read(
-        itti_desc.threads[thread_id].task_event_fd,
-        &sem_counter,
-        sizeof(sem_counter));
+      read_ret =
+        read(thread->task_event_fd, &sem_counter, sizeof(sem_counter));
       AssertFatal(
         read_ret == sizeof(sem_counter),
         "Read from task message FD (%d) failed (%d/%d)!\n",
         thread_id,
         (int) read_ret,
         (int) sizeof(sem_counter));
+      /*
+       * Re-arm the senders before draining the queue, so that a message
+       * enqueued after the drain is always signalled again.
+       */
+      __sync_fetch_and_and(&thread->event_fd_signalled, 0);
+      thread->messages_queued = true;
+      /*
+       * Mark that the event has been processed
+       */
+      thread->events[i].events &= ~EPOLLIN;
+    } else {
+      task_events++;
+    }
+  }
+  return task_events;
+}
 
-      if (
-        lfds710_queue_bmm_dequeue(
-          &itti_desc.tasks[task_id].message_queue, NULL, (void **) &message) ==
-        0) {
-        /*
-         * No element in list -> this should not happen
-         */
-        AssertFatal(
-          0,
-          "No message in queue for task %d while there are %d events and some "
-          "for the messages queue!\n",
-          task_id,
-          epoll_ret);
-      }
+static inline void itti_receive_msg_internal_event_fd(
+  task_id_t task_id,
+  uint8_t polling,
+  MessageDef **received_msg)
+{
+  thread_id_t thread_id;
+  thread_desc_t *thread;
+  int task_events = 0;
 
-      AssertFatal(message != NULL, "Message from message queue is NULL!\n");
-      *received_msg = message->msg;
-      result = itti_free(ITTI_MSG_ORIGIN_ID(message->msg), message);
-      AssertFatal(
-        result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(received_msg != NULL, "Received message is NULL!\n");
+  thread_id = TASK_GET_THREAD_ID(task_id);
+  thread = &itti_desc.threads[thread_id];
+  *received_msg = NULL;
+
+  while (true) {
+    if (thread->messages_queued && thread->nb_events == 1) {
       /*
-       * Mark that the event has been processed
+       * Messages signalled by a previous wake-up are still queued and the
+       * task has no fd of its own to service: no need to enter the kernel.
        */
-      itti_desc.threads[thread_id].events[i].events &= ~EPOLLIN;
+      thread->epoll_nb_events = 0;
+      task_events = 0;
+    } else {
+      /*
+       * In polling mode, or when messages are already known to be queued,
+       * the timeout is 0 causing epoll_wait to return immediately.
+       * timeout = -1 causes the epoll_wait to wait indefinitely.
+       */
+      task_events = itti_wait_events(
+        task_id, thread_id, (polling || thread->messages_queued) ? 0 : -1);
+    }
+
+    if (thread->messages_queued) {
+      *received_msg = itti_dequeue_msg(task_id);
+      if (*received_msg == NULL) {
+        thread->messages_queued = false;
+      }
+    }
+
+    /*
+     * An empty queue after a wake-up only means that the messages it
+     * signalled were drained by an earlier call, wait again.
+     */
+    if (*received_msg != NULL || task_events > 0 || polling) {
       return;
     }
   }
 }
 
+int itti_receive_msg_batch(
+  task_id_t task_id,
+  MessageDef **received_msgs,
+  int max_msgs)
+{
+  thread_id_t thread_id;
+  thread_desc_t *thread;
+  int task_events = 0;
+  int nb_msgs = 0;
+
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(received_msgs != NULL, "Received messages array is NULL!\n");
+  AssertFatal(max_msgs > 0, "Invalid batch size (%d)!\n", max_msgs);
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME(
+    VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG,
+    __sync_and_and_fetch(&itti_desc.vcd_receive_msg, ~(1L << task_id)));
+  thread_id = TASK_GET_THREAD_ID(task_id);
+  thread = &itti_desc.threads[thread_id];
+
+  while (true) {
+    if (thread->messages_queued && thread->nb_events == 1) {
+      thread->epoll_nb_events = 0;
+      task_events = 0;
+    } else {
+      task_events = itti_wait_events(
+        task_id, thread_id, thread->messages_queued ? 0 : -1);
+    }
+
+    if (thread->messages_queued) {
+      while (nb_msgs < max_msgs) {
+        received_msgs[nb_msgs] = itti_dequeue_msg(task_id);
+        if (received_msgs[nb_msgs] == NULL) {
+          thread->messages_queued = false;
+          break;
+        }
+        nb_msgs++;
+      }
+    }
+
+    if (nb_msgs > 0 || task_events > 0) {
+      break;
+    }
+  }
+
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME(
+    VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG,
+    __sync_or_and_fetch(&itti_desc.vcd_receive_msg, 1L << task_id));
+  return nb_msgs;
+}
+
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg)
 {
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME(
@@ -774,21 +1019,7 @@ void itti_poll_msg(task_id_t task_id, MessageDef **received_msg)
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME(
     VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG,
     __sync_or_and_fetch(&itti_desc.vcd_poll_msg, 1L << task_id));
-  {
-    struct message_list_s *message;
-
-    if (
-      lfds710_queue_bmm_dequeue(
-        &itti_desc.tasks[task_id].message_queue, NULL, (void **) &message) ==
-      1) {
-      int result;
-
-      *received_msg = message->msg;
-      result = itti_free(ITTI_MSG_ORIGIN_ID(*received_msg), message);
-      AssertFatal(
-        result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-    }
-  }
+  *received_msg = itti_dequeue_msg(task_id);
 
   if (*received_msg == NULL) {
     ITTI_DEBUG(
@@ -964,6 +1195,7 @@ int itti_init(
 {
   task_id_t task_id;
   thread_id_t thread_id;
+  itti_priority_level_t level;
 
   itti_desc.message_number = 1;
   ITTI_DEBUG(
@@ -982,6 +1214,7 @@ int itti_init(
   itti_desc.thread_handling_signals = false;
   itti_desc.tasks_info = tasks_info;
   itti_desc.messages_info = messages_info;
+  itti_desc.starvation_limit = ITTI_STARVATION_LIMIT_DEFAULT;
   /*
    * Allocates memory for tasks info
    */
@@ -1017,14 +1250,17 @@ int itti_init(
       " Creating queue of message of size %u\n",
       itti_desc.tasks_info[task_id].queue_size);
 
-    itti_desc.tasks[task_id].qbmme = calloc(
-      itti_desc.tasks_info[task_id].queue_size,
-      sizeof(struct lfds710_queue_bmm_element));
-    lfds710_queue_bmm_init_valid_on_current_logical_core(
-      &itti_desc.tasks[task_id].message_queue,
-      itti_desc.tasks[task_id].qbmme,
-      itti_desc.tasks_info[task_id].queue_size,
-      NULL);
+    for (level = ITTI_PRIORITY_LEVEL_HIGH; level < ITTI_PRIORITY_LEVEL_MAX;
+         level++) {
+      itti_desc.tasks[task_id].qbmme[level] = calloc(
+        itti_desc.tasks_info[task_id].queue_size,
+        sizeof(struct lfds710_queue_bmm_element));
+      lfds710_queue_bmm_init_valid_on_current_logical_core(
+        &itti_desc.tasks[task_id].message_queue[level],
+        itti_desc.tasks[task_id].qbmme[level],
+        itti_desc.tasks_info[task_id].queue_size,
+        NULL);
+    }
   }
 
   /*
@@ -1042,7 +1278,7 @@ int itti_init(
       AssertFatal(0, "Failed to create new epoll fd: %s!\n", strerror(errno));
     }
 
-    itti_desc.threads[thread_id].task_event_fd = eventfd(0, EFD_SEMAPHORE);
+    itti_desc.threads[thread_id].task_event_fd = eventfd(0, 0);
 
     if (itti_desc.threads[thread_id].task_event_fd == -1) {
       /*
@@ -73,6 +73,14 @@ typedef enum message_priorities_e {
   MESSAGE_PRIORITY_MIN = 10,
 } message_priorities_t;
 
+/* Destination queues, a message is queued on the level of its priority */
+typedef enum itti_priority_level_e {
+  ITTI_PRIORITY_LEVEL_HIGH = 0, /* MESSAGE_PRIORITY_MED_PLUS and above */
+  ITTI_PRIORITY_LEVEL_MED,      /* MESSAGE_PRIORITY_MED_LEAST and above */
+  ITTI_PRIORITY_LEVEL_LOW,
+  ITTI_PRIORITY_LEVEL_MAX,
+} itti_priority_level_t;
+
 typedef struct message_info_s {
   task_id_t id;
   message_priorities_t priority;
@@ -125,6 +133,20 @@ int itti_send_msg_to_task(
   instance_t instance,
   MessageDef *message);
 
+/** \brief Set the starvation protection of the priority queues.
+ * A level served that many times in a row while lower levels have messages
+ * waiting yields once to the lower levels.
+ \param starvation_limit Messages served in a row, 0 for strict priority
+ **/
+void itti_set_starvation_limit(uint32_t starvation_limit);
+
+/** \brief Return the number of messages waiting on a priority level
+ \param task_id Task ID of the receiving task
+ \param level Priority level of the queue
+ @returns number of messages waiting
+ **/
+int itti_get_queue_depth(task_id_t task_id, itti_priority_level_t level);
+
 /** \brief Add a new fd to monitor.
  * NOTE: it is up to the user to read data associated with the fd
  *  \param task_id Task ID of the receiving task
@@ -152,6 +174,19 @@ int itti_get_events(task_id_t task_id, struct epoll_event **events);
  **/
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg);
 
+/** \brief Retrieves up to max_msgs messages in the queue associated to task_id.
+ * If the queue is empty, the thread is blocked till a new message arrives or
+ * an event is pending on a fd subscribed by the task (see itti_get_events).
+ \param task_id Task ID of the receiving task
+ \param received_msgs Array of at least max_msgs message pointers
+ \param max_msgs Maximum number of messages to dequeue
+ @returns the number of messages stored in received_msgs
+ **/
+int itti_receive_msg_batch(
+  task_id_t task_id,
+  MessageDef **received_msgs,
+  int max_msgs);
+
 /** \brief Try to retrieves a message in the queue associated to task_id.
  \param task_id Task ID of the receiving task
  \param received_msg Pointer to the allocated message
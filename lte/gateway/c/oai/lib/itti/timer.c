@@ -27,6 +27,15 @@
  * either expressed or implied, of the FreeBSD Project.
  */
 
+/*
+ * Timers are kept in a hierarchical timing wheel, see timer_wheel.h, driven
+ * by a single timerfd ticking every TIMER_WHEEL_TICK_MS.
+ *
+ * Timer ids index a table of timer elements, the upper bits hold a
+ * generation number so that a stale id never matches a recycled element.
+ */
+
+#define _GNU_SOURCE
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,78 +45,267 @@
 #include <signal.h>
 #include <time.h>
 #include <errno.h>
+#include <unistd.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
 
 #include "intertask_interface.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "log.h"
 #include "queue.h"
 #include "dynamic_memory_check.h"
 #include "assertions.h"
 #include "timer_messages_types.h"
 
-int timer_handle_signal(siginfo_t *info);
+#define TIMER_WHEEL_TICK_MS 10
+
+#define TIMER_TABLE_CHUNK_SIZE 4096
+#define TIMER_ID_INDEX_BITS 32
+#define TIMER_ID_INDEX_MASK ((1UL << TIMER_ID_INDEX_BITS) - 1)
+#define TIMER_ID_GENERATION_MASK 0x7fffffffU
+
+typedef enum timer_state_e {
+  TIMER_STATE_FREE = 0,
+  TIMER_STATE_ARMED,   ///< Linked in a wheel slot
+  TIMER_STATE_EXPIRED, ///< One shot timer fired, waiting for the task
+} timer_state_t;
 
 struct timer_elm_s {
+  timer_wheel_entry_t wheel_entry; ///< Wheel linkage, first for _timer_expired
   task_id_t task_id; ///< Task ID which has requested the timer
   int32_t instance;  ///< Instance of the task which has requested the timer
-  timer_t timer;     ///< Unique timer id
+  long timer_id;     ///< Unique timer id
   timer_type_t type; ///< Timer type
   void *timer_arg; ///< Optional argument that will be passed when timer expires
-  STAILQ_ENTRY(timer_elm_s) entries; ///< Pointer to next element
+  timer_state_t state;
+  uint32_t index;      ///< Position in the timer table
+  uint32_t generation; ///< Incremented each time the element is recycled
+  uint64_t interval;   ///< Period in ticks
+  LIST_ENTRY(timer_elm_s) entries; ///< Free list linkage
 };
 
+LIST_HEAD(timer_list_head, timer_elm_s);
+
 typedef struct timer_desc_s {
-  STAILQ_HEAD(timer_list_head, timer_elm_s) timer_queue;
   pthread_mutex_t timer_list_mutex;
-  struct timespec timeout;
+
+  timer_wheel_t wheel;
+
+  struct timer_elm_s **chunks;
+  uint32_t nb_chunks;
+  struct timer_list_head free_list;
+
+  int timer_fd;
+  bool timer_fd_armed;
+  struct timespec start;
+  pthread_t thread;
 } timer_desc_t;
 
 static timer_desc_t timer_desc;
 
-static int _timer_delete_helper(struct timer_elm_s *timer_p);
-static struct timer_elm_s *_find_timer(long timer_id);
+static uint64_t _timer_now_tick(void)
+{
+  struct timespec now;
+  int64_t elapsed_ns;
 
-#define TIMER_SEARCH(vAR, tIMERfIELD, tIMERvALUE, tIMERqUEUE)                  \
-  do {                                                                         \
-    STAILQ_FOREACH(vAR, tIMERqUEUE, entries)                                   \
-    {                                                                          \
-      if (((vAR)->tIMERfIELD == tIMERvALUE)) break;                            \
-    }                                                                          \
-  } while (0)
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsed_ns = (int64_t)(now.tv_sec - timer_desc.start.tv_sec) * 1000000000 +
+               (now.tv_nsec - timer_desc.start.tv_nsec);
+  return (uint64_t) elapsed_ns / (TIMER_WHEEL_TICK_MS * 1000000);
+}
 
-int timer_handle_signal(siginfo_t *info)
+// The timerfd only ticks while at least one timer is armed
+static void _timer_fd_arm(bool arm)
+{
+  struct itimerspec its = {{0}};
+
+  if (arm == timer_desc.timer_fd_armed) {
+    return;
+  }
+  if (arm) {
+    its.it_value.tv_nsec = TIMER_WHEEL_TICK_MS * 1000000;
+    its.it_interval.tv_nsec = TIMER_WHEEL_TICK_MS * 1000000;
+  }
+  if (timerfd_settime(timer_desc.timer_fd, 0, &its, NULL) < 0) {
+    OAILOG_ERROR(
+      LOG_ITTI,
+      "Failed to %s timer fd: (%s:%d)\n",
+      arm ? "arm" : "disarm",
+      strerror(errno),
+      errno);
+    return;
+  }
+  timer_desc.timer_fd_armed = arm;
+}
+
+static void _timer_arm(struct timer_elm_s *timer_p)
+{
+  if (timer_desc.wheel.nb_entries == 0) {
+    // The wheel is empty, skip the ticks elapsed while it was idle
+    timer_desc.wheel.next_tick = _timer_now_tick();
+    _timer_fd_arm(true);
+  }
+  timer_p->state = TIMER_STATE_ARMED;
+  timer_wheel_insert(&timer_desc.wheel, &timer_p->wheel_entry);
+}
+
+static void _timer_disarm(struct timer_elm_s *timer_p)
+{
+  timer_wheel_remove(&timer_desc.wheel, &timer_p->wheel_entry);
+  timer_p->state = TIMER_STATE_EXPIRED;
+  if (timer_desc.wheel.nb_entries == 0) {
+    _timer_fd_arm(false);
+  }
+}
+
+static void _timer_notify_expiry(struct timer_elm_s *timer_p)
 {
-  struct timer_elm_s *timer_p;
   MessageDef *message_p;
   timer_has_expired_t *timer_expired_p;
-  task_id_t task_id;
-  int32_t instance;
 
-  /*
-   * Get back pointer to timer list element
-   */
-  timer_p = (struct timer_elm_s *) info->si_ptr;
-  // LG: To many traces for msc timer:
-  // TMR_DEBUG("Timer with id 0x%lx has expired", (long)timer_p->timer);
-  task_id = timer_p->task_id;
-  instance = timer_p->instance;
   message_p = itti_alloc_new_message(TASK_TIMER, TIMER_HAS_EXPIRED);
   timer_expired_p = &message_p->ittiMsg.timer_has_expired;
-  timer_expired_p->timer_id = (long) timer_p->timer;
+  timer_expired_p->timer_id = timer_p->timer_id;
   timer_expired_p->arg = timer_p->timer_arg;
 
   /*
    * Notify task of timer expiry
    */
-  if (itti_send_msg_to_task(task_id, instance, message_p) < 0) {
+  if (itti_send_msg_to_task(timer_p->task_id, timer_p->instance, message_p) <
+      0) {
     OAILOG_DEBUG(
-      LOG_ITTI, "Failed to send msg TIMER_HAS_EXPIRED to task %u\n", task_id);
-    itti_free(TASK_TIMER, message_p);
-    return -1;
+      LOG_ITTI,
+      "Failed to send msg TIMER_HAS_EXPIRED to task %u\n",
+      timer_p->task_id);
   }
+}
 
-  return 0;
+// Called by the wheel with the mutex held, the entry is already unlinked
+static void _timer_expired(
+  timer_wheel_t *wheel,
+  timer_wheel_entry_t *entry,
+  __attribute__((unused)) void *ctx)
+{
+  struct timer_elm_s *timer_p = (struct timer_elm_s *) entry;
+
+  _timer_notify_expiry(timer_p);
+  if (timer_p->type == TIMER_PERIODIC) {
+    entry->expiry += timer_p->interval;
+    timer_wheel_insert(wheel, entry);
+  } else {
+    timer_p->state = TIMER_STATE_EXPIRED;
+  }
+}
+
+// Processes every tick up to now, must be called with the mutex held
+static void _timer_wheel_advance(void)
+{
+  timer_wheel_advance(
+    &timer_desc.wheel, _timer_now_tick(), _timer_expired, NULL);
+  if (timer_desc.wheel.nb_entries == 0) {
+    _timer_fd_arm(false);
+  }
+}
+
+static void *_timer_thread(__attribute__((unused)) void *args)
+{
+  uint64_t expirations;
+  ssize_t read_ret;
+
+  while (1) {
+    read_ret = read(timer_desc.timer_fd, &expirations, sizeof(expirations));
+    if (read_ret < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      OAILOG_ERROR(
+        LOG_ITTI,
+        "Failed to read timer fd: (%s:%d)\n",
+        strerror(errno),
+        errno);
+      break;
+    }
+    pthread_mutex_lock(&timer_desc.timer_list_mutex);
+    _timer_wheel_advance();
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+  }
+  return NULL;
+}
+
+// Takes an element from the free list, growing the table if needed
+static struct timer_elm_s *_timer_alloc(void)
+{
+  struct timer_elm_s *timer_p;
+  struct timer_elm_s **chunks;
+  uint32_t i;
+
+  if (LIST_EMPTY(&timer_desc.free_list)) {
+    chunks = realloc(
+      timer_desc.chunks, (timer_desc.nb_chunks + 1) * sizeof(*chunks));
+    if (chunks == NULL) {
+      return NULL;
+    }
+    timer_desc.chunks = chunks;
+    chunks[timer_desc.nb_chunks] =
+      calloc(TIMER_TABLE_CHUNK_SIZE, sizeof(struct timer_elm_s));
+    if (chunks[timer_desc.nb_chunks] == NULL) {
+      return NULL;
+    }
+    for (i = TIMER_TABLE_CHUNK_SIZE; i > 0; i--) {
+      timer_p = &chunks[timer_desc.nb_chunks][i - 1];
+      timer_p->index = timer_desc.nb_chunks * TIMER_TABLE_CHUNK_SIZE + i - 1;
+      LIST_INSERT_HEAD(&timer_desc.free_list, timer_p, entries);
+    }
+    timer_desc.nb_chunks++;
+  }
+
+  timer_p = LIST_FIRST(&timer_desc.free_list);
+  LIST_REMOVE(timer_p, entries);
+  timer_p->generation = (timer_p->generation + 1) & TIMER_ID_GENERATION_MASK;
+  if (timer_p->generation == 0) {
+    timer_p->generation = 1;
+  }
+  timer_p->timer_id =
+    ((long) timer_p->generation << TIMER_ID_INDEX_BITS) | timer_p->index;
+  return timer_p;
+}
+
+static void _timer_free(struct timer_elm_s *timer_p)
+{
+  timer_p->state = TIMER_STATE_FREE;
+  timer_p->timer_arg = NULL;
+  LIST_INSERT_HEAD(&timer_desc.free_list, timer_p, entries);
+}
+
+// Helper function to find a timer, must be called with the mutex held
+static struct timer_elm_s *_find_timer(long timer_id)
+{
+  struct timer_elm_s *timer_p;
+  uint64_t index = (uint64_t) timer_id & TIMER_ID_INDEX_MASK;
+
+  if (timer_id <= 0 || index >= (uint64_t) timer_desc.nb_chunks *
+                                  TIMER_TABLE_CHUNK_SIZE) {
+    return NULL;
+  }
+  timer_p = &timer_desc.chunks[index / TIMER_TABLE_CHUNK_SIZE]
+                              [index % TIMER_TABLE_CHUNK_SIZE];
+  if (timer_p->state == TIMER_STATE_FREE || timer_p->timer_id != timer_id) {
+    return NULL;
+  }
+  return timer_p;
+}
+
+// Unlinks the timer and releases its element, must be called with the mutex held
+static void *_timer_delete_helper(struct timer_elm_s *timer_p)
+{
+  void *timer_arg = timer_p->timer_arg;
+
+  if (timer_p->state == TIMER_STATE_ARMED) {
+    _timer_disarm(timer_p);
+  }
+  _timer_free(timer_p);
+  return timer_arg;
 }
 
 int timer_setup(
@@ -120,10 +318,9 @@ int timer_setup(
   size_t arg_size,
   long *timer_id)
 {
-  struct sigevent se;
-  struct itimerspec its;
   struct timer_elm_s *timer_p;
-  timer_t timer;
+  void *arg_copy = NULL;
+  uint64_t interval_ms;
 
   if (timer_id == NULL) {
     return -1;
@@ -134,80 +331,47 @@ int timer_setup(
     "Invalid timer type (%d/%d)!\n",
     type,
     TIMER_TYPE_MAX);
-  /*
-   * Allocate new timer list element
-   */
-  timer_p = calloc(1, sizeof(struct timer_elm_s));
 
-  if (timer_p == NULL) {
-    OAILOG_ERROR(LOG_ITTI, "Failed to create new timer element\n");
-    return -1;
-  }
-
-  memset(&timer, 0, sizeof(timer_t));
-  memset(&se, 0, sizeof(struct sigevent));
-  timer_p->task_id = task_id;
-  timer_p->instance = instance;
-  timer_p->type = type;
   // copy timer_arg if it exists
   if (timer_arg != NULL) {
-    void *arg_copy = calloc(1, arg_size);
+    arg_copy = calloc(1, arg_size);
     if (arg_copy == NULL) {
       OAILOG_ERROR(LOG_ITTI, "Failed to copy timer argument\n");
-      free_wrapper((void **) &timer_p);
       return -1;
     }
     memcpy(arg_copy, timer_arg, arg_size);
-    timer_p->timer_arg = arg_copy;
   }
 
   /*
-   * Setting up alarm
-   */
-  /*
-   * Set and enable alarm
+   * Round up to the wheel resolution
    */
-  se.sigev_notify = SIGEV_SIGNAL;
-  se.sigev_signo = SIGTIMER;
-  se.sigev_value.sival_ptr = timer_p;
+  interval_ms = (uint64_t) interval_sec * 1000 + (interval_us + 999) / 1000;
 
-  /*
-   * At the timer creation, the timer structure will be filled in with timer_id,
-   * * * which is unique for this process. This id is allocated by kernel and the
-   * * * value might be used to distinguish timers.
-   */
-  if (timer_create(CLOCK_REALTIME, &se, &timer) < 0) {
-    OAILOG_ERROR(
-      LOG_ITTI, "Failed to create timer: (%s:%d)\n", strerror(errno), errno);
-    free_wrapper((void **) &timer_p);
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  timer_p = _timer_alloc();
+  if (timer_p == NULL) {
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+    OAILOG_ERROR(LOG_ITTI, "Failed to create new timer element\n");
+    free_wrapper(&arg_copy);
     return -1;
   }
-
-  /*
-   * Fill in the first expiration value.
-   */
-  its.it_value.tv_sec = interval_sec;
-  its.it_value.tv_nsec = interval_us * 1000;
-
-  if (type == TIMER_PERIODIC) {
-    /*
-     * Asked for periodic timer. We set the interval time
-     */
-    its.it_interval.tv_sec = interval_sec;
-    its.it_interval.tv_nsec = interval_us * 1000;
-  } else {
-    /*
-     * Asked for one-shot timer. Do not set the interval field
-     */
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
+  timer_p->task_id = task_id;
+  timer_p->instance = instance;
+  timer_p->type = type;
+  timer_p->timer_arg = arg_copy;
+  timer_p->interval =
+    (interval_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+  if (timer_p->interval == 0) {
+    timer_p->interval = 1;
   }
-
-  timer_settime(timer, 0, &its, NULL);
+  timer_p->wheel_entry.expiry = _timer_now_tick() + timer_p->interval;
+  _timer_arm(timer_p);
   /*
    * Simply set the timer_id argument. so it can be used by caller
    */
-  *timer_id = (long) timer;
+  *timer_id = timer_p->timer_id;
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+
   OAILOG_INFO(
     LOG_ITTI,
     "Requesting new %s timer with id 0x%lx that expires within "
@@ -216,50 +380,9 @@ int timer_setup(
     *timer_id,
     interval_sec,
     interval_us);
-  timer_p->timer = timer;
-  /*
-   * Lock the queue and insert the timer at the tail
-   */
-  pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  STAILQ_INSERT_TAIL(&timer_desc.timer_queue, timer_p, entries);
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
   return 0;
 }
 
-// Helper function to delete a timer from queue and cleanup associated resources
-static int _timer_delete_helper(struct timer_elm_s *timer_p)
-{
-  int rc = TIMER_OK;
-  pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-
-  if (timer_delete(timer_p->timer) < 0) {
-    OAILOG_ERROR(
-      LOG_ITTI, "Failed to delete timer 0x%lx\n", (long) timer_p->timer);
-    rc = TIMER_ERR;
-  }
-
-  free_wrapper(&timer_p->timer_arg);
-  free_wrapper((void **) &timer_p);
-  timer_p = NULL;
-  return rc;
-}
-
-// Helper function to find a timer in the queue
-static struct timer_elm_s *_find_timer(long timer_id)
-{
-  struct timer_elm_s *timer_p = NULL;
-  pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  TIMER_SEARCH(timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
-
-  if (timer_p == NULL) {
-    OAILOG_ERROR(LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
-  }
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-  return timer_p;
-}
-
 /**
  * Called when another actor gets a message that a timer has expired.
  * If the timer is a one shot timer, then the timer is removed. If it is
@@ -267,17 +390,27 @@ static struct timer_elm_s *_find_timer(long timer_id)
  */
 int timer_handle_expired(long timer_id)
 {
+  struct timer_elm_s *timer_p;
+  void *timer_arg;
+
   OAILOG_INFO(LOG_ITTI, "timer 0x%lx expired \n", timer_id);
-  struct timer_elm_s *timer_p = _find_timer(timer_id);
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  timer_p = _find_timer(timer_id);
   if (timer_p == NULL) {
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+    OAILOG_ERROR(LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
     return TIMER_NOT_FOUND;
   }
 
   if (timer_p->type == TIMER_ONE_SHOT) {
+    timer_arg = _timer_delete_helper(timer_p);
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
     OAILOG_INFO(
       LOG_ITTI, "Timer 0x%lx expiry signal received, deleting\n", timer_id);
-    return _timer_delete_helper(timer_p);
+    free_wrapper(&timer_arg);
+    return TIMER_OK;
   }
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
 
   OAILOG_INFO(
     LOG_ITTI,
@@ -288,17 +421,25 @@ int timer_handle_expired(long timer_id)
 
 bool timer_exists(long timer_id)
 {
-  return _find_timer(timer_id) != NULL;
+  bool exists;
+
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  exists = _find_timer(timer_id) != NULL;
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+  if (!exists) {
+    OAILOG_ERROR(LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
+  }
+  return exists;
 }
 
 int timer_remove(long timer_id, void **arg)
 {
-  int rc = 0;
   struct timer_elm_s *timer_p;
+  void *timer_arg;
 
   OAILOG_DEBUG(LOG_ITTI, "Removing timer 0x%lx\n", timer_id);
   pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  TIMER_SEARCH(timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
+  timer_p = _find_timer(timer_id);
 
   /*
    * We didn't find the timer in list
@@ -310,28 +451,42 @@ int timer_remove(long timer_id, void **arg)
     return -1;
   }
 
-  STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
+  timer_arg = _timer_delete_helper(timer_p);
   pthread_mutex_unlock(&timer_desc.timer_list_mutex);
 
   // let user of API get back arg that can be an allocated memory (memory leak).
-
-  if (arg) *arg = timer_p->timer_arg;
-  if (timer_delete(timer_p->timer) < 0) {
-    OAILOG_ERROR(
-      LOG_ITTI, "Failed to delete timer 0x%lx\n", (long) timer_p->timer);
-    rc = -1;
-  }
-
-  free_wrapper((void **) &timer_p);
-  return rc;
+  if (arg) *arg = timer_arg;
+  return 0;
 }
 
 int timer_init(void)
 {
   OAILOG_DEBUG(LOG_ITTI, "Initializing TIMER task interface\n");
   memset(&timer_desc, 0, sizeof(timer_desc_t));
-  STAILQ_INIT(&timer_desc.timer_queue);
   pthread_mutex_init(&timer_desc.timer_list_mutex, NULL);
+  timer_wheel_init(&timer_desc.wheel, 0);
+  LIST_INIT(&timer_desc.free_list);
+  clock_gettime(CLOCK_MONOTONIC, &timer_desc.start);
+
+  timer_desc.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (timer_desc.timer_fd < 0) {
+    OAILOG_ERROR(
+      LOG_ITTI,
+      "Failed to create timer fd: (%s:%d)\n",
+      strerror(errno),
+      errno);
+    return -1;
+  }
+
+  /*
+   * The thread inherits the signal mask set by signal_mask()
+   */
+  if (pthread_create(&timer_desc.thread, NULL, _timer_thread, NULL) != 0) {
+    OAILOG_ERROR(LOG_ITTI, "Failed to create timer thread\n");
+    close(timer_desc.timer_fd);
+    return -1;
+  }
+  pthread_setname_np(timer_desc.thread, "ITTI TIMER");
   OAILOG_DEBUG(LOG_ITTI, "Initializing TIMER task interface: DONE\n");
   return 0;
 }
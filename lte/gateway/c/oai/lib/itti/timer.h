@@ -38,8 +38,6 @@
 
 #include "intertask_interface_types.h"
 
-#define SIGTIMER SIGRTMIN
-
 typedef enum timer_type_s {
   TIMER_PERIODIC,
   TIMER_ONE_SHOT,
@@ -52,8 +50,6 @@ typedef enum {
   TIMER_ERR = -2,
 } timer_result_t;
 
-int timer_handle_signal(siginfo_t *info);
-
 /** \brief Request a new timer
  *  \param interval_sec timer interval in seconds
  *  \param interval_us  timer interval in micro seconds
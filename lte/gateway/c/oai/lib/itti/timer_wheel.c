@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "timer_wheel.h"
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t next_tick)
+{
+  int level;
+  int slot;
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+      LIST_INIT(&wheel->slots[level][slot]);
+    }
+  }
+  wheel->next_tick = next_tick;
+  wheel->nb_entries = 0;
+}
+
+static void _timer_wheel_link(timer_wheel_t *wheel, timer_wheel_entry_t *entry)
+{
+  uint64_t expiry = entry->expiry;
+  int64_t delta = (int64_t)(expiry - wheel->next_tick);
+  int level;
+  int slot;
+
+  if (delta < 0) {
+    // Already due, expire it on the next processed tick
+    level = 0;
+    slot = wheel->next_tick & TIMER_WHEEL_SLOT_MASK;
+  } else {
+    if ((uint64_t) delta > TIMER_WHEEL_MAX_TICKS) {
+      delta = TIMER_WHEEL_MAX_TICKS;
+      expiry = wheel->next_tick + delta;
+      entry->expiry = expiry;
+    }
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+      if ((uint64_t) delta < (1ULL << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) {
+        break;
+      }
+    }
+    slot = (expiry >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+  }
+  LIST_INSERT_HEAD(&wheel->slots[level][slot], entry, entries);
+}
+
+void timer_wheel_insert(timer_wheel_t *wheel, timer_wheel_entry_t *entry)
+{
+  _timer_wheel_link(wheel, entry);
+  wheel->nb_entries++;
+}
+
+void timer_wheel_remove(timer_wheel_t *wheel, timer_wheel_entry_t *entry)
+{
+  LIST_REMOVE(entry, entries);
+  wheel->nb_entries--;
+}
+
+// Detaches the content of a slot into list
+static void _timer_wheel_take_slot(
+  struct timer_wheel_list_head *slot,
+  struct timer_wheel_list_head *list)
+{
+  *list = *slot;
+  if (list->lh_first) {
+    list->lh_first->entries.le_prev = &list->lh_first;
+  }
+  LIST_INIT(slot);
+}
+
+// Moves the entries of an upper level slot down to the lower levels
+static int _timer_wheel_cascade(timer_wheel_t *wheel, int level)
+{
+  struct timer_wheel_list_head list;
+  timer_wheel_entry_t *entry;
+  int slot = (wheel->next_tick >> (level * TIMER_WHEEL_SLOT_BITS)) &
+             TIMER_WHEEL_SLOT_MASK;
+
+  _timer_wheel_take_slot(&wheel->slots[level][slot], &list);
+  while ((entry = LIST_FIRST(&list)) != NULL) {
+    LIST_REMOVE(entry, entries);
+    _timer_wheel_link(wheel, entry);
+  }
+  return slot;
+}
+
+void timer_wheel_advance(
+  timer_wheel_t *wheel,
+  uint64_t now_tick,
+  timer_wheel_expiry_cb_t expiry_cb,
+  void *ctx)
+{
+  struct timer_wheel_list_head list;
+  timer_wheel_entry_t *entry;
+  int index;
+  int level;
+
+  while (wheel->nb_entries > 0 && wheel->next_tick <= now_tick) {
+    index = wheel->next_tick & TIMER_WHEEL_SLOT_MASK;
+    if (index == 0) {
+      for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if (_timer_wheel_cascade(wheel, level) != 0) {
+          break;
+        }
+      }
+    }
+    wheel->next_tick++;
+
+    _timer_wheel_take_slot(&wheel->slots[0][index], &list);
+    while ((entry = LIST_FIRST(&list)) != NULL) {
+      timer_wheel_remove(wheel, entry);
+      expiry_cb(wheel, entry, ctx);
+    }
+  }
+}
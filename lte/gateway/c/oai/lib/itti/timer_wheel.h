@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+#include "queue.h"
+
+/*
+ * Hierarchical timing wheel counting in ticks. Level 0 has one slot per
+ * tick, each upper level has one slot per full turn of the level below.
+ * Entries are cascaded down a level when the lower level wraps, so that
+ * insert, remove and expiry are O(1). The wheel does not read any clock,
+ * its owner advances it.
+ */
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_TICKS                                                  \
+  ((1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1)
+
+typedef struct timer_wheel_entry_s {
+  uint64_t expiry; ///< Tick at which the entry expires
+  LIST_ENTRY(timer_wheel_entry_s) entries;
+} timer_wheel_entry_t;
+
+LIST_HEAD(timer_wheel_list_head, timer_wheel_entry_s);
+
+typedef struct timer_wheel_s {
+  struct timer_wheel_list_head slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t next_tick; ///< Next tick to be processed
+  uint64_t nb_entries;
+} timer_wheel_t;
+
+/*
+ * Called for each expired entry, already unlinked from the wheel. The entry
+ * may be inserted again from the callback, e.g. to re-arm a periodic timer.
+ */
+typedef void (*timer_wheel_expiry_cb_t)(
+  timer_wheel_t *wheel,
+  timer_wheel_entry_t *entry,
+  void *ctx);
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t next_tick);
+
+/** \brief Link an entry in the slot of its expiry tick
+ *  An expiry already due fires on the next processed tick, one further than
+ *  TIMER_WHEEL_MAX_TICKS is clamped.
+ **/
+void timer_wheel_insert(timer_wheel_t *wheel, timer_wheel_entry_t *entry);
+
+void timer_wheel_remove(timer_wheel_t *wheel, timer_wheel_entry_t *entry);
+
+/** \brief Process every tick up to now_tick included
+ *  \param expiry_cb called for each entry expiring on the processed ticks
+ **/
+void timer_wheel_advance(
+  timer_wheel_t *wheel,
+  uint64_t now_tick,
+  timer_wheel_expiry_cb_t expiry_cb,
+  void *ctx);
+
+#endif /* TIMER_WHEEL_H_ */
@@ -69,6 +69,13 @@ void PagingApplication::handle_paging_message(
   struct in_addr dest_ip;
   memcpy(&dest_ip, &ip_header->ip_dst, sizeof(struct in_addr));
   char *dest_ip_str = inet_ntoa(dest_ip);
+  if (is_clamped(dest_ip.s_addr)) {
+    OAILOG_DEBUG(
+      LOG_GTPV1U,
+      "Paging procedure already initiated for IP %s\n",
+      dest_ip_str);
+    return;
+  }
   OAILOG_DEBUG(
     LOG_GTPV1U, "Initiating paging procedure for IP %s\n", dest_ip_str);
   sgw_send_paging_request(&dest_ip);
@@ -94,6 +101,29 @@ void PagingApplication::handle_paging_message(
   return;
 }
 
+bool PagingApplication::is_clamped(uint32_t dest_ip)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto clamping_time = std::chrono::seconds(CLAMPING_TIMEOUT);
+  std::lock_guard<std::mutex> lock(clamped_ips_mutex_);
+
+  auto it = clamped_ips_.find(dest_ip);
+  if (it != clamped_ips_.end() && now - it->second < clamping_time) {
+    return true;
+  }
+  if (clamped_ips_.size() >= MAX_CLAMPED_IPS) {
+    for (auto ip_it = clamped_ips_.begin(); ip_it != clamped_ips_.end();) {
+      if (now - ip_it->second >= clamping_time) {
+        ip_it = clamped_ips_.erase(ip_it);
+      } else {
+        ++ip_it;
+      }
+    }
+  }
+  clamped_ips_[dest_ip] = now;
+  return false;
+}
+
 void PagingApplication::install_default_flow(
   fluid_base::OFConnection *ofconn,
   const OpenflowMessenger &messenger)
@@ -21,6 +21,10 @@
 
 #pragma once
 
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
 #include "OpenflowController.h"
 
 namespace openflow {
@@ -31,6 +35,13 @@ class PagingApplication : public Application {
   static const int MID_PRIORITY = 5;
   // TODO: move to config file
   static const int CLAMPING_TIMEOUT = 30; // seconds
+  // Above this number of clamped IPs, expired ones are purged
+  static const size_t MAX_CLAMPED_IPS = 1024;
+
+  // Time at which paging was last initiated, per destination IP
+  std::unordered_map<uint32_t, std::chrono::steady_clock::time_point>
+    clamped_ips_;
+  std::mutex clamped_ips_mutex_;
   /**
    * Main callback event required by inherited Application class. Whenever
    * the controller gets an event like packet in or switch up, it will pass
@@ -55,6 +66,15 @@ class PagingApplication : public Application {
     uint8_t *data,
     const OpenflowMessenger &messenger);
 
+  /**
+   * Returns true if paging has already been initiated for this IP within the
+   * clamping time. Packets that hit userspace before the clamping flow is
+   * installed are then dropped instead of paging the UE again.
+   *
+   * @param dest_ip (in) - destination IP of the packet, network byte order
+   */
+  bool is_clamped(uint32_t dest_ip);
+
   /**
    * Creates the default paging flow, which sends a packet intended for an
    * idle UE to this application
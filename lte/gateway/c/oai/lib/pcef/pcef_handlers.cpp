@@ -55,10 +55,8 @@ static void create_session_response(
   s5_response->failure_cause = S5_OK;
 
   if (!status.ok()) {
-    struct in_addr addr;
-    //BUFFER_TO_IN_ADDR (sgi_response.paa.ipv4_address, addr);
-    // TODO make asynchronous, or make part of create session call
-    release_ipv4_address(imsi.c_str(), &sgi_response.paa.ipv4_address);
+    // The UE address is released by TASK_SPGW_APP, see
+    // sgw_handle_s5_create_bearer_response()
     s5_response->failure_cause = PCEF_FAILURE;
   }
   itti_send_msg_to_task(TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
@@ -21,6 +21,7 @@
 
 #include <assert.h>
 #include <grpcpp/channel.h>
+#include <grpcpp/impl/codegen/async_unary_call.h>
 #include <grpcpp/impl/codegen/client_context.h>
 #include <grpcpp/impl/codegen/status.h>
 #include <netinet/in.h>
@@ -28,6 +29,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "lte/protos/mobilityd.grpc.pb.h"
 #include "lte/protos/mobilityd.pb.h"
@@ -39,6 +41,7 @@ using grpc::Channel;
 using grpc::ClientContext;
 using grpc::Status;
 using magma::AllocateIPRequest;
+using magma::AsyncLocalResponse;
 using magma::IPAddress;
 using magma::IPBlock;
 using magma::lte::MobilityService;
@@ -105,6 +108,30 @@ int MobilityServiceClient::AllocateIPv4Address(
   return 0;
 }
 
+void MobilityServiceClient::AllocateIPv4AddressAsync(
+  const std::string &imsi,
+  const std::function<void(Status, IPAddress)> &callback)
+{
+  AllocateIPRequest request;
+  request.set_version(AllocateIPRequest::IPV4);
+
+  SubscriberID *sid = request.mutable_sid();
+  sid->set_id(imsi);
+  sid->set_type(SubscriberID::IMSI);
+
+  // Create a raw response pointer that stores a callback to be called when the
+  // gRPC call is answered
+  auto response = new AsyncLocalResponse<IPAddress>(callback, RESPONSE_TIMEOUT);
+  // Create a response reader for the `AllocateIPAddress` RPC call. This reader
+  // stores the client context, the request to pass in, and the queue to add
+  // the response to when done
+  auto response_reader =
+    stub_->AsyncAllocateIPAddress(response->get_context(), request, &queue_);
+  // Set the reader for the response. When the call is answered, the callback
+  // stored in `response` will be called from the response loop
+  response->set_response_reader(std::move(response_reader));
+}
+
 int MobilityServiceClient::ReleaseIPv4Address(
   const std::string &imsi,
   const struct in_addr &addr)
@@ -130,6 +157,26 @@ int MobilityServiceClient::ReleaseIPv4Address(
   return 0;
 }
 
+void MobilityServiceClient::ReleaseIPv4AddressAsync(
+  const std::string &imsi,
+  const struct in_addr &addr,
+  const std::function<void(Status, Void)> &callback)
+{
+  ReleaseIPRequest request;
+  SubscriberID *sid = request.mutable_sid();
+  sid->set_id(imsi);
+  sid->set_type(SubscriberID::IMSI);
+
+  IPAddress *ip = request.mutable_ip();
+  ip->set_version(IPAddress::IPV4);
+  ip->set_address(&addr, sizeof(struct in_addr));
+
+  auto response = new AsyncLocalResponse<Void>(callback, RESPONSE_TIMEOUT);
+  auto response_reader =
+    stub_->AsyncReleaseIPAddress(response->get_context(), request, &queue_);
+  response->set_response_reader(std::move(response_reader));
+}
+
 int MobilityServiceClient::GetIPv4AddressForSubscriber(
   const std::string &imsi,
   struct in_addr *addr)
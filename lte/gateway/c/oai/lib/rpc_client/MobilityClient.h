@@ -25,10 +25,12 @@
 #include <arpa/inet.h>
 #include <grpc++/grpc++.h>
 #include <stdint.h>
+#include <functional>
 #include <memory>
 #include <string>
 
 #include "lte/protos/mobilityd.grpc.pb.h"
+#include "GRPCReceiver.h"
 
 namespace grpc {
 class Channel;
@@ -45,8 +47,11 @@ namespace magma {
 using namespace lte;
 /*
  * gRPC client for MobilityService
+ * Asynchronous calls are answered on the completion queue, one must call the
+ * rpc_response_loop method defined in the GRPCReceiver base class to receive
+ * them
  */
-class MobilityServiceClient {
+class MobilityServiceClient : public GRPCReceiver {
  public:
   explicit MobilityServiceClient(const std::shared_ptr<Channel> &channel);
 
@@ -79,6 +84,18 @@ class MobilityServiceClient {
      */
   int AllocateIPv4Address(const std::string &imsi, struct in_addr *addr);
 
+  /*
+     * Allocate an IPv4 address from the free IP pool without waiting for the
+     * answer, many allocations can be in flight on the same channel
+     *
+     * @param imsi: IMSI string
+     * @param callback: called from the response loop thread with the status
+     * and the allocated IP address in "network byte order"
+     */
+  void AllocateIPv4AddressAsync(
+    const std::string &imsi,
+    const std::function<void(Status, IPAddress)> &callback);
+
   /*
      * Release an allocated IPv4 address.
      *
@@ -92,6 +109,18 @@ class MobilityServiceClient {
      */
   int ReleaseIPv4Address(const std::string &imsi, const struct in_addr &addr);
 
+  /*
+     * Release an allocated IPv4 address without waiting for the answer
+     *
+     * @param imsi: IMSI string
+     * @param addr: IP address to release in "network byte order"
+     * @param callback: called from the response loop thread with the status
+     */
+  void ReleaseIPv4AddressAsync(
+    const std::string &imsi,
+    const struct in_addr &addr,
+    const std::function<void(Status, orc8r::Void)> &callback);
+
   /*
      * Get the allocated IPv4 address for a subscriber
      * @param imsi: IMSI string
@@ -116,6 +145,7 @@ class MobilityServiceClient {
 
  private:
   std::shared_ptr<MobilityService::Stub> stub_;
+  static const uint32_t RESPONSE_TIMEOUT = 10; // seconds
 };
 
 } // namespace magma
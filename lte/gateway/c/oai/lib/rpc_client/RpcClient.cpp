@@ -25,6 +25,8 @@
 #include <string.h>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "MobilityClient.h"
 #include "rpc_client.h"
@@ -36,53 +38,88 @@ class Channel;
 // TODO: MobilityService IP:port config (t14002037)
 #define MOBILITYD_ENDPOINT "localhost:60051"
 
-using grpc::Channel;
-using grpc::ChannelCredentials;
 using grpc::CreateChannel;
 using grpc::InsecureChannelCredentials;
+using magma::IPAddress;
 using magma::MobilityServiceClient;
+using magma::orc8r::Void;
+
+// All the calls share one channel to the MobilityService, asynchronous ones
+// are answered on a thread running the client response loop
+static MobilityServiceClient &get_mobility_client()
+{
+  static MobilityServiceClient client(
+    CreateChannel(MOBILITYD_ENDPOINT, InsecureChannelCredentials()));
+  static std::once_flag response_loop_started;
+
+  std::call_once(response_loop_started, []() {
+    std::thread response_loop_thread([]() { client.rpc_response_loop(); });
+    response_loop_thread.detach();
+  });
+  return client;
+}
+
 
 int get_assigned_ipv4_block(
   int index,
   struct in_addr *netaddr,
   uint32_t *netmask)
 {
-  const std::shared_ptr<ChannelCredentials> cred = InsecureChannelCredentials();
-  const std::shared_ptr<Channel> channel =
-    CreateChannel(MOBILITYD_ENDPOINT, cred);
-  MobilityServiceClient client(channel);
+  MobilityServiceClient &client = get_mobility_client();
   int status = client.GetAssignedIPv4Block(index, netaddr, netmask);
   return status;
 }
 
 int allocate_ipv4_address(const char *subscriber_id, struct in_addr *addr)
 {
-  const std::shared_ptr<ChannelCredentials> cred = InsecureChannelCredentials();
-  const std::shared_ptr<Channel> channel =
-    CreateChannel(MOBILITYD_ENDPOINT, cred);
-  MobilityServiceClient client(channel);
+  MobilityServiceClient &client = get_mobility_client();
   int status = client.AllocateIPv4Address(subscriber_id, addr);
   return status;
 }
 
+void allocate_ipv4_address_async(
+  const char *subscriber_id,
+  void (*callback)(int status, struct in_addr addr, void *callback_arg),
+  void *callback_arg)
+{
+  get_mobility_client().AllocateIPv4AddressAsync(
+    subscriber_id,
+    [callback, callback_arg](const Status &status, const IPAddress &ip_msg) {
+      struct in_addr addr = {0};
+      if (status.ok()) {
+        memcpy(&addr, ip_msg.address().c_str(), sizeof(in_addr));
+      }
+      callback(status.error_code(), addr, callback_arg);
+    });
+}
+
 int release_ipv4_address(const char *subscriber_id, const struct in_addr *addr)
 {
-  const std::shared_ptr<ChannelCredentials> cred = InsecureChannelCredentials();
-  const std::shared_ptr<Channel> channel =
-    CreateChannel(MOBILITYD_ENDPOINT, cred);
-  MobilityServiceClient client(channel);
+  MobilityServiceClient &client = get_mobility_client();
   int status = client.ReleaseIPv4Address(subscriber_id, *addr);
   return status;
 }
 
+void release_ipv4_address_async(
+  const char *subscriber_id,
+  const struct in_addr *addr,
+  void (*callback)(int status, struct in_addr addr, void *callback_arg),
+  void *callback_arg)
+{
+  struct in_addr released = *addr;
+  get_mobility_client().ReleaseIPv4AddressAsync(
+    subscriber_id,
+    released,
+    [released, callback, callback_arg](const Status &status, const Void &) {
+      callback(status.error_code(), released, callback_arg);
+    });
+}
+
 int get_ipv4_address_for_subscriber(
   const char *subscriber_id,
   struct in_addr *addr)
 {
-  const std::shared_ptr<ChannelCredentials> cred = InsecureChannelCredentials();
-  const std::shared_ptr<Channel> channel =
-    CreateChannel(MOBILITYD_ENDPOINT, cred);
-  MobilityServiceClient client(channel);
+  MobilityServiceClient &client = get_mobility_client();
   int status = client.GetIPv4AddressForSubscriber(subscriber_id, addr);
   return status;
 }
@@ -91,10 +128,7 @@ int get_subscriber_id_from_ipv4(
   const struct in_addr *addr,
   char **subscriber_id)
 {
-  const std::shared_ptr<ChannelCredentials> cred = InsecureChannelCredentials();
-  const std::shared_ptr<Channel> channel =
-    CreateChannel(MOBILITYD_ENDPOINT, cred);
-  MobilityServiceClient client(channel);
+  MobilityServiceClient &client = get_mobility_client();
   std::string subscriber_id_str;
   int status = client.GetSubscriberIDFromIPv4(*addr, &subscriber_id_str);
   if (!subscriber_id_str.empty()) {
@@ -73,6 +73,22 @@ int get_assigned_ipv4_block(
  */
 int allocate_ipv4_address(const char *subscriber_id, struct in_addr *addr);
 
+/*
+ * Allocate an IP address from the MobilityService over gRPC without waiting
+ * for the answer. Allocations requested back to back are in flight at the
+ * same time on the MobilityService channel.
+ *
+ * @param subscriber_id: subscriber id string, i.e. IMSI
+ * @param callback: called from the gRPC response thread with the allocation
+ * status (0 or a gRPC status code, as for allocate_ipv4_address) and the
+ * allocated IP address
+ * @param callback_arg: passed back to callback
+ */
+void allocate_ipv4_address_async(
+  const char *subscriber_id,
+  void (*callback)(int status, struct in_addr addr, void *callback_arg),
+  void *callback_arg);
+
 /*
  * Release an allocated IP address.
  *
@@ -86,6 +102,21 @@ int allocate_ipv4_address(const char *subscriber_id, struct in_addr *addr);
  */
 int release_ipv4_address(const char *subscriber_id, const struct in_addr *addr);
 
+/*
+ * Release an allocated IP address without waiting for the answer
+ *
+ * @param subscriber_id: subscriber id string, i.e. IMSI
+ * @param addr: IP address to release
+ * @param callback: called from the gRPC response thread with the release
+ * status (0 or a gRPC status code, as for release_ipv4_address) and addr
+ * @param callback_arg: passed back to callback
+ */
+void release_ipv4_address_async(
+  const char *subscriber_id,
+  const struct in_addr *addr,
+  void (*callback)(int status, struct in_addr addr, void *callback_arg),
+  void *callback_arg);
+
 /*
  * Get the allocated IPv4 address for a subscriber
  * @param subscriber_id: IMSI string
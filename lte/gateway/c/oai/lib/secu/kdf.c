@@ -25,7 +25,6 @@
 
 #include "security_types.h"
 #include "secu_defs.h"
-#include "dynamic_memory_check.h"
 
 void kdf(
   const uint8_t *key,
@@ -35,13 +34,11 @@ void kdf(
   uint8_t *out,
   const unsigned out_len)
 {
-  struct hmac_sha256_ctx *ctx = calloc(1, sizeof(struct hmac_sha256_ctx));
+  struct hmac_sha256_ctx ctx;
 
-  //memset (&ctx, 0, sizeof (ctx));
-  hmac_sha256_set_key(ctx, key_len, key);
-  hmac_sha256_update(ctx, s_len, s);
-  hmac_sha256_digest(ctx, out_len, out);
-  free_wrapper((void **) &ctx);
+  hmac_sha256_set_key(&ctx, key_len, key);
+  hmac_sha256_update(&ctx, s_len, s);
+  hmac_sha256_digest(&ctx, out_len, out);
 }
 
 int derive_keNB(
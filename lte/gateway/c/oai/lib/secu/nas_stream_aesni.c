@@ -0,0 +1,330 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "assertions.h"
+#include "conversions.h"
+#include "secu_defs.h"
+#include "nas_stream_aesni.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+/*
+ * Multi-buffer AES-128: each lane runs one job with its own key, the lanes
+ * are interleaved round by round so that the latency of an AESENC is hidden
+ * behind the ones of the other lanes. A lane takes the next job as soon as
+ * its job is done.
+ * The kernels are compiled for AES-NI with a target attribute and only called
+ * once nas_stream_aesni_supported() is true.
+ */
+#define NAS_STREAM_AESNI_LANES 8
+#define NAS_STREAM_AESNI_TARGET __attribute__((target("aes,sse2")))
+
+typedef struct {
+  __m128i state;
+  nas_stream_job_t *job;
+  const nas_stream_key_t *key;
+  uint32_t length; /* bytes of the message, for EIA2 with the 8 bytes header */
+  uint32_t block;  /* next block */
+  uint32_t nb_blocks;
+  uint64_t iv;
+  uint8_t header[8]; /* EIA2 */
+} nas_stream_lane_t;
+
+/*
+ * Keys expanded for the jobs without a precomputed key, one per lane slot.
+ * A slot is only reused by the next job of the same slot, the lanes moved to
+ * a lower slot once there is no job left keep pointing to their own key.
+ */
+typedef nas_stream_key_t nas_stream_lane_keys_t[NAS_STREAM_AESNI_LANES];
+
+bool nas_stream_aesni_supported(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2");
+}
+
+static inline uint8_t _nas_stream_iv_byte(const nas_stream_cipher_t *sc)
+{
+  return ((sc->bearer & 0x1F) << 3) | ((sc->direction & 0x01) << 2);
+}
+
+static inline void _nas_stream_lane_key(
+  nas_stream_lane_t *const lane,
+  nas_stream_key_t *const expanded_key)
+{
+  nas_stream_job_t *job = lane->job;
+
+  if (job->stream_key) {
+    lane->key = job->stream_key;
+  } else {
+    nas_stream_key_init(
+      expanded_key, job->stream_cipher.key, job->stream_cipher.key_length);
+    lane->key = expanded_key;
+  }
+}
+
+/* Encrypt the state of each lane in place */
+NAS_STREAM_AESNI_TARGET static inline void _nas_stream_aesni_encrypt(
+  nas_stream_lane_t *const lanes,
+  const uint32_t nb_lanes)
+{
+  for (uint32_t l = 0; l < nb_lanes; l++) {
+    lanes[l].state = _mm_xor_si128(
+      lanes[l].state,
+      _mm_loadu_si128((const __m128i *) lanes[l].key->round_keys[0]));
+  }
+  for (int r = 1; r < 10; r++) {
+    for (uint32_t l = 0; l < nb_lanes; l++) {
+      lanes[l].state = _mm_aesenc_si128(
+        lanes[l].state,
+        _mm_loadu_si128((const __m128i *) lanes[l].key->round_keys[r]));
+    }
+  }
+  for (uint32_t l = 0; l < nb_lanes; l++) {
+    lanes[l].state = _mm_aesenclast_si128(
+      lanes[l].state,
+      _mm_loadu_si128((const __m128i *) lanes[l].key->round_keys[10]));
+  }
+}
+
+/*
+ * EEA2: AES-128 in counter mode, the 128 bits counter block starts with
+ * COUNT, BEARER and DIRECTION, then zeros, see TS 33.401 annex B.1.3.
+ */
+static inline bool _nas_stream_eea2_start(
+  nas_stream_lane_t *const lane,
+  nas_stream_job_t *const job,
+  nas_stream_key_t *const expanded_key)
+{
+  uint32_t count = hton_int32(job->stream_cipher.count);
+  uint8_t iv[8] = {0};
+
+  lane->job = job;
+  lane->length = (job->stream_cipher.blength + 7) >> 3;
+  if (lane->length == 0) return false;
+  memcpy(iv, &count, 4);
+  iv[4] = _nas_stream_iv_byte(&job->stream_cipher);
+  memcpy(&lane->iv, iv, 8);
+  lane->block = 0;
+  lane->nb_blocks = (lane->length + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+  _nas_stream_lane_key(lane, expanded_key);
+  return true;
+}
+
+NAS_STREAM_AESNI_TARGET static inline void _nas_stream_eea2_xor(
+  nas_stream_lane_t *const lane)
+{
+  const uint8_t *in = lane->job->stream_cipher.message;
+  uint8_t *out = lane->job->out;
+  uint32_t offset = lane->block * AES_BLOCK_SIZE;
+  uint32_t n = lane->length - offset;
+
+  if (n >= AES_BLOCK_SIZE) {
+    _mm_storeu_si128(
+      (__m128i *) (out + offset),
+      _mm_xor_si128(
+        lane->state, _mm_loadu_si128((const __m128i *) (in + offset))));
+  } else {
+    uint8_t stream[AES_BLOCK_SIZE];
+
+    _mm_storeu_si128((__m128i *) stream, lane->state);
+    for (uint32_t i = 0; i < n; i++) {
+      out[offset + i] = in[offset + i] ^ stream[i];
+    }
+  }
+  lane->block++;
+  if (lane->block == lane->nb_blocks) {
+    uint32_t zero_bit = lane->job->stream_cipher.blength & 0x7;
+
+    if (zero_bit > 0)
+      out[lane->length - 1] &= (uint8_t)(0xFF << (8 - zero_bit));
+  }
+}
+
+NAS_STREAM_AESNI_TARGET void nas_stream_aesni_eea2(
+  nas_stream_job_t *const jobs,
+  const uint32_t nb_jobs)
+{
+  nas_stream_lane_t lanes[NAS_STREAM_AESNI_LANES];
+  nas_stream_lane_keys_t keys;
+  uint32_t nb_lanes = 0;
+  uint32_t next = 0;
+
+  while (nb_lanes < NAS_STREAM_AESNI_LANES && next < nb_jobs) {
+    if (_nas_stream_eea2_start(&lanes[nb_lanes], &jobs[next++], &keys[nb_lanes]))
+      nb_lanes++;
+  }
+  while (nb_lanes > 0) {
+    for (uint32_t l = 0; l < nb_lanes; l++) {
+      /* the counter of the block in the 64 least significant bits */
+      lanes[l].state = _mm_set_epi64x(
+        (int64_t) __builtin_bswap64(lanes[l].block), (int64_t) lanes[l].iv);
+    }
+    _nas_stream_aesni_encrypt(lanes, nb_lanes);
+    for (uint32_t l = 0; l < nb_lanes;) {
+      _nas_stream_eea2_xor(&lanes[l]);
+      if (lanes[l].block < lanes[l].nb_blocks) {
+        l++;
+        continue;
+      }
+      /* job done, take the next one or drop the lane */
+      bool started = false;
+
+      while (!started && next < nb_jobs) {
+        started = _nas_stream_eea2_start(&lanes[l], &jobs[next++], &keys[l]);
+      }
+      if (started) {
+        l++;
+      } else {
+        lanes[l] = lanes[--nb_lanes];
+      }
+    }
+  }
+}
+
+/*
+ * EIA2: AES-128 CMAC over the 8 bytes header (COUNT, BEARER, DIRECTION) and
+ * the message, see TS 33.401 annex B.2.3 and RFC 4493.
+ */
+NAS_STREAM_AESNI_TARGET static inline void _nas_stream_eia2_start(
+  nas_stream_lane_t *const lane,
+  nas_stream_job_t *const job,
+  nas_stream_key_t *const expanded_key)
+{
+  uint32_t count = hton_int32(job->stream_cipher.count);
+
+  lane->job = job;
+  memset(lane->header, 0, sizeof(lane->header));
+  memcpy(lane->header, &count, 4);
+  lane->header[4] = _nas_stream_iv_byte(&job->stream_cipher);
+  lane->length = 8 + ((job->stream_cipher.blength + 7) >> 3);
+  lane->block = 0;
+  lane->nb_blocks = (lane->length + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+  lane->state = _mm_setzero_si128();
+  _nas_stream_lane_key(lane, expanded_key);
+}
+
+/* XOR the next block of the message in the CMAC state of the lane */
+NAS_STREAM_AESNI_TARGET static inline void _nas_stream_eia2_load(
+  nas_stream_lane_t *const lane)
+{
+  const uint8_t *message = lane->job->stream_cipher.message;
+  uint32_t offset = lane->block * AES_BLOCK_SIZE;
+  bool last = (lane->block + 1 == lane->nb_blocks);
+  uint32_t zero_bit = lane->job->stream_cipher.blength & 0x7;
+  __m128i block;
+
+  if (
+    offset >= 8 && offset + AES_BLOCK_SIZE <= lane->length &&
+    !(last && zero_bit > 0)) {
+    block = _mm_loadu_si128((const __m128i *) (message + offset - 8));
+  } else {
+    uint8_t buffer[AES_BLOCK_SIZE] = {0};
+    uint32_t n = lane->length - offset;
+
+    if (n > AES_BLOCK_SIZE) n = AES_BLOCK_SIZE;
+    for (uint32_t i = 0; i < n; i++) {
+      buffer[i] = (offset + i < 8) ? lane->header[offset + i] :
+                                     message[offset + i - 8];
+    }
+    if (last && zero_bit > 0) {
+      /* the padding starts right after the last bit of the message */
+      buffer[n - 1] = (buffer[n - 1] & (uint8_t)(0xFF << (8 - zero_bit))) |
+                      (0x80 >> zero_bit);
+    } else if (n < AES_BLOCK_SIZE) {
+      buffer[n] = 0x80;
+    }
+    block = _mm_loadu_si128((const __m128i *) buffer);
+  }
+  if (last) {
+    const uint8_t *subkey =
+      (lane->length % AES_BLOCK_SIZE == 0 && zero_bit == 0) ?
+        lane->key->cmac_k1 :
+        lane->key->cmac_k2;
+
+    block =
+      _mm_xor_si128(block, _mm_loadu_si128((const __m128i *) subkey));
+  }
+  lane->state = _mm_xor_si128(lane->state, block);
+}
+
+NAS_STREAM_AESNI_TARGET void nas_stream_aesni_eia2(
+  nas_stream_job_t *const jobs,
+  const uint32_t nb_jobs)
+{
+  nas_stream_lane_t lanes[NAS_STREAM_AESNI_LANES];
+  nas_stream_lane_keys_t keys;
+  uint32_t nb_lanes = 0;
+  uint32_t next = 0;
+
+  while (nb_lanes < NAS_STREAM_AESNI_LANES && next < nb_jobs) {
+    _nas_stream_eia2_start(&lanes[nb_lanes], &jobs[next++], &keys[nb_lanes]);
+    nb_lanes++;
+  }
+  while (nb_lanes > 0) {
+    for (uint32_t l = 0; l < nb_lanes; l++) {
+      _nas_stream_eia2_load(&lanes[l]);
+    }
+    _nas_stream_aesni_encrypt(lanes, nb_lanes);
+    for (uint32_t l = 0; l < nb_lanes;) {
+      if (++lanes[l].block < lanes[l].nb_blocks) {
+        l++;
+        continue;
+      }
+      uint8_t mac[AES_BLOCK_SIZE];
+
+      _mm_storeu_si128((__m128i *) mac, lanes[l].state);
+      memcpy(lanes[l].job->out, mac, 4);
+      if (next < nb_jobs) {
+        _nas_stream_eia2_start(&lanes[l], &jobs[next++], &keys[l]);
+        l++;
+      } else {
+        lanes[l] = lanes[--nb_lanes];
+      }
+    }
+  }
+}
+
+#else
+
+bool nas_stream_aesni_supported(void)
+{
+  return false;
+}
+
+void nas_stream_aesni_eea2(nas_stream_job_t *const jobs, const uint32_t nb_jobs)
+{
+  AssertFatal(0, "AES-NI engine not available\n");
+}
+
+void nas_stream_aesni_eia2(nas_stream_job_t *const jobs, const uint32_t nb_jobs)
+{
+  AssertFatal(0, "AES-NI engine not available\n");
+}
+
+#endif
@@ -19,36 +19,20 @@
  *      contact@openairinterface.org
  */
 
-#ifndef SUPPORTED_CODEC_LIST_H_
-#define SUPPORTED_CODEC_LIST_H_
-#include <stdint.h>
+#ifndef FILE_NAS_STREAM_AESNI_SEEN
+#define FILE_NAS_STREAM_AESNI_SEEN
 
-#define SUPPORTED_CODEC_LIST_NUMBER_OF_SYSTEM_INDICATION                       \
-  2 /*Taking consideration of GERAN and UTRAN*/
-#define SUPPORTED_CODEC_LIST_MINIMUM_LENGTH 5
-#define SUPPORTED_CODEC_LIST_MAXIMUM_LENGTH                                    \
-  ((4 * SUPPORTED_CODEC_LIST_NUMBER_OF_SYSTEM_INDICATION) + 1)
+#include <stdbool.h>
+#include <stdint.h>
 
-typedef struct SupportedCodecList_tag {
-  uint8_t systemidentification;
-  uint8_t lengthofbitmap;
-  uint16_t codecbitmap;
-} SupportedCodecList[SUPPORTED_CODEC_LIST_NUMBER_OF_SYSTEM_INDICATION];
+#include "secu_defs.h"
 
-int encode_supported_codec_list(
-  SupportedCodecList *supportedcodeclist,
-  uint8_t iei,
-  uint8_t *buffer,
-  uint32_t len);
+/* Whether the CPU supports the AES-NI instructions */
+bool nas_stream_aesni_supported(void);
 
-int decode_supported_codec_list(
-  SupportedCodecList *supportedcodeclist,
-  uint8_t iei,
-  uint8_t *buffer,
-  uint32_t len);
+/* EEA2 and EIA2 of a batch of jobs, several jobs interleaved */
+void nas_stream_aesni_eea2(nas_stream_job_t *const jobs, const uint32_t nb_jobs);
 
-void dump_supported_codec_list_xml(
-  SupportedCodecList *supportedcodeclist,
-  uint8_t iei);
+void nas_stream_aesni_eia2(nas_stream_job_t *const jobs, const uint32_t nb_jobs);
 
-#endif /* SUPPORTED CODEC LIST_H_ */
+#endif /* FILE_NAS_STREAM_AESNI_SEEN */
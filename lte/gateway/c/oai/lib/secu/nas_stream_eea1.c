@@ -28,29 +28,22 @@
 #include "conversions.h"
 #include "secu_defs.h"
 #include "snow3g.h"
-#include "dynamic_memory_check.h"
 
 int nas_stream_encrypt_eea1(
   nas_stream_cipher_t *const stream_cipher,
   uint8_t *const out)
 {
   snow_3g_context_t snow_3g_context;
-  int n;
-  int i = 0;
   uint32_t zero_bit = 0;
-  //uint32_t                                byte_length;
-  uint32_t *KS;
+  uint32_t byte_length;
   uint32_t K[4], IV[4];
-  uint32_t len = 0;
 
   DevAssert(stream_cipher != NULL);
   DevAssert(stream_cipher->key != NULL);
   DevAssert(stream_cipher->key_length == 16);
   DevAssert(out != NULL);
-  n = (stream_cipher->blength + 31) / 32;
   zero_bit = stream_cipher->blength & 0x7;
-  //byte_length = stream_cipher->blength >> 3;
-  memset(&snow_3g_context, 0, sizeof(snow_3g_context));
+  byte_length = (stream_cipher->blength + 7) >> 3;
   /*
    * Initialisation
    */
@@ -81,44 +74,24 @@ int nas_stream_encrypt_eea1(
   IV[1] = IV[3];
   IV[0] = IV[2];
   /*
-   * Run SNOW 3G algorithm to generate sequence of key stream bits KS
+   * Run SNOW 3G algorithm and exclusive-OR the input data with the key
+   * stream, one word at a time, to generate the output bit stream
    */
   snow3g_initialize(K, IV, &snow_3g_context);
-  KS = (uint32_t *) calloc(1, 4 * n);
-  snow3g_generate_key_stream(n, (uint32_t *) KS, &snow_3g_context);
+  snow3g_start_key_stream(&snow_3g_context);
 
-  if (zero_bit > 0) {
-    KS[n - 1] = KS[n - 1] & (uint32_t)(0xFFFFFFFF << (8 - zero_bit));
-  }
-
-  for (i = 0; i < n; i++) {
-    KS[i] = hton_int32(KS[i]);
-  }
+  for (uint32_t i = 0; i < byte_length; i += 4) {
+    uint32_t ks = snow3g_next_key_word(&snow_3g_context);
+    uint32_t n = byte_length - i < 4 ? byte_length - i : 4;
 
-  /*
-   * Exclusive-OR the input data with keystream to generate the output bit
-   * stream
-   */
-  for (i = 0; i < n * 4; i++) {
-    stream_cipher->message[i] ^= *(((uint8_t *) KS) + i);
+    for (uint32_t j = 0; j < n; j++) {
+      out[i + j] = stream_cipher->message[i + j] ^ (uint8_t)(ks >> (24 - 8 * j));
+    }
   }
 
-  int ceil_index = 0;
-
-  if (zero_bit > 0) {
-    ceil_index = (stream_cipher->blength + 7) >> 3;
-    stream_cipher->message[ceil_index - 1] =
-      stream_cipher->message[ceil_index - 1] &
-      (uint8_t)(0xFF << (8 - zero_bit));
-  }
-
-  free_wrapper((void **) &KS);
-  len = sizeof(out);
-  memset(out, 0, len);
-  memcpy(out, stream_cipher->message, n * 4);
-
   if (zero_bit > 0) {
-    out[ceil_index - 1] = stream_cipher->message[ceil_index - 1];
+    out[byte_length - 1] =
+      out[byte_length - 1] & (uint8_t)(0xFF << (8 - zero_bit));
   }
 
   return 0;
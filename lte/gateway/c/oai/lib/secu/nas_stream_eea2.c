@@ -23,35 +23,50 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
-#include <nettle/nettle-meta.h>
-#include <nettle/ctr.h>
+#include <nettle/aes.h>
 
 #include "assertions.h"
 #include "conversions.h"
 #include "secu_defs.h"
-#include "dynamic_memory_check.h"
 
 int nas_stream_encrypt_eea2(
   nas_stream_cipher_t *const stream_cipher,
   uint8_t *const out)
 {
-  uint8_t m[16];
+  nas_stream_key_t stream_key;
+
+  DevAssert(stream_cipher != NULL);
+  nas_stream_key_init(
+    &stream_key, stream_cipher->key, stream_cipher->key_length);
+  return nas_stream_encrypt_eea2_with_key(stream_cipher, &stream_key, out);
+}
+
+/*!
+   @brief AES-128 in counter mode with a precomputed key schedule, the stream
+          is XORed into out block by block without any intermediate buffer.
+   @param[in] stream_cipher Structure containing various variables to setup encoding
+   @param[in] stream_key Key schedule of stream_cipher->key
+   @param[out] out Ciphered message, of the same length as the message
+*/
+int nas_stream_encrypt_eea2_with_key(
+  nas_stream_cipher_t *const stream_cipher,
+  const nas_stream_key_t *const stream_key,
+  uint8_t *const out)
+{
+  uint8_t m[AES_BLOCK_SIZE];
+  uint8_t stream[AES_BLOCK_SIZE];
   uint32_t local_count;
-  void *ctx;
-  uint8_t *data;
   uint32_t zero_bit = 0;
   uint32_t byte_length;
-  uint32_t len = 0;
 
   DevAssert(stream_cipher != NULL);
+  DevAssert(stream_key != NULL && stream_key->valid);
   DevAssert(out != NULL);
   zero_bit = stream_cipher->blength & 0x7;
   byte_length = stream_cipher->blength >> 3;
 
   if (zero_bit > 0) byte_length += 1;
 
-  ctx = malloc(nettle_aes128.context_size);
-  data = calloc(1, byte_length);
   local_count = hton_int32(stream_cipher->count);
   memset(m, 0, sizeof(m));
   memcpy(&m[0], &local_count, 4);
@@ -60,26 +75,24 @@ int nas_stream_encrypt_eea2(
   /*
    * Other bits are 0
    */
-  nettle_aes128.set_encrypt_key(
-    ctx, stream_cipher->key_length, stream_cipher->key);
+  for (uint32_t offset = 0; offset < byte_length; offset += AES_BLOCK_SIZE) {
+    uint32_t block_length = byte_length - offset;
 
-  nettle_ctr_crypt(
-    ctx,
-    nettle_aes128.encrypt,
-    nettle_aes128.block_size,
-    m,
-    byte_length,
-    data,
-    stream_cipher->message);
+    if (block_length > AES_BLOCK_SIZE) block_length = AES_BLOCK_SIZE;
+    aes_encrypt(&stream_key->aes, AES_BLOCK_SIZE, stream, m);
+    for (uint32_t i = 0; i < block_length; i++) {
+      out[offset + i] = stream_cipher->message[offset + i] ^ stream[i];
+    }
+    /*
+     * Increment the 128 bits counter block
+     */
+    for (int i = AES_BLOCK_SIZE - 1; i >= 0 && ++m[i] == 0; i--)
+      ;
+  }
 
   if (zero_bit > 0)
-    data[byte_length - 1] =
-      data[byte_length - 1] & (uint8_t)(0xFF << (8 - zero_bit));
+    out[byte_length - 1] =
+      out[byte_length - 1] & (uint8_t)(0xFF << (8 - zero_bit));
 
-  len = sizeof(out);
-  memset(out, 0, len);
-  memcpy(out, data, byte_length);
-  free_wrapper((void **) &data);
-  free_wrapper((void **) &ctx);
   return 0;
 }
@@ -21,7 +21,6 @@
 
 #include <stdint.h>
 #include <string.h>
-#include <math.h> // double ceil(double x);
 
 #include "secu_defs.h"
 #include "conversions.h"
@@ -63,10 +62,9 @@ uint64_t MUL64x(uint64_t V, uint64_t c)
 */
 uint64_t MUL64xPOW(uint64_t V, uint32_t i, uint64_t c)
 {
-  if (i == 0)
-    return V;
-  else
-    return MUL64x(MUL64xPOW(V, i - 1, c), c);
+  while (i--) V = MUL64x(V, c);
+
+  return V;
 }
 
 /* MUL64.
@@ -83,27 +81,34 @@ uint64_t MUL64(uint64_t V, uint64_t P, uint64_t c)
   uint64_t result = 0;
   int i = 0;
 
+  /*
+   * V is doubled along the bits of P, rather than computing MUL64xPOW(V, i, c)
+   * for each bit
+   */
   for (i = 0; i < 64; i++) {
-    if ((P >> i) & 0x1) result ^= MUL64xPOW(V, i, c);
+    if ((P >> i) & 0x1) result ^= V;
+    V = MUL64x(V, c);
   }
 
   return result;
 }
 
-/* mask32bit.
-  Input n: an integer in 1-32.
-  Output : a 32 bit mask.
-  Prepares a 32 bit mask with required number of 1 bits on the MSB side.
+/* Load the 64-bit block of the message at offset, most significant byte
+   first, padded with zeros past the end of the message.
 */
-uint32_t mask32bit(int n)
+static uint64_t _eia1_load64(
+  const uint8_t *const message,
+  uint32_t byte_length,
+  uint32_t offset)
 {
-  uint32_t mask = 0x0;
+  uint64_t block = 0;
 
-  if (n % 32 == 0) return 0xffffffff;
-
-  while (n--) mask = (mask >> 1) ^ 0x80000000;
+  for (int i = 0; i < 8; i++) {
+    block <<= 8;
+    if (offset + i < byte_length) block |= message[offset + i];
+  }
 
-  return mask;
+  return block;
 }
 
 /*!
@@ -126,12 +131,8 @@ int nas_stream_encrypt_eia1(
   uint64_t c;
   uint64_t M_D_2;
   int rem_bits;
-  uint32_t mask = 0;
-  uint32_t *message;
+  uint32_t byte_length = (stream_cipher->blength + 7) >> 3;
 
-  message =
-    (uint32_t *)
-      stream_cipher->message; /* To operate 32 bit message internally. */
   /*
    * Load the Integrity Key for SNOW3G initialization as in section 4.4.
    */
@@ -187,7 +188,7 @@ int nas_stream_encrypt_eia1(
   /*
    * Calculation
    */
-  D = ceil(stream_cipher->blength / 64.0) + 1;
+  D = (stream_cipher->blength + 63) / 64 + 1;
   //printf ("D:%d\n",D);
   EVAL = 0;
   c = 0x1b;
@@ -196,10 +197,8 @@ int nas_stream_encrypt_eia1(
    * for 0 <= i <= D-3
    */
   for (i = 0; i < D - 2; i++) {
-    V = EVAL ^ ((uint64_t) hton_int32(message[2 * i]) << 32 |
-                (uint64_t) hton_int32(message[2 * i + 1]));
+    V = EVAL ^ _eia1_load64(stream_cipher->message, byte_length, 8 * i);
     EVAL = MUL64(V, P, c);
-    //printf ("Mi: %16X %16X\tEVAL: %16lX\n",hton_int32(message[2*i]),hton_int32(message[2*i+1]), EVAL);
   }
 
   /*
@@ -209,14 +208,9 @@ int nas_stream_encrypt_eia1(
 
   if (rem_bits == 0) rem_bits = 64;
 
-  mask = mask32bit(rem_bits % 32);
+  M_D_2 = _eia1_load64(stream_cipher->message, byte_length, 8 * (D - 2));
 
-  if (rem_bits > 32) {
-    M_D_2 = ((uint64_t) hton_int32(message[2 * (D - 2)]) << 32) |
-            (uint64_t)(hton_int32(message[2 * (D - 2) + 1]) & mask);
-  } else {
-    M_D_2 = ((uint64_t) hton_int32(message[2 * (D - 2)]) & mask) << 32;
-  }
+  if (rem_bits < 64) M_D_2 &= ~(0xffffffffffffffffULL >> rem_bits);
 
   V = EVAL ^ M_D_2;
   EVAL = MUL64(V, P, c);
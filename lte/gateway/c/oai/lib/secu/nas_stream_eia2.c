@@ -23,16 +23,78 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
-#include <openssl/cmac.h>
-#include <openssl/evp.h>
-#include <openssl/ossl_typ.h>
+#include <nettle/aes.h>
 
 #include "secu_defs.h"
 #include "assertions.h"
 #include "conversions.h"
-#include "dynamic_memory_check.h"
 #include "log.h"
 
+/* Running CMAC over the message, the last block is kept until the final */
+typedef struct {
+  const nas_stream_key_t *key;
+  uint8_t x[AES_BLOCK_SIZE];
+  uint8_t block[AES_BLOCK_SIZE];
+  uint32_t block_length;
+} cmac_state_t;
+
+static void _cmac_update(
+  cmac_state_t *const state,
+  const uint8_t *data,
+  uint32_t length)
+{
+  while (length > 0) {
+    if (state->block_length == AES_BLOCK_SIZE) {
+      for (int i = 0; i < AES_BLOCK_SIZE; i++) {
+        state->x[i] ^= state->block[i];
+      }
+      aes_encrypt(&state->key->aes, AES_BLOCK_SIZE, state->x, state->x);
+      state->block_length = 0;
+    }
+    uint32_t n = AES_BLOCK_SIZE - state->block_length;
+
+    if (n > length) n = length;
+    memcpy(&state->block[state->block_length], data, n);
+    state->block_length += n;
+    data += n;
+    length -= n;
+  }
+}
+
+/*
+ * The last zero_bit bits of the last byte are the end of the message, the
+ * padding starts right after them and not at the next byte.
+ */
+static void _cmac_final(
+  cmac_state_t *const state,
+  const uint32_t zero_bit,
+  uint8_t *const mac)
+{
+  const uint8_t *subkey = state->key->cmac_k1;
+
+  if (zero_bit > 0) {
+    uint8_t *last = &state->block[state->block_length - 1];
+
+    *last = (*last & (uint8_t)(0xFF << (8 - zero_bit))) | (0x80 >> zero_bit);
+    memset(
+      &state->block[state->block_length],
+      0,
+      AES_BLOCK_SIZE - state->block_length);
+    subkey = state->key->cmac_k2;
+  } else if (state->block_length < AES_BLOCK_SIZE) {
+    state->block[state->block_length] = 0x80;
+    memset(
+      &state->block[state->block_length + 1],
+      0,
+      AES_BLOCK_SIZE - state->block_length - 1);
+    subkey = state->key->cmac_k2;
+  }
+  for (int i = 0; i < AES_BLOCK_SIZE; i++) {
+    state->x[i] ^= state->block[i] ^ subkey[i];
+  }
+  aes_encrypt(&state->key->aes, AES_BLOCK_SIZE, mac, state->x);
+}
+
 /*!
    @brief Create integrity cmac t for a given message.
    @param[in] stream_cipher Structure containing various variables to setup encoding
@@ -42,18 +104,37 @@ int nas_stream_encrypt_eia2(
   nas_stream_cipher_t *const stream_cipher,
   uint8_t const out[4])
 {
-  uint8_t *m = NULL;
+  nas_stream_key_t stream_key;
+
+  DevAssert(stream_cipher != NULL);
+  DevAssert(stream_cipher->key != NULL);
+  DevAssert(stream_cipher->key_length > 0);
+  nas_stream_key_init(
+    &stream_key, stream_cipher->key, stream_cipher->key_length);
+  return nas_stream_encrypt_eia2_with_key(stream_cipher, &stream_key, out);
+}
+
+/*!
+   @brief Create integrity cmac t for a given message, with the precomputed
+          key schedule and CMAC subkeys of the key.
+   @param[in] stream_cipher Structure containing various variables to setup encoding
+   @param[in] stream_key Precomputed stream_cipher->key
+   @param[out] out For EIA2 the output string is 32 bits long
+*/
+int nas_stream_encrypt_eia2_with_key(
+  nas_stream_cipher_t *const stream_cipher,
+  const nas_stream_key_t *const stream_key,
+  uint8_t const out[4])
+{
+  uint8_t m[8] = {0};
   uint32_t local_count = 0;
-  size_t size = 4;
-  uint8_t data[16] = {0};
-  CMAC_CTX *cmac_ctx = NULL;
-  const EVP_CIPHER *cipher = EVP_aes_128_cbc();
+  uint8_t data[AES_BLOCK_SIZE] = {0};
+  cmac_state_t state = {.key = stream_key};
   uint32_t zero_bit = 0;
   uint32_t m_length;
 
   DevAssert(stream_cipher != NULL);
-  DevAssert(stream_cipher->key != NULL);
-  DevAssert(stream_cipher->key_length > 0);
+  DevAssert(stream_key != NULL && stream_key->valid);
   DevAssert(out != NULL);
   zero_bit = stream_cipher->blength & 0x7;
   m_length = stream_cipher->blength >> 3;
@@ -61,32 +142,20 @@ int nas_stream_encrypt_eia2(
   if (zero_bit > 0) m_length += 1;
 
   local_count = hton_int32(stream_cipher->count);
-  m = calloc(1, m_length + 8);
   memcpy(&m[0], &local_count, 4);
   m[4] = ((stream_cipher->bearer & 0x1F) << 3) |
          ((stream_cipher->direction & 0x01) << 2);
-  memcpy(&m[8], stream_cipher->message, m_length);
 
   OAILOG_TRACE(
     LOG_NAS, "Byte length: %u, Zero bits: %u:\n", m_length + 8, zero_bit);
-  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "m:", m, m_length + 8);
-  OAILOG_STREAM_HEX(
-    OAILOG_LEVEL_TRACE,
-    LOG_NAS,
-    "Key:",
-    stream_cipher->key,
-    stream_cipher->key_length);
+  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "m:", m, 8);
   OAILOG_STREAM_HEX(
     OAILOG_LEVEL_TRACE, LOG_NAS, "Message:", stream_cipher->message, m_length);
 
-  cmac_ctx = CMAC_CTX_new();
-  CMAC_Init(
-    cmac_ctx, stream_cipher->key, stream_cipher->key_length, cipher, NULL);
-  CMAC_Update(cmac_ctx, m, m_length + 8);
-  CMAC_Final(cmac_ctx, data, &size);
-  CMAC_CTX_free(cmac_ctx);
-  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Out:", data, size);
+  _cmac_update(&state, m, 8);
+  _cmac_update(&state, stream_cipher->message, m_length);
+  _cmac_final(&state, zero_bit, data);
+  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Out:", data, 4);
   memcpy((void *) out, data, 4);
-  free_wrapper((void **) &m);
   return 0;
 }
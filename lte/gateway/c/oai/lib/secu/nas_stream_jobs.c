@@ -0,0 +1,97 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "assertions.h"
+#include "secu_defs.h"
+#include "nas_stream_aesni.h"
+
+#define NAS_STREAM_ENGINE_UNSET (-1)
+
+static int _nas_stream_engine = NAS_STREAM_ENGINE_UNSET;
+
+/*!
+   @brief Engine running EEA2/EIA2, AES-NI when the CPU supports it.
+*/
+nas_stream_engine_t nas_stream_get_engine(void)
+{
+  if (_nas_stream_engine == NAS_STREAM_ENGINE_UNSET) {
+    _nas_stream_engine = nas_stream_aesni_supported() ?
+                           NAS_STREAM_ENGINE_AESNI :
+                           NAS_STREAM_ENGINE_SCALAR;
+  }
+  return (nas_stream_engine_t) _nas_stream_engine;
+}
+
+/*!
+   @brief Force the engine, for tests and benchmarks.
+   @return 0, or -1 if the CPU does not support the engine
+*/
+int nas_stream_set_engine(nas_stream_engine_t engine)
+{
+  if (engine == NAS_STREAM_ENGINE_AESNI && !nas_stream_aesni_supported()) {
+    return -1;
+  }
+  _nas_stream_engine = engine;
+  return 0;
+}
+
+int nas_stream_encrypt_eea2_jobs(
+  nas_stream_job_t *const jobs,
+  const uint32_t nb_jobs)
+{
+  DevAssert(jobs != NULL || nb_jobs == 0);
+  if (nas_stream_get_engine() == NAS_STREAM_ENGINE_AESNI) {
+    nas_stream_aesni_eea2(jobs, nb_jobs);
+    return 0;
+  }
+  for (uint32_t i = 0; i < nb_jobs; i++) {
+    if (jobs[i].stream_key) {
+      nas_stream_encrypt_eea2_with_key(
+        &jobs[i].stream_cipher, jobs[i].stream_key, jobs[i].out);
+    } else {
+      nas_stream_encrypt_eea2(&jobs[i].stream_cipher, jobs[i].out);
+    }
+  }
+  return 0;
+}
+
+int nas_stream_encrypt_eia2_jobs(
+  nas_stream_job_t *const jobs,
+  const uint32_t nb_jobs)
+{
+  DevAssert(jobs != NULL || nb_jobs == 0);
+  if (nas_stream_get_engine() == NAS_STREAM_ENGINE_AESNI) {
+    nas_stream_aesni_eia2(jobs, nb_jobs);
+    return 0;
+  }
+  for (uint32_t i = 0; i < nb_jobs; i++) {
+    if (jobs[i].stream_key) {
+      nas_stream_encrypt_eia2_with_key(
+        &jobs[i].stream_cipher, jobs[i].stream_key, jobs[i].out);
+    } else {
+      nas_stream_encrypt_eia2(&jobs[i].stream_cipher, jobs[i].out);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <nettle/aes.h>
+
+#include "assertions.h"
+#include "rijndael.h"
+#include "secu_defs.h"
+
+/* CMAC subkey shift, RFC 4493 section 2.3 */
+static void _cmac_double(const uint8_t *const in, uint8_t *const out)
+{
+  uint8_t carry = 0;
+
+  for (int i = AES_BLOCK_SIZE - 1; i >= 0; i--) {
+    out[i] = (uint8_t)(in[i] << 1) | carry;
+    carry = in[i] >> 7;
+  }
+  if (carry) out[AES_BLOCK_SIZE - 1] ^= 0x87;
+}
+
+/* AES-128 key expansion, FIPS-197 section 5.2 */
+static void _aes128_expand_round_keys(
+  const uint8_t *const key,
+  uint8_t round_keys[11][AES_BLOCK_SIZE])
+{
+  uint8_t rcon = 0x01;
+
+  memcpy(round_keys[0], key, AES_BLOCK_SIZE);
+  for (int r = 1; r <= 10; r++) {
+    const uint8_t *prev = round_keys[r - 1];
+    uint8_t *rk = round_keys[r];
+
+    rk[0] = prev[0] ^ SR[prev[13]] ^ rcon;
+    rk[1] = prev[1] ^ SR[prev[14]];
+    rk[2] = prev[2] ^ SR[prev[15]];
+    rk[3] = prev[3] ^ SR[prev[12]];
+    for (int i = 4; i < AES_BLOCK_SIZE; i++) {
+      rk[i] = prev[i] ^ rk[i - 4];
+    }
+    rcon = (uint8_t)(rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0);
+  }
+}
+
+/*!
+   @brief Expand the AES-128 key schedule and the CMAC subkeys of a NAS key.
+   @param[out] stream_key Precomputed key, to be rebuilt when the key changes
+   @param[in] key NAS key
+   @param[in] key_length Length of the key in bytes
+*/
+void nas_stream_key_init(
+  nas_stream_key_t *const stream_key,
+  const uint8_t *const key,
+  const uint32_t key_length)
+{
+  uint8_t l[AES_BLOCK_SIZE] = {0};
+
+  DevAssert(stream_key != NULL);
+  DevAssert(key != NULL);
+  DevAssert(key_length == AES_MIN_KEY_SIZE);
+  aes_set_encrypt_key(&stream_key->aes, key_length, key);
+  _aes128_expand_round_keys(key, stream_key->round_keys);
+  aes_encrypt(&stream_key->aes, AES_BLOCK_SIZE, l, l);
+  _cmac_double(l, stream_key->cmac_k1);
+  _cmac_double(stream_key->cmac_k1, stream_key->cmac_k2);
+  stream_key->valid = true;
+}
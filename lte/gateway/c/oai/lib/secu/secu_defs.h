@@ -23,6 +23,8 @@
 #define FILE_SECU_DEFS_SEEN
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <nettle/aes.h>
 
 #include "security_types.h"
 
@@ -80,6 +82,25 @@ typedef struct {
   uint32_t blength;
 } nas_stream_cipher_t;
 
+/*
+ * AES-128 key schedule and CMAC subkeys of a NAS key, expanded once when the
+ * key is derived so that EEA2 and EIA2 run without allocation per message.
+ * Plain data, the structure can be copied along with the key.
+ */
+typedef struct {
+  bool valid;
+  struct aes_ctx aes;
+  /* Round keys in FIPS-197 byte order, for the AES-NI engine */
+  uint8_t round_keys[11][AES_BLOCK_SIZE];
+  uint8_t cmac_k1[AES_BLOCK_SIZE];
+  uint8_t cmac_k2[AES_BLOCK_SIZE];
+} nas_stream_key_t;
+
+void nas_stream_key_init(
+  nas_stream_key_t *const stream_key,
+  const uint8_t *const key,
+  const uint32_t key_length);
+
 int nas_stream_encrypt_eea1(
   nas_stream_cipher_t *const stream_cipher,
   uint8_t *const out);
@@ -96,6 +117,51 @@ int nas_stream_encrypt_eia2(
   nas_stream_cipher_t *const stream_cipher,
   uint8_t const out[4]);
 
+int nas_stream_encrypt_eea2_with_key(
+  nas_stream_cipher_t *const stream_cipher,
+  const nas_stream_key_t *const stream_key,
+  uint8_t *const out);
+
+int nas_stream_encrypt_eia2_with_key(
+  nas_stream_cipher_t *const stream_cipher,
+  const nas_stream_key_t *const stream_key,
+  uint8_t const out[4]);
+
+/*
+ * Batched EEA2/EIA2: each job is one message with its own key, count,
+ * bearer and direction. out receives the ciphered message for EEA2, or the
+ * 32 bits MAC for EIA2. stream_key is the precomputed stream_cipher.key, or
+ * NULL to expand the key for the job.
+ */
+typedef struct {
+  nas_stream_cipher_t stream_cipher;
+  const nas_stream_key_t *stream_key;
+  uint8_t *out;
+} nas_stream_job_t;
+
+/*
+ * The engine running the EEA2/EIA2 batches, selected at runtime: AES-NI when
+ * the CPU supports it, else one message at a time with the nettle based code.
+ * There is no EEA1/EIA1 batch, SNOW 3G runs one message at a time with
+ * nas_stream_encrypt_eea1/eia1.
+ */
+typedef enum {
+  NAS_STREAM_ENGINE_SCALAR = 0,
+  NAS_STREAM_ENGINE_AESNI,
+} nas_stream_engine_t;
+
+nas_stream_engine_t nas_stream_get_engine(void);
+
+int nas_stream_set_engine(nas_stream_engine_t engine);
+
+int nas_stream_encrypt_eea2_jobs(
+  nas_stream_job_t *const jobs,
+  const uint32_t nb_jobs);
+
+int nas_stream_encrypt_eia2_jobs(
+  nas_stream_job_t *const jobs,
+  const uint32_t nb_jobs);
+
 #undef SECU_DEBUG
 
 #endif /* FILE_SECU_DEFS_SEEN */
@@ -82,4 +82,13 @@ void snow3g_generate_key_stream(
   uint32_t *z,
   snow_3g_context_t *snow_3g_context_pP);
 
+/* Word at a time generation of keystream.
+* snow3g_start_key_stream clocks the cipher into keystream mode once after
+* the initialization, then each snow3g_next_key_word returns the next 32-bit
+* word of keystream, z1 first.
+*/
+void snow3g_start_key_stream(snow_3g_context_t *snow_3g_context_pP);
+
+uint32_t snow3g_next_key_word(snow_3g_context_t *snow_3g_context_pP);
+
 #endif
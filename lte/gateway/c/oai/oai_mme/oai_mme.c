@@ -84,6 +84,7 @@ int main(int argc, char *argv[])
 #else
   CHECK_INIT_RETURN(mme_config_parse_opt_line(argc, argv, &mme_config));
 #endif
+  itti_set_starvation_limit(mme_config.itti_config.starvation_limit);
 
 #if DAEMONIZE
   daemon_start();
@@ -176,6 +176,7 @@ void s6a_config_init(s6a_config_t *s6a_conf)
 void itti_config_init(itti_config_t *itti_conf)
 {
   itti_conf->queue_size = ITTI_QUEUE_MAX_ELEMENTS;
+  itti_conf->starvation_limit = ITTI_STARVATION_LIMIT_DEFAULT;
   itti_conf->log_file = NULL;
 }
 
@@ -197,6 +198,8 @@ void nas_config_init(nas_config_t *nas_conf)
   nas_conf->t3486_sec = T3486_DEFAULT_VALUE;
   nas_conf->t3489_sec = T3489_DEFAULT_VALUE;
   nas_conf->t3495_sec = T3495_DEFAULT_VALUE;
+  nas_conf->eps_auth_vectors = EPS_AUTH_VECTORS_DEFAULT_VALUE;
+  nas_conf->auth_vector_ttl_sec = AUTH_VECTOR_TTL_DEFAULT_VALUE;
   nas_conf->force_reject_tau = true;
   nas_conf->force_reject_sr = true;
   nas_conf->disable_esm_information = false;
@@ -596,6 +599,12 @@ int mme_config_parse_file(mme_config_t *config_pP)
             &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+      if ((config_setting_lookup_int(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_STARVATION_LIMIT,
+            &aint))) {
+        config_pP->itti_config.starvation_limit = (uint32_t) aint;
+      }
     }
     // S6A SETTING
     setting =
@@ -1084,6 +1093,19 @@ int mme_config_parse_file(mme_config_t *config_pP)
             setting, MME_CONFIG_STRING_NAS_T3495_TIMER, &aint))) {
         config_pP->nas_config.t3495_sec = (uint32_t) aint;
       }
+      if ((config_setting_lookup_int(
+            setting, MME_CONFIG_STRING_NAS_EPS_AUTH_VECTORS, &aint))) {
+        AssertFatal(
+          (aint >= 1) && (aint <= MAX_EPS_AUTH_VECTORS),
+          "%s must be between 1 and %d",
+          MME_CONFIG_STRING_NAS_EPS_AUTH_VECTORS,
+          MAX_EPS_AUTH_VECTORS);
+        config_pP->nas_config.eps_auth_vectors = (uint8_t) aint;
+      }
+      if ((config_setting_lookup_int(
+            setting, MME_CONFIG_STRING_NAS_AUTH_VECTOR_TTL, &aint))) {
+        config_pP->nas_config.auth_vector_ttl_sec = (uint32_t) aint;
+      }
       if ((config_setting_lookup_string(
             setting,
             MME_CONFIG_STRING_NAS_FORCE_REJECT_TAU,
@@ -1357,6 +1379,10 @@ void mme_config_display(mme_config_t *config_pP)
     LOG_CONFIG,
     "    queue size .......: %u (bytes)\n",
     config_pP->itti_config.queue_size);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    starvation limit .: %u (messages)\n",
+    config_pP->itti_config.starvation_limit);
   OAILOG_INFO(
     LOG_CONFIG,
     "    log file .........: %s\n",
@@ -1449,6 +1475,14 @@ void mme_config_display(mme_config_t *config_pP)
     LOG_CONFIG, "    T3470 ....: %d sec\n", config_pP->nas_config.t3470_sec);
   OAILOG_INFO(
     LOG_CONFIG, "    T3495 ....: %d sec\n", config_pP->nas_config.t3495_sec);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    Auth vectors per AIR .: %d\n",
+    config_pP->nas_config.eps_auth_vectors);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    Auth vector TTL ......: %d sec\n",
+    config_pP->nas_config.auth_vector_ttl_sec);
   OAILOG_INFO(LOG_CONFIG, "    NAS non standard features .:\n");
   OAILOG_INFO(
     LOG_CONFIG,
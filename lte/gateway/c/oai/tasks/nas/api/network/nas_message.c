@@ -1249,7 +1249,16 @@ static int _nas_message_decrypt(
            * length in bits
            */
             stream_cipher.blength = length << 3;
-            nas_stream_encrypt_eea2(&stream_cipher, (uint8_t *) dest);
+            if (!emm_security_context->knas_enc_stream.valid) {
+              nas_stream_key_init(
+                &emm_security_context->knas_enc_stream,
+                emm_security_context->knas_enc,
+                AUTH_KNAS_ENC_SIZE);
+            }
+            nas_stream_encrypt_eea2_with_key(
+              &stream_cipher,
+              &emm_security_context->knas_enc_stream,
+              (uint8_t *) dest);
             /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1431,7 +1440,16 @@ static int _nas_message_encrypt(
          * length in bits
          */
           stream_cipher.blength = length << 3;
-          nas_stream_encrypt_eea2(&stream_cipher, (uint8_t *) dest);
+          if (!emm_security_context->knas_enc_stream.valid) {
+            nas_stream_key_init(
+              &emm_security_context->knas_enc_stream,
+              emm_security_context->knas_enc,
+              AUTH_KNAS_ENC_SIZE);
+          }
+          nas_stream_encrypt_eea2_with_key(
+            &stream_cipher,
+            &emm_security_context->knas_enc_stream,
+            (uint8_t *) dest);
           OAILOG_FUNC_RETURN(LOG_NAS, length);
         } break;
 
@@ -1592,7 +1610,14 @@ static uint32_t _nas_message_get_mac(
        * length in bits
        */
       stream_cipher.blength = length << 3;
-      nas_stream_encrypt_eia2(&stream_cipher, mac);
+      if (!emm_security_context->knas_int_stream.valid) {
+        nas_stream_key_init(
+          &emm_security_context->knas_int_stream,
+          emm_security_context->knas_int,
+          AUTH_KNAS_INT_SIZE);
+      }
+      nas_stream_encrypt_eia2_with_key(
+        &stream_cipher, &emm_security_context->knas_int_stream, mac);
       OAILOG_DEBUG(
         LOG_NAS,
         "NAS_SECURITY_ALGORITHMS_EIA2 returned MAC %x.%x.%x.%x(%u) for length "
@@ -23,6 +23,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "bstrlib.h"
 #include "log.h"
@@ -53,6 +54,7 @@
 #include "emm_fsm.h"
 #include "emm_regDef.h"
 #include "mme_app_desc.h"
+#include "mme_config.h"
 #include "nas_procedures.h"
 #include "s6a_messages_types.h"
 #include "nas/securityDef.h"
@@ -130,8 +132,8 @@ static int _authentication_reject(
  **                                                                        **
  ** Inputs:  ue_id:      UE lower layer identifier                  **
  **      ksi:       NAS key set identifier                     **
- **      rand:      Random challenge number                    **
- **      autn:      Authentication token                       **
+ **      vector_index: Index of the authentication vector used  **
+ **             for the challenge, it is marked as used    **
  **      success:   Callback function executed when the authen-**
  **             tication procedure successfully completes  **
  **      reject:    Callback function executed when the authen-**
@@ -150,8 +152,7 @@ int emm_proc_authentication_ksi(
   struct emm_context_s *emm_context,
   nas_emm_specific_proc_t *const emm_specific_proc,
   ksi_t ksi,
-  const uint8_t *const rand,
-  const uint8_t *const autn,
+  int vector_index,
   success_cb_t success,
   failure_cb_t failure)
 {
@@ -186,13 +187,14 @@ int emm_proc_authentication_ksi(
         }
       }
       auth_proc->ksi = ksi;
-      if (rand) {
-        memcpy(auth_proc->rand, rand, AUTH_RAND_SIZE);
-      }
+      auth_proc->vector_index = vector_index;
+      memcpy(
+        auth_proc->rand, emm_context->_vector[vector_index].rand, AUTH_RAND_SIZE);
       // Set the authentication token
-      if (autn) {
-        memcpy(auth_proc->autn, autn, AUTH_AUTN_SIZE);
-      }
+      memcpy(
+        auth_proc->autn, emm_context->_vector[vector_index].autn, AUTH_AUTN_SIZE);
+      // A vector is only used for one challenge
+      emm_ctx_use_auth_vector(emm_context, vector_index);
       auth_proc->emm_cause = EMM_CAUSE_SUCCESS;
       auth_proc->retransmission_count = 0;
       auth_proc->ue_id = ue_id;
@@ -289,7 +291,9 @@ int emm_proc_authentication(
     auth_proc->emm_com_proc.emm_proc.base_proc.time_out = NULL;
 
     bool run_auth_info_proc = false;
-    if (!IS_EMM_CTXT_VALID_AUTH_VECTORS(emm_context)) {
+    // Serve the authentication from an unused vector of the last AIR if any
+    int vector_index = emm_ctx_get_auth_vector(emm_context);
+    if (vector_index < 0) {
       // Ask upper layer to fetch new security context
       nas_auth_info_proc_t *auth_info_proc =
         get_nas_cn_procedure_auth_info(emm_context);
@@ -306,27 +310,15 @@ int emm_proc_authentication(
         REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
         eksi = (emm_context->_security.eksi + 1) % (EKSI_MAX_VALUE + 1);
       }
-      for (; eksi < MAX_EPS_AUTH_VECTORS; eksi++) {
-        if (IS_EMM_CTXT_VALID_AUTH_VECTOR(
-              emm_context, (eksi % MAX_EPS_AUTH_VECTORS))) {
-          break;
-        }
-      }
-      // eksi should always be 0
-      if (!IS_EMM_CTXT_VALID_AUTH_VECTOR(
-            emm_context, (eksi % MAX_EPS_AUTH_VECTORS))) {
-        run_auth_info_proc = true;
-      } else {
-        rc = emm_proc_authentication_ksi(
-          emm_context,
-          emm_specific_proc,
-          eksi,
-          emm_context->_vector[eksi % MAX_EPS_AUTH_VECTORS].rand,
-          emm_context->_vector[eksi % MAX_EPS_AUTH_VECTORS].autn,
-          success,
-          failure);
-        OAILOG_FUNC_RETURN(LOG_NAS_EMM, rc);
-      }
+      OAILOG_DEBUG(
+        LOG_NAS_EMM,
+        "EMM-PROC  - Authentication with stored vector %d (ue_id="
+        MME_UE_S1AP_ID_FMT ")\n",
+        vector_index,
+        ue_id);
+      rc = emm_proc_authentication_ksi(
+        emm_context, emm_specific_proc, eksi, vector_index, success, failure);
+      OAILOG_FUNC_RETURN(LOG_NAS_EMM, rc);
     }
     if (run_auth_info_proc) {
       rc = _start_authentication_information_procedure(
@@ -376,6 +368,15 @@ static int _start_authentication_information_procedure(
 
   bool is_initial_req = !(auth_info_proc->request_sent);
   auth_info_proc->request_sent = true;
+  // Fetch a batch of vectors, limited by the slots left in the context
+  int nb_vectors = mme_config.nas_config.eps_auth_vectors;
+  int nb_free_vectors = emm_ctx_get_nb_free_auth_vectors(emm_context);
+  if (nb_vectors > nb_free_vectors) {
+    nb_vectors = nb_free_vectors;
+  }
+  if (nb_vectors < 1) {
+    nb_vectors = 1;
+  }
   nas_start_Ts6a_auth_info(
     auth_info_proc->ue_id,
     &auth_info_proc->timer_s6a,
@@ -387,7 +388,7 @@ static int _start_authentication_information_procedure(
     &emm_context->_imsi,
     is_initial_req,
     &visited_plmn,
-    MAX_EPS_AUTH_VECTORS,
+    nb_vectors,
     auts);
 
   OAILOG_FUNC_RETURN(LOG_NAS_EMM, RETURNok);
@@ -445,49 +446,22 @@ static int _auth_info_proc_success_cb(struct emm_context_s *emm_ctx)
     }
 
     /*
-     * Copy provided vector to user context
+     * Copy provided vectors to user context, the unused ones are kept for the
+     * next authentications
      */
-    for (int i = 0; i < auth_info_proc->nb_vectors; i++) {
-      AssertFatal(MAX_EPS_AUTH_VECTORS > i, " TOO many vectors");
-      int destination_index = (i + eksi) % MAX_EPS_AUTH_VECTORS;
-      memcpy(
-        emm_ctx->_vector[destination_index].kasme,
-        auth_info_proc->vector[i]->kasme,
-        AUTH_KASME_SIZE);
-      memcpy(
-        emm_ctx->_vector[destination_index].autn,
-        auth_info_proc->vector[i]->autn,
-        AUTH_AUTN_SIZE);
-      memcpy(
-        emm_ctx->_vector[destination_index].rand,
-        auth_info_proc->vector[i]->rand,
-        AUTH_RAND_SIZE);
-      memcpy(
-        emm_ctx->_vector[destination_index].xres,
-        auth_info_proc->vector[i]->xres.data,
-        auth_info_proc->vector[i]->xres.size);
-      emm_ctx->_vector[destination_index].xres_size =
-        auth_info_proc->vector[i]->xres.size;
-      OAILOG_INFO(LOG_NAS_EMM, "EMM-PROC  - Received Vector %u:\n", i);
-      OAILOG_INFO(
-        LOG_NAS_EMM,
-        "EMM-PROC  - Received XRES ..: " XRES_FORMAT "\n",
-        XRES_DISPLAY(emm_ctx->_vector[destination_index].xres));
-      OAILOG_INFO(
-        LOG_NAS_EMM,
-        "EMM-PROC  - Received RAND ..: " RAND_FORMAT "\n",
-        RAND_DISPLAY(emm_ctx->_vector[destination_index].rand));
-      OAILOG_INFO(
-        LOG_NAS_EMM,
-        "EMM-PROC  - Received AUTN ..: " AUTN_FORMAT "\n",
-        AUTN_DISPLAY(emm_ctx->_vector[destination_index].autn));
-      OAILOG_INFO(
+    AssertFatal(
+      MAX_EPS_AUTH_VECTORS >= auth_info_proc->nb_vectors, " TOO many vectors");
+    int nb_stored = emm_ctx_set_auth_vectors(
+      emm_ctx,
+      auth_info_proc->nb_vectors,
+      auth_info_proc->vector,
+      time(NULL) + mme_config.nas_config.auth_vector_ttl_sec);
+    if (nb_stored < auth_info_proc->nb_vectors) {
+      OAILOG_WARNING(
         LOG_NAS_EMM,
-        "EMM-PROC  - Received KASME .: " KASME_FORMAT " " KASME_FORMAT "\n",
-        KASME_DISPLAY_1(emm_ctx->_vector[destination_index].kasme),
-        KASME_DISPLAY_2(emm_ctx->_vector[destination_index].kasme));
-      emm_ctx_set_attribute_valid(
-        emm_ctx, EMM_CTXT_MEMBER_AUTH_VECTOR0 + destination_index);
+        "EMM-PROC  - Stored %d of %d received vectors\n",
+        nb_stored,
+        auth_info_proc->nb_vectors);
     }
 
     nas_emm_auth_proc_t *auth_proc =
@@ -495,19 +469,9 @@ static int _auth_info_proc_success_cb(struct emm_context_s *emm_ctx)
 
     if (auth_proc) {
       if (auth_info_proc->nb_vectors > 0) {
-        emm_ctx_set_attribute_present(emm_ctx, EMM_CTXT_MEMBER_AUTH_VECTORS);
-
-        for (; eksi < MAX_EPS_AUTH_VECTORS; eksi++) {
-          if (IS_EMM_CTXT_VALID_AUTH_VECTOR(
-                emm_ctx, (eksi % MAX_EPS_AUTH_VECTORS))) {
-            break;
-          }
-        }
-        // eksi should always be 0
-        ksi_t eksi_mod = eksi % MAX_EPS_AUTH_VECTORS;
+        int vector_index = emm_ctx_get_auth_vector(emm_ctx);
         AssertFatal(
-          IS_EMM_CTXT_VALID_AUTH_VECTOR(emm_ctx, eksi_mod),
-          "TODO No valid vector, should not happen");
+          vector_index >= 0, "TODO No valid vector, should not happen");
 
         auth_proc->ksi = eksi;
 
@@ -527,8 +491,7 @@ static int _auth_info_proc_success_cb(struct emm_context_s *emm_ctx)
           emm_ctx,
           (nas_emm_specific_proc_t *) auth_info_proc->cn_proc.base_proc.parent,
           eksi,
-          emm_ctx->_vector[eksi % MAX_EPS_AUTH_VECTORS].rand,
-          emm_ctx->_vector[eksi % MAX_EPS_AUTH_VECTORS].autn,
+          vector_index,
           auth_proc->emm_com_proc.emm_proc.base_proc.success_notif,
           auth_proc->emm_com_proc.emm_proc.base_proc.failure_notif);
 
@@ -690,10 +653,7 @@ int emm_proc_authentication_failure(
             OAILOG_FUNC_RETURN(LOG_NAS_EMM, rc);
           }
 
-          memcpy(
-            resync_param.data,
-            (emm_ctx->_vector[emm_ctx->_security.vector_index].rand),
-            RAND_LENGTH_OCTETS);
+          memcpy(resync_param.data, auth_proc->rand, RAND_LENGTH_OCTETS);
           memcpy(
             (resync_param.data + RAND_LENGTH_OCTETS), auts->data, AUTS_LENGTH);
           // TODO: Double check this case as there is no identity request being sent.
@@ -959,9 +919,10 @@ int emm_proc_authentication_complete(
     REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
     emm_ctx_set_security_eksi(emm_ctx, auth_proc->ksi);
 
-    for (idx = 0; idx < emm_ctx->_vector[auth_proc->ksi].xres_size; idx++) {
+    auth_vector_t *vector = &emm_ctx->_vector[auth_proc->vector_index];
+    for (idx = 0; idx < vector->xres_size; idx++) {
       if (
-        (emm_ctx->_vector[auth_proc->ksi].xres[idx]) !=
+        (vector->xres[idx]) !=
         msg->authenticationresponseparameter->data[idx]) {
         is_val_fail = true;
         break;
@@ -1018,6 +979,8 @@ int emm_proc_authentication_complete(
       LOG_NAS_EMM,
       "EMM-PROC  - Successful authentication of the UE RESP XRES == XRES UE "
       "CONTEXT\n");
+    // The keys of the new security context derive from the KASME of the vector
+    emm_ctx_set_security_vector_index(emm_ctx, auth_proc->vector_index);
 
     /*
    * Notify EMM that the authentication procedure successfully completed
@@ -258,13 +258,24 @@ int emm_proc_security_mode_control(
       derive_key_nas(
         NAS_INT_ALG,
         emm_ctx->_security.selected_algorithms.integrity,
-        emm_ctx->_vector[emm_ctx->_security.eksi % MAX_EPS_AUTH_VECTORS].kasme,
+        emm_ctx->_vector[emm_ctx->_security.vector_index].kasme,
         emm_ctx->_security.knas_int);
       derive_key_nas(
         NAS_ENC_ALG,
         emm_ctx->_security.selected_algorithms.encryption,
-        emm_ctx->_vector[emm_ctx->_security.eksi % MAX_EPS_AUTH_VECTORS].kasme,
+        emm_ctx->_vector[emm_ctx->_security.vector_index].kasme,
         emm_ctx->_security.knas_enc);
+      /*
+       * Expand the new keys once for the NAS messages of the context
+       */
+      nas_stream_key_init(
+        &emm_ctx->_security.knas_int_stream,
+        emm_ctx->_security.knas_int,
+        AUTH_KNAS_INT_SIZE);
+      nas_stream_key_init(
+        &emm_ctx->_security.knas_enc_stream,
+        emm_ctx->_security.knas_enc,
+        AUTH_KNAS_ENC_SIZE);
       /*
        * Set new security context indicator
        */
@@ -44,6 +44,7 @@ Description Defines internal private data handled by EPS Mobility
 #include "hashtable.h"
 #include "obj_hashtable.h"
 #include "nas/securityDef.h"
+#include "secu_defs.h"
 #include "TrackingAreaIdentityList.h"
 #include "emm_fsm.h"
 #include "nas_timer.h"
@@ -80,6 +81,8 @@ typedef struct emm_security_context_s {
   int vector_index;                     /* Pointer on vector */
   uint8_t knas_enc[AUTH_KNAS_ENC_SIZE]; /* NAS cyphering key               */
   uint8_t knas_int[AUTH_KNAS_INT_SIZE]; /* NAS integrity key               */
+  nas_stream_key_t knas_enc_stream;     /* Precomputed knas_enc for EEA2   */
+  nas_stream_key_t knas_int_stream;     /* Precomputed knas_int for EIA2   */
 
   struct count_s {
     uint32_t spare : 8;
@@ -187,11 +190,13 @@ typedef struct emm_context_s {
 #define EMM_CTXT_MEMBER_MOB_STATION_CLSMARK2 ((uint32_t) 1 << 15)
 
 #define EMM_CTXT_MEMBER_AUTH_VECTOR0 ((uint32_t) 1 << 26)
-  //#define           EMM_CTXT_MEMBER_AUTH_VECTOR1                 ((uint32_t)1 << 27)  // reserved bit for AUTH VECTOR
-  //#define           EMM_CTXT_MEMBER_AUTH_VECTOR2                 ((uint32_t)1 << 28)  // reserved bit for AUTH VECTOR
-  //#define           EMM_CTXT_MEMBER_AUTH_VECTOR3                 ((uint32_t)1 << 29)  // reserved bit for AUTH VECTOR
-  //#define           EMM_CTXT_MEMBER_AUTH_VECTOR4                 ((uint32_t)1 << 30)  // reserved bit for AUTH VECTOR
+#define EMM_CTXT_MEMBER_AUTH_VECTOR1 ((uint32_t) 1 << 27)
+#define EMM_CTXT_MEMBER_AUTH_VECTOR2 ((uint32_t) 1 << 28)
+#define EMM_CTXT_MEMBER_AUTH_VECTOR3 ((uint32_t) 1 << 29)
+#define EMM_CTXT_MEMBER_AUTH_VECTOR4 ((uint32_t) 1 << 30)
   //#define           EMM_CTXT_MEMBER_AUTH_VECTOR5                 ((uint32_t)1 << 31)  // reserved bit for AUTH VECTOR
+  // An auth vector is present once received from the HSS, and valid until it
+  // is used in an authentication procedure or expires
 
 #define EMM_CTXT_MEMBER_SET_BIT(eMmCtXtMemBeRmAsK, bIt)                        \
   do {                                                                         \
@@ -226,6 +231,7 @@ typedef struct emm_context_s {
   drx_parameter_t _drx_parameter;
 
   int remaining_vectors; // remaining unused vectors
+  time_t vectors_expiry; // unused vectors are discarded after this time
   auth_vector_t _vector
     [MAX_EPS_AUTH_VECTORS]; /* EPS authentication vector                            */
   emm_security_context_t
@@ -431,8 +437,19 @@ void emm_ctx_set_valid_lvr_tai(emm_context_t *const ctxt, tai_t *lvr_tai)
 
 void emm_ctx_clear_auth_vectors(emm_context_t *const ctxt)
   __attribute__((nonnull)) __attribute__((flatten));
-void emm_ctx_clear_auth_vector(emm_context_t *const ctxt, ksi_t eksi)
+void emm_ctx_clear_auth_vector(emm_context_t *const ctxt, int vector_index)
   __attribute__((nonnull)) __attribute__((flatten));
+int emm_ctx_get_nb_free_auth_vectors(const emm_context_t *const ctxt)
+  __attribute__((nonnull));
+int emm_ctx_set_auth_vectors(
+  emm_context_t *const ctxt,
+  int nb_vectors,
+  eutran_vector_t **vectors,
+  time_t expiry) __attribute__((nonnull));
+int emm_ctx_get_auth_vector(emm_context_t *const ctxt)
+  __attribute__((nonnull));
+void emm_ctx_use_auth_vector(emm_context_t *const ctxt, int vector_index)
+  __attribute__((nonnull));
 void emm_ctx_clear_security(emm_context_t *const ctxt) __attribute__((nonnull))
 __attribute__((flatten));
 void emm_ctx_set_security_type(emm_context_t *const ctxt, emm_sc_type_t sc_type)
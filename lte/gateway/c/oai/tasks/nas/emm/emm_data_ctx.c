@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 #include <sys/types.h>
 
 #include "bstrlib.h"
@@ -330,6 +331,24 @@ inline void emm_ctx_set_valid_lvr_tai(emm_context_t *const ctxt, tai_t *lvr_tai)
   //OAILOG_DEBUG (LOG_NAS_EMM, "ue_id="MME_UE_S1AP_ID_FMT" set last visited registered TAI "TAI_FMT" (valid)\n", (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id, TAI_ARG(&ctxt->_lvr_tai));
 }
 
+//------------------------------------------------------------------------------
+/* Count the valid AUTH vectors, and update the AUTH vectors attribute */
+static void _emm_ctx_update_remaining_vectors(emm_context_t *const ctxt)
+{
+  int remaining_vectors = 0;
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
+      remaining_vectors += 1;
+    }
+  }
+  ctxt->remaining_vectors = remaining_vectors;
+  if (remaining_vectors) {
+    emm_ctx_set_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
+  } else {
+    emm_ctx_clear_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
+  }
+}
+
 //------------------------------------------------------------------------------
 /* Clear AUTH vectors  */
 inline void emm_ctx_clear_auth_vectors(emm_context_t *const ctxt)
@@ -337,8 +356,10 @@ inline void emm_ctx_clear_auth_vectors(emm_context_t *const ctxt)
   emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
   for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
     memset((void *) &ctxt->_vector[i], 0, sizeof(ctxt->_vector[i]));
-    emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0 + i);
+    emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0 << i);
   }
+  ctxt->remaining_vectors = 0;
+  ctxt->vectors_expiry = 0;
   emm_ctx_clear_security_vector_index(ctxt);
   OAILOG_DEBUG(
     LOG_NAS_EMM,
@@ -347,36 +368,158 @@ inline void emm_ctx_clear_auth_vectors(emm_context_t *const ctxt)
 }
 //------------------------------------------------------------------------------
 /* Clear AUTH vector  */
-inline void emm_ctx_clear_auth_vector(emm_context_t *const ctxt, ksi_t eksi)
+inline void emm_ctx_clear_auth_vector(
+  emm_context_t *const ctxt,
+  int vector_index)
 {
-  AssertFatal(eksi < MAX_EPS_AUTH_VECTORS, "Out of bounds eksi %d", eksi);
+  AssertFatal(
+    (0 <= vector_index) && (vector_index < MAX_EPS_AUTH_VECTORS),
+    "Out of bounds vector index %d",
+    vector_index);
   memset(
-    (void *) &ctxt->_vector[eksi % MAX_EPS_AUTH_VECTORS],
+    (void *) &ctxt->_vector[vector_index],
     0,
-    sizeof(ctxt->_vector[eksi % MAX_EPS_AUTH_VECTORS]));
-  emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0 + eksi);
-  int remaining_vectors = 0;
-  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
-    if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
-      remaining_vectors += 1;
-    }
-  }
-  ctxt->remaining_vectors = remaining_vectors;
+    sizeof(ctxt->_vector[vector_index]));
+  emm_ctx_clear_attribute_present(
+    ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0 << vector_index);
+  _emm_ctx_update_remaining_vectors(ctxt);
   OAILOG_DEBUG(
     LOG_NAS_EMM,
-    "ue_id=" MME_UE_S1AP_ID_FMT " cleared auth vector %u \n",
+    "ue_id=" MME_UE_S1AP_ID_FMT " cleared auth vector %d \n",
     (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id,
-    eksi);
-  if (!(remaining_vectors)) {
-    emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
-    emm_ctx_clear_security_vector_index(ctxt);
+    vector_index);
+  if (!(ctxt->remaining_vectors)) {
     OAILOG_DEBUG(
       LOG_NAS_EMM,
-      "ue_id=" MME_UE_S1AP_ID_FMT " cleared auth vectors\n",
+      "ue_id=" MME_UE_S1AP_ID_FMT " no auth vector left\n",
       (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))
         ->mme_ue_s1ap_id);
   }
 }
+//------------------------------------------------------------------------------
+/* A slot can receive a new AUTH vector if its vector is not valid, and is not
+ * the vector of a security context */
+static bool _emm_ctx_is_auth_vector_free(
+  const emm_context_t *const ctxt,
+  int vector_index)
+{
+  return !IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, vector_index) &&
+         (ctxt->_security.vector_index != vector_index) &&
+         (ctxt->_non_current_security.vector_index != vector_index);
+}
+
+//------------------------------------------------------------------------------
+/* Number of AUTH vectors that can be stored */
+int emm_ctx_get_nb_free_auth_vectors(const emm_context_t *const ctxt)
+{
+  int nb_free = 0;
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if (_emm_ctx_is_auth_vector_free(ctxt, i)) {
+      nb_free += 1;
+    }
+  }
+  return nb_free;
+}
+
+//------------------------------------------------------------------------------
+/* Store the AUTH vectors received from the HSS in the free slots, in order.
+ * Returns the number of vectors stored */
+int emm_ctx_set_auth_vectors(
+  emm_context_t *const ctxt,
+  int nb_vectors,
+  eutran_vector_t **vectors,
+  time_t expiry)
+{
+  int nb_stored = 0;
+  for (int i = 0; (i < MAX_EPS_AUTH_VECTORS) && (nb_stored < nb_vectors);
+       i++) {
+    if (!_emm_ctx_is_auth_vector_free(ctxt, i)) {
+      continue;
+    }
+    eutran_vector_t *vector = vectors[nb_stored];
+    memcpy(ctxt->_vector[i].kasme, vector->kasme, AUTH_KASME_SIZE);
+    memcpy(ctxt->_vector[i].autn, vector->autn, AUTH_AUTN_SIZE);
+    memcpy(ctxt->_vector[i].rand, vector->rand, AUTH_RAND_SIZE);
+    memcpy(ctxt->_vector[i].xres, vector->xres.data, vector->xres.size);
+    ctxt->_vector[i].xres_size = vector->xres.size;
+    OAILOG_INFO(
+      LOG_NAS_EMM, "EMM-PROC  - Received Vector %u in slot %d:\n", nb_stored, i);
+    OAILOG_INFO(
+      LOG_NAS_EMM,
+      "EMM-PROC  - Received XRES ..: " XRES_FORMAT "\n",
+      XRES_DISPLAY(ctxt->_vector[i].xres));
+    OAILOG_INFO(
+      LOG_NAS_EMM,
+      "EMM-PROC  - Received RAND ..: " RAND_FORMAT "\n",
+      RAND_DISPLAY(ctxt->_vector[i].rand));
+    OAILOG_INFO(
+      LOG_NAS_EMM,
+      "EMM-PROC  - Received AUTN ..: " AUTN_FORMAT "\n",
+      AUTN_DISPLAY(ctxt->_vector[i].autn));
+    OAILOG_INFO(
+      LOG_NAS_EMM,
+      "EMM-PROC  - Received KASME .: " KASME_FORMAT " " KASME_FORMAT "\n",
+      KASME_DISPLAY_1(ctxt->_vector[i].kasme),
+      KASME_DISPLAY_2(ctxt->_vector[i].kasme));
+    emm_ctx_set_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0 << i);
+    nb_stored += 1;
+  }
+  if (nb_stored) {
+    emm_ctx_set_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
+    ctxt->vectors_expiry = expiry;
+  }
+  _emm_ctx_update_remaining_vectors(ctxt);
+  return nb_stored;
+}
+
+//------------------------------------------------------------------------------
+/* Get the next unused AUTH vector, after discarding the expired vectors.
+ * Returns the vector index, or -1 if no vector is left */
+int emm_ctx_get_auth_vector(emm_context_t *const ctxt)
+{
+  if (ctxt->remaining_vectors && (time(NULL) >= ctxt->vectors_expiry)) {
+    OAILOG_DEBUG(
+      LOG_NAS_EMM,
+      "ue_id=" MME_UE_S1AP_ID_FMT " %d auth vectors expired\n",
+      (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))
+        ->mme_ue_s1ap_id,
+      ctxt->remaining_vectors);
+    for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+      if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
+        emm_ctx_clear_auth_vector(ctxt, i);
+      }
+    }
+  }
+  // Vectors of a batch are stored in order, and a batch is only requested
+  // once the previous one is used up
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+/* Mark an AUTH vector as used by an authentication procedure. The vector
+ * stays present, as its KASME is needed by the security context */
+void emm_ctx_use_auth_vector(emm_context_t *const ctxt, int vector_index)
+{
+  AssertFatal(
+    (0 <= vector_index) && (vector_index < MAX_EPS_AUTH_VECTORS),
+    "Out of bounds vector index %d",
+    vector_index);
+  emm_ctx_clear_attribute_valid(
+    ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0 << vector_index);
+  _emm_ctx_update_remaining_vectors(ctxt);
+  OAILOG_DEBUG(
+    LOG_NAS_EMM,
+    "ue_id=" MME_UE_S1AP_ID_FMT " used auth vector %d, %d remaining\n",
+    (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id,
+    vector_index,
+    ctxt->remaining_vectors);
+}
+
 //------------------------------------------------------------------------------
 /* Clear security  */
 inline void emm_ctx_clear_security(emm_context_t *const ctxt)
@@ -384,6 +527,8 @@ inline void emm_ctx_clear_security(emm_context_t *const ctxt)
   memset(&ctxt->_security, 0, sizeof(ctxt->_security));
   emm_ctx_set_security_type(ctxt, SECURITY_CTX_TYPE_NOT_AVAILABLE);
   emm_ctx_set_security_eksi(ctxt, KSI_NO_KEY_AVAILABLE);
+  // no AUTH vector slot is held by the cleared context
+  emm_ctx_clear_security_vector_index(ctxt);
   ctxt->_security.selected_algorithms.encryption = NAS_SECURITY_ALGORITHMS_EEA0;
   ctxt->_security.selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA0;
   emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_SECURITY);
@@ -448,6 +593,7 @@ inline void emm_ctx_clear_non_current_security(emm_context_t *const ctxt)
   memset(&ctxt->_non_current_security, 0, sizeof(ctxt->_non_current_security));
   ctxt->_non_current_security.sc_type = SECURITY_CTX_TYPE_NOT_AVAILABLE;
   ctxt->_non_current_security.eksi = KSI_NO_KEY_AVAILABLE;
+  ctxt->_non_current_security.vector_index = EMM_SECURITY_VECTOR_INDEX_INVALID;
   ctxt->_non_current_security.selected_algorithms.encryption =
     NAS_SECURITY_ALGORITHMS_EEA0;
   ctxt->_non_current_security.selected_algorithms.integrity =
@@ -277,8 +277,7 @@ int emm_proc_authentication_ksi(
   struct emm_context_s *emm_context,
   nas_emm_specific_proc_t *const emm_specific_proc,
   ksi_t ksi,
-  const uint8_t *const rand,
-  const uint8_t *const autn,
+  int vector_index,
   success_cb_t success,
   failure_cb_t failure);
 
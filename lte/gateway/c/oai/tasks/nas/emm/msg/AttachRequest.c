@@ -28,6 +28,193 @@
 #include "AttachRequest.h"
 #include "UeNetworkCapability.h"
 #include "common_defs.h"
+#include "nas_ie_codec.h"
+
+/*
+ * Optional IEs of the attach request, see table 8.2.4.1, lengths of the whole
+ * IE: IE(name, IEI, presence bit, format, min length, max length (0 when not
+ * bounded), decode, encode)
+ */
+#define ATTACH_REQUEST_OPTIONAL_IES(IE)                                        \
+  IE(OLD_PTMSI_SIGNATURE,                                                      \
+     ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_IEI,                                   \
+     ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT,                               \
+     TV,                                                                       \
+     4,                                                                        \
+     4,                                                                        \
+     decode_p_tmsi_signature_ie(&msg->oldptmsisignature, true, buffer, len),   \
+     encode_p_tmsi_signature_ie(                                               \
+       msg->oldptmsisignature,                                                 \
+       ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_IEI,                                 \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(ADDITIONAL_GUTI,                                                          \
+     ATTACH_REQUEST_ADDITIONAL_GUTI_IEI,                                       \
+     ATTACH_REQUEST_ADDITIONAL_GUTI_PRESENT,                                   \
+     TLV,                                                                      \
+     3,                                                                        \
+     13,                                                                       \
+     decode_eps_mobile_identity(                                               \
+       &msg->additionalguti, ATTACH_REQUEST_ADDITIONAL_GUTI_IEI, buffer, len), \
+     encode_eps_mobile_identity(                                               \
+       &msg->additionalguti, ATTACH_REQUEST_ADDITIONAL_GUTI_IEI, buffer, len)) \
+  IE(LAST_VISITED_REGISTERED_TAI,                                              \
+     ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,                           \
+     ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT,                       \
+     TV,                                                                       \
+     6,                                                                        \
+     6,                                                                        \
+     decode_tracking_area_identity(                                            \
+       &msg->lastvisitedregisteredtai,                                         \
+       ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,                         \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_tracking_area_identity(                                            \
+       &msg->lastvisitedregisteredtai,                                         \
+       ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,                         \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(DRX_PARAMETER,                                                            \
+     ATTACH_REQUEST_DRX_PARAMETER_IEI,                                         \
+     ATTACH_REQUEST_DRX_PARAMETER_PRESENT,                                     \
+     TV,                                                                       \
+     3,                                                                        \
+     3,                                                                        \
+     decode_drx_parameter_ie(&msg->drxparameter, true, buffer, len),           \
+     encode_drx_parameter_ie(                                                  \
+       &msg->drxparameter, ATTACH_REQUEST_DRX_PARAMETER_IEI, buffer, len))     \
+  IE(MS_NETWORK_CAPABILITY,                                                    \
+     ATTACH_REQUEST_MS_NETWORK_CAPABILITY_IEI,                                 \
+     ATTACH_REQUEST_MS_NETWORK_CAPABILITY_PRESENT,                             \
+     TLV,                                                                      \
+     4,                                                                        \
+     10,                                                                       \
+     decode_ms_network_capability_ie(                                          \
+       &msg->msnetworkcapability, true, buffer, len),                          \
+     encode_ms_network_capability_ie(                                          \
+       &msg->msnetworkcapability,                                              \
+       ATTACH_REQUEST_MS_NETWORK_CAPABILITY_IEI,                               \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(OLD_LOCATION_AREA_IDENTIFICATION,                                         \
+     ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,                      \
+     ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT,                  \
+     TV,                                                                       \
+     6,                                                                        \
+     6,                                                                        \
+     decode_location_area_identification_ie(                                  \
+       &msg->oldlocationareaidentification, true, buffer, len),                \
+     encode_location_area_identification_ie(                                  \
+       &msg->oldlocationareaidentification,                                    \
+       ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,                    \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(TMSI_STATUS,                                                              \
+     ATTACH_REQUEST_TMSI_STATUS_IEI,                                           \
+     ATTACH_REQUEST_TMSI_STATUS_PRESENT,                                       \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_tmsi_status(&msg->tmsistatus, true, buffer, len),                  \
+     encode_tmsi_status(                                                       \
+       &msg->tmsistatus, ATTACH_REQUEST_TMSI_STATUS_IEI, buffer, len))         \
+  IE(MOBILE_STATION_CLASSMARK_2,                                               \
+     ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,                            \
+     ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT,                        \
+     TLV,                                                                      \
+     5,                                                                        \
+     5,                                                                        \
+     decode_mobile_station_classmark_2_ie(                                     \
+       &msg->mobilestationclassmark2, true, buffer, len),                      \
+     encode_mobile_station_classmark_2_ie(                                     \
+       &msg->mobilestationclassmark2,                                          \
+       ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,                          \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(MOBILE_STATION_CLASSMARK_3,                                               \
+     ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,                            \
+     ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT,                        \
+     TLV,                                                                      \
+     2,                                                                        \
+     34,                                                                       \
+     decode_mobile_station_classmark_3_ie(                                     \
+       &msg->mobilestationclassmark3, true, buffer, len),                      \
+     encode_mobile_station_classmark_3_ie(                                     \
+       &msg->mobilestationclassmark3,                                          \
+       ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,                          \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(SUPPORTED_CODECS,                                                         \
+     ATTACH_REQUEST_SUPPORTED_CODECS_IEI,                                      \
+     ATTACH_REQUEST_SUPPORTED_CODECS_PRESENT,                                  \
+     TLV,                                                                      \
+     5,                                                                        \
+     0,                                                                        \
+     decode_supported_codec_list(                                              \
+       &msg->supportedcodecs,                                                  \
+       ATTACH_REQUEST_SUPPORTED_CODECS_IEI,                                    \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_supported_codec_list(                                              \
+       &msg->supportedcodecs,                                                  \
+       ATTACH_REQUEST_SUPPORTED_CODECS_IEI,                                    \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(ADDITIONAL_UPDATE_TYPE,                                                   \
+     ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,                                \
+     ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT,                            \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_additional_update_type(                                            \
+       &msg->additionalupdatetype,                                             \
+       ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,                              \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_additional_update_type(                                            \
+       &msg->additionalupdatetype,                                             \
+       ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,                              \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(OLD_GUTI_TYPE,                                                            \
+     ATTACH_REQUEST_OLD_GUTI_TYPE_IEI,                                         \
+     ATTACH_REQUEST_OLD_GUTI_TYPE_PRESENT,                                     \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_guti_type(                                                         \
+       &msg->oldgutitype, ATTACH_REQUEST_OLD_GUTI_TYPE_IEI, buffer, len),      \
+     encode_guti_type(                                                         \
+       &msg->oldgutitype, ATTACH_REQUEST_OLD_GUTI_TYPE_IEI, buffer, len))      \
+  IE(VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING,                             \
+     ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_IEI,          \
+     ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_PRESENT,      \
+     TLV,                                                                      \
+     3,                                                                        \
+     3,                                                                        \
+     decode_voice_domain_preference_and_ue_usage_setting(                      \
+       &msg->voicedomainpreferenceandueusagesetting, true, buffer, len),       \
+     encode_voice_domain_preference_and_ue_usage_setting(                      \
+       &msg->voicedomainpreferenceandueusagesetting, true, buffer, len))       \
+  IE(MS_NETWORK_FEATURE_SUPPORT,                                               \
+     ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_IEI,                            \
+     ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_PRESENT,                        \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_ms_network_feature_support_ie(                                     \
+       &msg->msnetworkfeaturesupport,                                          \
+       ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_IEI,                          \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_ms_network_feature_support_ie(                                     \
+       &msg->msnetworkfeaturesupport,                                          \
+       ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_IEI,                          \
+       buffer,                                                                 \
+       len))
+
+#define NAS_IE_MSG_TYPE attach_request_msg
+NAS_MSG_DESC_DEFINE(_attach_request_desc, ATTACH_REQUEST_OPTIONAL_IES)
 
 int decode_attach_request(
   attach_request_msg *attach_request,
@@ -97,267 +284,15 @@ int decode_attach_request(
   /*
    * Decoding optional fields
    */
-  while (len - decoded > 0) {
-    uint8_t ieiDecoded = *(buffer + decoded);
-
-    /*
-     * Type | value iei are below 0x80 so just return the first 4 bits
-     */
-    if (ieiDecoded >= 0x80) ieiDecoded = ieiDecoded & 0xf0;
-
-    switch (ieiDecoded) {
-      case ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_IEI:
-        if (
-          (decoded_result = decode_p_tmsi_signature_ie(
-             &attach_request->oldptmsisignature,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_ADDITIONAL_GUTI_IEI:
-        if (
-          (decoded_result = decode_eps_mobile_identity(
-             &attach_request->additionalguti,
-             ATTACH_REQUEST_ADDITIONAL_GUTI_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |= ATTACH_REQUEST_ADDITIONAL_GUTI_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI:
-        if (
-          (decoded_result = decode_tracking_area_identity(
-             &attach_request->lastvisitedregisteredtai,
-             ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_DRX_PARAMETER_IEI:
-        if (
-          (decoded_result = decode_drx_parameter_ie(
-             &attach_request->drxparameter,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |= ATTACH_REQUEST_DRX_PARAMETER_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_MS_NETWORK_CAPABILITY_IEI:
-        if (
-          (decoded_result = decode_ms_network_capability_ie(
-             &attach_request->msnetworkcapability,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_MS_NETWORK_CAPABILITY_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI:
-        if (
-          (decoded_result = decode_location_area_identification_ie(
-             &attach_request->oldlocationareaidentification,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_TMSI_STATUS_IEI:
-        if (
-          (decoded_result = decode_tmsi_status(
-             &attach_request->tmsistatus,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |= ATTACH_REQUEST_TMSI_STATUS_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI:
-        if (
-          (decoded_result = decode_mobile_station_classmark_2_ie(
-             &attach_request->mobilestationclassmark2,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI:
-        if (
-          (decoded_result = decode_mobile_station_classmark_3_ie(
-             &attach_request->mobilestationclassmark3,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_SUPPORTED_CODECS_IEI:
-        if (
-          (decoded_result = decode_supported_codec_list(
-             &attach_request->supportedcodecs,
-             ATTACH_REQUEST_SUPPORTED_CODECS_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |= ATTACH_REQUEST_SUPPORTED_CODECS_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI:
-        if (
-          (decoded_result = decode_additional_update_type(
-             &attach_request->additionalupdatetype,
-             ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_OLD_GUTI_TYPE_IEI:
-        if (
-          (decoded_result = decode_guti_type(
-             &attach_request->oldgutitype,
-             ATTACH_REQUEST_OLD_GUTI_TYPE_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |= ATTACH_REQUEST_OLD_GUTI_TYPE_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_IEI:
-        if (
-          (decoded_result = decode_voice_domain_preference_and_ue_usage_setting(
-             &attach_request->voicedomainpreferenceandueusagesetting,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_PRESENT;
-        break;
-
-      case ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_IEI:
-        if (
-          (decoded_result = decode_ms_network_feature_support_ie(
-             &attach_request->msnetworkfeaturesupport,
-             ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0) {
-          //         return decoded_result;
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
-        }
-
-        decoded += decoded_result;
-        /* Set corresponding mask to 1 in presencemask */
-        attach_request->presencemask |=
-          ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_PRESENT;
-        break;
-      default:
-        errorCodeDecoder = TLV_UNEXPECTED_IEI;
-        {
-          OAILOG_FUNC_RETURN(LOG_NAS_EMM, TLV_UNEXPECTED_IEI);
-        }
-    }
-  }
+  if (
+    (decoded_result = nas_decode_optional_ies(
+       &_attach_request_desc,
+       attach_request,
+       buffer + decoded,
+       len - decoded)) < 0) {
+    OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded_result);
+  } else
+    decoded += decoded_result;
 
   OAILOG_FUNC_RETURN(LOG_NAS_EMM, decoded);
 }
@@ -411,223 +346,14 @@ int encode_attach_request(
     encoded += encode_result;
 
   if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT) ==
-    ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT) {
-    if (
-      (encode_result = encode_p_tmsi_signature_ie(
-         attach_request->oldptmsisignature,
-         ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask & ATTACH_REQUEST_ADDITIONAL_GUTI_PRESENT) ==
-    ATTACH_REQUEST_ADDITIONAL_GUTI_PRESENT) {
-    if (
-      (encode_result = encode_eps_mobile_identity(
-         &attach_request->additionalguti,
-         ATTACH_REQUEST_ADDITIONAL_GUTI_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT) ==
-    ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT) {
-    if (
-      (encode_result = encode_tracking_area_identity(
-         &attach_request->lastvisitedregisteredtai,
-         ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask & ATTACH_REQUEST_DRX_PARAMETER_PRESENT) ==
-    ATTACH_REQUEST_DRX_PARAMETER_PRESENT) {
-    if (
-      (encode_result = encode_drx_parameter_ie(
-         &attach_request->drxparameter,
-         ATTACH_REQUEST_DRX_PARAMETER_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_MS_NETWORK_CAPABILITY_PRESENT) ==
-    ATTACH_REQUEST_MS_NETWORK_CAPABILITY_PRESENT) {
-    if (
-      (encode_result = encode_ms_network_capability_ie(
-         &attach_request->msnetworkcapability,
-         ATTACH_REQUEST_MS_NETWORK_CAPABILITY_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT) ==
-    ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT) {
-    if (
-      (encode_result = encode_location_area_identification_ie(
-         &attach_request->oldlocationareaidentification,
-         ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask & ATTACH_REQUEST_TMSI_STATUS_PRESENT) ==
-    ATTACH_REQUEST_TMSI_STATUS_PRESENT) {
-    if (
-      (encode_result = encode_tmsi_status(
-         &attach_request->tmsistatus,
-         ATTACH_REQUEST_TMSI_STATUS_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT) ==
-    ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT) {
-    if (
-      (encode_result = encode_mobile_station_classmark_2_ie(
-         &attach_request->mobilestationclassmark2,
-         ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT) ==
-    ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT) {
-    if (
-      (encode_result = encode_mobile_station_classmark_3_ie(
-         &attach_request->mobilestationclassmark3,
-         ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask & ATTACH_REQUEST_SUPPORTED_CODECS_PRESENT) ==
-    ATTACH_REQUEST_SUPPORTED_CODECS_PRESENT) {
-    if (
-      (encode_result = encode_supported_codec_list(
-         &attach_request->supportedcodecs,
-         ATTACH_REQUEST_SUPPORTED_CODECS_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT) ==
-    ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT) {
-    if (
-      (encode_result = encode_additional_update_type(
-         &attach_request->additionalupdatetype,
-         ATTACH_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask & ATTACH_REQUEST_OLD_GUTI_TYPE_PRESENT) ==
-    ATTACH_REQUEST_OLD_GUTI_TYPE_PRESENT) {
-    if (
-      (encode_result = encode_guti_type(
-         &attach_request->oldgutitype,
-         ATTACH_REQUEST_OLD_GUTI_TYPE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_PRESENT) ==
-    ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_PRESENT) {
-    if (
-      (encode_result = encode_voice_domain_preference_and_ue_usage_setting(
-         &attach_request->voicedomainpreferenceandueusagesetting,
-         true,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (attach_request->presencemask &
-     ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_PRESENT) ==
-    ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_PRESENT) {
-    if (
-      (encode_result = encode_ms_network_feature_support_ie(
-         &attach_request->msnetworkfeaturesupport,
-         ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
+    (encode_result = nas_encode_optional_ies(
+       &_attach_request_desc,
+       attach_request,
+       buffer + encoded,
+       len - encoded)) < 0) //Return in case of error
+    return encode_result;
+  else
+    encoded += encode_result;
 
   return encoded;
 }
@@ -26,6 +26,315 @@
 #include "TrackingAreaUpdateRequest.h"
 #include "UeNetworkCapability.h"
 #include "common_defs.h"
+#include "nas_ie_codec.h"
+
+static int _tracking_area_update_request_skip_voice_domain_preference(void)
+{
+  // Not decoded as we do not use this IE in CSFB
+  return 3; // IEI, length and usage setting flag
+}
+
+/*
+ * Optional IEs of the tracking area update request, see table 8.2.29.1,
+ * lengths of the whole IE: IE(name, IEI, presence bit, format, min length,
+ * max length (0 when not bounded), decode, encode)
+ */
+#define TRACKING_AREA_UPDATE_REQUEST_OPTIONAL_IES(IE)                          \
+  IE(NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER,                                 \
+     TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_IEI, \
+     TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_PRESENT, \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_nas_key_set_identifier(                                            \
+       &msg->noncurrentnativenaskeysetidentifier,                              \
+       TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_IEI, \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_nas_key_set_identifier(                                            \
+       &msg->noncurrentnativenaskeysetidentifier,                              \
+       TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_IEI, \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(GPRS_CIPHERING_KEY_SEQUENCE_NUMBER,                                       \
+     TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_IEI,      \
+     TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_PRESENT,  \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_ciphering_key_sequence_number_ie(                                  \
+       &msg->gprscipheringkeysequencenumber,                                   \
+       TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_IEI,    \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_ciphering_key_sequence_number_ie(                                  \
+       &msg->gprscipheringkeysequencenumber,                                   \
+       TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_IEI,    \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(OLD_PTMSI_SIGNATURE,                                                      \
+     TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_IEI,                     \
+     TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT,                 \
+     TV,                                                                       \
+     4,                                                                        \
+     4,                                                                        \
+     decode_p_tmsi_signature_ie(                                               \
+       &msg->oldptmsisignature,                                                \
+       TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_IEI,                   \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_p_tmsi_signature_ie(                                               \
+       msg->oldptmsisignature,                                                 \
+       TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_IEI,                   \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(ADDITIONAL_GUTI,                                                          \
+     TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_IEI,                         \
+     TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_PRESENT,                     \
+     TLV,                                                                      \
+     3,                                                                        \
+     13,                                                                       \
+     decode_eps_mobile_identity(                                               \
+       &msg->additionalguti,                                                   \
+       TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_IEI,                       \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_eps_mobile_identity(                                               \
+       &msg->additionalguti,                                                   \
+       TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_IEI,                       \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(NONCEUE,                                                                  \
+     TRACKING_AREA_UPDATE_REQUEST_NONCEUE_IEI,                                 \
+     TRACKING_AREA_UPDATE_REQUEST_NONCEUE_PRESENT,                             \
+     TV,                                                                       \
+     5,                                                                        \
+     5,                                                                        \
+     decode_nonce(                                                             \
+       &msg->nonceue, TRACKING_AREA_UPDATE_REQUEST_NONCEUE_IEI, buffer, len),  \
+     encode_nonce(                                                             \
+       &msg->nonceue, TRACKING_AREA_UPDATE_REQUEST_NONCEUE_IEI, buffer, len))  \
+  IE(UE_NETWORK_CAPABILITY,                                                    \
+     TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_IEI,                   \
+     TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_PRESENT,               \
+     TLV,                                                                      \
+     4,                                                                        \
+     15,                                                                       \
+     decode_ue_network_capability(                                             \
+       &msg->uenetworkcapability,                                              \
+       TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_IEI,                 \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_ue_network_capability(                                             \
+       &msg->uenetworkcapability,                                              \
+       TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_IEI,                 \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(LAST_VISITED_REGISTERED_TAI,                                              \
+     TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,             \
+     TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT,         \
+     TV,                                                                       \
+     6,                                                                        \
+     6,                                                                        \
+     decode_tracking_area_identity(                                            \
+       &msg->lastvisitedregisteredtai,                                         \
+       TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,           \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_tracking_area_identity(                                            \
+       &msg->lastvisitedregisteredtai,                                         \
+       TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,           \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(DRX_PARAMETER,                                                            \
+     TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_IEI,                           \
+     TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_PRESENT,                       \
+     TV,                                                                       \
+     3,                                                                        \
+     3,                                                                        \
+     decode_drx_parameter_ie(                                                  \
+       &msg->drxparameter,                                                     \
+       TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_IEI,                         \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_drx_parameter_ie(                                                  \
+       &msg->drxparameter,                                                     \
+       TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_IEI,                         \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED,                            \
+     TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_IEI, \
+     TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_PRESENT, \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_ue_radio_capability_information_update_needed(                     \
+       &msg->ueradiocapabilityinformationupdateneeded,                         \
+       TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_IEI, \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_ue_radio_capability_information_update_needed(                     \
+       &msg->ueradiocapabilityinformationupdateneeded,                         \
+       TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_IEI, \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(EPS_BEARER_CONTEXT_STATUS,                                                \
+     TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_IEI,               \
+     TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_PRESENT,           \
+     TLV,                                                                      \
+     4,                                                                        \
+     4,                                                                        \
+     decode_eps_bearer_context_status(                                         \
+       &msg->epsbearercontextstatus,                                           \
+       TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_IEI,             \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_eps_bearer_context_status(                                         \
+       &msg->epsbearercontextstatus,                                           \
+       TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_IEI,             \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(MS_NETWORK_CAPABILITY,                                                    \
+     TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_IEI,                   \
+     TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_PRESENT,               \
+     TLV,                                                                      \
+     4,                                                                        \
+     10,                                                                       \
+     decode_ms_network_capability_ie(                                          \
+       &msg->msnetworkcapability,                                              \
+       TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_IEI,                 \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_ms_network_capability_ie(                                          \
+       &msg->msnetworkcapability,                                              \
+       TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_IEI,                 \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(OLD_LOCATION_AREA_IDENTIFICATION,                                         \
+     TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,        \
+     TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT,    \
+     TV,                                                                       \
+     6,                                                                        \
+     6,                                                                        \
+     decode_location_area_identification_ie(                                   \
+       &msg->oldlocationareaidentification,                                    \
+       TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,      \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_location_area_identification_ie(                                   \
+       &msg->oldlocationareaidentification,                                    \
+       TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,      \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(TMSI_STATUS,                                                              \
+     TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_IEI,                             \
+     TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_PRESENT,                         \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_tmsi_status(                                                       \
+       &msg->tmsistatus,                                                       \
+       TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_IEI,                           \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_tmsi_status(                                                       \
+       &msg->tmsistatus,                                                       \
+       TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_IEI,                           \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(MOBILE_STATION_CLASSMARK_2,                                               \
+     TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,              \
+     TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT,          \
+     TLV,                                                                      \
+     5,                                                                        \
+     5,                                                                        \
+     decode_mobile_station_classmark_2_ie(                                     \
+       &msg->mobilestationclassmark2,                                          \
+       TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,            \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_mobile_station_classmark_2_ie(                                     \
+       &msg->mobilestationclassmark2,                                          \
+       TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,            \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(MOBILE_STATION_CLASSMARK_3,                                               \
+     TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,              \
+     TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT,          \
+     TLV,                                                                      \
+     2,                                                                        \
+     34,                                                                       \
+     decode_mobile_station_classmark_3_ie(                                     \
+       &msg->mobilestationclassmark3,                                          \
+       TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,            \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_mobile_station_classmark_3_ie(                                     \
+       &msg->mobilestationclassmark3,                                          \
+       TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,            \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(SUPPORTED_CODECS,                                                         \
+     TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_IEI,                        \
+     TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_PRESENT,                    \
+     TLV,                                                                      \
+     5,                                                                        \
+     0,                                                                        \
+     decode_supported_codec_list(                                              \
+       &msg->supportedcodecs,                                                  \
+       TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_IEI,                      \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_supported_codec_list(                                              \
+       &msg->supportedcodecs,                                                  \
+       TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_IEI,                      \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(ADDITIONAL_UPDATE_TYPE,                                                   \
+     TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,                  \
+     TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT,              \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_additional_update_type(                                            \
+       &msg->additionalupdatetype,                                             \
+       TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,                \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_additional_update_type(                                            \
+       &msg->additionalupdatetype,                                             \
+       TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,                \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(OLD_GUTI_TYPE,                                                            \
+     TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_IEI,                           \
+     TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_PRESENT,                       \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_guti_type(                                                         \
+       &msg->oldgutitype,                                                      \
+       TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_IEI,                         \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_guti_type(                                                         \
+       &msg->oldgutitype,                                                      \
+       TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_IEI,                         \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(VOICE_DOMAIN_PREFERENCE,                                                  \
+     TRACKING_AREA_UPDATE_REQUEST_VOICE_DOMAIN_PREFERENCE_IEI,                 \
+     TRACKING_AREA_UPDATE_REQUEST_VOICE_DOMAIN_PREFERENCE,                     \
+     TLV,                                                                      \
+     3,                                                                        \
+     3,                                                                        \
+     _tracking_area_update_request_skip_voice_domain_preference(),             \
+     0)
+
+#define NAS_IE_MSG_TYPE tracking_area_update_request_msg
+NAS_MSG_DESC_DEFINE(
+  _tracking_area_update_request_desc,
+  TRACKING_AREA_UPDATE_REQUEST_OPTIONAL_IES)
 
 int decode_tracking_area_update_request(
   tracking_area_update_request_msg *tracking_area_update_request,
@@ -73,336 +382,15 @@ int decode_tracking_area_update_request(
   /*
    * Decoding optional fields
    */
-  while (len - decoded > 0) {
-    uint8_t ieiDecoded = *(buffer + decoded);
-
-    /*
-     * Type | value iei are below 0x80 so just return the first 4 bits
-     */
-    if (ieiDecoded >= 0x80) ieiDecoded = ieiDecoded & 0xf0;
-
-    switch (ieiDecoded) {
-      case TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_IEI:
-        if (
-          (decoded_result = decode_nas_key_set_identifier(
-             &tracking_area_update_request->noncurrentnativenaskeysetidentifier,
-             TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_IEI:
-        if (
-          (decoded_result = decode_ciphering_key_sequence_number_ie(
-             &tracking_area_update_request->gprscipheringkeysequencenumber,
-             TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_IEI:
-        if (
-          (decoded_result = decode_p_tmsi_signature_ie(
-             &tracking_area_update_request->oldptmsisignature,
-             TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_IEI:
-        if (
-          (decoded_result = decode_eps_mobile_identity(
-             &tracking_area_update_request->additionalguti,
-             TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_NONCEUE_IEI:
-        if (
-          (decoded_result = decode_nonce(
-             &tracking_area_update_request->nonceue,
-             TRACKING_AREA_UPDATE_REQUEST_NONCEUE_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_NONCEUE_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_IEI:
-        if (
-          (decoded_result = decode_ue_network_capability(
-             &tracking_area_update_request->uenetworkcapability,
-             TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI:
-        if (
-          (decoded_result = decode_tracking_area_identity(
-             &tracking_area_update_request->lastvisitedregisteredtai,
-             TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_IEI:
-        if (
-          (decoded_result = decode_drx_parameter_ie(
-             &tracking_area_update_request->drxparameter,
-             TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_IEI:
-        if (
-          (decoded_result = decode_ue_radio_capability_information_update_needed(
-             &tracking_area_update_request
-                ->ueradiocapabilityinformationupdateneeded,
-             TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_IEI:
-        if (
-          (decoded_result = decode_eps_bearer_context_status(
-             &tracking_area_update_request->epsbearercontextstatus,
-             TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_IEI:
-        if (
-          (decoded_result = decode_ms_network_capability_ie(
-             &tracking_area_update_request->msnetworkcapability,
-             TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI:
-        if (
-          (decoded_result = decode_location_area_identification_ie(
-             &tracking_area_update_request->oldlocationareaidentification,
-             TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_IEI:
-        if (
-          (decoded_result = decode_tmsi_status(
-             &tracking_area_update_request->tmsistatus,
-             TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI:
-        if (
-          (decoded_result = decode_mobile_station_classmark_2_ie(
-             &tracking_area_update_request->mobilestationclassmark2,
-             TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI:
-        if (
-          (decoded_result = decode_mobile_station_classmark_3_ie(
-             &tracking_area_update_request->mobilestationclassmark3,
-             TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_IEI:
-        if (
-          (decoded_result = decode_supported_codec_list(
-             &tracking_area_update_request->supportedcodecs,
-             TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI:
-        if (
-          (decoded_result = decode_additional_update_type(
-             &tracking_area_update_request->additionalupdatetype,
-             TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_IEI:
-        if (
-          (decoded_result = decode_guti_type(
-             &tracking_area_update_request->oldgutitype,
-             TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_PRESENT;
-        break;
-
-      case TRACKING_AREA_UPDATE_REQUEST_VOICE_DOMAIN_PREFERENCE_IEI:
-        //Not decoding as we do not use this IE in CSFB
-
-        decoded += 3; //IEI,Length and Usage setting flag
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        tracking_area_update_request->presencemask |=
-          TRACKING_AREA_UPDATE_REQUEST_VOICE_DOMAIN_PREFERENCE;
-        break;
+  if (
+    (decoded_result = nas_decode_optional_ies(
+       &_tracking_area_update_request_desc,
+       tracking_area_update_request,
+       buffer + decoded,
+       len - decoded)) < 0)
+    return decoded_result;
 
-      default: errorCodeDecoder = TLV_UNEXPECTED_IEI; return TLV_UNEXPECTED_IEI;
-    }
-  }
+  decoded += decoded_result;
 
   return decoded;
 }
@@ -421,11 +409,11 @@ int encode_tracking_area_update_request(
   CHECK_PDU_POINTER_AND_LENGTH_ENCODER(
     buffer, TRACKING_AREA_UPDATE_REQUEST_MINIMUM_LENGTH, len);
   *(buffer + encoded) =
-    ((encode_u8_eps_update_type(&tracking_area_update_request->epsupdatetype) &
+    ((encode_u8_nas_key_set_identifier(
+        &tracking_area_update_request->naskeysetidentifier) &
       0x0f)
      << 4) |
-    (encode_u8_nas_key_set_identifier(
-       &tracking_area_update_request->naskeysetidentifier) &
+    (encode_u8_eps_update_type(&tracking_area_update_request->epsupdatetype) &
      0x0f);
   encoded++;
 
@@ -440,293 +428,15 @@ int encode_tracking_area_update_request(
     encoded += encode_result;
 
   if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_PRESENT) {
-    if (
-      (encode_result = encode_nas_key_set_identifier(
-         &tracking_area_update_request->noncurrentnativenaskeysetidentifier,
-         TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_PRESENT) {
-    if (
-      (encode_result = encode_ciphering_key_sequence_number_ie(
-         &tracking_area_update_request->gprscipheringkeysequencenumber,
-         TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT) {
-    if (
-      (encode_result = encode_p_tmsi_signature_ie(
-         tracking_area_update_request->oldptmsisignature,
-         TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_PRESENT) {
-    if (
-      (encode_result = encode_eps_mobile_identity(
-         &tracking_area_update_request->additionalguti,
-         TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_GUTI_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_NONCEUE_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_NONCEUE_PRESENT) {
-    if (
-      (encode_result = encode_nonce(
-         &tracking_area_update_request->nonceue,
-         TRACKING_AREA_UPDATE_REQUEST_NONCEUE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_PRESENT) {
-    if (
-      (encode_result = encode_ue_network_capability(
-         &tracking_area_update_request->uenetworkcapability,
-         TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT) {
-    if (
-      (encode_result = encode_tracking_area_identity(
-         &tracking_area_update_request->lastvisitedregisteredtai,
-         TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_PRESENT) {
-    if (
-      (encode_result = encode_drx_parameter_ie(
-         &tracking_area_update_request->drxparameter,
-         TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_PRESENT) {
-    if (
-      (encode_result = encode_ue_radio_capability_information_update_needed(
-         &tracking_area_update_request
-            ->ueradiocapabilityinformationupdateneeded,
-         TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_PRESENT) {
-    if (
-      (encode_result = encode_eps_bearer_context_status(
-         &tracking_area_update_request->epsbearercontextstatus,
-         TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_PRESENT) {
-    if (
-      (encode_result = encode_ms_network_capability_ie(
-         &tracking_area_update_request->msnetworkcapability,
-         TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT) {
-    if (
-      (encode_result = encode_location_area_identification_ie(
-         &tracking_area_update_request->oldlocationareaidentification,
-         TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_PRESENT) {
-    if (
-      (encode_result = encode_tmsi_status(
-         &tracking_area_update_request->tmsistatus,
-         TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT) {
-    if (
-      (encode_result = encode_mobile_station_classmark_2_ie(
-         &tracking_area_update_request->mobilestationclassmark2,
-         TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_PRESENT) {
-    if (
-      (encode_result = encode_mobile_station_classmark_3_ie(
-         &tracking_area_update_request->mobilestationclassmark3,
-         TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_3_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_PRESENT) {
-    if (
-      (encode_result = encode_supported_codec_list(
-         &tracking_area_update_request->supportedcodecs,
-         TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_PRESENT) {
-    if (
-      (encode_result = encode_additional_update_type(
-         &tracking_area_update_request->additionalupdatetype,
-         TRACKING_AREA_UPDATE_REQUEST_ADDITIONAL_UPDATE_TYPE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (tracking_area_update_request->presencemask &
-     TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_PRESENT) ==
-    TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_PRESENT) {
-    if (
-      (encode_result = encode_guti_type(
-         &tracking_area_update_request->oldgutitype,
-         TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
+    (encode_result = nas_encode_optional_ies(
+       &_tracking_area_update_request_desc,
+       tracking_area_update_request,
+       buffer + encoded,
+       len - encoded)) < 0)
+    // Return in case of error
+    return encode_result;
+  else
+    encoded += encode_result;
 
   return encoded;
 }
@@ -27,6 +27,37 @@
 #include "TLVDecoder.h"
 #include "EsmInformationResponse.h"
 #include "common_defs.h"
+#include "nas_ie_codec.h"
+
+/*
+ * Optional IEs of the ESM information response, see table 8.3.14.1, lengths
+ * of the whole IE: IE(name, IEI, presence bit, format, min length, max length
+ * (0 when not bounded), decode, encode)
+ */
+#define ESM_INFORMATION_RESPONSE_OPTIONAL_IES(IE)                              \
+  IE(ACCESS_POINT_NAME,                                                        \
+     ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_IEI,                           \
+     ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_PRESENT,                       \
+     TLV,                                                                      \
+     3,                                                                        \
+     102,                                                                      \
+     decode_access_point_name_ie(&msg->accesspointname, true, buffer, len),    \
+     encode_access_point_name_ie(msg->accesspointname, true, buffer, len))     \
+  IE(PROTOCOL_CONFIGURATION_OPTIONS,                                           \
+     ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_IEI,              \
+     ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT,          \
+     TLV,                                                                      \
+     3,                                                                        \
+     253,                                                                      \
+     decode_protocol_configuration_options_ie(                                 \
+       &msg->protocolconfigurationoptions, true, buffer, len),                 \
+     encode_protocol_configuration_options_ie(                                 \
+       &msg->protocolconfigurationoptions, true, buffer, len))
+
+#define NAS_IE_MSG_TYPE esm_information_response_msg
+NAS_MSG_DESC_DEFINE(
+  _esm_information_response_desc,
+  ESM_INFORMATION_RESPONSE_OPTIONAL_IES)
 
 int decode_esm_information_response(
   esm_information_response_msg *esm_information_response,
@@ -47,54 +78,15 @@ int decode_esm_information_response(
   /*
    * Decoding optional fields
    */
-  while (len - decoded > 0) {
-    uint8_t ieiDecoded = *(buffer + decoded);
-
-    /*
-     * Type | value iei are below 0x80 so just return the first 4 bits
-     */
-    if (ieiDecoded >= 0x80) ieiDecoded = ieiDecoded & 0xf0;
-
-    switch (ieiDecoded) {
-      case ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_IEI:
-        if (
-          (decoded_result = decode_access_point_name_ie(
-             &esm_information_response->accesspointname,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          OAILOG_FUNC_RETURN(LOG_NAS_ESM, decoded_result);
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        esm_information_response->presencemask |=
-          ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_PRESENT;
-        break;
-
-      case ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_IEI:
-        if (
-          (decoded_result = decode_protocol_configuration_options_ie(
-             &esm_information_response->protocolconfigurationoptions,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          OAILOG_FUNC_RETURN(LOG_NAS_ESM, decoded_result);
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        esm_information_response->presencemask |=
-          ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT;
-        break;
+  if (
+    (decoded_result = nas_decode_optional_ies(
+       &_esm_information_response_desc,
+       esm_information_response,
+       buffer + decoded,
+       len - decoded)) < 0)
+    OAILOG_FUNC_RETURN(LOG_NAS_ESM, decoded_result);
 
-      default:
-        errorCodeDecoder = TLV_UNEXPECTED_IEI;
-        OAILOG_FUNC_RETURN(LOG_NAS_ESM, TLV_UNEXPECTED_IEI);
-    }
-  }
+  decoded += decoded_result;
 
   OAILOG_FUNC_RETURN(LOG_NAS_ESM, decoded);
 }
@@ -115,36 +107,15 @@ int encode_esm_information_response(
     buffer, ESM_INFORMATION_RESPONSE_MINIMUM_LENGTH, len);
 
   if (
-    (esm_information_response->presencemask &
-     ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_PRESENT) ==
-    ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_PRESENT) {
-    if (
-      (encode_result = encode_access_point_name_ie(
-         esm_information_response->accesspointname,
-         true,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      OAILOG_FUNC_RETURN(LOG_NAS_ESM, encode_result);
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (esm_information_response->presencemask &
-     ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT) ==
-    ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT) {
-    if (
-      (encode_result = encode_protocol_configuration_options_ie(
-         &esm_information_response->protocolconfigurationoptions,
-         true,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      OAILOG_FUNC_RETURN(LOG_NAS_ESM, encode_result);
-    else
-      encoded += encode_result;
-  }
+    (encode_result = nas_encode_optional_ies(
+       &_esm_information_response_desc,
+       esm_information_response,
+       buffer + encoded,
+       len - encoded)) < 0)
+    // Return in case of error
+    OAILOG_FUNC_RETURN(LOG_NAS_ESM, encode_result);
+  else
+    encoded += encode_result;
 
   OAILOG_FUNC_RETURN(LOG_NAS_ESM, encoded);
 }
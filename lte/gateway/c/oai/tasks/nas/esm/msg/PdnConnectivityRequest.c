@@ -27,6 +27,72 @@
 #include "TLVDecoder.h"
 #include "PdnConnectivityRequest.h"
 #include "common_defs.h"
+#include "nas_ie_codec.h"
+
+static int _pdn_connectivity_request_skip_device_properties(uint8_t *buffer)
+{
+  // Skip this IE. Not supported. It is relevant for delay tolerant devices such as IoT devices.
+  OAILOG_INFO(
+    LOG_NAS_ESM,
+    "ESM-MSG - Device Properties IE in PDN Connectivity Request is not "
+    "supported. Skipping this IE. IE = %x\n",
+    *buffer);
+  return 1; // Device Properties is 1 byte
+}
+
+/*
+ * Optional IEs of the PDN connectivity request, see table 8.3.20.1, lengths
+ * of the whole IE: IE(name, IEI, presence bit, format, min length, max length
+ * (0 when not bounded), decode, encode)
+ */
+#define PDN_CONNECTIVITY_REQUEST_OPTIONAL_IES(IE)                              \
+  IE(ESM_INFORMATION_TRANSFER_FLAG,                                            \
+     PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_IEI,               \
+     PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT,           \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     decode_esm_information_transfer_flag(                                     \
+       &msg->esminformationtransferflag,                                       \
+       PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_IEI,             \
+       buffer,                                                                 \
+       len),                                                                   \
+     encode_esm_information_transfer_flag(                                     \
+       &msg->esminformationtransferflag,                                       \
+       PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_IEI,             \
+       buffer,                                                                 \
+       len))                                                                   \
+  IE(ACCESS_POINT_NAME,                                                        \
+     PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_IEI,                           \
+     PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_PRESENT,                       \
+     TLV,                                                                      \
+     3,                                                                        \
+     102,                                                                      \
+     decode_access_point_name_ie(&msg->accesspointname, true, buffer, len),    \
+     encode_access_point_name_ie(msg->accesspointname, true, buffer, len))     \
+  IE(PROTOCOL_CONFIGURATION_OPTIONS,                                           \
+     PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_IEI,              \
+     PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT,          \
+     TLV,                                                                      \
+     3,                                                                        \
+     253,                                                                      \
+     decode_protocol_configuration_options_ie(                                 \
+       &msg->protocolconfigurationoptions, true, buffer, len),                 \
+     encode_protocol_configuration_options_ie(                                 \
+       &msg->protocolconfigurationoptions, true, buffer, len))                 \
+  IE(DEVICE_PROPERTIES,                                                        \
+     PDN_CONNECTIVITY_REQUEST_DEVICE_PROPERTIES_IEI,                           \
+     0,                                                                        \
+     TV1,                                                                      \
+     1,                                                                        \
+     1,                                                                        \
+     _pdn_connectivity_request_skip_device_properties(buffer),                 \
+     0)
+
+#define NAS_IE_MSG_TYPE pdn_connectivity_request_msg
+NAS_MSG_DESC_DEFINE(
+  _pdn_connectivity_request_desc,
+  PDN_CONNECTIVITY_REQUEST_OPTIONAL_IES)
 
 int decode_pdn_connectivity_request(
   pdn_connectivity_request_msg *pdn_connectivity_request,
@@ -64,80 +130,15 @@ int decode_pdn_connectivity_request(
   /*
    * Decoding optional fields
    */
-  while (len - decoded > 0) {
-    uint8_t ieiDecoded = *(buffer + decoded);
-
-    /*
-     * Type | value iei are below 0x80 so just return the first 4 bits
-     */
-    if (ieiDecoded >= 0x80) ieiDecoded = ieiDecoded & 0xf0;
-
-    switch (ieiDecoded) {
-      case PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_IEI:
-        if (
-          (decoded_result = decode_esm_information_transfer_flag(
-             &pdn_connectivity_request->esminformationtransferflag,
-             PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_IEI,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        pdn_connectivity_request->presencemask |=
-          PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT;
-        break;
-
-      case PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_IEI:
-        if (
-          (decoded_result = decode_access_point_name_ie(
-             &pdn_connectivity_request->accesspointname,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        pdn_connectivity_request->presencemask |=
-          PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_PRESENT;
-        break;
-
-      case PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_IEI:
-        if (
-          (decoded_result = decode_protocol_configuration_options_ie(
-             &pdn_connectivity_request->protocolconfigurationoptions,
-             true,
-             buffer + decoded,
-             len - decoded)) <= 0)
-          return decoded_result;
-
-        decoded += decoded_result;
-        /*
-       * Set corresponding mask to 1 in presencemask
-       */
-        pdn_connectivity_request->presencemask |=
-          PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT;
-        break;
-
-      case PDN_CONNECTIVITY_REQUEST_DEVICE_PROPERTIES_IEI:
-      case PDN_CONNECTIVITY_REQUEST_DEVICE_PROPERTIES_LOW_PRIO_IEI:
-        // Skip this IE. Not supported. It is relevant for delay tolerant devices such as IoT devices.
-        OAILOG_INFO(
-          LOG_NAS_ESM,
-          "ESM-MSG - Device Properties IE in PDN Connectivity Request is not "
-          "supported. Skipping this IE. IE = %x\n",
-          ieiDecoded);
-        decoded += 1; // Device Properties is 1 byte
-        break;
-
-      default: errorCodeDecoder = TLV_UNEXPECTED_IEI; return TLV_UNEXPECTED_IEI;
-    }
-  }
+  if (
+    (decoded_result = nas_decode_optional_ies(
+       &_pdn_connectivity_request_desc,
+       pdn_connectivity_request,
+       buffer + decoded,
+       len - decoded)) < 0)
+    return decoded_result;
+
+  decoded += decoded_result;
 
   return decoded;
 }
@@ -161,52 +162,15 @@ int encode_pdn_connectivity_request(
   encoded++;
 
   if (
-    (pdn_connectivity_request->presencemask &
-     PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT) ==
-    PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT) {
-    if (
-      (encode_result = encode_esm_information_transfer_flag(
-         &pdn_connectivity_request->esminformationtransferflag,
-         PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_IEI,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (pdn_connectivity_request->presencemask &
-     PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_PRESENT) ==
-    PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_PRESENT) {
-    if (
-      (encode_result = encode_access_point_name_ie(
-         pdn_connectivity_request->accesspointname,
-         true,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
-
-  if (
-    (pdn_connectivity_request->presencemask &
-     PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT) ==
-    PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT) {
-    if (
-      (encode_result = encode_protocol_configuration_options_ie(
-         &pdn_connectivity_request->protocolconfigurationoptions,
-         true,
-         buffer + encoded,
-         len - encoded)) < 0)
-      // Return in case of error
-      return encode_result;
-    else
-      encoded += encode_result;
-  }
+    (encode_result = nas_encode_optional_ies(
+       &_pdn_connectivity_request_desc,
+       pdn_connectivity_request,
+       buffer + encoded,
+       len - encoded)) < 0)
+    // Return in case of error
+    return encode_result;
+  else
+    encoded += encode_result;
 
   return encoded;
 }
@@ -214,6 +214,7 @@ typedef struct nas_emm_auth_proc_s {
   mme_ue_s1ap_id_t ue_id;
   bool is_cause_is_attach; //  could also be done by seeking parent procedure
   ksi_t ksi;
+  int vector_index;             /* Auth vector of the challenge */
   uint8_t rand[AUTH_RAND_SIZE]; /* Random challenge number  */
   uint8_t autn[AUTH_AUTN_SIZE]; /* Authentication token     */
   imsi_t *unchecked_imsi;
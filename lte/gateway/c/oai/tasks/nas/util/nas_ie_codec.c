@@ -0,0 +1,165 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*****************************************************************************
+  Source      nas_ie_codec.c
+
+  Subsystem   Utilities
+
+  Description Table driven codec of the optional IEs of a NAS message
+
+*****************************************************************************/
+
+#include <stdint.h>
+
+#include "common_defs.h"
+#include "TLVDecoder.h"
+#include "nas_ie_codec.h"
+
+//------------------------------------------------------------------------------
+// Length of the IE at the head of buffer from its format, 0 if its header is
+// cut.
+static inline uint32_t _nas_ie_length(
+  const nas_ie_desc_t *ie,
+  const uint8_t *buffer,
+  uint32_t len)
+{
+  switch (ie->format) {
+    case NAS_IE_FORMAT_TV1: return 1;
+    case NAS_IE_FORMAT_TV: return ie->min_length;
+    case NAS_IE_FORMAT_TLV: return (len < 2) ? 0 : 2 + buffer[1];
+    case NAS_IE_FORMAT_TLVE:
+      return (len < 3) ? 0 : 3 + ((buffer[1] << 8) | buffer[2]);
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Decode the optional IEs of a message, up to the end of buffer, and set
+ * their bits in the presencemask of msg. The length of each IE is checked
+ * against the buffer and the bounds of its table entry once, before its
+ * decoder runs, the IEs out of these bounds are skipped.
+ * Returns the number of bytes decoded, or the error of the first IE that
+ * cannot be decoded.
+ */
+int nas_decode_optional_ies(
+  const nas_msg_desc_t *desc,
+  void *msg,
+  uint8_t *buffer,
+  uint32_t len)
+{
+  uint32_t *presencemask =
+    (uint32_t *) ((uint8_t *) msg + desc->presencemask_offset);
+  uint32_t decoded = 0;
+
+  while (decoded < len) {
+    uint8_t iei = buffer[decoded];
+    uint32_t remaining = len - decoded;
+    const nas_ie_desc_t *ie;
+    uint32_t ie_length;
+    int decoded_result;
+
+    /*
+     * Type | value iei are below 0x80 so just use the first 4 bits
+     */
+    if (iei >= 0x80) iei &= 0xf0;
+    if (desc->index[iei] == 0) {
+      errorCodeDecoder = TLV_UNEXPECTED_IEI;
+      return TLV_UNEXPECTED_IEI;
+    }
+    ie = &desc->ies[desc->index[iei] - 1];
+
+    ie_length = _nas_ie_length(ie, buffer + decoded, remaining);
+    if (ie_length == 0 || ie_length > remaining) {
+      errorCodeDecoder = TLV_BUFFER_TOO_SHORT;
+      return TLV_BUFFER_TOO_SHORT;
+    }
+    /*
+     * An optional IE with a length out of its bounds is syntactically
+     * incorrect, it is treated as not present, see 3GPP TS 24.301 section
+     * 7.5.3
+     */
+    if (
+      ie_length < ie->min_length ||
+      (ie->max_length > 0 && ie_length > ie->max_length)) {
+      decoded += ie_length;
+      continue;
+    }
+
+    /*
+     * Only the first occurrence of a repeated IE is handled, see 3GPP TS
+     * 24.007 section 11.2.4
+     */
+    if (*presencemask & ie->presence) {
+      decoded += ie_length;
+      continue;
+    }
+
+    /*
+     * The IE decoders keep the length checks of their own, they are given
+     * the rest of the buffer as with the switch based decoders. A decoder
+     * that consumes nothing did not recognize its IE.
+     */
+    if ((decoded_result = ie->decode(msg, buffer + decoded, remaining)) < 0)
+      return decoded_result;
+    if (decoded_result == 0) {
+      errorCodeDecoder = TLV_VALUE_DOESNT_MATCH;
+      return TLV_VALUE_DOESNT_MATCH;
+    }
+
+    decoded += decoded_result;
+    *presencemask |= ie->presence;
+  }
+
+  return decoded;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Encode the optional IEs of msg set in its presencemask, in the order of the
+ * table.
+ * Returns the number of bytes encoded, or the error of the first IE that
+ * cannot be encoded.
+ */
+int nas_encode_optional_ies(
+  const nas_msg_desc_t *desc,
+  void *msg,
+  uint8_t *buffer,
+  uint32_t len)
+{
+  uint32_t presencemask =
+    *(const uint32_t *) ((const uint8_t *) msg + desc->presencemask_offset);
+  int encoded = 0;
+  int encode_result;
+
+  for (uint32_t i = 0; i < desc->nb_ies; i++) {
+    const nas_ie_desc_t *ie = &desc->ies[i];
+
+    if ((presencemask & ie->presence) == 0) continue;
+    if ((encode_result = ie->encode(msg, buffer + encoded, len - encoded)) < 0)
+      return encode_result;
+
+    encoded += encode_result;
+  }
+
+  return encoded;
+}
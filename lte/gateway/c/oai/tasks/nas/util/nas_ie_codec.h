@@ -0,0 +1,145 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*****************************************************************************
+Source      nas_ie_codec.h
+
+Subsystem   Utilities
+
+Description Table driven codec of the optional IEs of a NAS message
+
+*****************************************************************************/
+#ifndef FILE_NAS_IE_CODEC_SEEN
+#define FILE_NAS_IE_CODEC_SEEN
+
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************************/
+/************************  G L O B A L    T Y P E S  ************************/
+/****************************************************************************/
+
+/* Format of an IE, see 3GPP TS 24.007 section 11.2.1.1 */
+typedef enum nas_ie_format_e {
+  NAS_IE_FORMAT_TV1 = 0, /* IEI in the high nibble, value in the low one */
+  NAS_IE_FORMAT_TV,      /* IEI and a value of fixed length */
+  NAS_IE_FORMAT_TLV,     /* IEI, one octet length and value */
+  NAS_IE_FORMAT_TLVE,    /* IEI, two octets length and value */
+} nas_ie_format_t;
+
+/* Decode or encode one IE of the message msg, IEI included */
+typedef int (*nas_ie_decode_t)(void *msg, uint8_t *buffer, uint32_t len);
+typedef int (*nas_ie_encode_t)(void *msg, uint8_t *buffer, uint32_t len);
+
+typedef struct nas_ie_desc_s {
+  uint8_t iei;
+  nas_ie_format_t format;
+  uint16_t min_length; /* of the whole IE, IEI and length included */
+  uint16_t max_length; /* 0 when the length is not bounded */
+  uint32_t presence;   /* bit in the presencemask, 0 if the IE is not kept */
+  nas_ie_decode_t decode;
+  nas_ie_encode_t encode;
+} nas_ie_desc_t;
+
+/*
+ * The optional IEs of a message, in the order they are encoded, and the
+ * index + 1 of the IE of each IEI, 0 for an unexpected IEI. The IEI of a
+ * type 1 IE is its high nibble.
+ */
+typedef struct nas_msg_desc_s {
+  const nas_ie_desc_t *ies;
+  uint32_t nb_ies;
+  size_t presencemask_offset;
+  uint8_t index[256];
+} nas_msg_desc_t;
+
+/****************************************************************************/
+/*********************  G L O B A L    C O N S T A N T S  *******************/
+/****************************************************************************/
+
+/*
+ * A message describes its optional IEs once with an X-macro
+ *
+ *   #define FOO_OPTIONAL_IES(IE)                                            \
+ *     IE(NAME, IEI, PRESENT_BIT, FORMAT, MIN_LENGTH, MAX_LENGTH,            \
+ *        decode expression, encode expression)                              \
+ *     ...
+ *
+ * where the expressions see the message as msg and the IE as buffer and len,
+ * then generates the codec tables with
+ *
+ *   #define NAS_IE_MSG_TYPE foo_msg
+ *   NAS_MSG_DESC_DEFINE(foo_desc, FOO_OPTIONAL_IES)
+ *
+ * The tables, including the IEI index, are built at compile time.
+ */
+#define NAS_IE_WRAPPERS(nAME, iEI, pRESENT, fORMAT, mIN, mAX, dEC, eNC)        \
+  static int _nas_ie_decode_##nAME(void *m, uint8_t *buffer, uint32_t len)     \
+  {                                                                            \
+    NAS_IE_MSG_TYPE *msg __attribute__((unused)) = m;                          \
+    return dEC;                                                                \
+  }                                                                            \
+  static int _nas_ie_encode_##nAME(void *m, uint8_t *buffer, uint32_t len)     \
+  {                                                                            \
+    NAS_IE_MSG_TYPE *msg __attribute__((unused)) = m;                          \
+    return eNC;                                                                \
+  }
+
+#define NAS_IE_INDEX(nAME, ...) _NAS_IE_INDEX_##nAME,
+
+#define NAS_IE_DESC(nAME, iEI, pRESENT, fORMAT, mIN, mAX, dEC, eNC)           \
+  {.iei = iEI,                                                                 \
+   .format = NAS_IE_FORMAT_##fORMAT,                                           \
+   .min_length = mIN,                                                          \
+   .max_length = mAX,                                                          \
+   .presence = pRESENT,                                                        \
+   .decode = _nas_ie_decode_##nAME,                                            \
+   .encode = _nas_ie_encode_##nAME},
+
+#define NAS_IE_LOOKUP(nAME, iEI, ...) [iEI] = _NAS_IE_INDEX_##nAME + 1,
+
+#define NAS_MSG_DESC_DEFINE(dESC, iES)                                         \
+  iES(NAS_IE_WRAPPERS)                                                         \
+  enum { iES(NAS_IE_INDEX) _NAS_IE_NB };                                       \
+  static const nas_ie_desc_t dESC##_ies[] = {iES(NAS_IE_DESC)};                \
+  static const nas_msg_desc_t dESC = {                                         \
+    .ies = dESC##_ies,                                                         \
+    .nb_ies = _NAS_IE_NB,                                                      \
+    .presencemask_offset = offsetof(NAS_IE_MSG_TYPE, presencemask),            \
+    .index = {iES(NAS_IE_LOOKUP)}};
+
+/****************************************************************************/
+/******************  E X P O R T E D    F U N C T I O N S  ******************/
+/****************************************************************************/
+
+int nas_decode_optional_ies(
+  const nas_msg_desc_t *desc,
+  void *msg,
+  uint8_t *buffer,
+  uint32_t len);
+
+int nas_encode_optional_ies(
+  const nas_msg_desc_t *desc,
+  void *msg,
+  uint8_t *buffer,
+  uint32_t len);
+
+#endif /* FILE_NAS_IE_CODEC_SEEN */
@@ -63,6 +63,7 @@
 #include "mme_default_values.h"
 #include "s1ap_messages_types.h"
 #include "sctp_messages_types.h"
+#include "sctp_rx_buffer.h"
 #include "timer_messages_types.h"
 
 #if S1AP_DEBUG_LIST
@@ -79,11 +80,13 @@ bool hss_associated = false;
 uint32_t nb_enb_associated = 0;
 
 hash_table_ts_t g_s1ap_enb_coll = {
-  .mutex = PTHREAD_MUTEX_INITIALIZER,
   0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
 hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {
-  .mutex = PTHREAD_MUTEX_INITIALIZER,
   0}; // contains sctp association id, key is mme_ue_s1ap_id;
+static hash_table_ts_t g_s1ap_mme_ue_id2ue_ref_coll = {
+  0}; // index on ue_description_s of all eNBs, key is mme_ue_s1ap_id;
+static hash_table_ts_t g_s1ap_s11_teid2ue_ref_coll = {
+  0}; // index on ue_description_s of all eNBs, key is s11_sgw_teid;
 
 static int indent = 0;
 void *s1ap_mme_thread(void *args);
@@ -146,10 +149,17 @@ void *s1ap_mme_thread(__attribute__((unused)) void *args)
         /*
          * Invoke S1AP message decoder
          */
-        if (
-          s1ap_mme_decode_pdu(
-            &message, SCTP_DATA_IND(received_message_p).payload, &message_id) <
-          0) {
+        int rc = s1ap_mme_decode_pdu(
+          &message,
+          &SCTP_DATA_IND(received_message_p).buffer->payload,
+          &message_id);
+
+        /*
+         * The decoded message does not refer to the received PDU, give the
+         * receive buffer back to SCTP right away
+         */
+        sctp_rx_buffer_unref(&SCTP_DATA_IND(received_message_p).buffer);
+        if (rc < 0) {
           // TODO: Notify eNB of failure with right cause
           OAILOG_ERROR(LOG_S1AP, "Failed to decode new buffer\n");
         } else {
@@ -162,11 +172,6 @@ void *s1ap_mme_thread(__attribute__((unused)) void *args)
         if (message_id != MESSAGES_ID_MAX) {
           s1ap_free_mme_decode_pdu(&message, message_id);
         }
-
-        /*
-         * Free received PDU array
-         */
-        bdestroy_wrapper(&SCTP_DATA_IND(received_message_p).payload);
       } break;
 
       case SCTP_DATA_CNF:
@@ -379,6 +384,27 @@ int s1ap_mme_init(void)
   bdestroy_wrapper(&bs2);
   if (!h) return RETURNerror;
 
+  // UE indexes do not own the ue_description_t, ue_coll of eNBs do.
+  bstring bs3 = bfromcstr("s1ap_mme_ue_id2ue_ref_coll");
+  h = hashtable_ts_init(
+    &g_s1ap_mme_ue_id2ue_ref_coll,
+    mme_config.max_ues,
+    NULL,
+    hash_free_int_func,
+    bs3);
+  bdestroy_wrapper(&bs3);
+  if (!h) return RETURNerror;
+
+  bstring bs4 = bfromcstr("s1ap_s11_teid2ue_ref_coll");
+  h = hashtable_ts_init(
+    &g_s1ap_s11_teid2ue_ref_coll,
+    mme_config.max_ues,
+    NULL,
+    hash_free_int_func,
+    bs4);
+  bdestroy_wrapper(&bs4);
+  if (!h) return RETURNerror;
+
   if (itti_create_task(TASK_S1AP, &s1ap_mme_thread, NULL) < 0) {
     OAILOG_ERROR(LOG_S1AP, "Error while creating S1AP task\n");
     return RETURNerror;
@@ -403,6 +429,12 @@ void s1ap_mme_exit(void)
   if (hashtable_ts_destroy(&g_s1ap_mme_id2assoc_id_coll) != HASH_TABLE_OK) {
     OAI_FPRINTF_ERR("An error occured while destroying assoc_id hash table");
   }
+  if (hashtable_ts_destroy(&g_s1ap_mme_ue_id2ue_ref_coll) != HASH_TABLE_OK) {
+    OAI_FPRINTF_ERR("An error occured while destroying mme_ue_id hash table");
+  }
+  if (hashtable_ts_destroy(&g_s1ap_s11_teid2ue_ref_coll) != HASH_TABLE_OK) {
+    OAI_FPRINTF_ERR("An error occured while destroying s11 teid hash table");
+  }
   OAILOG_DEBUG(LOG_S1AP, "Cleaning S1AP: DONE\n");
 }
 
@@ -557,83 +589,46 @@ ue_description_t *s1ap_is_ue_enb_id_in_list(
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_mme_ue_id_cb(
-  __attribute__((unused)) const hash_key_t keyP,
-  void *const elementP,
-  void *parameterP,
-  void **resultP)
+// Removes key from a UE index only if it still refers to ue_ref, the key may
+// already have been taken over by a newer UE description.
+static void s1ap_ue_index_remove(
+  hash_table_ts_t *const ue_index,
+  const hash_key_t key,
+  const ue_description_t *const ue_ref)
 {
-  mme_ue_s1ap_id_t *mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t *) parameterP;
-  ue_description_t *ue_ref = (ue_description_t *) elementP;
-  if (*mme_ue_s1ap_id_p == ue_ref->mme_ue_s1ap_id) {
-    *resultP = elementP;
-    OAILOG_TRACE(
-      LOG_S1AP,
-      "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
-      ue_ref,
-      ue_ref->mme_ue_s1ap_id);
-    return true;
+  ue_description_t *indexed_ue_ref = NULL;
+
+  hashtable_ts_get(ue_index, key, (void **) &indexed_ue_ref);
+  if (indexed_ue_ref == ue_ref) {
+    hashtable_ts_free(ue_index, key);
   }
-  return false;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_mme_ue_id_cb(
-  __attribute__((unused)) const hash_key_t keyP,
-  void *const elementP,
-  void *parameterP,
-  void **resultP)
+static void s1ap_ue_index_remove_all(const ue_description_t *const ue_ref)
 {
-  enb_description_t *enb_ref = (enb_description_t *) elementP;
-
-  hashtable_ts_apply_callback_on_elements(
-    (hash_table_ts_t *const) & enb_ref->ue_coll,
-    s1ap_ue_compare_by_mme_ue_id_cb,
-    parameterP,
-    resultP);
-  if (*resultP) {
-    OAILOG_TRACE(
-      LOG_S1AP,
-      "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
-      *resultP,
-      ((ue_description_t *) (*resultP))->mme_ue_s1ap_id);
-    return true;
+  if (ue_ref->mme_ue_s1ap_id != INVALID_MME_UE_S1AP_ID) {
+    s1ap_ue_index_remove(
+      &g_s1ap_mme_ue_id2ue_ref_coll,
+      (const hash_key_t) ue_ref->mme_ue_s1ap_id,
+      ue_ref);
   }
-  return false;
-}
-//------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_s11_sgw_teid_cb(
-  __attribute__((unused)) const hash_key_t keyP,
-  void *const elementP,
-  void *parameterP,
-  void **resultP)
-{
-  s11_teid_t *s11_sgw_teid_p = (s11_teid_t *) parameterP;
-  ue_description_t *ue_ref = (ue_description_t *) elementP;
-  if (*s11_sgw_teid_p == ue_ref->s11_sgw_teid) {
-    *resultP = elementP;
-    return true;
+  if (ue_ref->s11_sgw_teid) {
+    s1ap_ue_index_remove(
+      &g_s1ap_s11_teid2ue_ref_coll,
+      (const hash_key_t) ue_ref->s11_sgw_teid,
+      ue_ref);
   }
-  return false;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_s11_sgw_teid_cb(
-  __attribute((unused)) const hash_key_t keyP,
+static bool s1ap_ue_index_remove_cb(
+  __attribute__((unused)) const hash_key_t keyP,
   void *const elementP,
-  void *parameterP,
-  void **resultP)
+  __attribute__((unused)) void *parameterP,
+  __attribute__((unused)) void **resultP)
 {
-  enb_description_t *enb_ref = (enb_description_t *) elementP;
-
-  hashtable_ts_apply_callback_on_elements(
-    (hash_table_ts_t *const) & enb_ref->ue_coll,
-    s1ap_ue_compare_by_s11_sgw_teid_cb,
-    parameterP,
-    resultP);
-  if (*resultP) {
-    return true;
-  }
+  s1ap_ue_index_remove_all((ue_description_t *) elementP);
   return false;
 }
 
@@ -642,32 +637,48 @@ ue_description_t *s1ap_is_ue_mme_id_in_list(
   const mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
   ue_description_t *ue_ref = NULL;
-  mme_ue_s1ap_id_t *mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t *) &mme_ue_s1ap_id;
 
-  hashtable_ts_apply_callback_on_elements(
-    &g_s1ap_enb_coll,
-    s1ap_enb_find_ue_by_mme_ue_id_cb,
-    (void *) mme_ue_s1ap_id_p,
+  hashtable_ts_get(
+    &g_s1ap_mme_ue_id2ue_ref_coll,
+    (const hash_key_t) mme_ue_s1ap_id,
     (void **) &ue_ref);
   OAILOG_TRACE(LOG_S1AP, "Return ue_ref %p \n", ue_ref);
   return ue_ref;
 }
 
 //------------------------------------------------------------------------------
-// TODO(amar) unused function check with OAI.
 ue_description_t *s1ap_is_s11_sgw_teid_in_list(const s11_teid_t teid)
 {
   ue_description_t *ue_ref = NULL;
-  s11_teid_t *teid_id_p = (s11_teid_t *) &teid;
 
-  hashtable_ts_apply_callback_on_elements(
-    &g_s1ap_enb_coll,
-    s1ap_enb_find_ue_by_s11_sgw_teid_cb,
-    (void *) teid_id_p,
-    (void **) &ue_ref);
+  hashtable_ts_get(
+    &g_s1ap_s11_teid2ue_ref_coll, (const hash_key_t) teid, (void **) &ue_ref);
   return ue_ref;
 }
 
+//------------------------------------------------------------------------------
+void s1ap_set_ue_s11_sgw_teid(
+  ue_description_t *const ue_ref,
+  const s11_teid_t s11_sgw_teid)
+{
+  if (ue_ref->s11_sgw_teid == s11_sgw_teid) {
+    return;
+  }
+  if (ue_ref->s11_sgw_teid) {
+    s1ap_ue_index_remove(
+      &g_s1ap_s11_teid2ue_ref_coll,
+      (const hash_key_t) ue_ref->s11_sgw_teid,
+      ue_ref);
+  }
+  ue_ref->s11_sgw_teid = s11_sgw_teid;
+  if (s11_sgw_teid) {
+    hashtable_ts_insert(
+      &g_s1ap_s11_teid2ue_ref_coll,
+      (const hash_key_t) s11_sgw_teid,
+      (void *) ue_ref);
+  }
+}
+
 //------------------------------------------------------------------------------
 void s1ap_notified_new_ue_mme_s1ap_id_association(
   const sctp_assoc_id_t sctp_assoc_id,
@@ -679,7 +690,19 @@ void s1ap_notified_new_ue_mme_s1ap_id_association(
     ue_description_t *ue_ref =
       s1ap_is_ue_enb_id_in_list(enb_ref, enb_ue_s1ap_id);
     if (ue_ref) {
+      if (
+        (ue_ref->mme_ue_s1ap_id != INVALID_MME_UE_S1AP_ID) &&
+        (ue_ref->mme_ue_s1ap_id != mme_ue_s1ap_id)) {
+        s1ap_ue_index_remove(
+          &g_s1ap_mme_ue_id2ue_ref_coll,
+          (const hash_key_t) ue_ref->mme_ue_s1ap_id,
+          ue_ref);
+      }
       ue_ref->mme_ue_s1ap_id = mme_ue_s1ap_id;
+      hashtable_ts_insert(
+        &g_s1ap_mme_ue_id2ue_ref_coll,
+        (const hash_key_t) mme_ue_s1ap_id,
+        (void *) ue_ref);
       hashtable_rc_t h_rc = hashtable_ts_insert(
         &g_s1ap_mme_id2assoc_id_coll,
         (const hash_key_t) mme_ue_s1ap_id,
@@ -810,6 +833,7 @@ void s1ap_remove_ue(ue_description_t *ue_ref)
     enb_ref->enb_id);
 
   ue_ref->s1_ue_state = S1AP_UE_INVALID_STATE;
+  s1ap_ue_index_remove_all(ue_ref);
   hashtable_ts_free(&enb_ref->ue_coll, ue_ref->enb_ue_s1ap_id);
   hashtable_ts_free(&g_s1ap_mme_id2assoc_id_coll, mme_ue_s1ap_id);
   if (!enb_ref->nb_ue_associated) {
@@ -848,6 +872,9 @@ void s1ap_remove_enb(enb_description_t *enb_ref)
     enb_ref->s1ap_enb_assoc_clean_up_timer.id = S1AP_TIMER_INACTIVE_ID;
   }
   enb_ref->s1_state = S1AP_INIT;
+  // UE descriptions are released with ue_coll, drop them from the indexes
+  hashtable_ts_apply_callback_on_elements(
+    &enb_ref->ue_coll, s1ap_ue_index_remove_cb, NULL, NULL);
   hashtable_ts_destroy(&enb_ref->ue_coll);
   hashtable_ts_free(&g_s1ap_enb_coll, enb_ref->sctp_assoc_id);
   nb_enb_associated--;
@@ -179,12 +179,21 @@ ue_description_t *s1ap_is_ue_enb_id_in_list(
   const enb_ue_s1ap_id_t enb_ue_s1ap_id);
 
 /** \brief Look for given ue mme id in the list
+ * Constant time, UEs of all eNBs are indexed by mme_ue_s1ap_id.
  * \param enb_id The unique ue_mme_id to search in list
  * @returns NULL if no UE matchs the ue_mme_id, or reference to the ue element in list if matches
  **/
 ue_description_t *s1ap_is_ue_mme_id_in_list(const mme_ue_s1ap_id_t ue_mme_id);
 ue_description_t *s1ap_is_s11_sgw_teid_in_list(const s11_teid_t teid);
 
+/** \brief Set the S11 SGW TEID of a UE, keeping the TEID index up to date
+ * \param ue_ref UE structure reference
+ * \param s11_sgw_teid new TEID, 0 removes the UE from the index
+ **/
+void s1ap_set_ue_s11_sgw_teid(
+  ue_description_t *const ue_ref,
+  const s11_teid_t s11_sgw_teid);
+
 /** \brief associate mainly 2(3) identifiers in S1AP layer: {mme_ue_s1ap_id_t, sctp_assoc_id (,enb_ue_s1ap_id)}
  **/
 void s1ap_notified_new_ue_mme_s1ap_id_association(
@@ -73,7 +73,7 @@ int sctp_itti_send_new_association(
 
 //------------------------------------------------------------------------------
 int sctp_itti_send_new_message_ind(
-  STOLEN_REF bstring *payload,
+  STOLEN_REF sctp_rx_buffer_t **buffer,
   const sctp_assoc_id_t assoc_id,
   const sctp_stream_id_t stream,
   const sctp_stream_id_t instreams,
@@ -81,8 +81,8 @@ int sctp_itti_send_new_message_ind(
 {
   MessageDef *message_p = itti_alloc_new_message(TASK_SCTP, SCTP_DATA_IND);
   if (message_p) {
-    SCTP_DATA_IND(message_p).payload = *payload;
-    STOLEN_REF *payload = NULL;
+    SCTP_DATA_IND(message_p).buffer = *buffer;
+    STOLEN_REF *buffer = NULL;
     SCTP_DATA_IND(message_p).stream = stream;
     SCTP_DATA_IND(message_p).assoc_id = assoc_id;
     SCTP_DATA_IND(message_p).instreams = instreams;
@@ -35,6 +35,7 @@
 #include "bstrlib.h"
 #include "common_types.h"
 #include "intertask_interface_types.h"
+#include "sctp_rx_buffer.h"
 
 int sctp_itti_send_lower_layer_conf(
   const task_id_t origin_task_id,
@@ -49,7 +50,7 @@ int sctp_itti_send_new_association(
   const sctp_stream_id_t outstreams);
 
 int sctp_itti_send_new_message_ind(
-  STOLEN_REF bstring *payload,
+  STOLEN_REF sctp_rx_buffer_t **buffer,
   const sctp_assoc_id_t assoc_id,
   const sctp_stream_id_t stream,
   const sctp_stream_id_t instreams,
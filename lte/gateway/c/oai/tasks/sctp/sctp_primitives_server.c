@@ -38,7 +38,8 @@
 #include <netinet/in.h>
 #include <netinet/sctp.h>
 #include <arpa/inet.h>
-#include <sys/select.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
 
 #include "dynamic_memory_check.h"
 #include "common_defs.h"
@@ -56,15 +57,15 @@
 #include "itti_types.h"
 #include "mme_default_values.h"
 #include "sctp_messages_types.h"
+#include "hashtable.h"
+#include "sctp_rx_buffer.h"
 
 #define SCTP_RC_ERROR -1
 #define SCTP_RC_NORMAL_READ 0
 #define SCTP_RC_DISCONNECT 1
+#define SCTP_RC_WOULD_BLOCK 2
 
 typedef struct sctp_association_s {
-  struct sctp_association_s *next_assoc; ///< Next association in the list
-  struct sctp_association_s
-    *previous_assoc; ///< Previous association in the list
   int sd;            ///< Socket descriptor
   uint32_t ppid;     ///< Payload protocol Identifier
   uint16_t
@@ -80,9 +81,15 @@ typedef struct sctp_association_s {
 } sctp_association_t;
 
 typedef struct sctp_descriptor_s {
-  // List of connected peers
-  struct sctp_association_s *available_connections_head;
-  struct sctp_association_s *available_connections_tail;
+  // Connected peers, contains sctp_association_s, key is assoc_id
+  hash_table_ts_t *associations;
+  // Messages not fully received yet, contains sctp_rx_partial_t, key is the
+  // socket descriptor. Only accessed by the receiver thread.
+  hash_table_t *partial_messages;
+  // Held by TASK_SCTP while it sends on an association and by the receiver
+  // thread while it removes one. The socket of a removed association is only
+  // closed afterwards, so no send can use a descriptor closed and reused.
+  pthread_mutex_t assoc_lock;
 
   uint32_t number_of_connections;
   uint16_t nb_instreams;
@@ -108,7 +115,7 @@ static int sctp_send_msg(
 
 // Association list related local functions prototypes
 static sctp_association_t *sctp_is_assoc_in_list(sctp_assoc_id_t assoc_id);
-static sctp_association_t *sctp_add_new_peer(void);
+static sctp_association_t *sctp_add_new_peer(sctp_assoc_id_t assoc_id);
 static int handle_assoc_change(
   int sd,
   uint32_t ppid,
@@ -119,7 +126,21 @@ static void sctp_dump_list(void);
 static void sctp_exit(void);
 
 //------------------------------------------------------------------------------
-static sctp_association_t *sctp_add_new_peer(void)
+static void sctp_free_association(void **assoc_pp)
+{
+  sctp_association_t *assoc_desc = (sctp_association_t *) *assoc_pp;
+
+  if (assoc_desc->peer_addresses) {
+    int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
+    if (rv)
+      OAILOG_DEBUG(
+        LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
+  }
+  free_wrapper(assoc_pp);
+}
+
+//------------------------------------------------------------------------------
+static sctp_association_t *sctp_add_new_peer(sctp_assoc_id_t assoc_id)
 {
   sctp_association_t *new_sctp_descriptor =
     calloc(1, sizeof(sctp_association_t));
@@ -133,16 +154,19 @@ static sctp_association_t *sctp_add_new_peer(void)
     return NULL;
   }
 
-  new_sctp_descriptor->next_assoc = NULL;
-  new_sctp_descriptor->previous_assoc = NULL;
-
-  if (sctp_desc.available_connections_tail == NULL) {
-    sctp_desc.available_connections_head = new_sctp_descriptor;
-    sctp_desc.available_connections_tail = sctp_desc.available_connections_head;
-  } else {
-    new_sctp_descriptor->previous_assoc = sctp_desc.available_connections_tail;
-    sctp_desc.available_connections_tail->next_assoc = new_sctp_descriptor;
-    sctp_desc.available_connections_tail = new_sctp_descriptor;
+  new_sctp_descriptor->assoc_id = assoc_id;
+  hashtable_rc_t hrc = hashtable_ts_insert(
+    sctp_desc.associations,
+    (const hash_key_t) assoc_id,
+    (void *) new_sctp_descriptor);
+  if (HASH_TABLE_OK != hrc) {
+    OAILOG_ERROR(
+      LOG_SCTP,
+      "Failed to insert new peer assoc id %d: %s\n",
+      assoc_id,
+      hashtable_rc_code2string(hrc));
+    free_wrapper((void **) &new_sctp_descriptor);
+    return NULL;
   }
 
   sctp_desc.number_of_connections++;
@@ -159,65 +183,30 @@ static sctp_association_t *sctp_is_assoc_in_list(sctp_assoc_id_t assoc_id)
     return NULL;
   }
 
-  for (assoc_desc = sctp_desc.available_connections_head; assoc_desc;
-       assoc_desc = assoc_desc->next_assoc) {
-    if (assoc_desc->assoc_id == assoc_id) {
-      break;
-    }
-  }
-
+  hashtable_ts_get(
+    sctp_desc.associations, (const hash_key_t) assoc_id, (void **) &assoc_desc);
   return assoc_desc;
 }
 
 //------------------------------------------------------------------------------
 static int sctp_remove_assoc_from_list(sctp_assoc_id_t assoc_id)
 {
-  sctp_association_t *assoc_desc = NULL;
+  if (assoc_id < 0) {
+    return -1;
+  }
 
   /*
    * Association not in the list
    */
-  if ((assoc_desc = sctp_is_assoc_in_list(assoc_id)) == NULL) {
+  pthread_mutex_lock(&sctp_desc.assoc_lock);
+  if (
+    hashtable_ts_free(sctp_desc.associations, (const hash_key_t) assoc_id) !=
+    HASH_TABLE_OK) {
+    pthread_mutex_unlock(&sctp_desc.assoc_lock);
     return -1;
   }
+  pthread_mutex_unlock(&sctp_desc.assoc_lock);
 
-  if (assoc_desc->next_assoc == NULL) {
-    if (assoc_desc->previous_assoc == NULL) {
-      /*
-       * Head and tail
-       */
-      sctp_desc.available_connections_head =
-        sctp_desc.available_connections_tail = NULL;
-    } else {
-      /*
-       * Not head but tail
-       */
-      sctp_desc.available_connections_tail = assoc_desc->previous_assoc;
-      assoc_desc->previous_assoc->next_assoc = NULL;
-    }
-  } else {
-    if (assoc_desc->previous_assoc == NULL) {
-      /*
-       * Head but not tail
-       */
-      sctp_desc.available_connections_head = assoc_desc->next_assoc;
-      assoc_desc->next_assoc->previous_assoc = NULL;
-    } else {
-      /*
-       * Not head and not tail
-       */
-      assoc_desc->previous_assoc->next_assoc = assoc_desc->next_assoc;
-      assoc_desc->next_assoc->previous_assoc = assoc_desc->previous_assoc;
-    }
-  }
-
-  if (assoc_desc->peer_addresses) {
-    int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
-    if (rv)
-      OAILOG_DEBUG(
-        LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
-  }
-  free_wrapper((void **) &assoc_desc);
   sctp_desc.number_of_connections--;
   return 0;
 }
@@ -258,21 +247,29 @@ static void sctp_dump_assoc(sctp_association_t *sctp_assoc_p)
 #endif
 }
 
+//------------------------------------------------------------------------------
+#if SCTP_DUMP_LIST
+static bool sctp_dump_assoc_cb(
+  __attribute__((unused)) const hash_key_t keyP,
+  void *const assoc_void,
+  __attribute__((unused)) void *parameterP,
+  __attribute__((unused)) void **resultP)
+{
+  sctp_dump_assoc((sctp_association_t *) assoc_void);
+  return false;
+}
+#endif
+
 //------------------------------------------------------------------------------
 static void sctp_dump_list(void)
 {
 #if SCTP_DUMP_LIST
-  sctp_association_t *sctp_assoc_p = sctp_desc.available_connections_head;
   OAILOG_DEBUG(
     LOG_SCTP,
     "SCTP list contains %d associations\n",
     sctp_desc.number_of_connections);
-
-  while (sctp_assoc_p != NULL) {
-    sctp_dump_assoc(sctp_assoc_p);
-    sctp_assoc_p = sctp_assoc_p->next_assoc;
-  }
-
+  hashtable_ts_apply_callback_on_elements(
+    sctp_desc.associations, sctp_dump_assoc_cb, NULL, NULL);
 #else
   sctp_dump_assoc(NULL);
 #endif
@@ -285,10 +282,13 @@ static int sctp_send_msg(
   STOLEN_REF bstring *payload)
 {
   sctp_association_t *assoc_desc = NULL;
+  int rc = 0;
 
   DevAssert(*payload);
 
+  pthread_mutex_lock(&sctp_desc.assoc_lock);
   if ((assoc_desc = sctp_is_assoc_in_list(sctp_assoc_id)) == NULL) {
+    pthread_mutex_unlock(&sctp_desc.assoc_lock);
     OAILOG_DEBUG(
       LOG_SCTP,
       "This assoc id has not been fount in list (%d)\n",
@@ -297,6 +297,7 @@ static int sctp_send_msg(
   }
 
   if (assoc_desc->sd == -1) {
+    pthread_mutex_unlock(&sctp_desc.assoc_lock);
     /*
      * The socket is invalid may be closed.
      */
@@ -332,20 +333,21 @@ static int sctp_send_msg(
       stream,
       0,
       0) < 0) {
-    bdestroy(*payload);
     OAILOG_ERROR(LOG_SCTP, "send: %s:%d\n", strerror(errno), errno);
-    return -1;
+    rc = -1;
+  } else {
+    OAILOG_DEBUG(
+      LOG_SCTP,
+      "Successfully sent %d bytes on stream %d\n",
+      blength(*payload),
+      stream);
+    assoc_desc->messages_sent++;
   }
-  OAILOG_DEBUG(
-    LOG_SCTP,
-    "Successfully sent %d bytes on stream %d\n",
-    blength(*payload),
-    stream);
+  pthread_mutex_unlock(&sctp_desc.assoc_lock);
+
   bdestroy(*payload);
   *payload = NULL;
-
-  assoc_desc->messages_sent++;
-  return 0;
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -482,49 +484,92 @@ err:
   return -1;
 }
 
+//------------------------------------------------------------------------------
+static int sctp_recv(
+  int sd,
+  void *data,
+  size_t size,
+  struct sctp_sndrcvinfo *sinfo,
+  int *flags)
+{
+  return sctp_recvmsg(sd, data, size, NULL, NULL, sinfo, flags);
+}
+
+//------------------------------------------------------------------------------
+static void sctp_free_partial_message(void **partial_pp)
+{
+  sctp_rx_partial_t *partial = (sctp_rx_partial_t *) *partial_pp;
+
+  sctp_rx_buffer_unref(&partial->buffer);
+  free_wrapper(partial_pp);
+}
+
 //------------------------------------------------------------------------------
 static inline int sctp_read_from_socket(int sd, uint32_t ppid)
 {
   int flags = 0, n;
-  socklen_t from_len = 0;
   struct sctp_sndrcvinfo sinfo = {0};
-  struct sockaddr_in6 addr = {0};
-  uint8_t buffer[SCTP_RECV_BUFFER_SIZE];
+  sctp_rx_partial_t message_start = {0};
+  sctp_rx_partial_t *partial = NULL;
+  sctp_rx_buffer_t *buffer = NULL;
+  int rc = SCTP_RC_NORMAL_READ;
 
   if (sd < 0) {
     return -1;
   }
 
-  memset((void *) &addr, 0, sizeof(struct sockaddr_in6));
-  from_len = (socklen_t) sizeof(struct sockaddr_in6);
-  memset((void *) &sinfo, 0, sizeof(struct sctp_sndrcvinfo));
-  n = sctp_recvmsg(
-    sd,
-    (void *) buffer,
-    SCTP_RECV_BUFFER_SIZE,
-    (struct sockaddr *) &addr,
-    &from_len,
-    &sinfo,
-    &flags);
-
-  if (n < 0) {
-    OAILOG_DEBUG(LOG_SCTP, "An error occured during read\n");
-    OAILOG_ERROR(LOG_SCTP, "sctp_recvmsg: %s:%d\n", strerror(errno), errno);
+  /*
+   * The socket is one-to-one, a message of the association still partially
+   * received by the previous wake-up is completed first.
+   */
+  if (
+    hashtable_get(
+      sctp_desc.partial_messages, (const hash_key_t) sd, (void **) &partial) !=
+    HASH_TABLE_OK) {
+    partial = &message_start;
+  }
+
+  rc = sctp_rx_buffer_recv(sd, sctp_recv, partial, &sinfo, &flags, &buffer);
+  if ((rc == SCTP_RX_RECV_WOULD_BLOCK) && (partial == &message_start)) {
+    if (message_start.buffer) {
+      // Kept until the end of the message is queued on the socket
+      partial = malloc(sizeof(sctp_rx_partial_t));
+      AssertFatal(partial, "Allocation of partial SCTP message failed");
+      *partial = message_start;
+      hashtable_insert(
+        sctp_desc.partial_messages, (const hash_key_t) sd, (void *) partial);
+    }
+  } else if ((rc != SCTP_RX_RECV_WOULD_BLOCK) && (partial != &message_start)) {
+    hashtable_free(sctp_desc.partial_messages, (const hash_key_t) sd);
+  }
+
+  if (rc == SCTP_RX_RECV_WOULD_BLOCK) {
+    return SCTP_RC_WOULD_BLOCK;
+  } else if (rc == SCTP_RX_RECV_CLOSED) {
+    OAILOG_DEBUG(LOG_SCTP, "[%d] Socket closed by the peer\n", sd);
+    return SCTP_RC_DISCONNECT;
+  } else if (rc != SCTP_RX_RECV_MESSAGE) {
     return SCTP_RC_ERROR;
   }
+  n = blength(&buffer->payload);
+  rc = SCTP_RC_NORMAL_READ;
 
   if (flags & MSG_NOTIFICATION) {
-    union sctp_notification *snp = (union sctp_notification *) buffer;
+    union sctp_notification *snp = (union sctp_notification *) buffer->data;
 
     switch (snp->sn_header.sn_type) {
       case SCTP_SHUTDOWN_EVENT: {
         OAILOG_DEBUG(LOG_SCTP, "SCTP_SHUTDOWN_EVENT received\n");
-        return sctp_handle_com_down(
+        rc = sctp_handle_com_down(
           (sctp_assoc_id_t) snp->sn_shutdown_event.sse_assoc_id);
+        sctp_rx_buffer_unref(&buffer);
+        return rc;
       }
       case SCTP_ASSOC_CHANGE: {
         OAILOG_DEBUG(LOG_SCTP, "SCTP association change event received\n");
-        return handle_assoc_change(sd, ppid, &snp->sn_assoc_change);
+        rc = handle_assoc_change(sd, ppid, &snp->sn_assoc_change);
+        sctp_rx_buffer_unref(&buffer);
+        return rc;
       }
       default: {
         OAILOG_WARNING(
@@ -542,6 +587,7 @@ static inline int sctp_read_from_socket(int sd, uint32_t ppid)
       (association = sctp_is_assoc_in_list(
          (sctp_assoc_id_t) sinfo.sinfo_assoc_id)) == NULL) {
       // TODO: handle this case
+      sctp_rx_buffer_unref(&buffer);
       return SCTP_RC_ERROR;
     }
 
@@ -557,28 +603,28 @@ static inline int sctp_read_from_socket(int sd, uint32_t ppid)
         "Received data from peer with unsollicited PPID %d, expecting %d\n",
         ntohl(sinfo.sinfo_ppid),
         association->ppid);
+      sctp_rx_buffer_unref(&buffer);
       return SCTP_RC_ERROR;
     }
 
     OAILOG_DEBUG(
       LOG_SCTP,
-      "[%d][%d] Msg of length %d received from port %u, on stream %d, PPID "
-      "%d\n",
+      "[%d][%d] Msg of length %d received on stream %d, PPID %d\n",
       sinfo.sinfo_assoc_id,
       sd,
       n,
-      ntohs(addr.sin6_port),
       sinfo.sinfo_stream,
       ntohl(sinfo.sinfo_ppid));
-    bstring payload = blk2bstr(buffer, n);
     sctp_itti_send_new_message_ind(
-      &payload,
+      &buffer,
       (sctp_assoc_id_t) sinfo.sinfo_assoc_id,
       sinfo.sinfo_stream,
       association->instreams,
       association->outstreams);
   }
 
+  // No-op if the buffer has been handed over to S1AP
+  sctp_rx_buffer_unref(&buffer);
   return SCTP_RC_NORMAL_READ;
 }
 
@@ -614,24 +660,96 @@ static int sctp_handle_reset(const sctp_assoc_id_t assoc_id)
 }
 
 //------------------------------------------------------------------------------
-void *sctp_receiver_thread(void *args_p)
+static int sctp_set_non_blocking(int sd)
 {
-  sctp_arg_t sctp_arg_p;
+  int flags = fcntl(sd, F_GETFL, 0);
 
-  /*
-   * maximum file descriptor number
-   */
-  int fdmax, clientsock, i;
+  if ((flags < 0) || (fcntl(sd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+    OAILOG_ERROR(LOG_SCTP, "[%d] fcntl: %s:%d\n", sd, strerror(errno), errno);
+    return -1;
+  }
+  return 0;
+}
 
-  /*
-   * master file descriptor list
-   */
-  fd_set master;
+//------------------------------------------------------------------------------
+// Accepts all pending connections, the listener is edge-triggered.
+static int sctp_accept_connections(int epoll_fd, int listen_sd)
+{
+  struct epoll_event event = {0};
+  int clientsock = -1;
 
-  /*
-   * temp file descriptor list for select()
-   */
-  fd_set read_fds;
+  while (1) {
+    if ((clientsock = accept(listen_sd, NULL, NULL)) < 0) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        return 0;
+      }
+      if ((errno == EINTR) || (errno == ECONNABORTED)) {
+        continue;
+      }
+      OAILOG_ERROR(
+        LOG_SCTP, "[%d] accept: %s:%d\n", listen_sd, strerror(errno), errno);
+      return -1;
+    }
+    if (sctp_set_non_blocking(clientsock) < 0) {
+      close(clientsock);
+      continue;
+    }
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = clientsock;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clientsock, &event) < 0) {
+      OAILOG_ERROR(
+        LOG_SCTP,
+        "[%d] epoll_ctl: %s:%d\n",
+        clientsock,
+        strerror(errno),
+        errno);
+      close(clientsock);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Reads up to SCTP_RECV_MSGS_PER_WAKEUP messages on an edge-triggered socket.
+// If the socket is not drained by then, it is re-armed so that epoll reports
+// it again after the other ready sockets have been served.
+static void sctp_drain_socket(int epoll_fd, int sd, uint32_t ppid)
+{
+  struct epoll_event event = {0};
+  int ret = SCTP_RC_NORMAL_READ;
+
+  for (int n = 0; n < SCTP_RECV_MSGS_PER_WAKEUP; n++) {
+    ret = sctp_read_from_socket(sd, ppid);
+    if (ret == SCTP_RC_WOULD_BLOCK) {
+      return;
+    }
+    if (ret == SCTP_RC_DISCONNECT) {
+      /*
+       * Association is gone, stop polling this socket. It has been removed
+       * from the list under assoc_lock, TASK_SCTP does not send on it anymore.
+       */
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sd, NULL);
+      hashtable_free(sctp_desc.partial_messages, (const hash_key_t) sd);
+      close(sd);
+      return;
+    }
+  }
+
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = sd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sd, &event) < 0) {
+    OAILOG_ERROR(
+      LOG_SCTP, "[%d] epoll_ctl: %s:%d\n", sd, strerror(errno), errno);
+  }
+}
+
+//------------------------------------------------------------------------------
+void *sctp_receiver_thread(void *args_p)
+{
+  sctp_arg_t sctp_arg_p;
+  struct epoll_event event = {0};
+  struct epoll_event events[SCTP_EPOLL_MAX_EVENTS];
+  int epoll_fd = -1;
+  int nb_events = 0;
 
   if (args_p == NULL) {
     pthread_exit(NULL);
@@ -639,78 +757,63 @@ void *sctp_receiver_thread(void *args_p)
 
   memcpy(&sctp_arg_p, args_p, sizeof sctp_arg_p);
   free_wrapper(&args_p);
+  // Receive buffers pool has been initialized by another thread
+  LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
 
-  /*
-   * clear the master and temp sets
-   */
-  FD_ZERO(&master);
-  FD_ZERO(&read_fds);
-  FD_SET(sctp_arg_p.sd, &master);
-  fdmax = sctp_arg_p.sd; /* so far, it's this one */
+  if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+    OAILOG_ERROR(
+      LOG_SCTP,
+      "[%d] epoll_create1: %s\n",
+      sctp_arg_p.sd,
+      strerror(errno));
+    close(sctp_arg_p.sd);
+    pthread_exit(NULL);
+  }
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = sctp_arg_p.sd;
+  if (
+    (sctp_set_non_blocking(sctp_arg_p.sd) < 0) ||
+    (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sctp_arg_p.sd, &event) < 0)) {
+    OAILOG_ERROR(
+      LOG_SCTP,
+      "[%d] Cannot poll listener: %s\n",
+      sctp_arg_p.sd,
+      strerror(errno));
+    close(epoll_fd);
+    close(sctp_arg_p.sd);
+    pthread_exit(NULL);
+  }
 
   while (1) {
-    memcpy(&read_fds, &master, sizeof(master));
+    nb_events = epoll_wait(epoll_fd, events, SCTP_EPOLL_MAX_EVENTS, -1);
 
-    if (select(fdmax + 1, &read_fds, NULL, NULL, NULL) == -1) {
+    if (nb_events < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
       OAILOG_ERROR(
-        LOG_SCTP, "[%d] Select() error: %s\n", sctp_arg_p.sd, strerror(errno));
-      free_wrapper((void **) &args_p);
+        LOG_SCTP,
+        "[%d] epoll_wait() error: %s\n",
+        sctp_arg_p.sd,
+        strerror(errno));
+      close(epoll_fd);
       close(sctp_arg_p.sd);
-      args_p = NULL;
       pthread_exit(NULL);
     }
 
-    for (i = 0; i <= fdmax; i++) {
-      if (FD_ISSET(i, &read_fds)) {
-        if (i == sctp_arg_p.sd) {
-          /*
-           * There is data to read on listener socket. This means we have to accept
-           * * * * the connection.
-           */
-          if ((clientsock = accept(sctp_arg_p.sd, NULL, NULL)) < 0) {
-            OAILOG_ERROR(
-              LOG_SCTP,
-              "[%d] accept: %s:%d\n",
-              sctp_arg_p.sd,
-              strerror(errno),
-              errno);
-            free_wrapper((void **) &args_p);
-            close(sctp_arg_p.sd);
-            args_p = NULL;
-            pthread_exit(NULL);
-          } else {
-            FD_SET(clientsock, &master); /* add to master set */
-
-            if (clientsock > fdmax) {
-              /*
-               * keep track of the maximum
-               */
-              fdmax = clientsock;
-            }
-          }
-        } else {
-          int ret;
-
-          /*
-           * Read from socket
-           */
-          ret = sctp_read_from_socket(i, sctp_arg_p.ppid);
-
-          /*
-           * When the socket is disconnected we have to update
-           * * * * the fd_set.
-           */
-          if (ret == SCTP_RC_DISCONNECT) {
-            /*
-             * Remove the socket from the FD set and update the max sd
-             */
-            FD_CLR(i, &master);
-
-            if (i == fdmax) {
-              while (FD_ISSET(fdmax, &master) == false) fdmax -= 1;
-            }
-          }
+    for (int i = 0; i < nb_events; i++) {
+      if (events[i].data.fd == sctp_arg_p.sd) {
+        /*
+         * There is data to read on listener socket. This means we have to
+         * accept the connection(s).
+         */
+        if (sctp_accept_connections(epoll_fd, sctp_arg_p.sd) < 0) {
+          close(epoll_fd);
+          close(sctp_arg_p.sd);
+          pthread_exit(NULL);
         }
+      } else {
+        sctp_drain_socket(epoll_fd, events[i].data.fd, sctp_arg_p.ppid);
       }
     }
   }
@@ -816,7 +919,9 @@ sctp_association_t *add_new_association(
   struct sctp_assoc_change *sctp_assoc_changed)
 {
   sctp_association_t *new_association = NULL;
-  if ((new_association = sctp_add_new_peer()) == NULL) {
+  if (
+    (new_association = sctp_add_new_peer(
+       (sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id)) == NULL) {
     OAILOG_ERROR(LOG_SCTP, "Failed to allocate new sctp peer \n");
     return NULL;
   }
@@ -825,8 +930,6 @@ sctp_association_t *add_new_association(
   new_association->ppid = ppid;
   new_association->instreams = sctp_assoc_changed->sac_inbound_streams;
   new_association->outstreams = sctp_assoc_changed->sac_outbound_streams;
-  new_association->assoc_id =
-    (sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id;
   sctp_get_localaddresses(sd, NULL, NULL);
   sctp_get_peeraddresses(
     sd, &new_association->peer_addresses, &new_association->nb_peer_addresses);
@@ -899,6 +1002,25 @@ int sctp_init(const mme_config_t *mme_config_p)
    */
   sctp_desc.nb_instreams = mme_config_p->sctp_config.in_streams;
   sctp_desc.nb_outstreams = mme_config_p->sctp_config.out_streams;
+  pthread_mutex_init(&sctp_desc.assoc_lock, NULL);
+
+  bstring bs = bfromcstr("sctp_associations");
+  sctp_desc.associations = hashtable_ts_create(
+    mme_config_p->max_enbs, NULL, sctp_free_association, bs);
+  bdestroy_wrapper(&bs);
+  if (!sctp_desc.associations) {
+    OAILOG_ERROR(LOG_SCTP, "Failed to create association table\n");
+    return -1;
+  }
+  bs = bfromcstr("sctp_partial_messages");
+  sctp_desc.partial_messages = hashtable_create(
+    mme_config_p->max_enbs, NULL, sctp_free_partial_message, bs);
+  bdestroy_wrapper(&bs);
+  if (!sctp_desc.partial_messages) {
+    OAILOG_ERROR(LOG_SCTP, "Failed to create partial message table\n");
+    return -1;
+  }
+  sctp_rx_buffer_pool_init(SCTP_RX_BUFFER_POOL_SIZE);
 
   if (itti_create_task(TASK_SCTP, &sctp_intertask_interface, NULL) < 0) {
     OAILOG_ERROR(LOG_SCTP, "create task failed\n");
@@ -910,6 +1032,21 @@ int sctp_init(const mme_config_t *mme_config_p)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+static bool sctp_close_association_cb(
+  __attribute__((unused)) const hash_key_t keyP,
+  void *const assoc_void,
+  __attribute__((unused)) void *parameterP,
+  __attribute__((unused)) void **resultP)
+{
+  sctp_association_t *sctp_assoc_p = (sctp_association_t *) assoc_void;
+
+  if (sctp_assoc_p->sd >= 0) {
+    close(sctp_assoc_p->sd);
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 static void sctp_exit(void)
 {
@@ -924,22 +1061,13 @@ static void sctp_exit(void)
       strerror(rv));
   ;
 
-  sctp_association_t *sctp_assoc_p = sctp_desc.available_connections_head;
-  sctp_association_t *next_sctp_assoc_p = sctp_desc.available_connections_head;
-
-  while (next_sctp_assoc_p) {
-    next_sctp_assoc_p = sctp_assoc_p->next_assoc;
-    if (sctp_assoc_p->peer_addresses) {
-      close(sctp_assoc_p->sd);
-      rv = sctp_freepaddrs(sctp_assoc_p->peer_addresses);
-      if (rv)
-        OAILOG_DEBUG(
-          LOG_SCTP,
-          "sctp_freepaddrs(%p) failed\n",
-          sctp_assoc_p->peer_addresses);
-    }
-    free_wrapper((void **) &sctp_assoc_p);
-    sctp_desc.number_of_connections--;
-  }
+  hashtable_ts_apply_callback_on_elements(
+    sctp_desc.associations, sctp_close_association_cb, NULL, NULL);
+  hashtable_ts_destroy(sctp_desc.associations);
+  sctp_desc.associations = NULL;
+  hashtable_destroy(sctp_desc.partial_messages);
+  sctp_desc.partial_messages = NULL;
+  sctp_desc.number_of_connections = 0;
+  sctp_rx_buffer_pool_exit();
   OAI_FPRINTF_INFO("TASK_SCTP terminated\n");
 }
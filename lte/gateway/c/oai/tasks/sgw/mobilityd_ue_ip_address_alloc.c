@@ -21,17 +21,135 @@
 
 #include "pgw_ue_ip_address_alloc.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "assertions.h"
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "intertask_interface.h"
 #include "log.h"
 #include "rpc_client.h"
 #include "service303.h"
 
 struct in_addr;
 
+#define UE_IP_IMSI_MAP_SIZE 1024
+
+// Local copy of the UE IPv4 address to IMSI mapping kept by mobilityd, so
+// that paging does not need a round trip to mobilityd. Keys are addresses in
+// network byte order, see ue_imsi_to_value() for the values.
+static hash_table_uint64_ts_t *ue_ip_imsi_map = NULL;
+
+//------------------------------------------------------------------------------
+// The IMSI digits count is kept in the top byte since IMSIs of test networks
+// start with zeros (MCC 001)
+static uint64_t ue_imsi_to_value(const char *imsi)
+{
+  uint64_t value = 0;
+  uint64_t nb_digits = 0;
+
+  for (; (imsi[nb_digits]) && (nb_digits < IMSI_BCD_DIGITS_MAX); nb_digits++) {
+    value = (value * 10) + (imsi[nb_digits] - '0');
+  }
+  return (nb_digits << 56) | value;
+}
+
+static void ue_value_to_imsi(const uint64_t value, char *imsi)
+{
+  int nb_digits = (int) (value >> 56);
+  uint64_t digits = value & ((UINT64_C(1) << 56) - 1);
+
+  imsi[nb_digits] = '\0';
+  for (int i = nb_digits - 1; i >= 0; i--) {
+    imsi[i] = '0' + (digits % 10);
+    digits /= 10;
+  }
+}
+
+static void ue_ip_imsi_map_update(const char *imsi, const struct in_addr *addr)
+{
+  if (ue_ip_imsi_map) {
+    hashtable_uint64_ts_insert(
+      ue_ip_imsi_map, (const hash_key_t) addr->s_addr, ue_imsi_to_value(imsi));
+  }
+}
+
+static void ue_ip_imsi_map_remove(const struct in_addr *addr)
+{
+  if (ue_ip_imsi_map) {
+    hashtable_uint64_ts_free(ue_ip_imsi_map, (const hash_key_t) addr->s_addr);
+  }
+}
+
 int allocate_ue_ipv4_address(const char *imsi, struct in_addr *addr)
 {
   // Call PGW IP Address allocator
   int ip_alloc_status = RPC_STATUS_OK;
   ip_alloc_status = allocate_ipv4_address(imsi, addr);
+  return check_ue_ipv4_address_allocation(imsi, addr, ip_alloc_status);
+}
+
+//------------------------------------------------------------------------------
+// Called from the gRPC response thread, hands the result over to TASK_PGW_APP
+static void ue_ipv4_address_allocated(
+  int status,
+  struct in_addr addr,
+  void *callback_arg)
+{
+  itti_s5_ip_allocation_response_t *ip_alloc_ctxt_p =
+    (itti_s5_ip_allocation_response_t *) callback_arg;
+  MessageDef *message_p =
+    itti_alloc_new_message(TASK_PGW_APP, S5_IP_ALLOCATION_RESPONSE);
+  AssertFatal(message_p, "Allocation of S5_IP_ALLOCATION_RESPONSE failed");
+
+  ip_alloc_ctxt_p->status = status;
+  ip_alloc_ctxt_p->ipv4_address = addr;
+  S5_IP_ALLOCATION_RESPONSE(message_p) = *ip_alloc_ctxt_p;
+  free_wrapper((void **) &ip_alloc_ctxt_p);
+  itti_send_msg_to_task(TASK_PGW_APP, INSTANCE_DEFAULT, message_p);
+}
+
+void allocate_ue_ipv4_address_async(
+  const char *imsi,
+  const itti_s5_create_bearer_request_t *const bearer_req_p)
+{
+  // Completed by the callback and sent as is to TASK_PGW_APP
+  itti_s5_ip_allocation_response_t *ip_alloc_ctxt_p =
+    calloc(1, sizeof(itti_s5_ip_allocation_response_t));
+  AssertFatal(ip_alloc_ctxt_p, "Allocation of IP allocation context failed");
+
+  ip_alloc_ctxt_p->bearer_request = *bearer_req_p;
+  strncpy(ip_alloc_ctxt_p->imsi, imsi, IMSI_BCD_DIGITS_MAX);
+  allocate_ipv4_address_async(imsi, ue_ipv4_address_allocated, ip_alloc_ctxt_p);
+}
+
+//------------------------------------------------------------------------------
+// Called from the gRPC response thread, only reports the failures
+static void ue_ipv4_address_released(
+  int status,
+  struct in_addr addr,
+  __attribute__((unused)) void *callback_arg)
+{
+  if (status != RPC_STATUS_OK) {
+    char ip_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr, ip_str, INET_ADDRSTRLEN);
+    OAILOG_ERROR(
+      LOG_SPGW_APP,
+      "Failed to release IPv4 address %s, release status = %d\n",
+      ip_str,
+      status);
+  }
+}
+
+int check_ue_ipv4_address_allocation(
+  const char *imsi,
+  struct in_addr *addr,
+  int ip_alloc_status)
+{
   if (ip_alloc_status == RPC_STATUS_ALREADY_EXISTS) {
     increment_counter(
       "ue_pdn_connection",
@@ -45,7 +163,8 @@ int allocate_ue_ipv4_address(const char *imsi, struct in_addr *addr)
      * This implies that UE session was not release properly.
      * Release the IP address so that subsequent attempt is successfull
      */
-    release_ipv4_address(imsi, addr);
+    ue_ip_imsi_map_remove(addr);
+    release_ipv4_address_async(imsi, addr, ue_ipv4_address_released, NULL);
     // TODO - Release the GTP-tunnel corresponding to this IP address
   }
 
@@ -54,6 +173,8 @@ int allocate_ue_ipv4_address(const char *imsi, struct in_addr *addr)
       LOG_SPGW_APP,
       "Failed to allocate IPv4 PAA for PDN type IPv4. IP alloc status = %d \n",
       ip_alloc_status);
+  } else {
+    ue_ip_imsi_map_update(imsi, addr);
   }
   return ip_alloc_status;
 }
@@ -68,13 +189,47 @@ int release_ue_ipv4_address(const char *imsi, struct in_addr *addr)
     "ipv4",
     "result",
     "ip_address_released");
+  ue_ip_imsi_map_remove(addr);
   // Release IP address back to PGW IP Address allocator
   return release_ipv4_address(imsi, addr);
 }
 
+int get_imsi_from_ue_ipv4_address(const struct in_addr *addr, char *imsi)
+{
+  uint64_t value = 0;
+  char *mobilityd_imsi = NULL;
+
+  if (
+    (ue_ip_imsi_map) &&
+    (HASH_TABLE_OK ==
+     hashtable_uint64_ts_get(
+       ue_ip_imsi_map, (const hash_key_t) addr->s_addr, &value))) {
+    ue_value_to_imsi(value, imsi);
+    return RPC_STATUS_OK;
+  }
+
+  /*
+   * Not allocated by this process (i.e. before a restart), ask mobilityd.
+   * The answer is not cached: the address may be released by TASK_SPGW_APP
+   * while the call is in flight, and the mapping would then outlive it.
+   */
+  int rv = get_subscriber_id_from_ipv4(addr, &mobilityd_imsi);
+  if (mobilityd_imsi) {
+    if (RPC_STATUS_OK == rv) {
+      strncpy(imsi, mobilityd_imsi, IMSI_BCD_DIGITS_MAX);
+      imsi[IMSI_BCD_DIGITS_MAX] = '\0';
+    }
+    free(mobilityd_imsi);
+  }
+  return rv;
+}
+
 void pgw_ip_address_pool_init(void)
 {
-  return;
+  bstring b = bfromcstr("pgw_ue_ip_imsi_map");
+  ue_ip_imsi_map = hashtable_uint64_ts_create(UE_IP_IMSI_MAP_SIZE, NULL, b);
+  bdestroy_wrapper(&b);
+  AssertFatal(ue_ip_imsi_map, "Allocation of UE IP to IMSI map failed");
 }
 
 int get_ip_block(struct in_addr *netaddr, uint32_t *netmask)
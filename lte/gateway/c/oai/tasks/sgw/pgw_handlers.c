@@ -42,6 +42,7 @@
 #include "pgw_ue_ip_address_alloc.h"
 #include "pgw_handlers.h"
 #include "pcef_handlers.h"
+#include "rpc_client.h"
 #include "common_defs.h"
 #include "3gpp_23.003.h"
 #include "3gpp_23.401.h"
@@ -64,17 +65,105 @@ static void get_session_req_data(
 extern sgw_app_t sgw_app;
 extern spgw_config_t spgw_config;
 //--------------------------------------------------------------------------------
+// Fills the SGi endpoint response of a bearer request, except the UE address
+static void pgw_fill_sgi_create_endpoint_resp(
+  const itti_s5_create_bearer_request_t *const bearer_req_p,
+  s_plus_p_gw_eps_bearer_context_information_t *const new_bearer_ctxt_info_p,
+  itti_sgi_create_end_point_response_t *const sgi_create_endpoint_resp_p,
+  protocol_configuration_options_ids_t *const pco_ids_p)
+{
+  sgw_eps_bearer_ctxt_t *eps_bearer_entry_p = NULL;
+
+  /*hash_rc = hashtable_ts_get
+  (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array, bearer_req_p->eps_bearer_id, (void **)&eps_bearer_entry_p);
+  DevAssert (HASH_TABLE_OK == hash_rc);*/
+  eps_bearer_entry_p =
+    new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection
+      .sgw_eps_bearers_array[EBI_TO_INDEX(bearer_req_p->eps_bearer_id)];
+  OAILOG_DEBUG(
+    LOG_PGW_APP,
+    "Updated eps_bearer_entry_p eps_b_id %u with SGW S1U teid %u\n",
+    bearer_req_p->eps_bearer_id,
+    bearer_req_p->S1u_teid);
+  eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up = bearer_req_p->S1u_teid;
+  memset(
+    sgi_create_endpoint_resp_p,
+    0,
+    sizeof(itti_sgi_create_end_point_response_t));
+
+  //--------------------------------------------------------------------------
+  // PCO processing
+  //--------------------------------------------------------------------------
+  pgw_process_bearer_pco_request(
+    &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message
+       .pco,
+    &sgi_create_endpoint_resp_p->pco,
+    pco_ids_p);
+
+  //--------------------------------------------------------------------------
+  // IP forward will forward packets to this teid
+  sgi_create_endpoint_resp_p->context_teid = bearer_req_p->context_teid;
+  sgi_create_endpoint_resp_p->sgw_S1u_teid = bearer_req_p->S1u_teid;
+  sgi_create_endpoint_resp_p->eps_bearer_id = bearer_req_p->eps_bearer_id;
+  // TO DO NOW
+  sgi_create_endpoint_resp_p->paa.pdn_type =
+    new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message
+      .pdn_type;
+}
 
+//------------------------------------------------------------------------------
+static void pgw_send_create_bearer_response(
+  const itti_s5_create_bearer_request_t *const bearer_req_p,
+  s_plus_p_gw_eps_bearer_context_information_t *const new_bearer_ctxt_info_p,
+  const itti_sgi_create_end_point_response_t *const sgi_create_endpoint_resp_p)
+{
+  MessageDef *message_p = NULL;
+
+  if (
+    spgw_config.pgw_config.relay_enabled &&
+    sgi_create_endpoint_resp_p->status == SGI_STATUS_OK) {
+    // create session in PCEF and return
+    char ip_str[INET_ADDRSTRLEN];
+    inet_ntop(
+      AF_INET,
+      &(sgi_create_endpoint_resp_p->paa.ipv4_address.s_addr),
+      ip_str,
+      INET_ADDRSTRLEN);
+    struct pcef_create_session_data session_data;
+    get_session_req_data(
+      &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message,
+      &session_data);
+    pcef_create_session(
+      (char *)
+        new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi.digit,
+      ip_str,
+      &session_data,
+      *sgi_create_endpoint_resp_p,
+      *bearer_req_p);
+    return;
+  }
+  message_p = itti_alloc_new_message(TASK_SPGW_APP, S5_CREATE_BEARER_RESPONSE);
+  itti_s5_create_bearer_response_t *s5_response =
+    &message_p->ittiMsg.s5_create_bearer_response;
+  memset(s5_response, 0, sizeof(itti_s5_create_bearer_response_t));
+  s5_response->context_teid = bearer_req_p->context_teid;
+  s5_response->S1u_teid = bearer_req_p->S1u_teid;
+  s5_response->eps_bearer_id = bearer_req_p->eps_bearer_id;
+  s5_response->sgi_create_endpoint_resp = *sgi_create_endpoint_resp_p;
+  s5_response->failure_cause = S5_OK;
+  itti_send_msg_to_task(TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
 int pgw_handle_create_bearer_request(
   const itti_s5_create_bearer_request_t *const bearer_req_p)
 {
-  // assign the IP here and just send back a S5_CREATE_BEARER_RESPONSE
+  // Start the IP allocation, the S5_CREATE_BEARER_RESPONSE is sent once
+  // mobilityd answered, see pgw_handle_ip_allocation_response()
   s_plus_p_gw_eps_bearer_context_information_t *new_bearer_ctxt_info_p = NULL;
-  MessageDef *message_p = NULL;
-  sgw_eps_bearer_ctxt_t *eps_bearer_entry_p = NULL;
   hashtable_rc_t hash_rc = HASH_TABLE_OK;
   itti_sgi_create_end_point_response_t sgi_create_endpoint_resp = {0};
-  struct in_addr inaddr;
+  protocol_configuration_options_ids_t pco_ids;
   char *imsi = NULL;
   OAILOG_FUNC_IN(LOG_PGW_APP);
 
@@ -89,50 +178,11 @@ int pgw_handle_create_bearer_request(
     (void **) &new_bearer_ctxt_info_p);
 
   if (HASH_TABLE_OK == hash_rc) {
-    /*hash_rc = hashtable_ts_get
-    (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array, bearer_req_p->eps_bearer_id, (void **)&eps_bearer_entry_p);
-    DevAssert (HASH_TABLE_OK == hash_rc);*/
-    eps_bearer_entry_p =
-      new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection
-        .sgw_eps_bearers_array[EBI_TO_INDEX(bearer_req_p->eps_bearer_id)];
-    OAILOG_DEBUG(
-      LOG_PGW_APP,
-      "Updated eps_bearer_entry_p eps_b_id %u with SGW S1U teid %u\n",
-      bearer_req_p->eps_bearer_id,
-      bearer_req_p->S1u_teid);
-    eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up = bearer_req_p->S1u_teid;
-    memset(
+    pgw_fill_sgi_create_endpoint_resp(
+      bearer_req_p,
+      new_bearer_ctxt_info_p,
       &sgi_create_endpoint_resp,
-      0,
-      sizeof(itti_sgi_create_end_point_response_t));
-
-    //--------------------------------------------------------------------------
-    // PCO processing
-    //--------------------------------------------------------------------------
-    protocol_configuration_options_t *pco_req =
-      &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message
-         .pco;
-    protocol_configuration_options_t pco_resp = {0};
-    protocol_configuration_options_ids_t pco_ids;
-    memset(&pco_ids, 0, sizeof pco_ids);
-
-    // TODO: perhaps change to a nonfatal assert?
-    AssertFatal(
-      0 == pgw_process_pco_request(pco_req, &pco_resp, &pco_ids),
-      "Error in processing PCO in request");
-    copy_protocol_configuration_options(
-      &sgi_create_endpoint_resp.pco, &pco_resp);
-    clear_protocol_configuration_options(&pco_resp);
-
-    //--------------------------------------------------------------------------
-    // IP forward will forward packets to this teid
-    sgi_create_endpoint_resp.context_teid = bearer_req_p->context_teid;
-    sgi_create_endpoint_resp.sgw_S1u_teid = bearer_req_p->S1u_teid;
-    sgi_create_endpoint_resp.eps_bearer_id = bearer_req_p->eps_bearer_id;
-    // TO DO NOW
-    sgi_create_endpoint_resp.paa.pdn_type =
-      new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message
-        .pdn_type;
+      &pco_ids);
 
     imsi =
       (char *)
@@ -161,33 +211,9 @@ int pgw_handle_create_bearer_request(
         // and using them here in conditional logic. We will also want to
         // implement different logic between the PDN types.
         if (!pco_ids.ci_ipv4_address_allocation_via_dhcpv4) {
-          if (0 == allocate_ue_ipv4_address(imsi, &inaddr)) {
-            increment_counter(
-              "ue_pdn_connection",
-              1,
-              2,
-              "pdn_type",
-              "ipv4",
-              "result",
-              "success");
-            sgi_create_endpoint_resp.paa.ipv4_address = inaddr;
-            OAILOG_DEBUG(
-              LOG_PGW_APP, "Allocated IPv4 address for imsi <%s>\n", imsi);
-            sgi_create_endpoint_resp.status = SGI_STATUS_OK;
-          } else {
-            increment_counter(
-              "ue_pdn_connection",
-              1,
-              2,
-              "pdn_type",
-              "ipv4",
-              "result",
-              "failure");
-            OAILOG_ERROR(
-              LOG_PGW_APP, "Failed to allocate IPv4 PAA for PDN type IPv4\n");
-            sgi_create_endpoint_resp.status =
-              SGI_STATUS_ERROR_ALL_DYNAMIC_ADDRESSES_OCCUPIED;
-          }
+          allocate_ue_ipv4_address_async(imsi, bearer_req_p);
+          clear_protocol_configuration_options(&sgi_create_endpoint_resp.pco);
+          OAILOG_FUNC_RETURN(LOG_PGW_APP, RETURNok);
         }
 
         break;
@@ -202,36 +228,9 @@ int pgw_handle_create_bearer_request(
         break;
 
       case IPv4_AND_v6:
-        if (0 == allocate_ue_ipv4_address(imsi, &inaddr)) {
-          increment_counter(
-            "ue_pdn_connection",
-            1,
-            2,
-            "pdn_type",
-            "ipv4v6",
-            "result",
-            "success");
-          sgi_create_endpoint_resp.paa.ipv4_address = inaddr;
-          OAILOG_DEBUG(LOG_PGW_APP, "Allocated IPv4 address\n");
-          sgi_create_endpoint_resp.status = SGI_STATUS_OK;
-          sgi_create_endpoint_resp.paa.pdn_type = IPv4;
-        } else {
-          increment_counter(
-            "ue_pdn_connection",
-            1,
-            2,
-            "pdn_type",
-            "ipv4v6",
-            "result",
-            "failure");
-          OAILOG_ERROR(
-            LOG_PGW_APP,
-            "Failed to allocate IPv4 PAA for PDN type IPv4_AND_v6\n");
-          sgi_create_endpoint_resp.status =
-            SGI_STATUS_ERROR_ALL_DYNAMIC_ADDRESSES_OCCUPIED;
-        }
-
-        break;
+        allocate_ue_ipv4_address_async(imsi, bearer_req_p);
+        clear_protocol_configuration_options(&sgi_create_endpoint_resp.pco);
+        OAILOG_FUNC_RETURN(LOG_PGW_APP, RETURNok);
 
       default:
         AssertFatal(
@@ -246,30 +245,76 @@ int pgw_handle_create_bearer_request(
       bearer_req_p->context_teid);
     sgi_create_endpoint_resp.status = SGI_STATUS_ERROR_CONTEXT_NOT_FOUND;
   }
-  if (
-    spgw_config.pgw_config.relay_enabled &&
-    sgi_create_endpoint_resp.status == SGI_STATUS_OK) {
-    // create session in PCEF and return
-    char ip_str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(inaddr.s_addr), ip_str, INET_ADDRSTRLEN);
-    struct pcef_create_session_data session_data;
-    get_session_req_data(
-      &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message,
-      &session_data);
-    pcef_create_session(
-      imsi, ip_str, &session_data, sgi_create_endpoint_resp, *bearer_req_p);
+  pgw_send_create_bearer_response(
+    bearer_req_p, new_bearer_ctxt_info_p, &sgi_create_endpoint_resp);
+  OAILOG_FUNC_RETURN(LOG_PGW_APP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+int pgw_handle_ip_allocation_response(
+  const itti_s5_ip_allocation_response_t *const ip_alloc_resp_p)
+{
+  const itti_s5_create_bearer_request_t *const bearer_req_p =
+    &ip_alloc_resp_p->bearer_request;
+  s_plus_p_gw_eps_bearer_context_information_t *new_bearer_ctxt_info_p = NULL;
+  hashtable_rc_t hash_rc = HASH_TABLE_OK;
+  itti_sgi_create_end_point_response_t sgi_create_endpoint_resp = {0};
+  protocol_configuration_options_ids_t pco_ids;
+  struct in_addr inaddr = ip_alloc_resp_p->ipv4_address;
+  const char *pdn_type_str = NULL;
+  char *imsi = NULL;
+  OAILOG_FUNC_IN(LOG_PGW_APP);
+
+  hash_rc = hashtable_ts_get(
+    sgw_app.s11_bearer_context_information_hashtable,
+    bearer_req_p->context_teid,
+    (void **) &new_bearer_ctxt_info_p);
+
+  if (HASH_TABLE_OK != hash_rc) {
+    // The session went away while mobilityd was allocating the address
+    OAILOG_DEBUG(
+      LOG_PGW_APP,
+      "Rx S5_IP_ALLOCATION_RESPONSE, Context: teid %u NOT FOUND\n",
+      bearer_req_p->context_teid);
+    if (RPC_STATUS_OK == ip_alloc_resp_p->status) {
+      release_ue_ipv4_address(ip_alloc_resp_p->imsi, &inaddr);
+    }
+    sgi_create_endpoint_resp.status = SGI_STATUS_ERROR_CONTEXT_NOT_FOUND;
+    pgw_send_create_bearer_response(
+      bearer_req_p, new_bearer_ctxt_info_p, &sgi_create_endpoint_resp);
     OAILOG_FUNC_RETURN(LOG_PGW_APP, RETURNok);
   }
-  message_p = itti_alloc_new_message(TASK_SPGW_APP, S5_CREATE_BEARER_RESPONSE);
-  itti_s5_create_bearer_response_t *s5_response =
-    &message_p->ittiMsg.s5_create_bearer_response;
-  memset(s5_response, 0, sizeof(itti_s5_create_bearer_response_t));
-  s5_response->context_teid = bearer_req_p->context_teid;
-  s5_response->S1u_teid = bearer_req_p->S1u_teid;
-  s5_response->eps_bearer_id = bearer_req_p->eps_bearer_id;
-  s5_response->sgi_create_endpoint_resp = sgi_create_endpoint_resp;
-  s5_response->failure_cause = S5_OK;
-  itti_send_msg_to_task(TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+
+  pgw_fill_sgi_create_endpoint_resp(
+    bearer_req_p, new_bearer_ctxt_info_p, &sgi_create_endpoint_resp, &pco_ids);
+  imsi =
+    (char *)
+      new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi.digit;
+  pdn_type_str =
+    (sgi_create_endpoint_resp.paa.pdn_type == IPv4) ? "ipv4" : "ipv4v6";
+
+  if (
+    0 == check_ue_ipv4_address_allocation(
+           imsi, &inaddr, ip_alloc_resp_p->status)) {
+    increment_counter(
+      "ue_pdn_connection", 1, 2, "pdn_type", pdn_type_str, "result", "success");
+    sgi_create_endpoint_resp.paa.ipv4_address = inaddr;
+    OAILOG_DEBUG(LOG_PGW_APP, "Allocated IPv4 address for imsi <%s>\n", imsi);
+    sgi_create_endpoint_resp.status = SGI_STATUS_OK;
+    sgi_create_endpoint_resp.paa.pdn_type = IPv4;
+  } else {
+    increment_counter(
+      "ue_pdn_connection", 1, 2, "pdn_type", pdn_type_str, "result", "failure");
+    OAILOG_ERROR(
+      LOG_PGW_APP,
+      "Failed to allocate IPv4 PAA for PDN type %s\n",
+      (sgi_create_endpoint_resp.paa.pdn_type == IPv4) ? "IPv4" :
+                                                          "IPv4_AND_v6");
+    sgi_create_endpoint_resp.status =
+      SGI_STATUS_ERROR_ALL_DYNAMIC_ADDRESSES_OCCUPIED;
+  }
+  pgw_send_create_bearer_response(
+    bearer_req_p, new_bearer_ctxt_info_p, &sgi_create_endpoint_resp);
   OAILOG_FUNC_RETURN(LOG_PGW_APP, RETURNok);
 }
 
@@ -32,5 +32,7 @@
 
 int pgw_handle_create_bearer_request(
   const itti_s5_create_bearer_request_t *const bearer_req_p);
+int pgw_handle_ip_allocation_response(
+  const itti_s5_ip_allocation_response_t *const ip_alloc_resp_p);
 
 #endif /* FILE_PGW_HANDLERS_SEEN */
@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "bstrlib.h"
+#include "assertions.h"
 #include "log.h"
 #include "common_defs.h"
 #include "3gpp_24.008.h"
@@ -381,3 +382,19 @@ int pgw_process_pco_request(
   }
   return RETURNok;
 }
+
+//------------------------------------------------------------------------------
+void pgw_process_bearer_pco_request(
+  const protocol_configuration_options_t *const pco_req,
+  protocol_configuration_options_t *const sgi_pco_resp,
+  protocol_configuration_options_ids_t *const pco_ids)
+{
+  protocol_configuration_options_t pco_resp = {0};
+
+  // TODO: perhaps change to a nonfatal assert?
+  AssertFatal(
+    0 == pgw_process_pco_request(pco_req, &pco_resp, pco_ids),
+    "Error in processing PCO in request");
+  copy_protocol_configuration_options(sgi_pco_resp, &pco_resp);
+  clear_protocol_configuration_options(&pco_resp);
+}
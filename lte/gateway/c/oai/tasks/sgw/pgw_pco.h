@@ -72,4 +72,13 @@ int pgw_process_pco_request(
   protocol_configuration_options_t *pco_resp,
   protocol_configuration_options_ids_t *const pco_ids);
 
+/*
+ * Processes the PCO saved from the create session request of a bearer into
+ * the PCO of its SGi endpoint response
+ */
+void pgw_process_bearer_pco_request(
+  const protocol_configuration_options_t *const pco_req,
+  protocol_configuration_options_t *const sgi_pco_resp,
+  protocol_configuration_options_ids_t *const pco_ids);
+
 #endif
@@ -63,6 +63,11 @@ static void *pgw_intertask_interface(void *args_p)
           &received_message_p->ittiMsg.s5_create_bearer_request);
       } break;
 
+      case S5_IP_ALLOCATION_RESPONSE: {
+        pgw_handle_ip_allocation_response(
+          &received_message_p->ittiMsg.s5_ip_allocation_response);
+      } break;
+
       case TERMINATE_MESSAGE: {
         pgw_exit();
         itti_exit_task();
@@ -32,9 +32,36 @@
 #include <arpa/inet.h>
 #include <stdint.h>
 
+#include "s5_messages_types.h"
+
 int allocate_ue_ipv4_address(const char *imsi, struct in_addr *addr);
+
+/*
+ * Requests an IPv4 address for the UE of bearer_req_p without blocking, the
+ * answer is sent to TASK_PGW_APP in a S5_IP_ALLOCATION_RESPONSE message that
+ * carries a copy of bearer_req_p.
+ */
+void allocate_ue_ipv4_address_async(
+  const char *imsi,
+  const itti_s5_create_bearer_request_t *const bearer_req_p);
+
+/*
+ * Processes the status returned by mobilityd for an IPv4 address allocation,
+ * returns 0 if the address can be used.
+ */
+int check_ue_ipv4_address_allocation(
+  const char *imsi,
+  struct in_addr *addr,
+  int ip_alloc_status);
 int release_ue_ipv4_address(const char *imsi, struct in_addr *addr);
 void pgw_ip_address_pool_init(void);
+
+/*
+ * Gets the IMSI an UE IPv4 address (in network byte order) is allocated to,
+ * from the local mapping or else from mobilityd. imsi must be able to hold
+ * IMSI_BCD_DIGITS_MAX + 1 chars. Returns 0 on success.
+ */
+int get_imsi_from_ue_ipv4_address(const struct in_addr *addr, char *imsi);
 int get_ip_block(struct in_addr *netaddr, uint32_t *netmask);
 
 #endif /*PGW_UE_IP_ADDRESS_ALLOC_SEEN */
@@ -538,20 +538,12 @@ int sgw_handle_gtpv1uCreateTunnelResp(
     //--------------------------------------------------------------------------
     // PCO processing
     //--------------------------------------------------------------------------
-    protocol_configuration_options_t *pco_req =
-      &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message
-         .pco;
-    protocol_configuration_options_t pco_resp = {0};
     protocol_configuration_options_ids_t pco_ids;
-    memset(&pco_ids, 0, sizeof pco_ids);
-
-    // TODO: perhaps change to a nonfatal assert?
-    AssertFatal(
-      0 == pgw_process_pco_request(pco_req, &pco_resp, &pco_ids),
-      "Error in processing PCO in request");
-    copy_protocol_configuration_options(
-      &sgi_create_endpoint_resp.pco, &pco_resp);
-    clear_protocol_configuration_options(&pco_resp);
+    pgw_process_bearer_pco_request(
+      &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message
+         .pco,
+      &sgi_create_endpoint_resp.pco,
+      &pco_ids);
 
     //--------------------------------------------------------------------------
     // IP forward will forward packets to this teid
@@ -1629,6 +1621,32 @@ int sgw_handle_release_access_bearers_request(
 }
 
 //-------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// Releases the UE address allocated for a bearer the PCEF refused, through
+// release_ue_ipv4_address() so that the local UE address to IMSI mapping is
+// cleared as well
+static void sgw_release_ue_ipv4_address_of_failed_bearer(
+  s_plus_p_gw_eps_bearer_context_information_t *const bearer_ctxt_info_p,
+  struct in_addr *const addr)
+{
+  char imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+
+  if (bearer_ctxt_info_p) {
+    strncpy(
+      imsi,
+      (char *) bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi
+        .digit,
+      IMSI_BCD_DIGITS_MAX);
+  } else if (get_imsi_from_ue_ipv4_address(addr, imsi)) {
+    OAILOG_ERROR(
+      LOG_SPGW_APP, "No IMSI found for the UE address of a refused bearer\n");
+    return;
+  }
+  if (release_ue_ipv4_address(imsi, addr)) {
+    OAILOG_ERROR(LOG_SPGW_APP, "Failed to release IPv4 PAA of IMSI %s\n", imsi);
+  }
+}
+
 int sgw_handle_s5_create_bearer_response(
   const itti_s5_create_bearer_response_t *const bearer_resp_p)
 {
@@ -1718,6 +1736,8 @@ int sgw_handle_s5_create_bearer_response(
     }
   } else if (bearer_resp_p->failure_cause == PCEF_FAILURE) {
     cause = SERVICE_DENIED;
+    sgw_release_ue_ipv4_address_of_failed_bearer(
+      new_bearer_ctxt_info_p, &sgi_create_endpoint_resp.paa.ipv4_address);
   }
 
   // Send Create Session Response with Nack
@@ -27,7 +27,7 @@
 
 #include "intertask_interface.h"
 #include "log.h"
-#include "rpc_client.h"
+#include "pgw_ue_ip_address_alloc.h"
 #include "sgw_paging.h"
 #include "intertask_interface_types.h"
 #include "itti_types.h"
@@ -35,8 +35,8 @@
 
 int sgw_send_paging_request(const struct in_addr *dest_ip)
 {
-  char *imsi;
-  int ret = get_subscriber_id_from_ipv4(dest_ip, &imsi);
+  char imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+  int ret = get_imsi_from_ue_ipv4_address(dest_ip, imsi);
   if (ret > 0) {
     char ip_str[INET_ADDRSTRLEN];
     inet_ntop(AF_INET, &(dest_ip->s_addr), ip_str, INET_ADDRSTRLEN);
@@ -52,7 +52,6 @@ int sgw_send_paging_request(const struct in_addr *dest_ip)
   paging_request_p = &message_p->ittiMsg.s11_paging_request;
   memset((void *) paging_request_p, 0, sizeof(itti_s11_paging_request_t));
   paging_request_p->imsi = strdup(imsi);
-  free(imsi);
 
   ret = itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
   return ret;
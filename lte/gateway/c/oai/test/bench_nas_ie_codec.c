@@ -0,0 +1,122 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "AttachRequest.h"
+#include "PdnConnectivityRequest.h"
+
+/*
+ * Time to decode and encode an attach request and a PDN connectivity request
+ * carrying most of their optional IEs, as received on each attach.
+ */
+
+#define BENCH_ROUNDS 1000000
+
+static const uint8_t attach_request[] = {
+  0x71, 0x08, 0x09, 0x10, 0x10, 0x10, 0x32, 0x54, 0x76, 0x98, 0x02, 0xe0,
+  0xe0, 0x00, 0x04, 0x02, 0x01, 0xd0, 0x11, 0x19, 0x01, 0x02, 0x03, 0x52,
+  0x00, 0xf1, 0x10, 0x00, 0x01, 0x5c, 0x0a, 0x00, 0x31, 0x03, 0xe5, 0xe0,
+  0x34, 0x13, 0x00, 0xf1, 0x10, 0x00, 0x01, 0x90, 0x11, 0x03, 0x57, 0x58,
+  0xa6, 0x40, 0x08, 0x04, 0x02, 0x60, 0x04, 0x1f, 0x02, 0x1f, 0x00, 0x5d,
+  0x01, 0x02, 0xc1};
+
+static const uint8_t pdn_connectivity_request[] = {
+  0x11, 0xd1, 0x28, 0x09, 0x08, 0x69, 0x6e, 0x74, 0x65, 0x72,
+  0x6e, 0x65, 0x74, 0x27, 0x04, 0x80, 0x00, 0x0d, 0x00};
+
+static double _now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void _print(const char *name, double decode_time, double encode_time)
+{
+  printf(
+    "%-28s decode %7.1f ns/msg encode %7.1f ns/msg\n",
+    name,
+    decode_time * 1e9 / BENCH_ROUNDS,
+    encode_time * 1e9 / BENCH_ROUNDS);
+}
+
+static void _bench_attach_request(void)
+{
+  attach_request_msg msg;
+  uint8_t buffer[sizeof(attach_request)];
+  uint8_t out[256];
+  double decode_time = 0, encode_time = 0, start;
+
+  memcpy(buffer, attach_request, sizeof(buffer));
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    memset(&msg, 0, sizeof(msg));
+    start = _now();
+    if (decode_attach_request(&msg, buffer, sizeof(buffer)) < 0) {
+      fprintf(stderr, "Failed to decode the attach request\n");
+      exit(EXIT_FAILURE);
+    }
+    decode_time += _now() - start;
+    start = _now();
+    encode_attach_request(&msg, out, sizeof(out));
+    encode_time += _now() - start;
+    bdestroy(msg.esmmessagecontainer);
+    bdestroy(msg.supportedcodecs);
+  }
+  _print("Attach request", decode_time, encode_time);
+}
+
+static void _bench_pdn_connectivity_request(void)
+{
+  pdn_connectivity_request_msg msg;
+  uint8_t buffer[sizeof(pdn_connectivity_request)];
+  uint8_t out[256];
+  double decode_time = 0, encode_time = 0, start;
+
+  memcpy(buffer, pdn_connectivity_request, sizeof(buffer));
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    memset(&msg, 0, sizeof(msg));
+    start = _now();
+    if (decode_pdn_connectivity_request(&msg, buffer, sizeof(buffer)) < 0) {
+      fprintf(stderr, "Failed to decode the PDN connectivity request\n");
+      exit(EXIT_FAILURE);
+    }
+    decode_time += _now() - start;
+    start = _now();
+    encode_pdn_connectivity_request(&msg, out, sizeof(out));
+    encode_time += _now() - start;
+    bdestroy(msg.accesspointname);
+    clear_protocol_configuration_options(&msg.protocolconfigurationoptions);
+  }
+  _print("PDN connectivity request", decode_time, encode_time);
+}
+
+int main(void)
+{
+  _bench_attach_request();
+  _bench_pdn_connectivity_request();
+  return EXIT_SUCCESS;
+}
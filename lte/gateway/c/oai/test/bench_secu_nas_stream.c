@@ -0,0 +1,168 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "secu_defs.h"
+
+/*
+ * Throughput of the batched NAS security API against the per message path
+ * of nas_message.c, for a burst of messages each with its own UE key, as
+ * during a mass re-attach.
+ */
+
+#define BENCH_NB_UES 4096
+#define BENCH_ROUNDS 20
+
+typedef int (*bench_jobs_func_t)(nas_stream_job_t *const, const uint32_t);
+
+static double _now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void _print(const char *name, uint32_t length, double time)
+{
+  double nb_msgs = (double) BENCH_NB_UES * BENCH_ROUNDS;
+
+  printf(
+    "%-28s %5u bytes %10.0f msg/s %8.1f MB/s\n",
+    name,
+    length,
+    nb_msgs / time,
+    nb_msgs * length / time / 1e6);
+}
+
+/* One message at a time, as _nas_message_encrypt and _nas_message_get_mac */
+static double _bench_per_message(
+  nas_stream_job_t *jobs,
+  bool integrity,
+  bool eea2)
+{
+  double start = _now();
+
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    for (uint32_t i = 0; i < BENCH_NB_UES; i++) {
+      nas_stream_job_t *job = &jobs[i];
+
+      job->stream_cipher.count = r;
+      if (eea2 && integrity) {
+        nas_stream_encrypt_eia2_with_key(
+          &job->stream_cipher, job->stream_key, job->out);
+      } else if (eea2) {
+        nas_stream_encrypt_eea2_with_key(
+          &job->stream_cipher, job->stream_key, job->out);
+      } else if (integrity) {
+        nas_stream_encrypt_eia1(&job->stream_cipher, job->out);
+      } else {
+        nas_stream_encrypt_eea1(&job->stream_cipher, job->out);
+      }
+    }
+  }
+  return _now() - start;
+}
+
+static double _bench_jobs(nas_stream_job_t *jobs, bench_jobs_func_t func)
+{
+  double start = _now();
+
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    for (uint32_t i = 0; i < BENCH_NB_UES; i++) {
+      jobs[i].stream_cipher.count = r;
+    }
+    func(jobs, BENCH_NB_UES);
+  }
+  return _now() - start;
+}
+
+static void _bench(uint32_t length)
+{
+  nas_stream_job_t *jobs = calloc(BENCH_NB_UES, sizeof(nas_stream_job_t));
+  nas_stream_key_t *keys = calloc(BENCH_NB_UES, sizeof(nas_stream_key_t));
+  uint8_t *key_bytes = malloc(BENCH_NB_UES * 16);
+  uint8_t *msgs = malloc(BENCH_NB_UES * length);
+  uint8_t *outs = malloc(BENCH_NB_UES * length);
+  uint8_t *macs = malloc(BENCH_NB_UES * 4);
+  bool aesni = (nas_stream_set_engine(NAS_STREAM_ENGINE_AESNI) == 0);
+
+  for (uint32_t i = 0; i < BENCH_NB_UES * 16; i++) key_bytes[i] = rand();
+  for (uint32_t i = 0; i < BENCH_NB_UES * length; i++) msgs[i] = rand();
+  for (uint32_t i = 0; i < BENCH_NB_UES; i++) {
+    nas_stream_key_init(&keys[i], &key_bytes[i * 16], 16);
+    jobs[i].stream_cipher.key = &key_bytes[i * 16];
+    jobs[i].stream_cipher.key_length = 16;
+    jobs[i].stream_cipher.bearer = 0;
+    jobs[i].stream_cipher.direction = SECU_DIRECTION_DOWNLINK;
+    jobs[i].stream_cipher.message = &msgs[i * length];
+    jobs[i].stream_cipher.blength = length << 3;
+    jobs[i].stream_key = &keys[i];
+    jobs[i].out = &outs[i * length];
+  }
+
+  nas_stream_set_engine(NAS_STREAM_ENGINE_SCALAR);
+  _print("EEA2 per message", length, _bench_per_message(jobs, false, true));
+  _print(
+    "EEA2 batch scalar", length, _bench_jobs(jobs, nas_stream_encrypt_eea2_jobs));
+  if (aesni) {
+    nas_stream_set_engine(NAS_STREAM_ENGINE_AESNI);
+    _print(
+      "EEA2 batch AES-NI", length, _bench_jobs(jobs, nas_stream_encrypt_eea2_jobs));
+  }
+  _print("EEA1 per message", length, _bench_per_message(jobs, false, false));
+
+  for (uint32_t i = 0; i < BENCH_NB_UES; i++) jobs[i].out = &macs[i * 4];
+  nas_stream_set_engine(NAS_STREAM_ENGINE_SCALAR);
+  _print("EIA2 per message", length, _bench_per_message(jobs, true, true));
+  _print(
+    "EIA2 batch scalar", length, _bench_jobs(jobs, nas_stream_encrypt_eia2_jobs));
+  if (aesni) {
+    nas_stream_set_engine(NAS_STREAM_ENGINE_AESNI);
+    _print(
+      "EIA2 batch AES-NI", length, _bench_jobs(jobs, nas_stream_encrypt_eia2_jobs));
+  }
+  _print("EIA1 per message", length, _bench_per_message(jobs, true, false));
+
+  free(jobs);
+  free(keys);
+  free(key_bytes);
+  free(msgs);
+  free(outs);
+  free(macs);
+}
+
+int main(void)
+{
+  printf(
+    "%u UEs, AES-NI %s\n",
+    BENCH_NB_UES,
+    nas_stream_set_engine(NAS_STREAM_ENGINE_AESNI) == 0 ? "available" :
+                                                          "not available");
+  _bench(32);
+  _bench(128);
+  _bench(1024);
+  return EXIT_SUCCESS;
+}
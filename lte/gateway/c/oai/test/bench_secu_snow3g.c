@@ -0,0 +1,202 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "rijndael.h"
+#include "secu_defs.h"
+#include "snow3g.h"
+
+/*
+ * Benchmark of the table driven SNOW 3G core against the reference one it
+ * replaced, which computes MULalpha, DIValpha and the S-boxes bit by bit from
+ * the specification, and of EEA1/EIA1 on NAS sized messages.
+ */
+
+#define BENCH_KEY_STREAM_WORDS (256 * 1024)
+
+static double _now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint8_t _ref_MULx(uint8_t V, uint8_t c)
+{
+  return (V & 0x80) ? ((V << 1) ^ c) : (V << 1);
+}
+
+static uint8_t _ref_MULxPOW(uint8_t V, uint8_t i, uint8_t c)
+{
+  return (i == 0) ? V : _ref_MULx(_ref_MULxPOW(V, i - 1, c), c);
+}
+
+static uint32_t _ref_MULalpha(uint8_t c)
+{
+  return ((uint32_t) _ref_MULxPOW(c, 23, 0xa9) << 24) |
+         ((uint32_t) _ref_MULxPOW(c, 245, 0xa9) << 16) |
+         ((uint32_t) _ref_MULxPOW(c, 48, 0xa9) << 8) |
+         (uint32_t) _ref_MULxPOW(c, 239, 0xa9);
+}
+
+static uint32_t _ref_DIValpha(uint8_t c)
+{
+  return ((uint32_t) _ref_MULxPOW(c, 16, 0xa9) << 24) |
+         ((uint32_t) _ref_MULxPOW(c, 39, 0xa9) << 16) |
+         ((uint32_t) _ref_MULxPOW(c, 6, 0xa9) << 8) |
+         (uint32_t) _ref_MULxPOW(c, 64, 0xa9);
+}
+
+static uint32_t _ref_S(uint32_t w, const uint8_t *box, uint8_t c)
+{
+  uint8_t s0 = box[(w >> 24) & 0xff], s1 = box[(w >> 16) & 0xff];
+  uint8_t s2 = box[(w >> 8) & 0xff], s3 = box[w & 0xff];
+  uint8_t r0 = _ref_MULx(s0, c) ^ s1 ^ s2 ^ _ref_MULx(s3, c) ^ s3;
+  uint8_t r1 = _ref_MULx(s0, c) ^ s0 ^ _ref_MULx(s1, c) ^ s2 ^ s3;
+  uint8_t r2 = s0 ^ _ref_MULx(s1, c) ^ s1 ^ _ref_MULx(s2, c) ^ s3;
+  uint8_t r3 = s0 ^ s1 ^ _ref_MULx(s2, c) ^ s2 ^ _ref_MULx(s3, c);
+
+  return ((uint32_t) r0 << 24) | ((uint32_t) r1 << 16) | ((uint32_t) r2 << 8) |
+         r3;
+}
+
+/* Reference keystream, state as s[16] and r1, r2, r3 */
+static void _ref_key_stream(
+  uint32_t k[4],
+  uint32_t iv[4],
+  uint32_t n,
+  uint32_t *z)
+{
+  uint32_t s[16] = {k[0] ^ 0xffffffff,
+                    k[1] ^ 0xffffffff,
+                    k[2] ^ 0xffffffff,
+                    k[3] ^ 0xffffffff,
+                    k[0],
+                    k[1],
+                    k[2],
+                    k[3],
+                    k[0] ^ 0xffffffff,
+                    k[1] ^ 0xffffffff ^ iv[3],
+                    k[2] ^ 0xffffffff ^ iv[2],
+                    k[3] ^ 0xffffffff,
+                    k[0] ^ iv[1],
+                    k[1],
+                    k[2],
+                    k[3] ^ iv[0]};
+  uint32_t r1 = 0, r2 = 0, r3 = 0;
+
+  for (int32_t t = -33; t < (int32_t) n; t++) {
+    uint32_t f = (s[15] + r1) ^ r2;
+    uint32_t r = r2 + (r3 ^ s[5]);
+    uint32_t v;
+
+    r3 = _ref_S(r2, SQ, 0x69);
+    r2 = _ref_S(r1, SR, 0x1b);
+    r1 = r;
+    if (t >= 0) z[t] = f ^ s[0];
+    v = (s[0] << 8) ^ _ref_MULalpha(s[0] >> 24) ^ s[2] ^ (s[11] >> 8) ^
+        _ref_DIValpha(s[11] & 0xff) ^ (t < -1 ? f : 0);
+    memmove(s, s + 1, 15 * sizeof(uint32_t));
+    s[15] = v;
+  }
+}
+
+static void _bench_key_stream(uint32_t *z_ref, uint32_t *z)
+{
+  uint32_t k[4] = {0x2BD6459F, 0x82C5B300, 0x952C4910, 0x4881FF48};
+  uint32_t iv[4] = {0xEA024714, 0xAD5C4D84, 0xDF1F9B25, 0x1C0BF45F};
+  snow_3g_context_t ctx;
+  double mbytes = BENCH_KEY_STREAM_WORDS * 4 / 1e6;
+  double start, ref_time, time;
+
+  start = _now();
+  _ref_key_stream(k, iv, BENCH_KEY_STREAM_WORDS, z_ref);
+  ref_time = _now() - start;
+
+  start = _now();
+  snow3g_initialize(k, iv, &ctx);
+  snow3g_generate_key_stream(BENCH_KEY_STREAM_WORDS, z, &ctx);
+  time = _now() - start;
+
+  printf(
+    "keystream  reference %8.2f MB/s  tables %8.2f MB/s  speedup %6.1fx  %s\n",
+    mbytes / ref_time,
+    mbytes / time,
+    ref_time / time,
+    memcmp(z_ref, z, BENCH_KEY_STREAM_WORDS * 4) ? "MISMATCH" : "match");
+}
+
+static void _bench_nas(uint32_t length, uint32_t iterations)
+{
+  uint8_t key[16] = {0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00,
+                     0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48};
+  uint8_t *msg = calloc(1, length);
+  uint8_t *out = calloc(1, length);
+  uint8_t mac[4];
+  nas_stream_cipher_t stream_cipher = {.key = key,
+                                       .key_length = sizeof(key),
+                                       .bearer = 0,
+                                       .direction = SECU_DIRECTION_DOWNLINK,
+                                       .message = msg,
+                                       .blength = length << 3};
+  double start, eea1_time, eia1_time;
+
+  start = _now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    stream_cipher.count = i;
+    nas_stream_encrypt_eea1(&stream_cipher, out);
+  }
+  eea1_time = _now() - start;
+
+  start = _now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    stream_cipher.count = i;
+    nas_stream_encrypt_eia1(&stream_cipher, mac);
+  }
+  eia1_time = _now() - start;
+
+  printf(
+    "%5u bytes  EEA1 %8.2f us/msg  EIA1 %8.2f us/msg\n",
+    length,
+    eea1_time * 1e6 / iterations,
+    eia1_time * 1e6 / iterations);
+  free(msg);
+  free(out);
+}
+
+int main(void)
+{
+  uint32_t *z_ref = calloc(BENCH_KEY_STREAM_WORDS, sizeof(uint32_t));
+  uint32_t *z = calloc(BENCH_KEY_STREAM_WORDS, sizeof(uint32_t));
+
+  _bench_key_stream(z_ref, z);
+  _bench_nas(64, 100000);
+  _bench_nas(256, 100000);
+  _bench_nas(1500, 20000);
+  free(z_ref);
+  free(z);
+  return EXIT_SUCCESS;
+}
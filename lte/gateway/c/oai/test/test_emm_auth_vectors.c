@@ -0,0 +1,189 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "mme_app_ue_context.h"
+#include "emm_data.h"
+
+#define VECTORS_TTL 3600
+
+/*
+ * The EMM context functions find the UE context from the EMM context, which
+ * must be embedded in one.
+ */
+static ue_mm_context_t *new_ue_context(void)
+{
+  ue_mm_context_t *ue_context = calloc(1, sizeof(*ue_context));
+  emm_init_context(&ue_context->emm_context, false);
+  return ue_context;
+}
+
+/* Vectors told apart by the first byte of their RAND */
+static void set_vectors(
+  emm_context_t *ctxt,
+  int nb_vectors,
+  uint8_t first_rand,
+  time_t expiry,
+  int nb_expected)
+{
+  eutran_vector_t vectors[MAX_EPS_AUTH_VECTORS];
+  eutran_vector_t *vector_ptrs[MAX_EPS_AUTH_VECTORS];
+
+  memset(vectors, 0, sizeof(vectors));
+  for (int i = 0; i < nb_vectors; i++) {
+    vectors[i].rand[0] = first_rand + i;
+    vectors[i].xres.size = XRES_LENGTH_MAX;
+    vector_ptrs[i] = &vectors[i];
+  }
+  ck_assert_int_eq(
+    emm_ctx_set_auth_vectors(ctxt, nb_vectors, vector_ptrs, expiry),
+    nb_expected);
+}
+
+START_TEST(free_slots_after_init_test)
+{
+  ue_mm_context_t *ue_context = new_ue_context();
+  emm_context_t *ctxt = &ue_context->emm_context;
+
+  /* No slot is held by a cleared security context */
+  ck_assert_int_eq(
+    ctxt->_security.vector_index, EMM_SECURITY_VECTOR_INDEX_INVALID);
+  ck_assert_int_eq(
+    ctxt->_non_current_security.vector_index,
+    EMM_SECURITY_VECTOR_INDEX_INVALID);
+  ck_assert_int_eq(
+    emm_ctx_get_nb_free_auth_vectors(ctxt), MAX_EPS_AUTH_VECTORS);
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), -1);
+
+  set_vectors(ctxt, MAX_EPS_AUTH_VECTORS, 0, time(NULL) + VECTORS_TTL,
+    MAX_EPS_AUTH_VECTORS);
+  ck_assert_int_eq(ctxt->remaining_vectors, MAX_EPS_AUTH_VECTORS);
+  ck_assert_int_eq(emm_ctx_get_nb_free_auth_vectors(ctxt), 0);
+  free(ue_context);
+}
+END_TEST
+
+START_TEST(slot_selection_test)
+{
+  ue_mm_context_t *ue_context = new_ue_context();
+  emm_context_t *ctxt = &ue_context->emm_context;
+
+  set_vectors(ctxt, 3, 0, time(NULL) + VECTORS_TTL, 3);
+  ck_assert_int_eq(ctxt->remaining_vectors, 3);
+  ck_assert_int_eq(emm_ctx_get_nb_free_auth_vectors(ctxt), 2);
+
+  /* The oldest vector is used first, and becomes the security context's */
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), 0);
+  emm_ctx_use_auth_vector(ctxt, 0);
+  emm_ctx_set_security_vector_index(ctxt, 0);
+  ck_assert_int_eq(ctxt->remaining_vectors, 2);
+  ck_assert_int_eq(emm_ctx_get_nb_free_auth_vectors(ctxt), 2);
+
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), 1);
+  emm_ctx_use_auth_vector(ctxt, 1);
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), 2);
+  emm_ctx_use_auth_vector(ctxt, 2);
+  ck_assert_int_eq(ctxt->remaining_vectors, 0);
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), -1);
+
+  /* A new batch fills every slot but the one of the security context */
+  ck_assert_int_eq(
+    emm_ctx_get_nb_free_auth_vectors(ctxt), MAX_EPS_AUTH_VECTORS - 1);
+  set_vectors(ctxt, MAX_EPS_AUTH_VECTORS, 10, time(NULL) + VECTORS_TTL,
+    MAX_EPS_AUTH_VECTORS - 1);
+  ck_assert_int_eq(ctxt->_vector[0].rand[0], 0);
+  for (int i = 1; i < MAX_EPS_AUTH_VECTORS; i++) {
+    ck_assert_int_eq(ctxt->_vector[i].rand[0], 10 + i - 1);
+  }
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), 1);
+
+  /* Clearing the security contexts releases their slots */
+  emm_ctx_set_security_vector_index(ctxt, 0);
+  ctxt->_non_current_security.vector_index = 1;
+  emm_ctx_use_auth_vector(ctxt, 1);
+  ck_assert_int_eq(emm_ctx_get_nb_free_auth_vectors(ctxt), 0);
+  emm_ctx_clear_security(ctxt);
+  ck_assert_int_eq(emm_ctx_get_nb_free_auth_vectors(ctxt), 1);
+  emm_ctx_clear_non_current_security(ctxt);
+  ck_assert_int_eq(emm_ctx_get_nb_free_auth_vectors(ctxt), 2);
+  free(ue_context);
+}
+END_TEST
+
+START_TEST(vectors_expiry_test)
+{
+  ue_mm_context_t *ue_context = new_ue_context();
+  emm_context_t *ctxt = &ue_context->emm_context;
+
+  set_vectors(ctxt, 2, 0, time(NULL) + VECTORS_TTL, 2);
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), 0);
+
+  /* Unused vectors are discarded once expired */
+  ctxt->vectors_expiry = time(NULL) - 1;
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), -1);
+  ck_assert_int_eq(ctxt->remaining_vectors, 0);
+  ck_assert_int_eq(
+    emm_ctx_get_nb_free_auth_vectors(ctxt), MAX_EPS_AUTH_VECTORS);
+
+  /* A new batch gets a new expiry */
+  set_vectors(ctxt, 1, 20, time(NULL) + VECTORS_TTL, 1);
+  ck_assert_int_eq(emm_ctx_get_auth_vector(ctxt), 0);
+  ck_assert_int_eq(ctxt->_vector[0].rand[0], 20);
+  free(ue_context);
+}
+END_TEST
+
+Suite *emm_auth_vectors_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("EMM auth vectors tests");
+
+  /* Core test case */
+  tc_core = tcase_create("EMM auth vectors test");
+  tcase_add_test(tc_core, free_slots_after_init_test);
+  tcase_add_test(tc_core, slot_selection_test);
+  tcase_add_test(tc_core, vectors_expiry_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = emm_auth_vectors_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,197 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "hashtable.h"
+
+#define TEST_HASHTABLE_NB_KEYS 100000
+#define TEST_HASHTABLE_NB_THREADS 4
+
+static int nb_freed = 0;
+
+static void test_free_func(void **data)
+{
+  nb_freed++;
+  *data = NULL;
+}
+
+static hash_size_t test_identity_hashfunc(const hash_key_t key)
+{
+  return (hash_size_t) key;
+}
+
+START_TEST(hashtable_ts_grow_test)
+{
+  hash_table_ts_t *htbl =
+    hashtable_ts_create(16, test_identity_hashfunc, test_free_func, NULL);
+  void *data = NULL;
+
+  ck_assert(htbl != NULL);
+  nb_freed = 0;
+  /* Sequential keys with an identity hash, much more than the initial size */
+  for (uint64_t i = 0; i < TEST_HASHTABLE_NB_KEYS; i++) {
+    ck_assert_int_eq(
+      hashtable_ts_insert(htbl, i, (void *) (uintptr_t)(i + 1)), HASH_TABLE_OK);
+  }
+  ck_assert_uint_eq(htbl->rh.num_elements, TEST_HASHTABLE_NB_KEYS);
+  for (uint64_t i = 0; i < TEST_HASHTABLE_NB_KEYS; i++) {
+    ck_assert_int_eq(hashtable_ts_get(htbl, i, &data), HASH_TABLE_OK);
+    ck_assert_ptr_eq(data, (void *) (uintptr_t)(i + 1));
+  }
+  ck_assert_int_eq(
+    hashtable_ts_get(htbl, TEST_HASHTABLE_NB_KEYS, &data),
+    HASH_TABLE_KEY_NOT_EXISTS);
+  ck_assert_ptr_eq(data, NULL);
+
+  /* Remove every other key, the remaining ones must still be reachable */
+  for (uint64_t i = 0; i < TEST_HASHTABLE_NB_KEYS; i += 2) {
+    ck_assert_int_eq(hashtable_ts_remove(htbl, i, &data), HASH_TABLE_OK);
+    ck_assert_ptr_eq(data, (void *) (uintptr_t)(i + 1));
+  }
+  for (uint64_t i = 0; i < TEST_HASHTABLE_NB_KEYS; i++) {
+    ck_assert_int_eq(
+      hashtable_ts_is_key_exists(htbl, i),
+      (i & 1) ? HASH_TABLE_OK : HASH_TABLE_KEY_NOT_EXISTS);
+  }
+  ck_assert_int_eq(nb_freed, 0);
+
+  /* Overwriting releases the previous element */
+  ck_assert_int_eq(
+    hashtable_ts_insert(htbl, 1, (void *) (uintptr_t) 0xdead),
+    HASH_TABLE_INSERT_OVERWRITTEN_DATA);
+  ck_assert_int_eq(nb_freed, 1);
+  ck_assert_int_eq(hashtable_ts_free(htbl, 1), HASH_TABLE_OK);
+  ck_assert_int_eq(nb_freed, 2);
+
+  hashtable_ts_destroy(htbl);
+  ck_assert_int_eq(nb_freed, 2 + (TEST_HASHTABLE_NB_KEYS / 2) - 1);
+}
+END_TEST
+
+static bool test_count_cb(
+  const hash_key_t key,
+  const uint64_t element,
+  void *parameter,
+  void **result)
+{
+  hash_table_uint64_ts_t *htbl = (hash_table_uint64_ts_t *) *result;
+  uint64_t data = 0;
+
+  /* The callback is allowed to use the table */
+  ck_assert_int_eq(hashtable_uint64_ts_get(htbl, key, &data), HASH_TABLE_OK);
+  ck_assert_uint_eq(data, element);
+  (*(int *) parameter)++;
+  return false;
+}
+
+typedef struct test_worker_arg_s {
+  hash_table_uint64_ts_t *htbl;
+  uint64_t base;
+} test_worker_arg_t;
+
+static void *test_uint64_worker(void *arg)
+{
+  hash_table_uint64_ts_t *htbl = ((test_worker_arg_t *) arg)->htbl;
+  uint64_t base = ((test_worker_arg_t *) arg)->base;
+  uint64_t data = 0;
+
+  for (uint64_t i = 0; i < TEST_HASHTABLE_NB_KEYS; i++) {
+    hashtable_uint64_ts_insert(htbl, base + i, i);
+    if (hashtable_uint64_ts_get(htbl, base + i, &data) != HASH_TABLE_OK ||
+        data != i) {
+      return (void *) 1;
+    }
+    if (i & 1) {
+      hashtable_uint64_ts_remove(htbl, base + i);
+    }
+  }
+  return NULL;
+}
+
+START_TEST(hashtable_uint64_ts_concurrent_test)
+{
+  hash_table_uint64_ts_t *htbl = hashtable_uint64_ts_create(1024, NULL, NULL);
+  pthread_t threads[TEST_HASHTABLE_NB_THREADS];
+  test_worker_arg_t args[TEST_HASHTABLE_NB_THREADS];
+  void *result = htbl;
+  int count = 0;
+
+  for (int i = 0; i < TEST_HASHTABLE_NB_THREADS; i++) {
+    args[i].htbl = htbl;
+    args[i].base = ((uint64_t) i) << 32;
+    pthread_create(&threads[i], NULL, test_uint64_worker, &args[i]);
+  }
+  for (int i = 0; i < TEST_HASHTABLE_NB_THREADS; i++) {
+    void *rc = NULL;
+    pthread_join(threads[i], &rc);
+    ck_assert_ptr_eq(rc, NULL);
+  }
+  ck_assert_uint_eq(
+    htbl->rh.num_elements,
+    TEST_HASHTABLE_NB_THREADS * TEST_HASHTABLE_NB_KEYS / 2);
+
+  hashtable_uint64_ts_apply_callback_on_elements(
+    htbl, test_count_cb, &count, &result);
+  ck_assert_int_eq(
+    count, TEST_HASHTABLE_NB_THREADS * TEST_HASHTABLE_NB_KEYS / 2);
+
+  hashtable_key_array_t *keys = hashtable_uint64_ts_get_keys(htbl);
+  ck_assert_int_eq(keys->num_keys, count);
+  free(keys->keys);
+  free(keys);
+  hashtable_uint64_ts_destroy(htbl);
+}
+END_TEST
+
+Suite *hashtable_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("Hashtable tests");
+
+  /* Core test case */
+  tc_core = tcase_create("Thread safe hashtable test");
+  tcase_add_test(tc_core, hashtable_ts_grow_test);
+  tcase_add_test(tc_core, hashtable_uint64_ts_concurrent_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = hashtable_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
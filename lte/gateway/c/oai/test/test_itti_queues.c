@@ -0,0 +1,305 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <poll.h>
+#include <sys/epoll.h>
+
+#include "log.h"
+#include "shared_ts_log.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+
+/*
+ * TASK_S1AP is never started by the test, the test thread plays its role
+ * and receives from its queues directly.
+ */
+#define TEST_TASK TASK_S1AP
+
+static void test_setup(void)
+{
+  ck_assert_int_eq(
+    OAILOG_INIT("ITTI_TEST", OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS), 0);
+  ck_assert_int_eq(shared_log_init(MAX_LOG_PROTOS), 0);
+  ck_assert_int_eq(
+    itti_init(
+      TASK_MAX,
+      THREAD_MAX,
+      MESSAGES_ID_MAX,
+      tasks_info,
+      messages_info,
+      NULL,
+      NULL),
+    0);
+  itti_mark_task_ready(TEST_TASK);
+}
+
+/*
+ * A task that subscribed no fd of its own only monitors its ITTI event fd,
+ * the first entry of its events.
+ */
+static int test_task_event_fd(void)
+{
+  struct epoll_event *events = NULL;
+
+  itti_get_events(TEST_TASK, &events);
+  ck_assert_ptr_ne(events, NULL);
+  return events[0].data.fd;
+}
+
+static bool test_event_fd_signalled(int event_fd)
+{
+  struct pollfd pfd = {.fd = event_fd, .events = POLLIN};
+
+  ck_assert_int_ge(poll(&pfd, 1, 0), 0);
+  return (pfd.revents & POLLIN) != 0;
+}
+
+static void test_send_close_association(sctp_assoc_id_t assoc_id)
+{
+  MessageDef *message_p =
+    itti_alloc_new_message(TASK_SCTP, SCTP_CLOSE_ASSOCIATION);
+
+  SCTP_CLOSE_ASSOCIATION(message_p).assoc_id = assoc_id;
+  ck_assert_int_eq(
+    itti_send_msg_to_task(TEST_TASK, INSTANCE_DEFAULT, message_p), 0);
+}
+
+/* Queued on ITTI_PRIORITY_LEVEL_HIGH */
+static void test_send_timer_has_expired(long timer_id)
+{
+  MessageDef *message_p =
+    itti_alloc_new_message(TASK_TIMER, TIMER_HAS_EXPIRED);
+
+  TIMER_HAS_EXPIRED(message_p).timer_id = timer_id;
+  ck_assert_int_eq(
+    itti_send_msg_to_task(TEST_TASK, INSTANCE_DEFAULT, message_p), 0);
+}
+
+/*
+ * Receives the next message and checks that it is msg_id, identified by id
+ * (the timer id or the association id)
+ */
+static void test_receive(MessagesIds msg_id, long id)
+{
+  MessageDef *received_msg = NULL;
+
+  itti_receive_msg(TEST_TASK, &received_msg);
+  ck_assert_ptr_ne(received_msg, NULL);
+  ck_assert_int_eq(ITTI_MSG_ID(received_msg), msg_id);
+  if (msg_id == TIMER_HAS_EXPIRED) {
+    ck_assert_int_eq(TIMER_HAS_EXPIRED(received_msg).timer_id, id);
+  } else {
+    ck_assert_int_eq(SCTP_CLOSE_ASSOCIATION(received_msg).assoc_id, id);
+  }
+  itti_free(ITTI_MSG_ORIGIN_ID(received_msg), received_msg);
+}
+
+static void test_check_queue_depth(int high, int med)
+{
+  ck_assert_int_eq(
+    itti_get_queue_depth(TEST_TASK, ITTI_PRIORITY_LEVEL_HIGH), high);
+  ck_assert_int_eq(
+    itti_get_queue_depth(TEST_TASK, ITTI_PRIORITY_LEVEL_MED), med);
+  ck_assert_int_eq(
+    itti_get_queue_depth(TEST_TASK, ITTI_PRIORITY_LEVEL_LOW), 0);
+}
+
+/*
+ * Messages sent before the receiver wakes up are all returned by a single
+ * batch receive, in the order they were sent, and the signals of the
+ * event fd are consumed with them.
+ */
+START_TEST(itti_receive_msg_batch_test)
+{
+  const int nb_msgs = 100;
+  MessageDef *received_msgs[128];
+  int event_fd = test_task_event_fd();
+  int nb_received;
+
+  ck_assert(!test_event_fd_signalled(event_fd));
+  for (int i = 0; i < nb_msgs; i++) {
+    test_send_close_association(i);
+  }
+  ck_assert(test_event_fd_signalled(event_fd));
+
+  nb_received = itti_receive_msg_batch(TEST_TASK, received_msgs, 128);
+  ck_assert_int_eq(nb_received, nb_msgs);
+  for (int i = 0; i < nb_received; i++) {
+    ck_assert_int_eq(ITTI_MSG_ID(received_msgs[i]), SCTP_CLOSE_ASSOCIATION);
+    ck_assert_uint_eq(SCTP_CLOSE_ASSOCIATION(received_msgs[i]).assoc_id, i);
+    itti_free(ITTI_MSG_ORIGIN_ID(received_msgs[i]), received_msgs[i]);
+  }
+  ck_assert(!test_event_fd_signalled(event_fd));
+}
+END_TEST
+
+/* A batch smaller than the queue leaves the rest for the next call */
+START_TEST(itti_receive_msg_batch_partial_test)
+{
+  MessageDef *received_msgs[8];
+  int event_fd = test_task_event_fd();
+  int nb_received;
+
+  for (int i = 0; i < 12; i++) {
+    test_send_close_association(i);
+  }
+
+  nb_received = itti_receive_msg_batch(TEST_TASK, received_msgs, 8);
+  ck_assert_int_eq(nb_received, 8);
+  ck_assert(!test_event_fd_signalled(event_fd));
+  for (int i = 0; i < nb_received; i++) {
+    ck_assert_uint_eq(SCTP_CLOSE_ASSOCIATION(received_msgs[i]).assoc_id, i);
+    itti_free(ITTI_MSG_ORIGIN_ID(received_msgs[i]), received_msgs[i]);
+  }
+
+  nb_received = itti_receive_msg_batch(TEST_TASK, received_msgs, 8);
+  ck_assert_int_eq(nb_received, 4);
+  for (int i = 0; i < nb_received; i++) {
+    ck_assert_uint_eq(
+      SCTP_CLOSE_ASSOCIATION(received_msgs[i]).assoc_id, 8 + i);
+    itti_free(ITTI_MSG_ORIGIN_ID(received_msgs[i]), received_msgs[i]);
+  }
+}
+END_TEST
+
+/* With strict priority the high level is drained first, each level in order */
+START_TEST(itti_priority_order_test)
+{
+  itti_set_starvation_limit(0);
+  for (int i = 0; i < 4; i++) {
+    test_send_close_association(i);
+    test_send_timer_has_expired(i);
+  }
+
+  for (int i = 0; i < 4; i++) {
+    test_receive(TIMER_HAS_EXPIRED, i);
+  }
+  for (int i = 0; i < 4; i++) {
+    test_receive(SCTP_CLOSE_ASSOCIATION, i);
+  }
+  test_check_queue_depth(0, 0);
+}
+END_TEST
+
+/*
+ * A level served starvation_limit times in a row while a lower level is
+ * waiting lets one message of the lower level through.
+ */
+START_TEST(itti_starvation_limit_test)
+{
+  const int limit = 5;
+
+  itti_set_starvation_limit(limit);
+  test_send_close_association(0);
+  test_send_close_association(1);
+  for (int i = 0; i < 3 * limit; i++) {
+    test_send_timer_has_expired(i);
+  }
+
+  for (int i = 0; i < limit; i++) {
+    test_receive(TIMER_HAS_EXPIRED, i);
+  }
+  test_receive(SCTP_CLOSE_ASSOCIATION, 0);
+  for (int i = limit; i < 2 * limit; i++) {
+    test_receive(TIMER_HAS_EXPIRED, i);
+  }
+  test_receive(SCTP_CLOSE_ASSOCIATION, 1);
+  /* Nothing left to starve, the high level is served without a break */
+  for (int i = 3 * limit; i < 4 * limit; i++) {
+    test_send_timer_has_expired(i);
+  }
+  for (int i = 2 * limit; i < 4 * limit; i++) {
+    test_receive(TIMER_HAS_EXPIRED, i);
+  }
+  test_check_queue_depth(0, 0);
+}
+END_TEST
+
+/* The depth of each level follows the messages queued and received */
+START_TEST(itti_queue_depth_test)
+{
+  itti_set_starvation_limit(0);
+  test_check_queue_depth(0, 0);
+  test_send_timer_has_expired(0);
+  test_send_close_association(0);
+  test_send_close_association(1);
+  test_send_timer_has_expired(1);
+  test_send_timer_has_expired(2);
+  test_check_queue_depth(3, 2);
+
+  test_receive(TIMER_HAS_EXPIRED, 0);
+  test_check_queue_depth(2, 2);
+  test_receive(TIMER_HAS_EXPIRED, 1);
+  test_receive(TIMER_HAS_EXPIRED, 2);
+  test_check_queue_depth(0, 2);
+  test_send_timer_has_expired(3);
+  test_check_queue_depth(1, 2);
+  test_receive(TIMER_HAS_EXPIRED, 3);
+  test_receive(SCTP_CLOSE_ASSOCIATION, 0);
+  test_check_queue_depth(0, 1);
+  test_receive(SCTP_CLOSE_ASSOCIATION, 1);
+  test_check_queue_depth(0, 0);
+}
+END_TEST
+
+Suite *itti_queues_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+  TCase *tc_priority;
+
+  s = suite_create("ITTI queues tests");
+
+  /* Each test runs in its own process, with its own ITTI */
+  tc_core = tcase_create("ITTI batch receive test");
+  tcase_add_checked_fixture(tc_core, test_setup, NULL);
+  tcase_add_test(tc_core, itti_receive_msg_batch_test);
+  tcase_add_test(tc_core, itti_receive_msg_batch_partial_test);
+
+  suite_add_tcase(s, tc_core);
+
+  tc_priority = tcase_create("ITTI priority levels test");
+  tcase_add_checked_fixture(tc_priority, test_setup, NULL);
+  tcase_add_test(tc_priority, itti_priority_order_test);
+  tcase_add_test(tc_priority, itti_starvation_limit_test);
+  tcase_add_test(tc_priority, itti_queue_depth_test);
+
+  suite_add_tcase(s, tc_priority);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = itti_queues_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "timer_wheel.h"
+
+typedef struct test_timer_s {
+  timer_wheel_entry_t entry; /* first, see test_expired */
+  uint64_t period;           /* re-armed when not 0 */
+  uint32_t nb_fired;
+  uint64_t fired_at; /* tick of the last expiry */
+} test_timer_t;
+
+static void test_expired(
+  timer_wheel_t *wheel,
+  timer_wheel_entry_t *entry,
+  void *ctx)
+{
+  test_timer_t *timer = (test_timer_t *) entry;
+
+  timer->nb_fired++;
+  timer->fired_at = wheel->next_tick - 1;
+  if (timer->period) {
+    entry->expiry += timer->period;
+    timer_wheel_insert(wheel, entry);
+  }
+}
+
+static void test_timer_arm(
+  timer_wheel_t *wheel,
+  test_timer_t *timer,
+  uint64_t expiry,
+  uint64_t period)
+{
+  timer->entry.expiry = expiry;
+  timer->period = period;
+  timer->nb_fired = 0;
+  timer->fired_at = 0;
+  timer_wheel_insert(wheel, &timer->entry);
+}
+
+/*
+ * Expiries on every level of the wheel, from a start tick that is not
+ * aligned on a slot, must fire on their exact tick after being cascaded.
+ */
+START_TEST(timer_wheel_cascade_test)
+{
+  static const uint64_t expiries[] = {
+    11,                 /* level 0 */
+    255,  256,   257,   /* level 0 / 1 boundary */
+    300,  511,   512,   /* level 1, cascaded once */
+    65535, 65536, 70000, /* level 1 / 2, cascaded twice */
+    (1ULL << 24) + 5,   /* level 3, cascaded three times */
+  };
+  const int nb_timers = sizeof(expiries) / sizeof(expiries[0]);
+  test_timer_t timers[sizeof(expiries) / sizeof(expiries[0])];
+  timer_wheel_t wheel;
+
+  timer_wheel_init(&wheel, 10);
+  for (int i = 0; i < nb_timers; i++) {
+    test_timer_arm(&wheel, &timers[i], expiries[i], 0);
+  }
+  ck_assert_uint_eq(wheel.nb_entries, nb_timers);
+
+  for (int i = 0; i < nb_timers; i++) {
+    /* Nothing fires one tick early */
+    timer_wheel_advance(&wheel, expiries[i] - 1, test_expired, NULL);
+    ck_assert_uint_eq(timers[i].nb_fired, 0);
+    timer_wheel_advance(&wheel, expiries[i], test_expired, NULL);
+    ck_assert_uint_eq(timers[i].nb_fired, 1);
+    ck_assert_uint_eq(timers[i].fired_at, expiries[i]);
+  }
+  ck_assert_uint_eq(wheel.nb_entries, 0);
+}
+END_TEST
+
+START_TEST(timer_wheel_due_and_clamp_test)
+{
+  test_timer_t due, far;
+  timer_wheel_t wheel;
+
+  timer_wheel_init(&wheel, 1000);
+
+  /* An expiry already passed fires on the next processed tick */
+  test_timer_arm(&wheel, &due, 10, 0);
+  timer_wheel_advance(&wheel, 1000, test_expired, NULL);
+  ck_assert_uint_eq(due.nb_fired, 1);
+  ck_assert_uint_eq(due.fired_at, 1000);
+
+  /* An expiry out of the range of the wheel is clamped */
+  test_timer_arm(&wheel, &far, UINT64_MAX / 2, 0);
+  ck_assert_uint_eq(far.entry.expiry, 1001 + TIMER_WHEEL_MAX_TICKS);
+  timer_wheel_remove(&wheel, &far.entry);
+  ck_assert_uint_eq(wheel.nb_entries, 0);
+}
+END_TEST
+
+START_TEST(timer_wheel_cancel_test)
+{
+  test_timer_t level0, level1, cascaded, kept;
+  timer_wheel_t wheel;
+
+  timer_wheel_init(&wheel, 0);
+  test_timer_arm(&wheel, &level0, 5, 0);
+  test_timer_arm(&wheel, &level1, 1000, 0);
+  test_timer_arm(&wheel, &cascaded, 600, 0);
+  test_timer_arm(&wheel, &kept, 700, 0);
+
+  /* Removed from the slot it was inserted in */
+  timer_wheel_remove(&wheel, &level0.entry);
+  timer_wheel_remove(&wheel, &level1.entry);
+
+  /* Removed after being cascaded from level 1 to level 0 at tick 512 */
+  timer_wheel_advance(&wheel, 520, test_expired, NULL);
+  timer_wheel_remove(&wheel, &cascaded.entry);
+
+  timer_wheel_advance(&wheel, 2000, test_expired, NULL);
+  ck_assert_uint_eq(level0.nb_fired, 0);
+  ck_assert_uint_eq(level1.nb_fired, 0);
+  ck_assert_uint_eq(cascaded.nb_fired, 0);
+  ck_assert_uint_eq(kept.nb_fired, 1);
+  ck_assert_uint_eq(kept.fired_at, 700);
+  ck_assert_uint_eq(wheel.nb_entries, 0);
+}
+END_TEST
+
+/*
+ * Periodic timers re-armed from the expiry callback keep their period,
+ * across the level boundaries too.
+ */
+START_TEST(timer_wheel_periodic_test)
+{
+  test_timer_t every_tick, every_100, every_300;
+  timer_wheel_t wheel;
+
+  timer_wheel_init(&wheel, 0);
+  test_timer_arm(&wheel, &every_tick, 1, 1);
+  test_timer_arm(&wheel, &every_100, 100, 100);
+  test_timer_arm(&wheel, &every_300, 300, 300);
+
+  for (uint64_t tick = 1; tick <= 3000; tick++) {
+    timer_wheel_advance(&wheel, tick, test_expired, NULL);
+    ck_assert_uint_eq(every_tick.nb_fired, tick);
+    ck_assert_uint_eq(every_100.nb_fired, tick / 100);
+    ck_assert_uint_eq(every_300.nb_fired, tick / 300);
+  }
+  ck_assert_uint_eq(every_100.fired_at, 3000);
+  ck_assert_uint_eq(every_300.fired_at, 3000);
+
+  /* Cancelled between two periods */
+  timer_wheel_remove(&wheel, &every_300.entry);
+  timer_wheel_advance(&wheel, 3600, test_expired, NULL);
+  ck_assert_uint_eq(every_300.nb_fired, 10);
+  ck_assert_uint_eq(every_100.nb_fired, 36);
+  ck_assert_uint_eq(wheel.nb_entries, 2);
+}
+END_TEST
+
+Suite *timer_wheel_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("Timer wheel tests");
+
+  /* Core test case */
+  tc_core = tcase_create("Timer wheel test");
+  tcase_add_test(tc_core, timer_wheel_cascade_test);
+  tcase_add_test(tc_core, timer_wheel_due_and_clamp_test);
+  tcase_add_test(tc_core, timer_wheel_cancel_test);
+  tcase_add_test(tc_core, timer_wheel_periodic_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = timer_wheel_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
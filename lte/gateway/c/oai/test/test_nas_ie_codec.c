@@ -0,0 +1,525 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "AttachRequest.h"
+#include "PdnConnectivityRequest.h"
+#include "TrackingAreaUpdateRequest.h"
+#include "EsmInformationResponse.h"
+#include "nas_ie_codec.h"
+
+/*
+ * Attach request, PDN connectivity request, tracking area update request and
+ * ESM information response bodies, after the message type, with most of
+ * their optional IEs. Each IE is decoded and encoded by the IE
+ * codecs of tasks/nas/ies and lib/3gpp, the table driven message codec must
+ * give them back unchanged.
+ */
+static const uint8_t attach_request[] = {
+  /* NAS key set identifier, EPS attach type */
+  0x71,
+  /* EPS mobile identity: IMSI 001010123456789 */
+  0x08, 0x09, 0x10, 0x10, 0x10, 0x32, 0x54, 0x76, 0x98,
+  /* UE network capability */
+  0x02, 0xe0, 0xe0,
+  /* ESM message container: PDN connectivity request */
+  0x00, 0x04, 0x02, 0x01, 0xd0, 0x11,
+  /* Old P-TMSI signature */
+  0x19, 0x01, 0x02, 0x03,
+  /* Last visited registered TAI */
+  0x52, 0x00, 0xf1, 0x10, 0x00, 0x01,
+  /* DRX parameter */
+  0x5c, 0x0a, 0x00,
+  /* MS network capability */
+  0x31, 0x03, 0xe5, 0xe0, 0x34,
+  /* Old location area identification */
+  0x13, 0x00, 0xf1, 0x10, 0x00, 0x01,
+  /* TMSI status */
+  0x90,
+  /* Mobile station classmark 2 */
+  0x11, 0x03, 0x57, 0x58, 0xa6,
+  /* Supported codecs */
+  0x40, 0x08, 0x04, 0x02, 0x60, 0x04, 0x1f, 0x02, 0x1f, 0x00,
+  /* Voice domain preference and UE's usage setting */
+  0x5d, 0x01, 0x02,
+  /* MS network feature support */
+  0xc1};
+
+static const uint8_t pdn_connectivity_request[] = {
+  /* PDN type, request type */
+  0x11,
+  /* ESM information transfer flag */
+  0xd1,
+  /* Access point name */
+  0x28, 0x09, 0x08, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x65, 0x74,
+  /* Protocol configuration options */
+  0x27, 0x04, 0x80, 0x00, 0x0d, 0x00};
+
+static const uint8_t tracking_area_update_request[] = {
+  /* NAS key set identifier, EPS update type */
+  0x71,
+  /* Old GUTI */
+  0x0b, 0xf6, 0x00, 0xf1, 0x10, 0x80, 0x01, 0x01, 0x00, 0x00, 0x00, 0x01,
+  /* Non-current native NAS key set identifier */
+  0xb1,
+  /* GPRS ciphering key sequence number */
+  0x81,
+  /* Old P-TMSI signature */
+  0x19, 0x01, 0x02, 0x03,
+  /* NonceUE */
+  0x55, 0x12, 0x34, 0x56, 0x78,
+  /* UE network capability */
+  0x58, 0x02, 0xe0, 0xe0,
+  /* Last visited registered TAI */
+  0x52, 0x00, 0xf1, 0x10, 0x00, 0x01,
+  /* DRX parameter */
+  0x5c, 0x0a, 0x00,
+  /* UE radio capability information update needed */
+  0xa1,
+  /* EPS bearer context status */
+  0x57, 0x02, 0x20, 0x00,
+  /* MS network capability */
+  0x31, 0x03, 0xe5, 0xe0, 0x34,
+  /* Old location area identification */
+  0x13, 0x00, 0xf1, 0x10, 0x00, 0x01,
+  /* TMSI status */
+  0x90,
+  /* Mobile station classmark 2 */
+  0x11, 0x03, 0x57, 0x58, 0xa6,
+  /* Supported codecs */
+  0x40, 0x08, 0x04, 0x02, 0x60, 0x04, 0x1f, 0x02, 0x1f, 0x00,
+  /* Old GUTI type */
+  0xe0};
+
+static const uint8_t esm_information_response[] = {
+  /* Access point name */
+  0x28, 0x09, 0x08, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x65, 0x74,
+  /* Protocol configuration options */
+  0x27, 0x04, 0x80, 0x00, 0x0d, 0x00};
+
+/* Length of the mandatory IEs at the head of the messages above */
+#define ATTACH_REQUEST_MANDATORY_LENGTH 20
+#define PDN_CONNECTIVITY_REQUEST_MANDATORY_LENGTH 1
+#define TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH 13
+#define ESM_INFORMATION_RESPONSE_MANDATORY_LENGTH 0
+
+#define NB_FUZZ_ROUNDS 20000
+
+/* The messages are zeroed before decoding, free what the decoders allocated */
+static void free_attach_request(attach_request_msg *msg)
+{
+  bdestroy(msg->esmmessagecontainer);
+  bdestroy(msg->supportedcodecs);
+  msg->esmmessagecontainer = NULL;
+  msg->supportedcodecs = NULL;
+}
+
+static void free_pdn_connectivity_request(pdn_connectivity_request_msg *msg)
+{
+  bdestroy(msg->accesspointname);
+  msg->accesspointname = NULL;
+  clear_protocol_configuration_options(&msg->protocolconfigurationoptions);
+}
+
+static void free_tracking_area_update_request(
+  tracking_area_update_request_msg *msg)
+{
+  bdestroy(msg->supportedcodecs);
+  msg->supportedcodecs = NULL;
+}
+
+static void free_esm_information_response(esm_information_response_msg *msg)
+{
+  bdestroy(msg->accesspointname);
+  msg->accesspointname = NULL;
+  clear_protocol_configuration_options(&msg->protocolconfigurationoptions);
+}
+
+START_TEST(attach_request_round_trip_test)
+{
+  attach_request_msg msg;
+  uint8_t buffer[sizeof(attach_request)];
+  uint8_t out[256];
+  int decoded, encoded;
+
+  memset(&msg, 0, sizeof(msg));
+  memcpy(buffer, attach_request, sizeof(buffer));
+  decoded = decode_attach_request(&msg, buffer, sizeof(buffer));
+  ck_assert_int_eq(decoded, sizeof(attach_request));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    ATTACH_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT |
+      ATTACH_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT |
+      ATTACH_REQUEST_DRX_PARAMETER_PRESENT |
+      ATTACH_REQUEST_MS_NETWORK_CAPABILITY_PRESENT |
+      ATTACH_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT |
+      ATTACH_REQUEST_TMSI_STATUS_PRESENT |
+      ATTACH_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT |
+      ATTACH_REQUEST_SUPPORTED_CODECS_PRESENT |
+      ATTACH_REQUEST_VOICE_DOMAIN_PREFERENCE_AND_UE_USAGE_SETTING_PRESENT |
+      ATTACH_REQUEST_MS_NETWORK_FEATURE_SUPPORT_PRESENT);
+  ck_assert_uint_eq(msg.oldptmsisignature, 0x010203);
+
+  encoded = encode_attach_request(&msg, out, sizeof(out));
+  ck_assert_int_eq(encoded, sizeof(attach_request));
+  ck_assert_int_eq(memcmp(out, attach_request, sizeof(attach_request)), 0);
+  free_attach_request(&msg);
+}
+END_TEST
+
+START_TEST(pdn_connectivity_request_round_trip_test)
+{
+  pdn_connectivity_request_msg msg;
+  uint8_t buffer[sizeof(pdn_connectivity_request)];
+  uint8_t out[256];
+  int decoded, encoded;
+
+  memset(&msg, 0, sizeof(msg));
+  memcpy(buffer, pdn_connectivity_request, sizeof(buffer));
+  decoded = decode_pdn_connectivity_request(&msg, buffer, sizeof(buffer));
+  ck_assert_int_eq(decoded, sizeof(pdn_connectivity_request));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT |
+      PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_PRESENT |
+      PDN_CONNECTIVITY_REQUEST_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT);
+  ck_assert_int_eq(biseqcstr(msg.accesspointname, "internet"), 1);
+
+  encoded = encode_pdn_connectivity_request(&msg, out, sizeof(out));
+  ck_assert_int_eq(encoded, sizeof(pdn_connectivity_request));
+  ck_assert_int_eq(
+    memcmp(out, pdn_connectivity_request, sizeof(pdn_connectivity_request)),
+    0);
+  free_pdn_connectivity_request(&msg);
+}
+END_TEST
+
+START_TEST(tracking_area_update_request_round_trip_test)
+{
+  tracking_area_update_request_msg msg;
+  uint8_t buffer[sizeof(tracking_area_update_request)];
+  uint8_t out[256];
+  int decoded, encoded;
+
+  memset(&msg, 0, sizeof(msg));
+  memcpy(buffer, tracking_area_update_request, sizeof(buffer));
+  decoded = decode_tracking_area_update_request(&msg, buffer, sizeof(buffer));
+  ck_assert_int_eq(decoded, sizeof(tracking_area_update_request));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    TRACKING_AREA_UPDATE_REQUEST_NONCURRENT_NATIVE_NAS_KEY_SET_IDENTIFIER_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_GPRS_CIPHERING_KEY_SEQUENCE_NUMBER_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_OLD_PTMSI_SIGNATURE_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_NONCEUE_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_UE_NETWORK_CAPABILITY_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_LAST_VISITED_REGISTERED_TAI_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_DRX_PARAMETER_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_UE_RADIO_CAPABILITY_INFORMATION_UPDATE_NEEDED_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_EPS_BEARER_CONTEXT_STATUS_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_MS_NETWORK_CAPABILITY_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_OLD_LOCATION_AREA_IDENTIFICATION_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_MOBILE_STATION_CLASSMARK_2_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_SUPPORTED_CODECS_PRESENT |
+      TRACKING_AREA_UPDATE_REQUEST_OLD_GUTI_TYPE_PRESENT);
+  ck_assert_uint_eq(msg.naskeysetidentifier.naskeysetidentifier, 7);
+  ck_assert_uint_eq(msg.epsupdatetype.eps_update_type_value, 1);
+  ck_assert_uint_eq(msg.nonceue, 0x12345678);
+
+  encoded = encode_tracking_area_update_request(&msg, out, sizeof(out));
+  ck_assert_int_eq(encoded, sizeof(tracking_area_update_request));
+  ck_assert_int_eq(
+    memcmp(
+      out, tracking_area_update_request, sizeof(tracking_area_update_request)),
+    0);
+  free_tracking_area_update_request(&msg);
+}
+END_TEST
+
+/* The voice domain preference is skipped, it is not encoded back */
+START_TEST(tracking_area_update_request_skipped_ie_test)
+{
+  tracking_area_update_request_msg msg;
+  uint8_t buffer[TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH + 4];
+  uint8_t out[256];
+
+  memcpy(
+    buffer,
+    tracking_area_update_request,
+    TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH);
+  /* Voice domain preference and UE's usage setting, TMSI status */
+  memcpy(
+    buffer + TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH,
+    (uint8_t[]){0x5d, 0x01, 0x02, 0x90},
+    4);
+  memset(&msg, 0, sizeof(msg));
+  ck_assert_int_eq(
+    decode_tracking_area_update_request(&msg, buffer, sizeof(buffer)),
+    sizeof(buffer));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    TRACKING_AREA_UPDATE_REQUEST_VOICE_DOMAIN_PREFERENCE |
+      TRACKING_AREA_UPDATE_REQUEST_TMSI_STATUS_PRESENT);
+
+  ck_assert_int_eq(
+    encode_tracking_area_update_request(&msg, out, sizeof(out)),
+    TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH + 1);
+  ck_assert_uint_eq(out[TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH], 0x90);
+  free_tracking_area_update_request(&msg);
+}
+END_TEST
+
+START_TEST(esm_information_response_round_trip_test)
+{
+  esm_information_response_msg msg;
+  uint8_t buffer[sizeof(esm_information_response)];
+  uint8_t out[256];
+  int decoded, encoded;
+
+  memset(&msg, 0, sizeof(msg));
+  memcpy(buffer, esm_information_response, sizeof(buffer));
+  decoded = decode_esm_information_response(&msg, buffer, sizeof(buffer));
+  ck_assert_int_eq(decoded, sizeof(esm_information_response));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_PRESENT |
+      ESM_INFORMATION_RESPONSE_PROTOCOL_CONFIGURATION_OPTIONS_PRESENT);
+  ck_assert_int_eq(biseqcstr(msg.accesspointname, "internet"), 1);
+
+  encoded = encode_esm_information_response(&msg, out, sizeof(out));
+  ck_assert_int_eq(encoded, sizeof(esm_information_response));
+  ck_assert_int_eq(
+    memcmp(out, esm_information_response, sizeof(esm_information_response)),
+    0);
+  free_esm_information_response(&msg);
+}
+END_TEST
+
+/* A message of a single TV IE whose decoder never consumes anything */
+typedef struct {
+  uint32_t presencemask;
+} zero_decoder_msg;
+
+#define ZERO_DECODER_OPTIONAL_IES(IE)                                            IE(ZERO, 0x5c, (1 << 0), TV, 3, 3, 0, 0)
+
+#define NAS_IE_MSG_TYPE zero_decoder_msg
+NAS_MSG_DESC_DEFINE(_zero_decoder_desc, ZERO_DECODER_OPTIONAL_IES)
+
+START_TEST(optional_ie_errors_test)
+{
+  pdn_connectivity_request_msg msg;
+  /* Unexpected IEI */
+  uint8_t unexpected[] = {0x11, 0x5c, 0x0a, 0x00};
+  /* APN longer than the rest of the message */
+  uint8_t cut[] = {0x11, 0x28, 0x09, 0x08, 0x69, 0x6e};
+  /* Device properties are skipped */
+  uint8_t skipped[] = {0x11, 0xc1, 0xd1};
+  /* APN shorter than its minimum length, skipped as if not present */
+  uint8_t out_of_range[] = {0x11, 0x28, 0x00, 0xd1};
+  /* APN longer than its maximum length, skipped as well */
+  uint8_t too_long[1 + 2 + 101 + 1] = {0x11, 0x28, 101};
+
+  memset(&msg, 0, sizeof(msg));
+  ck_assert_int_eq(
+    decode_pdn_connectivity_request(&msg, unexpected, sizeof(unexpected)),
+    TLV_UNEXPECTED_IEI);
+  memset(&msg, 0, sizeof(msg));
+  ck_assert_int_eq(
+    decode_pdn_connectivity_request(&msg, cut, sizeof(cut)),
+    TLV_BUFFER_TOO_SHORT);
+  memset(&msg, 0, sizeof(msg));
+  ck_assert_int_eq(
+    decode_pdn_connectivity_request(&msg, skipped, sizeof(skipped)),
+    sizeof(skipped));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT);
+
+  memset(&msg, 0, sizeof(msg));
+  ck_assert_int_eq(
+    decode_pdn_connectivity_request(&msg, out_of_range, sizeof(out_of_range)),
+    sizeof(out_of_range));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT);
+  ck_assert_ptr_eq(msg.accesspointname, NULL);
+
+  memset(&msg, 0, sizeof(msg));
+  too_long[sizeof(too_long) - 1] = 0xd1;
+  ck_assert_int_eq(
+    decode_pdn_connectivity_request(&msg, too_long, sizeof(too_long)),
+    sizeof(too_long));
+  ck_assert_uint_eq(
+    msg.presencemask,
+    PDN_CONNECTIVITY_REQUEST_ESM_INFORMATION_TRANSFER_FLAG_PRESENT);
+  ck_assert_ptr_eq(msg.accesspointname, NULL);
+}
+END_TEST
+
+/* An IE its decoder did not recognize must not loop nor be taken as decoded */
+START_TEST(optional_ie_decoder_returns_zero_test)
+{
+  zero_decoder_msg msg = {0};
+  uint8_t buffer[] = {0x5c, 0x0a, 0x00};
+
+  ck_assert_int_eq(
+    nas_decode_optional_ies(&_zero_decoder_desc, &msg, buffer, sizeof(buffer)),
+    TLV_VALUE_DOESNT_MATCH);
+  ck_assert_uint_eq(msg.presencemask, 0);
+}
+END_TEST
+
+/*
+ * Copy of the optional IEs of msg, past its mandatory_length octets, randomly
+ * truncated and with up to 3 random octets. The mandatory IEs keep the
+ * decoders of their own and are left as they are.
+ */
+static uint8_t *fuzz_message(
+  const uint8_t *msg,
+  uint32_t size,
+  uint32_t mandatory_length,
+  uint32_t *len)
+{
+  uint8_t *buffer;
+
+  *len = mandatory_length + rand() % (size - mandatory_length + 1);
+  buffer = malloc(*len);
+  memcpy(buffer, msg, *len);
+  if (*len > mandatory_length) {
+    for (int m = rand() % 4; m > 0; m--)
+      buffer[mandatory_length + rand() % (*len - mandatory_length)] = rand();
+  }
+  return buffer;
+}
+
+/*
+ * The decoders must stay within the buffer, and what they accept must encode
+ * again.
+ */
+START_TEST(fuzz_test)
+{
+  uint8_t out[1024];
+
+  srand(0);
+  for (int r = 0; r < NB_FUZZ_ROUNDS; r++) {
+    attach_request_msg attach;
+    pdn_connectivity_request_msg pdn;
+    tracking_area_update_request_msg tau;
+    esm_information_response_msg esm_info;
+    uint32_t len;
+    uint8_t *buffer;
+
+    buffer = fuzz_message(
+      attach_request,
+      sizeof(attach_request),
+      ATTACH_REQUEST_MANDATORY_LENGTH,
+      &len);
+    memset(&attach, 0, sizeof(attach));
+    if (decode_attach_request(&attach, buffer, len) > 0) {
+      ck_assert_int_ge(encode_attach_request(&attach, out, sizeof(out)), 0);
+    }
+    free_attach_request(&attach);
+    free(buffer);
+
+    buffer = fuzz_message(
+      pdn_connectivity_request,
+      sizeof(pdn_connectivity_request),
+      PDN_CONNECTIVITY_REQUEST_MANDATORY_LENGTH,
+      &len);
+    memset(&pdn, 0, sizeof(pdn));
+    if (decode_pdn_connectivity_request(&pdn, buffer, len) > 0) {
+      ck_assert_int_ge(
+        encode_pdn_connectivity_request(&pdn, out, sizeof(out)), 0);
+    }
+    free_pdn_connectivity_request(&pdn);
+    free(buffer);
+
+    buffer = fuzz_message(
+      tracking_area_update_request,
+      sizeof(tracking_area_update_request),
+      TRACKING_AREA_UPDATE_REQUEST_MANDATORY_LENGTH,
+      &len);
+    memset(&tau, 0, sizeof(tau));
+    if (decode_tracking_area_update_request(&tau, buffer, len) > 0) {
+      ck_assert_int_ge(
+        encode_tracking_area_update_request(&tau, out, sizeof(out)), 0);
+    }
+    free_tracking_area_update_request(&tau);
+    free(buffer);
+
+    buffer = fuzz_message(
+      esm_information_response,
+      sizeof(esm_information_response),
+      ESM_INFORMATION_RESPONSE_MANDATORY_LENGTH,
+      &len);
+    memset(&esm_info, 0, sizeof(esm_info));
+    if (decode_esm_information_response(&esm_info, buffer, len) >= 0) {
+      ck_assert_int_ge(
+        encode_esm_information_response(&esm_info, out, sizeof(out)), 0);
+    }
+    free_esm_information_response(&esm_info);
+    free(buffer);
+  }
+}
+END_TEST
+
+Suite *nas_ie_codec_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("NAS IE codec tests");
+
+  /* Core test case */
+  tc_core = tcase_create("NAS IE codec test");
+  tcase_add_test(tc_core, attach_request_round_trip_test);
+  tcase_add_test(tc_core, pdn_connectivity_request_round_trip_test);
+  tcase_add_test(tc_core, tracking_area_update_request_round_trip_test);
+  tcase_add_test(tc_core, tracking_area_update_request_skipped_ie_test);
+  tcase_add_test(tc_core, esm_information_response_round_trip_test);
+  tcase_add_test(tc_core, optional_ie_errors_test);
+  tcase_add_test(tc_core, optional_ie_decoder_returns_zero_test);
+  tcase_add_test(tc_core, fuzz_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = nas_ie_codec_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
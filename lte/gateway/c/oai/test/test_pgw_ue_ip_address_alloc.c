@@ -0,0 +1,216 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "pgw_ue_ip_address_alloc.h"
+#include "rpc_client.h"
+
+/*
+ * mobilityd is replaced by the functions below: an allocation returns
+ * next_addr, the reverse lookup answers with mobilityd_imsi if set.
+ */
+static struct in_addr next_addr;
+static const char *mobilityd_imsi;
+static int nb_lookups;
+static int nb_releases;
+
+int allocate_ipv4_address(const char *subscriber_id, struct in_addr *addr)
+{
+  *addr = next_addr;
+  return RPC_STATUS_OK;
+}
+
+void allocate_ipv4_address_async(
+  const char *subscriber_id,
+  void (*callback)(int status, struct in_addr addr, void *callback_arg),
+  void *callback_arg)
+{
+  ck_abort_msg("Not used by the test");
+}
+
+int release_ipv4_address(const char *subscriber_id, const struct in_addr *addr)
+{
+  nb_releases++;
+  return RPC_STATUS_OK;
+}
+
+void release_ipv4_address_async(
+  const char *subscriber_id,
+  const struct in_addr *addr,
+  void (*callback)(int status, struct in_addr addr, void *callback_arg),
+  void *callback_arg)
+{
+  nb_releases++;
+  callback(RPC_STATUS_OK, *addr, callback_arg);
+}
+
+int get_assigned_ipv4_block(
+  int index,
+  struct in_addr *netaddr,
+  uint32_t *netmask)
+{
+  return RPC_STATUS_UNAVAILABLE;
+}
+
+int get_subscriber_id_from_ipv4(
+  const struct in_addr *addr,
+  char **subscriber_id)
+{
+  nb_lookups++;
+  if (!mobilityd_imsi) {
+    return RPC_STATUS_UNAVAILABLE;
+  }
+  *subscriber_id = strdup(mobilityd_imsi);
+  return RPC_STATUS_OK;
+}
+
+void increment_counter(
+  const char *name,
+  double increment,
+  size_t n_labels,
+  ...)
+{
+}
+
+static void test_setup(void)
+{
+  static bool initialized = false;
+
+  if (!initialized) {
+    pgw_ip_address_pool_init();
+    initialized = true;
+  }
+  inet_pton(AF_INET, "192.168.128.11", &next_addr);
+  mobilityd_imsi = NULL;
+  nb_lookups = 0;
+  nb_releases = 0;
+}
+
+START_TEST(ue_ip_reallocated_lookup_test)
+{
+  struct in_addr addr = {0};
+  char imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+
+  ck_assert_int_eq(allocate_ue_ipv4_address("001010000000001", &addr), 0);
+  ck_assert_int_eq(get_imsi_from_ue_ipv4_address(&addr, imsi), 0);
+  ck_assert_str_eq(imsi, "001010000000001");
+
+  ck_assert_int_eq(release_ue_ipv4_address("001010000000001", &addr), 0);
+  ck_assert_int_eq(nb_releases, 1);
+
+  /* mobilityd hands the same address out to another UE */
+  ck_assert_int_eq(allocate_ue_ipv4_address("208950000000002", &addr), 0);
+  ck_assert_int_eq(get_imsi_from_ue_ipv4_address(&addr, imsi), 0);
+  ck_assert_str_eq(imsi, "208950000000002");
+  ck_assert_int_eq(nb_lookups, 0);
+
+  ck_assert_int_eq(release_ue_ipv4_address("208950000000002", &addr), 0);
+}
+END_TEST
+
+START_TEST(ue_ip_released_lookup_test)
+{
+  struct in_addr addr = {0};
+  char imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+
+  ck_assert_int_eq(allocate_ue_ipv4_address("001010000000001", &addr), 0);
+  ck_assert_int_eq(release_ue_ipv4_address("001010000000001", &addr), 0);
+
+  /* No stale mapping left, mobilityd is asked */
+  ck_assert_int_ne(get_imsi_from_ue_ipv4_address(&addr, imsi), 0);
+  ck_assert_int_eq(nb_lookups, 1);
+}
+END_TEST
+
+START_TEST(ue_ip_mobilityd_lookup_not_cached_test)
+{
+  struct in_addr addr = {0};
+  char imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+
+  /* Allocated before a restart, only mobilityd knows it */
+  inet_pton(AF_INET, "192.168.128.12", &addr);
+  mobilityd_imsi = "310150000000003";
+  ck_assert_int_eq(get_imsi_from_ue_ipv4_address(&addr, imsi), 0);
+  ck_assert_str_eq(imsi, "310150000000003");
+
+  /* Released meanwhile, the first answer must not be served again */
+  mobilityd_imsi = NULL;
+  ck_assert_int_ne(get_imsi_from_ue_ipv4_address(&addr, imsi), 0);
+  ck_assert_int_eq(nb_lookups, 2);
+}
+END_TEST
+
+START_TEST(ue_ip_already_allocated_test)
+{
+  struct in_addr addr = {0};
+  char imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+
+  ck_assert_int_eq(allocate_ue_ipv4_address("001010000000001", &addr), 0);
+
+  /* A stale session: the address is released with its mapping */
+  ck_assert_int_eq(
+    check_ue_ipv4_address_allocation(
+      "001010000000001", &addr, RPC_STATUS_ALREADY_EXISTS),
+    RPC_STATUS_ALREADY_EXISTS);
+  ck_assert_int_eq(nb_releases, 1);
+  ck_assert_int_ne(get_imsi_from_ue_ipv4_address(&addr, imsi), 0);
+  ck_assert_int_eq(nb_lookups, 1);
+}
+END_TEST
+
+Suite *pgw_ue_ip_address_alloc_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("PGW UE IP address allocation tests");
+
+  /* Core test case */
+  tc_core = tcase_create("UE IP address to IMSI mapping test");
+  tcase_add_checked_fixture(tc_core, test_setup, NULL);
+  tcase_add_test(tc_core, ue_ip_reallocated_lookup_test);
+  tcase_add_test(tc_core, ue_ip_released_lookup_test);
+  tcase_add_test(tc_core, ue_ip_mobilityd_lookup_not_cached_test);
+  tcase_add_test(tc_core, ue_ip_already_allocated_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = pgw_ue_ip_address_alloc_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,374 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+#include "sctp_rx_buffer.h"
+
+#define TEST_POOL_SIZE 4
+
+/*
+ * Replaces sctp_recvmsg(): each call plays the next step, returning length
+ * bytes with flags, or failing with err if it is set. The bytes of the
+ * stream are numbered, byte i is (uint8_t) i.
+ */
+typedef struct test_recv_step_s {
+  int length;
+  int flags;
+  int err;
+} test_recv_step_t;
+
+static const test_recv_step_t *test_steps;
+static int test_nb_steps;
+static int test_stream_offset;
+
+static int test_recv(
+  int sd,
+  void *data,
+  size_t size,
+  struct sctp_sndrcvinfo *sinfo,
+  int *flags)
+{
+  const test_recv_step_t *step = NULL;
+
+  ck_assert_int_gt(test_nb_steps, 0);
+  step = test_steps++;
+  test_nb_steps--;
+  if (step->err) {
+    errno = step->err;
+    return -1;
+  }
+  ck_assert_uint_le(step->length, size);
+  for (int i = 0; i < step->length; i++) {
+    ((uint8_t *) data)[i] = (uint8_t)(test_stream_offset + i);
+  }
+  test_stream_offset += step->length;
+  *flags = step->flags;
+  return step->length;
+}
+
+static void test_play(const test_recv_step_t *steps, int nb_steps)
+{
+  test_steps = steps;
+  test_nb_steps = nb_steps;
+}
+
+static void test_check_message(
+  sctp_rx_buffer_t *message,
+  const int stream_offset,
+  const int length)
+{
+  ck_assert_ptr_ne(message, NULL);
+  ck_assert_int_eq(blength(&message->payload), length);
+  for (int i = 0; i < length; i++) {
+    ck_assert_uint_eq(message->data[i], (uint8_t)(stream_offset + i));
+  }
+}
+
+static void test_setup(void)
+{
+  sctp_rx_buffer_pool_init(TEST_POOL_SIZE);
+}
+
+static void test_teardown(void)
+{
+  sctp_rx_buffer_pool_exit();
+}
+
+START_TEST(sctp_rx_buffer_get_test)
+{
+  sctp_rx_buffer_t *buffer = sctp_rx_buffer_get();
+
+  ck_assert_ptr_ne(buffer, NULL);
+  ck_assert(buffer->is_pooled);
+  ck_assert_uint_eq(buffer->ref_count, 1);
+  ck_assert_uint_eq(buffer->size, SCTP_RX_BUFFER_SIZE);
+  ck_assert_int_eq(blength(&buffer->payload), 0);
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 1);
+
+  memcpy(buffer->data, "\x00\x11\x22", 3);
+  sctp_rx_buffer_set_length(&buffer, 3);
+  ck_assert_int_eq(blength(&buffer->payload), 3);
+  ck_assert_ptr_eq(bdata(&buffer->payload), buffer->data);
+
+  sctp_rx_buffer_unref(&buffer);
+  ck_assert_ptr_eq(buffer, NULL);
+}
+END_TEST
+
+START_TEST(sctp_rx_buffer_ref_test)
+{
+  sctp_rx_buffer_t *buffer = sctp_rx_buffer_get();
+  sctp_rx_buffer_t *holder = buffer;
+  sctp_rx_buffer_t *again = NULL;
+
+  sctp_rx_buffer_ref(buffer);
+  ck_assert_uint_eq(buffer->ref_count, 2);
+
+  /* Still referenced by holder, not back in the pool */
+  sctp_rx_buffer_unref(&buffer);
+  ck_assert_ptr_eq(buffer, NULL);
+  ck_assert_uint_eq(holder->ref_count, 1);
+  again = sctp_rx_buffer_get();
+  ck_assert_ptr_ne(again, holder);
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 2);
+  sctp_rx_buffer_unref(&again);
+
+  /* Last reference, reused by the next get */
+  sctp_rx_buffer_unref(&holder);
+  again = sctp_rx_buffer_get();
+  ck_assert_uint_eq(again->ref_count, 1);
+  ck_assert_int_eq(blength(&again->payload), 0);
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 2);
+  sctp_rx_buffer_unref(&again);
+
+  /* Unref of a released buffer is a no-op */
+  sctp_rx_buffer_unref(&again);
+  sctp_rx_buffer_unref(NULL);
+}
+END_TEST
+
+START_TEST(sctp_rx_buffer_exhaustion_test)
+{
+  sctp_rx_buffer_t *buffers[TEST_POOL_SIZE + 2];
+  int i;
+
+  for (i = 0; i < TEST_POOL_SIZE + 2; i++) {
+    buffers[i] = sctp_rx_buffer_get();
+    ck_assert_ptr_ne(buffers[i], NULL);
+    ck_assert_uint_eq(buffers[i]->size, SCTP_RX_BUFFER_SIZE);
+    ck_assert(buffers[i]->is_pooled == (i < TEST_POOL_SIZE));
+  }
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), TEST_POOL_SIZE);
+
+  /* Buffers allocated outside of the pool are freed, not pooled */
+  for (i = 0; i < TEST_POOL_SIZE + 2; i++) {
+    sctp_rx_buffer_unref(&buffers[i]);
+  }
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), TEST_POOL_SIZE);
+
+  for (i = 0; i < TEST_POOL_SIZE + 2; i++) {
+    buffers[i] = sctp_rx_buffer_get();
+    ck_assert(buffers[i]->is_pooled == (i < TEST_POOL_SIZE));
+  }
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), TEST_POOL_SIZE);
+  for (i = 0; i < TEST_POOL_SIZE + 2; i++) {
+    sctp_rx_buffer_unref(&buffers[i]);
+  }
+}
+END_TEST
+
+START_TEST(sctp_rx_buffer_grow_test)
+{
+  const int length = SCTP_RX_BUFFER_SIZE + 100;
+  sctp_rx_buffer_t *buffer = sctp_rx_buffer_get();
+  int i;
+
+  for (i = 0; i < SCTP_RX_BUFFER_SIZE; i++) {
+    buffer->data[i] = (uint8_t) i;
+  }
+  sctp_rx_buffer_grow(&buffer, SCTP_RX_BUFFER_SIZE, SCTP_RECV_BUFFER_SIZE);
+  ck_assert(!buffer->is_pooled);
+  ck_assert_uint_eq(buffer->ref_count, 1);
+  ck_assert_uint_eq(buffer->size, SCTP_RECV_BUFFER_SIZE);
+  for (i = SCTP_RX_BUFFER_SIZE; i < length; i++) {
+    buffer->data[i] = (uint8_t) i;
+  }
+
+  /* Shrunk to the message, received bytes kept */
+  sctp_rx_buffer_set_length(&buffer, length);
+  ck_assert_uint_eq(buffer->size, length);
+  ck_assert_int_eq(blength(&buffer->payload), length);
+  ck_assert_ptr_eq(bdata(&buffer->payload), buffer->data);
+  for (i = 0; i < length; i++) {
+    ck_assert_uint_eq(buffer->data[i], (uint8_t) i);
+  }
+  sctp_rx_buffer_unref(&buffer);
+
+  /* The pooled buffer the message started in went back to the pool */
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 1);
+  buffer = sctp_rx_buffer_get();
+  ck_assert(buffer->is_pooled);
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 1);
+  sctp_rx_buffer_unref(&buffer);
+}
+END_TEST
+
+/*
+ * The end of a message not queued yet on the non-blocking socket is
+ * received by the next call, the message is not split.
+ */
+START_TEST(sctp_rx_buffer_recv_would_block_test)
+{
+  const test_recv_step_t steps[] = {
+    {10, 0, 0},
+    {0, 0, EAGAIN},
+    {5, MSG_EOR, 0},
+    {SCTP_RX_BUFFER_SIZE, 0, 0},
+    {0, 0, EWOULDBLOCK},
+    {100, 0, 0},
+    {0, 0, EAGAIN},
+    {100, MSG_EOR, 0},
+    {0, 0, EAGAIN},
+  };
+  sctp_rx_partial_t partial = {0};
+  struct sctp_sndrcvinfo sinfo = {0};
+  sctp_rx_buffer_t *message = NULL;
+  int flags = 0;
+
+  test_stream_offset = 0;
+  test_play(steps, sizeof(steps) / sizeof(steps[0]));
+
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_WOULD_BLOCK);
+  ck_assert_ptr_eq(message, NULL);
+  ck_assert_ptr_ne(partial.buffer, NULL);
+  ck_assert_int_eq(partial.length, 10);
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_MESSAGE);
+  ck_assert(flags & MSG_EOR);
+  ck_assert_ptr_eq(partial.buffer, NULL);
+  test_check_message(message, 0, 15);
+  sctp_rx_buffer_unref(&message);
+
+  /* Larger than a pooled buffer, completed over three calls */
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_WOULD_BLOCK);
+  ck_assert_int_eq(partial.length, SCTP_RX_BUFFER_SIZE);
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_WOULD_BLOCK);
+  ck_assert_int_eq(partial.length, SCTP_RX_BUFFER_SIZE + 100);
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_MESSAGE);
+  test_check_message(message, 15, SCTP_RX_BUFFER_SIZE + 200);
+  ck_assert(!message->is_pooled);
+  ck_assert_uint_eq(message->size, SCTP_RX_BUFFER_SIZE + 200);
+  sctp_rx_buffer_unref(&message);
+
+  /* Nothing to read, no buffer is held for the idle socket */
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_WOULD_BLOCK);
+  ck_assert_ptr_eq(message, NULL);
+  ck_assert_ptr_eq(partial.buffer, NULL);
+  ck_assert_int_eq(test_nb_steps, 0);
+}
+END_TEST
+
+/* A read of 0 bytes is the peer closing the one-to-one socket */
+START_TEST(sctp_rx_buffer_recv_closed_test)
+{
+  const test_recv_step_t steps[] = {
+    {0, 0, 0},
+    {100, 0, 0},
+    {0, 0, EAGAIN},
+    {0, 0, 0},
+    {50, 0, 0},
+    {0, 0, 0},
+  };
+  sctp_rx_partial_t partial = {0};
+  struct sctp_sndrcvinfo sinfo = {0};
+  sctp_rx_buffer_t *message = NULL;
+  sctp_rx_buffer_t *buffer = NULL;
+  int flags = 0;
+
+  test_stream_offset = 0;
+  test_play(steps, sizeof(steps) / sizeof(steps[0]));
+
+  /* On a new message */
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_CLOSED);
+  ck_assert_ptr_eq(message, NULL);
+  ck_assert_ptr_eq(partial.buffer, NULL);
+
+  /* On the end of a partial message, received by an earlier call */
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_WOULD_BLOCK);
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_CLOSED);
+  ck_assert_ptr_eq(message, NULL);
+  ck_assert_ptr_eq(partial.buffer, NULL);
+
+  /* On the end of a message started by the same call */
+  ck_assert_int_eq(
+    sctp_rx_buffer_recv(0, test_recv, &partial, &sinfo, &flags, &message),
+    SCTP_RX_RECV_CLOSED);
+  ck_assert_ptr_eq(message, NULL);
+  ck_assert_ptr_eq(partial.buffer, NULL);
+  ck_assert_int_eq(test_nb_steps, 0);
+
+  /* The buffers went back to the pool */
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 1);
+  buffer = sctp_rx_buffer_get();
+  ck_assert(buffer->is_pooled);
+  ck_assert_uint_eq(sctp_rx_buffer_pool_size(), 1);
+  sctp_rx_buffer_unref(&buffer);
+}
+END_TEST
+
+Suite *sctp_rx_buffer_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("SCTP receive buffer tests");
+
+  /* Core test case */
+  tc_core = tcase_create("SCTP receive buffer test");
+  tcase_add_checked_fixture(tc_core, test_setup, test_teardown);
+  tcase_add_test(tc_core, sctp_rx_buffer_get_test);
+  tcase_add_test(tc_core, sctp_rx_buffer_ref_test);
+  tcase_add_test(tc_core, sctp_rx_buffer_exhaustion_test);
+  tcase_add_test(tc_core, sctp_rx_buffer_grow_test);
+  tcase_add_test(tc_core, sctp_rx_buffer_recv_would_block_test);
+  tcase_add_test(tc_core, sctp_rx_buffer_recv_closed_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = sctp_rx_buffer_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
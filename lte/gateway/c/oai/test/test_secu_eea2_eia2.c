@@ -0,0 +1,342 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "secu_defs.h"
+
+/*
+ * Test data from 3GPP TS 33.401 Annex C (128-EEA2 and 128-EIA2 test sets).
+ * Most of the lengths are not a multiple of 8 bits, the unused bits of the
+ * last byte are zero in the plaintexts and in the ciphertexts.
+ */
+
+typedef struct {
+  uint8_t key[16];
+  uint32_t count;
+  uint8_t bearer;
+  uint8_t direction;
+  uint32_t blength;
+  const uint8_t *message;
+  /* ciphertext for EEA2, MAC for EIA2 */
+  const uint8_t *out;
+} nas_stream_test_set_t;
+
+#define NB_TEST_SETS(test_sets) (sizeof(test_sets) / sizeof(test_sets[0]))
+
+static const uint8_t eea2_plaintext_1[32] = {
+  0x98, 0x1b, 0xa6, 0x82, 0x4c, 0x1b, 0xfb, 0x1a, 0xb4, 0x85, 0x47,
+  0x20, 0x29, 0xb7, 0x1d, 0x80, 0x8c, 0xe3, 0x3e, 0x2c, 0xc3, 0xc0,
+  0xb5, 0xfc, 0x1f, 0x3d, 0xe8, 0xa6, 0xdc, 0x66, 0xb1, 0xf0};
+
+static const uint8_t eea2_ciphertext_1[32] = {
+  0xe9, 0xfe, 0xd8, 0xa6, 0x3d, 0x15, 0x53, 0x04, 0xd7, 0x1d, 0xf2,
+  0x0b, 0xf3, 0xe8, 0x22, 0x14, 0xb2, 0x0e, 0xd7, 0xda, 0xd2, 0xf2,
+  0x33, 0xdc, 0x3c, 0x22, 0xd7, 0xbd, 0xee, 0xed, 0x8e, 0x78};
+
+static const uint8_t eea2_plaintext_2[39] = {
+  0xfd, 0x40, 0xa4, 0x1d, 0x37, 0x0a, 0x1f, 0x65, 0x74, 0x50, 0x95,
+  0x68, 0x7d, 0x47, 0xba, 0x1d, 0x36, 0xd2, 0x34, 0x9e, 0x23, 0xf6,
+  0x44, 0x39, 0x2c, 0x8e, 0xa9, 0xc4, 0x9d, 0x40, 0xc1, 0x32, 0x71,
+  0xaf, 0xf2, 0x64, 0xd0, 0xf2, 0x48};
+
+static const uint8_t eea2_ciphertext_2[39] = {
+  0x75, 0x75, 0x0d, 0x37, 0xb4, 0xbb, 0xa2, 0xa4, 0xde, 0xdb, 0x34,
+  0x23, 0x5b, 0xd6, 0x8c, 0x66, 0x45, 0xac, 0xda, 0xac, 0xa4, 0x81,
+  0x38, 0xa3, 0xb0, 0xc4, 0x71, 0xe2, 0xa7, 0x04, 0x1a, 0x57, 0x64,
+  0x23, 0xd2, 0x92, 0x72, 0x87, 0xf0};
+
+static const uint8_t eea2_plaintext_3[128] = {
+  0xfb, 0x1b, 0x96, 0xc5, 0xc8, 0xba, 0xdf, 0xb2, 0xe8, 0xe8, 0xed,
+  0xfd, 0xe7, 0x8e, 0x57, 0xf2, 0xad, 0x81, 0xe7, 0x41, 0x03, 0xfc,
+  0x43, 0x0a, 0x53, 0x4d, 0xcc, 0x37, 0xaf, 0xce, 0xc7, 0x0e, 0x15,
+  0x17, 0xbb, 0x06, 0xf2, 0x72, 0x19, 0xda, 0xe4, 0x90, 0x22, 0xdd,
+  0xc4, 0x7a, 0x06, 0x8d, 0xe4, 0xc9, 0x49, 0x6a, 0x95, 0x1a, 0x6b,
+  0x09, 0xed, 0xbd, 0xc8, 0x64, 0xc7, 0xad, 0xbd, 0x74, 0x0a, 0xc5,
+  0x0c, 0x02, 0x2f, 0x30, 0x82, 0xba, 0xfd, 0x22, 0xd7, 0x81, 0x97,
+  0xc5, 0xd5, 0x08, 0xb9, 0x77, 0xbc, 0xa1, 0x3f, 0x32, 0xe6, 0x52,
+  0xe7, 0x4b, 0xa7, 0x28, 0x57, 0x60, 0x77, 0xce, 0x62, 0x8c, 0x53,
+  0x5e, 0x87, 0xdc, 0x60, 0x77, 0xba, 0x07, 0xd2, 0x90, 0x68, 0x59,
+  0x0c, 0x8c, 0xb5, 0xf1, 0x08, 0x8e, 0x08, 0x2c, 0xfa, 0x0e, 0xc9,
+  0x61, 0x30, 0x2d, 0x69, 0xcf, 0x3d, 0x44};
+
+static const uint8_t eea2_ciphertext_3[128] = {
+  0xdf, 0xb4, 0x40, 0xac, 0xb3, 0x77, 0x35, 0x49, 0xef, 0xc0, 0x46,
+  0x28, 0xae, 0xb8, 0xd8, 0x15, 0x62, 0x75, 0x23, 0x0b, 0xdc, 0x69,
+  0x0d, 0x94, 0xb0, 0x0d, 0x8d, 0x95, 0xf2, 0x8c, 0x4b, 0x56, 0x30,
+  0x7f, 0x60, 0xf4, 0xca, 0x55, 0xeb, 0xa6, 0x61, 0xeb, 0xba, 0x72,
+  0xac, 0x80, 0x8f, 0xa8, 0xc4, 0x9e, 0x26, 0x78, 0x8e, 0xd0, 0x4a,
+  0x5d, 0x60, 0x6c, 0xb4, 0x18, 0xde, 0x74, 0x87, 0x8b, 0x9a, 0x22,
+  0xf8, 0xef, 0x29, 0x59, 0x0b, 0xc4, 0xeb, 0x57, 0xc9, 0xfa, 0xf7,
+  0xc4, 0x15, 0x24, 0xa8, 0x85, 0xb8, 0x97, 0x9c, 0x42, 0x3f, 0x2f,
+  0x8f, 0x8e, 0x05, 0x92, 0xa9, 0x87, 0x92, 0x01, 0xbe, 0x7f, 0xf9,
+  0x77, 0x7a, 0x16, 0x2a, 0xb8, 0x10, 0xfe, 0xb3, 0x24, 0xba, 0x74,
+  0xc4, 0xc1, 0x56, 0xe0, 0x4d, 0x39, 0x09, 0x72, 0x09, 0x65, 0x3a,
+  0xc3, 0x3e, 0x5a, 0x5f, 0x2d, 0x88, 0x64};
+
+static const nas_stream_test_set_t eea2_test_sets[] = {
+  {{0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c,
+    0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1},
+   0x398a59b4,
+   0x15,
+   1,
+   253,
+   eea2_plaintext_1,
+   eea2_ciphertext_1},
+  {{0x0a, 0x8b, 0x6b, 0xd8, 0xd9, 0xb0, 0x8b, 0x08,
+    0xd6, 0x4e, 0x32, 0xd1, 0x81, 0x77, 0x77, 0xfb},
+   0x544d49cd,
+   0x04,
+   0,
+   310,
+   eea2_plaintext_2,
+   eea2_ciphertext_2},
+  {{0xaa, 0x1f, 0x95, 0xae, 0xa5, 0x33, 0xbc, 0xb3,
+    0x2e, 0xb6, 0x3b, 0xf5, 0x2d, 0x8f, 0x83, 0x1a},
+   0x72d8c671,
+   0x10,
+   1,
+   1022,
+   eea2_plaintext_3,
+   eea2_ciphertext_3}};
+
+static const uint8_t eia2_mac_1[4] = {0x11, 0x8c, 0x6e, 0xb8};
+static const uint8_t eia2_message_1[8] = {
+  0x33, 0x32, 0x34, 0x62, 0x63, 0x39, 0x38, 0x40};
+
+static const uint8_t eia2_mac_2[4] = {0xb9, 0x37, 0x87, 0xe6};
+static const uint8_t eia2_message_2[8] = {
+  0x48, 0x45, 0x83, 0xd5, 0xaf, 0xe0, 0x82, 0xae};
+
+static const uint8_t eia2_mac_3[4] = {0x1f, 0x60, 0xb0, 0x1d};
+static const uint8_t eia2_message_3[32] = {
+  0xb3, 0xd3, 0xc9, 0x17, 0x0a, 0x4e, 0x16, 0x32, 0xf6, 0x0f, 0x86,
+  0x10, 0x13, 0xd2, 0x2d, 0x84, 0xb7, 0x26, 0xb6, 0xa2, 0x78, 0xd8,
+  0x02, 0xd1, 0xee, 0xaf, 0x13, 0x21, 0xba, 0x59, 0x29, 0xdc};
+
+static const uint8_t eia2_mac_4[4] = {0x68, 0x46, 0xa2, 0xf0};
+static const uint8_t eia2_message_4[64] = {
+  0xbb, 0xb0, 0x57, 0x03, 0x88, 0x09, 0x49, 0x6b, 0xcf, 0xf8, 0x6d,
+  0x6f, 0xbc, 0x8c, 0xe5, 0xb1, 0x35, 0xa0, 0x6b, 0x16, 0x60, 0x54,
+  0xf2, 0xd5, 0x65, 0xbe, 0x8a, 0xce, 0x75, 0xdc, 0x85, 0x1e, 0x0b,
+  0xcd, 0xd8, 0xf0, 0x71, 0x41, 0xc4, 0x95, 0x87, 0x2f, 0xb5, 0xd8,
+  0xc0, 0xc6, 0x6a, 0x8b, 0x6d, 0xa5, 0x56, 0x66, 0x3e, 0x4e, 0x46,
+  0x12, 0x05, 0xd8, 0x45, 0x80, 0xbe, 0xe5, 0xbc, 0x7e};
+
+static const uint8_t eia2_mac_5[4] = {0xe6, 0x57, 0xe1, 0x82};
+static const uint8_t eia2_message_5[96] = {
+  0x35, 0xc6, 0x87, 0x16, 0x63, 0x3c, 0x66, 0xfb, 0x75, 0x0c, 0x26,
+  0x68, 0x65, 0xd5, 0x3c, 0x11, 0xea, 0x05, 0xb1, 0xe9, 0xfa, 0x49,
+  0xc8, 0x39, 0x8d, 0x48, 0xe1, 0xef, 0xa5, 0x90, 0x9d, 0x39, 0x47,
+  0x90, 0x28, 0x37, 0xf5, 0xae, 0x96, 0xd5, 0xa0, 0x5b, 0xc8, 0xd6,
+  0x1c, 0xa8, 0xdb, 0xef, 0x1b, 0x13, 0xa4, 0xb4, 0xab, 0xfe, 0x4f,
+  0xb1, 0x00, 0x60, 0x45, 0xb6, 0x74, 0xbb, 0x54, 0x72, 0x93, 0x04,
+  0xc3, 0x82, 0xbe, 0x53, 0xa5, 0xaf, 0x05, 0x55, 0x61, 0x76, 0xf6,
+  0xea, 0xa2, 0xef, 0x1d, 0x05, 0xe4, 0xb0, 0x83, 0x18, 0x1e, 0xe6,
+  0x74, 0xcd, 0xa5, 0xa4, 0x85, 0xf7, 0x4d, 0x7a};
+
+static const uint8_t eia2_mac_6[4] = {0xf0, 0x66, 0x8c, 0x1e};
+static const uint8_t eia2_message_6[48] = {
+  0xd3, 0xc5, 0x38, 0x39, 0x62, 0x68, 0x20, 0x71, 0x77, 0x65, 0x66,
+  0x76, 0x20, 0x32, 0x38, 0x37, 0x63, 0x62, 0x40, 0x98, 0x1b, 0xa6,
+  0x82, 0x4c, 0x1b, 0xfb, 0x1a, 0xb4, 0x85, 0x47, 0x20, 0x29, 0xb7,
+  0x1d, 0x80, 0x8c, 0xe3, 0x3e, 0x2c, 0xc3, 0xc0, 0xb5, 0xfc, 0x1f,
+  0x3d, 0xe8, 0xa6, 0xdc};
+
+static const nas_stream_test_set_t eia2_test_sets[] = {
+  {{0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00,
+    0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48},
+   0x38a6f056,
+   0x18,
+   0,
+   58,
+   eia2_message_1,
+   eia2_mac_1},
+  {{0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c,
+    0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1},
+   0x398a59b4,
+   0x1a,
+   1,
+   64,
+   eia2_message_2,
+   eia2_mac_2},
+  {{0x7e, 0x5e, 0x94, 0x43, 0x1e, 0x11, 0xd7, 0x38,
+    0x28, 0xd7, 0x39, 0xcc, 0x6c, 0xed, 0x45, 0x73},
+   0x36af6144,
+   0x18,
+   1,
+   254,
+   eia2_message_3,
+   eia2_mac_3},
+  {{0xd3, 0x41, 0x9b, 0xe8, 0x21, 0x08, 0x7a, 0xcd,
+    0x02, 0x12, 0x3a, 0x92, 0x48, 0x03, 0x33, 0x59},
+   0xc7590ea9,
+   0x17,
+   0,
+   511,
+   eia2_message_4,
+   eia2_mac_4},
+  {{0x83, 0xfd, 0x23, 0xa2, 0x44, 0xa7, 0x4c, 0xf3,
+    0x58, 0xda, 0x30, 0x19, 0xf1, 0x72, 0x26, 0x35},
+   0x36af6144,
+   0x0f,
+   1,
+   768,
+   eia2_message_5,
+   eia2_mac_5},
+  {{0x68, 0x32, 0xa6, 0x5c, 0xff, 0x44, 0x73, 0x62,
+    0x1e, 0xbd, 0xd4, 0xba, 0x26, 0xa9, 0x21, 0xfe},
+   0x36af6144,
+   0x18,
+   0,
+   383,
+   eia2_message_6,
+   eia2_mac_6}};
+
+static void test_set_stream_cipher(
+  const nas_stream_test_set_t *test_set,
+  nas_stream_cipher_t *stream_cipher,
+  uint8_t *msg)
+{
+  stream_cipher->key = (uint8_t *) test_set->key;
+  stream_cipher->key_length = sizeof(test_set->key);
+  stream_cipher->count = test_set->count;
+  stream_cipher->bearer = test_set->bearer;
+  stream_cipher->direction = test_set->direction;
+  stream_cipher->message = msg;
+  stream_cipher->blength = test_set->blength;
+}
+
+START_TEST(eea2_test)
+{
+  for (uint32_t i = 0; i < NB_TEST_SETS(eea2_test_sets); i++) {
+    const nas_stream_test_set_t *test_set = &eea2_test_sets[i];
+    uint32_t length = (test_set->blength + 7) >> 3;
+    nas_stream_cipher_t stream_cipher;
+    nas_stream_key_t stream_key;
+    uint8_t msg[128];
+    uint8_t out[128 + 1];
+
+    memcpy(msg, test_set->message, length);
+    test_set_stream_cipher(test_set, &stream_cipher, msg);
+    memset(out, 0xff, sizeof(out));
+    nas_stream_encrypt_eea2(&stream_cipher, out);
+    ck_assert_int_eq(memcmp(out, test_set->out, length), 0);
+    /* Nothing is written past the end of the message */
+    ck_assert_uint_eq(out[length], 0xff);
+
+    /* Same output with the precomputed key */
+    nas_stream_key_init(&stream_key, test_set->key, sizeof(test_set->key));
+    memset(out, 0, sizeof(out));
+    nas_stream_encrypt_eea2_with_key(&stream_cipher, &stream_key, out);
+    ck_assert_int_eq(memcmp(out, test_set->out, length), 0);
+
+    /* Deciphering is the same operation */
+    memcpy(msg, test_set->out, length);
+    nas_stream_encrypt_eea2(&stream_cipher, out);
+    ck_assert_int_eq(memcmp(out, test_set->message, length), 0);
+  }
+}
+END_TEST
+
+START_TEST(eia2_test)
+{
+  for (uint32_t i = 0; i < NB_TEST_SETS(eia2_test_sets); i++) {
+    const nas_stream_test_set_t *test_set = &eia2_test_sets[i];
+    nas_stream_cipher_t stream_cipher;
+    nas_stream_key_t stream_key;
+    uint8_t msg[128];
+    uint8_t mac[4];
+
+    memcpy(msg, test_set->message, (test_set->blength + 7) >> 3);
+    test_set_stream_cipher(test_set, &stream_cipher, msg);
+    nas_stream_encrypt_eia2(&stream_cipher, mac);
+    ck_assert_int_eq(memcmp(mac, test_set->out, sizeof(mac)), 0);
+
+    nas_stream_key_init(&stream_key, test_set->key, sizeof(test_set->key));
+    memset(mac, 0, sizeof(mac));
+    nas_stream_encrypt_eia2_with_key(&stream_cipher, &stream_key, mac);
+    ck_assert_int_eq(memcmp(mac, test_set->out, sizeof(mac)), 0);
+  }
+}
+END_TEST
+
+START_TEST(eia2_bit_length_test)
+{
+  const nas_stream_test_set_t *test_set = &eia2_test_sets[0];
+  nas_stream_cipher_t stream_cipher;
+  uint8_t msg[8];
+  uint8_t mac[4];
+
+  /* 58 bits: only the 2 high bits of the last byte are part of the MAC */
+  memcpy(msg, test_set->message, sizeof(msg));
+  test_set_stream_cipher(test_set, &stream_cipher, msg);
+  msg[7] ^= 0x3f;
+  nas_stream_encrypt_eia2(&stream_cipher, mac);
+  ck_assert_int_eq(memcmp(mac, test_set->out, sizeof(mac)), 0);
+
+  /* The same bytes taken as a whole bytes message have another MAC */
+  msg[7] = test_set->message[7];
+  stream_cipher.blength = 64;
+  nas_stream_encrypt_eia2(&stream_cipher, mac);
+  ck_assert_int_ne(memcmp(mac, test_set->out, sizeof(mac)), 0);
+
+  msg[7] ^= 0x40;
+  stream_cipher.blength = 58;
+  nas_stream_encrypt_eia2(&stream_cipher, mac);
+  ck_assert_int_ne(memcmp(mac, test_set->out, sizeof(mac)), 0);
+}
+END_TEST
+
+Suite *eea2_eia2_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("128-EEA2 and 128-EIA2 tests");
+
+  /* Core test case */
+  tc_core = tcase_create("TS 33.401 test sets");
+  tcase_add_test(tc_core, eea2_test);
+  tcase_add_test(tc_core, eia2_test);
+  tcase_add_test(tc_core, eia2_bit_length_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = eea2_eia2_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
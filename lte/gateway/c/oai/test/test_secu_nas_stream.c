@@ -0,0 +1,301 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "secu_defs.h"
+
+/*
+ * Test data from 3GPP TS 33.401 Annex C (128-EEA2 test set 1 and 128-EIA2
+ * test sets 1 to 4), the random batches are checked against the one message
+ * at a time functions.
+ */
+
+#define NB_JOBS 37
+#define MAX_LENGTH 300
+
+static const uint8_t eea2_key[16] = {0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f,
+                                     0xb1, 0x1c, 0x40, 0x35, 0xc6, 0x68,
+                                     0x0a, 0xf8, 0xc6, 0xd1};
+static const uint8_t eea2_plaintext[32] = {
+  0x98, 0x1b, 0xa6, 0x82, 0x4c, 0x1b, 0xfb, 0x1a, 0xb4, 0x85, 0x47,
+  0x20, 0x29, 0xb7, 0x1d, 0x80, 0x8c, 0xe3, 0x3e, 0x2c, 0xc3, 0xc0,
+  0xb5, 0xfc, 0x1f, 0x3d, 0xe8, 0xa6, 0xdc, 0x66, 0xb1, 0xf0};
+static const uint8_t eea2_ciphertext[32] = {
+  0xe9, 0xfe, 0xd8, 0xa6, 0x3d, 0x15, 0x53, 0x04, 0xd7, 0x1d, 0xf2,
+  0x0b, 0xf3, 0xe8, 0x22, 0x14, 0xb2, 0x0e, 0xd7, 0xda, 0xd2, 0xf2,
+  0x33, 0xdc, 0x3c, 0x22, 0xd7, 0xbd, 0xee, 0xed, 0x8e, 0x78};
+
+typedef struct {
+  uint8_t key[16];
+  uint32_t count;
+  uint8_t bearer;
+  uint8_t direction;
+  uint32_t blength;
+  const uint8_t *message;
+  const uint8_t *mac;
+} eia2_test_set_t;
+
+static const uint8_t eia2_mac_1[4] = {0x11, 0x8c, 0x6e, 0xb8};
+static const uint8_t eia2_message_1[8] = {
+  0x33, 0x32, 0x34, 0x62, 0x63, 0x39, 0x38, 0x40};
+
+static const uint8_t eia2_mac_2[4] = {0xb9, 0x37, 0x87, 0xe6};
+static const uint8_t eia2_message_2[8] = {
+  0x48, 0x45, 0x83, 0xd5, 0xaf, 0xe0, 0x82, 0xae};
+
+static const uint8_t eia2_mac_3[4] = {0x1f, 0x60, 0xb0, 0x1d};
+static const uint8_t eia2_message_3[32] = {
+  0xb3, 0xd3, 0xc9, 0x17, 0x0a, 0x4e, 0x16, 0x32, 0xf6, 0x0f, 0x86,
+  0x10, 0x13, 0xd2, 0x2d, 0x84, 0xb7, 0x26, 0xb6, 0xa2, 0x78, 0xd8,
+  0x02, 0xd1, 0xee, 0xaf, 0x13, 0x21, 0xba, 0x59, 0x29, 0xdc};
+
+static const uint8_t eia2_mac_4[4] = {0x68, 0x46, 0xa2, 0xf0};
+static const uint8_t eia2_message_4[64] = {
+  0xbb, 0xb0, 0x57, 0x03, 0x88, 0x09, 0x49, 0x6b, 0xcf, 0xf8, 0x6d,
+  0x6f, 0xbc, 0x8c, 0xe5, 0xb1, 0x35, 0xa0, 0x6b, 0x16, 0x60, 0x54,
+  0xf2, 0xd5, 0x65, 0xbe, 0x8a, 0xce, 0x75, 0xdc, 0x85, 0x1e, 0x0b,
+  0xcd, 0xd8, 0xf0, 0x71, 0x41, 0xc4, 0x95, 0x87, 0x2f, 0xb5, 0xd8,
+  0xc0, 0xc6, 0x6a, 0x8b, 0x6d, 0xa5, 0x56, 0x66, 0x3e, 0x4e, 0x46,
+  0x12, 0x05, 0xd8, 0x45, 0x80, 0xbe, 0xe5, 0xbc, 0x7e};
+
+static const eia2_test_set_t eia2_test_sets[] = {
+  {{0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00,
+    0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48},
+   0x38a6f056,
+   0x18,
+   0,
+   58,
+   eia2_message_1,
+   eia2_mac_1},
+  {{0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c,
+    0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1},
+   0x398a59b4,
+   0x1a,
+   1,
+   64,
+   eia2_message_2,
+   eia2_mac_2},
+  {{0x7e, 0x5e, 0x94, 0x43, 0x1e, 0x11, 0xd7, 0x38,
+    0x28, 0xd7, 0x39, 0xcc, 0x6c, 0xed, 0x45, 0x73},
+   0x36af6144,
+   0x18,
+   1,
+   254,
+   eia2_message_3,
+   eia2_mac_3},
+  {{0xd3, 0x41, 0x9b, 0xe8, 0x21, 0x08, 0x7a, 0xcd,
+    0x02, 0x12, 0x3a, 0x92, 0x48, 0x03, 0x33, 0x59},
+   0xc7590ea9,
+   0x17,
+   0,
+   511,
+   eia2_message_4,
+   eia2_mac_4}};
+
+#define NB_EIA2_TEST_SETS (sizeof(eia2_test_sets) / sizeof(eia2_test_sets[0]))
+
+typedef struct {
+  nas_stream_job_t jobs[NB_JOBS];
+  nas_stream_key_t keys[NB_JOBS];
+  uint8_t key_bytes[NB_JOBS][16];
+  uint8_t msgs[NB_JOBS][MAX_LENGTH];
+  uint8_t outs[NB_JOBS][MAX_LENGTH];
+  uint8_t expected[NB_JOBS][MAX_LENGTH];
+} jobs_fixture_t;
+
+/* Jobs of random lengths, half of them without a precomputed key */
+static void jobs_fixture_init(jobs_fixture_t *f)
+{
+  memset(f, 0, sizeof(*f));
+  for (int i = 0; i < NB_JOBS; i++) {
+    nas_stream_cipher_t *sc = &f->jobs[i].stream_cipher;
+
+    for (int j = 0; j < 16; j++) f->key_bytes[i][j] = rand();
+    for (int j = 0; j < MAX_LENGTH; j++) f->msgs[i][j] = rand();
+    nas_stream_key_init(&f->keys[i], f->key_bytes[i], 16);
+    sc->key = f->key_bytes[i];
+    sc->key_length = 16;
+    sc->count = rand();
+    sc->bearer = rand() & 0x1f;
+    sc->direction = rand() & 0x01;
+    sc->message = f->msgs[i];
+    sc->blength = rand() % (MAX_LENGTH << 3);
+    f->jobs[i].stream_key = (i & 1) ? &f->keys[i] : NULL;
+    f->jobs[i].out = f->outs[i];
+  }
+}
+
+static void eea2_stream_cipher(nas_stream_cipher_t *stream_cipher, uint8_t *msg)
+{
+  stream_cipher->key = (uint8_t *) eea2_key;
+  stream_cipher->key_length = sizeof(eea2_key);
+  stream_cipher->count = 0x398a59b4;
+  stream_cipher->bearer = 0x15;
+  stream_cipher->direction = 1;
+  stream_cipher->message = msg;
+  stream_cipher->blength = 253;
+}
+
+static void check_engines(void (*check)(void))
+{
+  nas_stream_engine_t engine = nas_stream_get_engine();
+
+  ck_assert_int_eq(nas_stream_set_engine(NAS_STREAM_ENGINE_SCALAR), 0);
+  check();
+  if (nas_stream_set_engine(NAS_STREAM_ENGINE_AESNI) == 0) check();
+  nas_stream_set_engine(engine);
+}
+
+static void eea2_vector_check(void)
+{
+  nas_stream_job_t job = {0};
+  uint8_t msg[sizeof(eea2_plaintext)];
+  uint8_t out[sizeof(eea2_plaintext) + 4];
+
+  memcpy(msg, eea2_plaintext, sizeof(msg));
+  memset(out, 0xff, sizeof(out));
+  eea2_stream_cipher(&job.stream_cipher, msg);
+  job.out = out;
+  nas_stream_encrypt_eea2_jobs(&job, 1);
+  ck_assert_int_eq(memcmp(out, eea2_ciphertext, sizeof(eea2_ciphertext)), 0);
+  /* Nothing is written past the end of the message */
+  ck_assert_uint_eq(out[sizeof(eea2_ciphertext)], 0xff);
+}
+
+/*
+ * The test sets in one batch, so that they run side by side on the AES-NI
+ * lanes, half of them with a precomputed key
+ */
+static void eia2_vector_check(void)
+{
+  nas_stream_job_t jobs[NB_EIA2_TEST_SETS] = {{{0}}};
+  nas_stream_key_t keys[NB_EIA2_TEST_SETS];
+  uint8_t msgs[NB_EIA2_TEST_SETS][64];
+  uint8_t macs[NB_EIA2_TEST_SETS][4];
+
+  for (uint32_t i = 0; i < NB_EIA2_TEST_SETS; i++) {
+    const eia2_test_set_t *test_set = &eia2_test_sets[i];
+    nas_stream_cipher_t *sc = &jobs[i].stream_cipher;
+
+    memcpy(msgs[i], test_set->message, (test_set->blength + 7) >> 3);
+    sc->key = (uint8_t *) test_set->key;
+    sc->key_length = sizeof(test_set->key);
+    sc->count = test_set->count;
+    sc->bearer = test_set->bearer;
+    sc->direction = test_set->direction;
+    sc->message = msgs[i];
+    sc->blength = test_set->blength;
+    nas_stream_key_init(&keys[i], test_set->key, sizeof(test_set->key));
+    jobs[i].stream_key = (i & 1) ? &keys[i] : NULL;
+    jobs[i].out = macs[i];
+  }
+  memset(macs, 0, sizeof(macs));
+  nas_stream_encrypt_eia2_jobs(jobs, NB_EIA2_TEST_SETS);
+  for (uint32_t i = 0; i < NB_EIA2_TEST_SETS; i++) {
+    ck_assert_int_eq(memcmp(macs[i], eia2_test_sets[i].mac, 4), 0);
+  }
+
+  /* And each one alone */
+  for (uint32_t i = 0; i < NB_EIA2_TEST_SETS; i++) {
+    memset(macs[i], 0, 4);
+    nas_stream_encrypt_eia2_jobs(&jobs[i], 1);
+    ck_assert_int_eq(memcmp(macs[i], eia2_test_sets[i].mac, 4), 0);
+  }
+}
+
+static void eea2_batch_check(void)
+{
+  jobs_fixture_t *f = malloc(sizeof(jobs_fixture_t));
+
+  jobs_fixture_init(f);
+  for (int i = 0; i < NB_JOBS; i++) {
+    nas_stream_encrypt_eea2(&f->jobs[i].stream_cipher, f->expected[i]);
+  }
+  nas_stream_encrypt_eea2_jobs(f->jobs, NB_JOBS);
+  for (int i = 0; i < NB_JOBS; i++) {
+    ck_assert_int_eq(memcmp(f->outs[i], f->expected[i], MAX_LENGTH), 0);
+  }
+  free(f);
+}
+
+static void eia2_batch_check(void)
+{
+  jobs_fixture_t *f = malloc(sizeof(jobs_fixture_t));
+
+  jobs_fixture_init(f);
+  for (int i = 0; i < NB_JOBS; i++) {
+    nas_stream_encrypt_eia2(&f->jobs[i].stream_cipher, f->expected[i]);
+  }
+  nas_stream_encrypt_eia2_jobs(f->jobs, NB_JOBS);
+  for (int i = 0; i < NB_JOBS; i++) {
+    ck_assert_int_eq(memcmp(f->outs[i], f->expected[i], 4), 0);
+  }
+  free(f);
+}
+
+START_TEST(eea2_jobs_test)
+{
+  check_engines(eea2_vector_check);
+  check_engines(eea2_batch_check);
+}
+END_TEST
+
+START_TEST(eia2_jobs_test)
+{
+  check_engines(eia2_vector_check);
+  check_engines(eia2_batch_check);
+}
+END_TEST
+
+Suite *nas_stream_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("NAS stream batch tests");
+
+  /* Core test case */
+  tc_core = tcase_create("NAS stream batch test");
+  tcase_add_test(tc_core, eea2_jobs_test);
+  tcase_add_test(tc_core, eia2_jobs_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = nas_stream_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
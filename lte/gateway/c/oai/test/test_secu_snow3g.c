@@ -0,0 +1,225 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "secu_defs.h"
+#include "snow3g.h"
+
+/*
+ * Test data from the Specification of the 3GPP Confidentiality and Integrity
+ * Algorithms UEA2 & UIA2, Document 4: Design Conformance Test Data (SNOW 3G
+ * test sets) and 3GPP TS 33.401 Annex C (128-EEA1 and 128-EIA1 test sets 1).
+ */
+
+typedef struct {
+  uint32_t k[4];
+  uint32_t iv[4];
+  uint32_t z1;
+  uint32_t z2;
+} snow3g_test_set_t;
+
+static const snow3g_test_set_t snow3g_test_sets[] = {
+  {{0x2BD6459F, 0x82C5B300, 0x952C4910, 0x4881FF48},
+   {0xEA024714, 0xAD5C4D84, 0xDF1F9B25, 0x1C0BF45F},
+   0xABEE9704,
+   0x7AC31373},
+  {{0x8CE33E2C, 0xC3C0B5FC, 0x1F3DE8A6, 0xDC66B1F3},
+   {0xD3C5D592, 0x327FB11C, 0xDE551988, 0xCEB2F9B7},
+   0xEFF8A342,
+   0xF751480F},
+  {{0x4035C668, 0x0AF8C6D1, 0xA8FF8667, 0xB1714013},
+   {0x62A54098, 0x1BA6F9B7, 0x4592B0E7, 0x8690F71B},
+   0xA8C874A9,
+   0x7AE7C4F8},
+  {{0x0DED7263, 0x109CF92E, 0x3352255A, 0x140E0F76},
+   {0x6B68079A, 0x41A7C4C9, 0x1BEFD79F, 0x7FDCC233},
+   0xD712C05C,
+   0xA937C2A6},
+};
+
+static const uint8_t eea1_key[16] = {0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f,
+                                     0xb1, 0x1c, 0x40, 0x35, 0xc6, 0x68,
+                                     0x0a, 0xf8, 0xc6, 0xd1};
+static const uint8_t eea1_plaintext[32] = {
+  0x98, 0x1b, 0xa6, 0x82, 0x4c, 0x1b, 0xfb, 0x1a, 0xb4, 0x85, 0x47,
+  0x20, 0x29, 0xb7, 0x1d, 0x80, 0x8c, 0xe3, 0x3e, 0x2c, 0xc3, 0xc0,
+  0xb5, 0xfc, 0x1f, 0x3d, 0xe8, 0xa6, 0xdc, 0x66, 0xb1, 0xf0};
+static const uint8_t eea1_ciphertext[32] = {
+  0x5d, 0x5b, 0xfe, 0x75, 0xeb, 0x04, 0xf6, 0x8c, 0xe0, 0xa1, 0x23,
+  0x77, 0xea, 0x00, 0xb3, 0x7d, 0x47, 0xc6, 0xa0, 0xba, 0x06, 0x30,
+  0x91, 0x55, 0x08, 0x6a, 0x85, 0x9c, 0x43, 0x41, 0xb3, 0x78};
+
+static void eea1_stream_cipher(nas_stream_cipher_t *stream_cipher, uint8_t *msg)
+{
+  stream_cipher->key = (uint8_t *) eea1_key;
+  stream_cipher->key_length = sizeof(eea1_key);
+  stream_cipher->count = 0x398a59b4;
+  stream_cipher->bearer = 0x15;
+  stream_cipher->direction = 1;
+  stream_cipher->message = msg;
+  stream_cipher->blength = 253;
+}
+
+static const uint8_t eia1_key[16] = {0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5,
+                                     0xb3, 0x00, 0x95, 0x2c, 0x49, 0x10,
+                                     0x48, 0x81, 0xff, 0x48};
+static const uint8_t eia1_message[11] = {0x33, 0x32, 0x34, 0x62, 0x63, 0x39,
+                                         0x38, 0x61, 0x37, 0x34, 0x79};
+static const uint8_t eia1_mac[4] = {0x73, 0x1f, 0x11, 0x65};
+
+static void eia1_stream_cipher(nas_stream_cipher_t *stream_cipher, uint8_t *msg)
+{
+  stream_cipher->key = (uint8_t *) eia1_key;
+  stream_cipher->key_length = sizeof(eia1_key);
+  stream_cipher->count = 0x38a6f056;
+  stream_cipher->bearer = 0x1f;
+  stream_cipher->direction = 0;
+  stream_cipher->message = msg;
+  stream_cipher->blength = 88;
+}
+
+START_TEST(snow3g_key_stream_test)
+{
+  for (int i = 0; i < sizeof(snow3g_test_sets) / sizeof(snow3g_test_sets[0]);
+       i++) {
+    snow_3g_context_t ctx;
+    uint32_t k[4], iv[4], z[2];
+
+    memcpy(k, snow3g_test_sets[i].k, sizeof(k));
+    memcpy(iv, snow3g_test_sets[i].iv, sizeof(iv));
+    snow3g_initialize(k, iv, &ctx);
+    snow3g_generate_key_stream(2, z, &ctx);
+    ck_assert_uint_eq(z[0], snow3g_test_sets[i].z1);
+    ck_assert_uint_eq(z[1], snow3g_test_sets[i].z2);
+  }
+}
+END_TEST
+
+START_TEST(snow3g_long_key_stream_test)
+{
+  /* Test set 4 also gives z2500 */
+  snow_3g_context_t ctx;
+  uint32_t k[4], iv[4];
+  uint32_t *z = calloc(2500, sizeof(uint32_t));
+
+  memcpy(k, snow3g_test_sets[3].k, sizeof(k));
+  memcpy(iv, snow3g_test_sets[3].iv, sizeof(iv));
+  snow3g_initialize(k, iv, &ctx);
+  snow3g_generate_key_stream(2500, z, &ctx);
+  ck_assert_uint_eq(z[2499], 0x9C0DB3AA);
+
+  /* The word at a time path gives the same keystream */
+  snow3g_initialize(k, iv, &ctx);
+  snow3g_start_key_stream(&ctx);
+  for (int i = 0; i < 2500; i++) {
+    ck_assert_uint_eq(snow3g_next_key_word(&ctx), z[i]);
+  }
+  free(z);
+}
+END_TEST
+
+START_TEST(eea1_test)
+{
+  nas_stream_cipher_t stream_cipher;
+  uint8_t msg[sizeof(eea1_plaintext)];
+  uint8_t out[sizeof(eea1_plaintext) + 4];
+
+  memcpy(msg, eea1_plaintext, sizeof(msg));
+  memset(out, 0xff, sizeof(out));
+  eea1_stream_cipher(&stream_cipher, msg);
+  nas_stream_encrypt_eea1(&stream_cipher, out);
+  ck_assert_int_eq(memcmp(out, eea1_ciphertext, sizeof(eea1_ciphertext)), 0);
+  /* The message is left untouched and nothing is written past its end */
+  ck_assert_int_eq(memcmp(msg, eea1_plaintext, sizeof(msg)), 0);
+  ck_assert_uint_eq(out[sizeof(eea1_ciphertext)], 0xff);
+
+  /* Deciphering is the same operation */
+  memcpy(msg, eea1_ciphertext, sizeof(msg));
+  nas_stream_encrypt_eea1(&stream_cipher, out);
+  ck_assert_int_eq(memcmp(out, eea1_plaintext, sizeof(eea1_plaintext)), 0);
+}
+END_TEST
+
+START_TEST(eia1_test)
+{
+  nas_stream_cipher_t stream_cipher;
+  uint8_t msg[sizeof(eia1_message)];
+  uint8_t mac[4];
+  uint8_t short_mac[4];
+
+  memcpy(msg, eia1_message, sizeof(msg));
+  eia1_stream_cipher(&stream_cipher, msg);
+  nas_stream_encrypt_eia1(&stream_cipher, mac);
+  ck_assert_int_eq(memcmp(mac, eia1_mac, sizeof(mac)), 0);
+
+  /* The bits past the length of the message are not part of the MAC */
+  stream_cipher.blength = 85;
+  nas_stream_encrypt_eia1(&stream_cipher, short_mac);
+  ck_assert_int_ne(memcmp(short_mac, eia1_mac, sizeof(mac)), 0);
+  msg[sizeof(msg) - 1] ^= 0x07;
+  nas_stream_encrypt_eia1(&stream_cipher, mac);
+  ck_assert_int_eq(memcmp(mac, short_mac, sizeof(mac)), 0);
+  msg[sizeof(msg) - 1] ^= 0x07;
+  stream_cipher.blength = 88;
+
+  /* Any change of the message changes the MAC */
+  msg[7] ^= 0x01;
+  nas_stream_encrypt_eia1(&stream_cipher, mac);
+  ck_assert_int_ne(memcmp(mac, eia1_mac, sizeof(mac)), 0);
+}
+END_TEST
+
+Suite *snow3g_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("SNOW 3G tests");
+
+  /* Core test case */
+  tc_core = tcase_create("SNOW 3G conformance test");
+  tcase_add_test(tc_core, snow3g_key_stream_test);
+  tcase_add_test(tc_core, snow3g_long_key_stream_test);
+  tcase_add_test(tc_core, eea1_test);
+  tcase_add_test(tc_core, eia1_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = snow3g_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
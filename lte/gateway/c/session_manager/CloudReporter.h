@@ -43,10 +43,13 @@ public:
   SessionCloudReporter(folly::EventBase* base,
                        std::shared_ptr<grpc::Channel> channel);
 
+  virtual ~SessionCloudReporter() = default;
+
   /**
-   * Proxy an UpdateSessionRequest gRPC call to the cloud
+   * Proxy an UpdateSessionRequest gRPC call to the cloud. Virtual so that
+   * the scheduling of the reports can be tested without a cloud
    */
-  void report_updates(
+  virtual void report_updates(
     const UpdateSessionRequest& request,
     std::function<void(grpc::Status, UpdateSessionResponse)> callback);
 
@@ -6,6 +6,7 @@
  * LICENSE file in the root directory of this source tree. An additional grant
  * of patent rights can be found in the PATENTS file in the same directory.
  */
+#include <algorithm>
 #include <limits>
 #include "CreditPool.h"
 
@@ -16,6 +17,26 @@ namespace magma {
 ChargingCreditPool::ChargingCreditPool(const std::string& imsi)
   : imsi_(imsi) {}
 
+ChargingCreditPool ChargingCreditPool::unmarshal(
+    const std::string& imsi,
+    const StoredChargingCreditPool& marshaled) {
+  ChargingCreditPool pool(imsi);
+  for (const auto& credit_pair : marshaled.credits()) {
+    pool.credit_map_[credit_pair.first] = std::make_unique<SessionCredit>(
+      SessionCredit::unmarshal(credit_pair.second));
+  }
+  return pool;
+}
+
+StoredChargingCreditPool ChargingCreditPool::marshal() const {
+  StoredChargingCreditPool marshaled;
+  auto& credits = *marshaled.mutable_credits();
+  for (const auto& credit_pair : credit_map_) {
+    credits[credit_pair.first] = credit_pair.second->marshal();
+  }
+  return marshaled;
+}
+
 bool ChargingCreditPool::add_used_credit(
     const uint32_t& key,
     uint64_t used_tx,
@@ -214,9 +235,50 @@ ChargingReAuthAnswer::Result ChargingCreditPool::reauth_all() {
   return res;
 }
 
+std::time_t ChargingCreditPool::get_next_expiry_time() {
+  auto next_expiry_time = std::numeric_limits<std::time_t>::max();
+  for (auto& credit_pair : credit_map_) {
+    next_expiry_time = std::min(
+      next_expiry_time, credit_pair.second->get_expiry_time());
+  }
+  return next_expiry_time;
+}
+
 UsageMonitoringCreditPool::UsageMonitoringCreditPool(const std::string& imsi)
   : imsi_(imsi), session_level_key_(nullptr) {}
 
+UsageMonitoringCreditPool UsageMonitoringCreditPool::unmarshal(
+    const std::string& imsi,
+    const StoredUsageMonitoringCreditPool& marshaled) {
+  UsageMonitoringCreditPool pool(imsi);
+  for (const auto& monitor_pair : marshaled.monitors()) {
+    auto monitor = std::make_unique<UsageMonitoringCreditPool::Monitor>();
+    monitor->credit = SessionCredit::unmarshal(monitor_pair.second.credit());
+    monitor->level = monitor_pair.second.level();
+    pool.monitor_map_[monitor_pair.first] = std::move(monitor);
+  }
+  if (!marshaled.session_level_key().empty()) {
+    pool.session_level_key_ =
+      std::make_unique<std::string>(marshaled.session_level_key());
+  }
+  return pool;
+}
+
+StoredUsageMonitoringCreditPool UsageMonitoringCreditPool::marshal() const {
+  StoredUsageMonitoringCreditPool marshaled;
+  auto& monitors = *marshaled.mutable_monitors();
+  for (const auto& monitor_pair : monitor_map_) {
+    StoredMonitor monitor;
+    *monitor.mutable_credit() = monitor_pair.second->credit.marshal();
+    monitor.set_level(monitor_pair.second->level);
+    monitors[monitor_pair.first] = monitor;
+  }
+  if (session_level_key_ != nullptr) {
+    marshaled.set_session_level_key(*session_level_key_);
+  }
+  return marshaled;
+}
+
 bool UsageMonitoringCreditPool::add_used_credit(
     const std::string& key,
     uint64_t used_tx,
@@ -283,6 +345,7 @@ bool UsageMonitoringCreditPool::get_termination_updates(
         credit_pair.first,
         credit_pair.second->level));
   }
+  return true;
 }
 
 void UsageMonitoringCreditPool::update_session_level_key(
@@ -80,6 +80,12 @@ class ChargingCreditPool
 public:
   ChargingCreditPool(const std::string& imsi);
 
+  static ChargingCreditPool unmarshal(
+    const std::string& imsi,
+    const StoredChargingCreditPool& marshaled);
+
+  StoredChargingCreditPool marshal() const;
+
   bool add_used_credit(
     const uint32_t& key,
     uint64_t used_tx,
@@ -102,6 +108,12 @@ public:
 
   ChargingReAuthAnswer::Result reauth_all();
 
+  /**
+   * get_next_expiry_time returns the earliest validity timer expiry of the
+   * credits in the pool, or the max time_t if none of them expires
+   */
+  std::time_t get_next_expiry_time();
+
 private:
   std::unordered_map<uint32_t, std::unique_ptr<SessionCredit>> credit_map_;
   std::string imsi_;
@@ -121,6 +133,12 @@ class UsageMonitoringCreditPool
 public:
   UsageMonitoringCreditPool(const std::string& imsi);
 
+  static UsageMonitoringCreditPool unmarshal(
+    const std::string& imsi,
+    const StoredUsageMonitoringCreditPool& marshaled);
+
+  StoredUsageMonitoringCreditPool marshal() const;
+
   bool add_used_credit(
     const std::string& key,
     uint64_t used_tx,
@@ -7,6 +7,7 @@
  * of patent rights can be found in the PATENTS file in the same directory.
  */
 
+#include <limits>
 #include <string>
 #include <vector>
 #include <time.h>
@@ -18,19 +19,6 @@
 #include "LocalEnforcer.h"
 #include "magma_logging.h"
 
-namespace {
-
-std::chrono::milliseconds time_difference_from_now(
-    const google::protobuf::Timestamp &timestamp) {
-  auto rule_time_sec = google::protobuf::util::TimeUtil::TimestampToSeconds(
-    timestamp);
-  auto now = time(NULL);
-  auto delta = std::max(rule_time_sec - now, 0L);
-  std::chrono::seconds sec(delta);
-  return std::chrono::duration_cast<std::chrono::milliseconds>(sec);
-}
-}
-
 namespace magma {
 
 using google::protobuf::RepeatedPtrField;
@@ -49,20 +37,106 @@ static void mark_rule_failures(
 LocalEnforcer::LocalEnforcer(
   std::shared_ptr<StaticRuleStore> rule_store,
   std::shared_ptr<PipelinedClient> pipelined_client)
-  : rule_store_(rule_store), pipelined_client_(pipelined_client) {}
+  : rule_store_(rule_store),
+    pipelined_client_(pipelined_client),
+    updates_due_(false) {}
 
 LocalEnforcer::LocalEnforcer()
   : LocalEnforcer(
       std::make_shared<StaticRuleStore>(),
       std::make_shared<AsyncPipelinedClient>()) {}
 
-void LocalEnforcer::new_report() {
-  for (auto& session_pair : session_map_) {
-    session_pair.second->new_report();
+void LocalEnforcer::mark_dirty(const std::string& imsi) {
+  dirty_sessions_.insert(imsi);
+}
+
+void LocalEnforcer::track_validity_timer(
+    const std::string& imsi,
+    SessionState& session) {
+  auto expiry_time = session.get_next_expiry_time();
+  if (expiry_time == std::numeric_limits<std::time_t>::max()) {
+    return;
+  }
+  timers_.add(expiry_time, [this, imsi] {
+    mark_dirty(imsi);
+    updates_due_ = true;
+  });
+}
+
+void LocalEnforcer::set_on_updates_due(std::function<void()> on_updates_due) {
+  on_updates_due_ = on_updates_due;
+}
+
+void LocalEnforcer::process_due_timers(std::time_t now) {
+  timers_.advance(now);
+  if (updates_due_) {
+    updates_due_ = false;
+    if (on_updates_due_) {
+      on_updates_due_();
+    }
+  }
+}
+
+void LocalEnforcer::schedule_timer_tick() {
+  evb_->timer().scheduleTimeoutFn(
+    [this] {
+      process_due_timers(time(NULL));
+      schedule_timer_tick();
+    },
+    std::chrono::seconds(1));
+}
+
+void LocalEnforcer::mark_unsaved(const std::string& imsi) {
+  if (session_store_ != nullptr) {
+    unsaved_sessions_.insert(imsi);
+  }
+}
+
+void LocalEnforcer::attachSessionStore(
+    std::shared_ptr<SessionStore> session_store,
+    std::chrono::milliseconds save_interval) {
+  session_store_ = session_store;
+  save_interval_ = save_interval;
+}
+
+void LocalEnforcer::restore_sessions(
+    const std::vector<StoredSessionState>& sessions) {
+  for (const auto& stored : sessions) {
+    auto imsi = stored.imsi();
+    auto session = SessionState::unmarshal(stored, *rule_store_);
+    track_validity_timer(imsi, *session);
+    session_map_[imsi] = std::move(session);
+    mark_dirty(imsi);
+  }
+  MLOG(MINFO) << "Restored " << sessions.size() << " sessions";
+}
+
+void LocalEnforcer::save_sessions() {
+  for (const auto& imsi : unsaved_sessions_) {
+    auto it = session_map_.find(imsi);
+    if (it == session_map_.end() || !it->second->is_active()) {
+      session_store_->remove_session(imsi);
+    } else {
+      session_store_->write_session(it->second->marshal());
+    }
   }
+  unsaved_sessions_.clear();
+}
+
+void LocalEnforcer::schedule_session_save() {
+  evb_->timer().scheduleTimeoutFn(
+    [this] {
+      save_sessions();
+      schedule_session_save();
+    },
+    save_interval_);
 }
 
 void LocalEnforcer::start() {
+  if (session_store_ != nullptr) {
+    evb_->runInEventBaseThread([this] { schedule_session_save(); });
+  }
+  evb_->runInEventBaseThread([this] { schedule_timer_tick(); });
   evb_->loopForever();
 }
 
@@ -79,26 +153,31 @@ folly::EventBase& LocalEnforcer::get_event_base() {
 }
 
 void LocalEnforcer::aggregate_records(const RuleRecordTable& records) {
-  new_report(); // unmark all credits
   for (const RuleRecord& record : records.records()) {
-    auto it = session_map_.find(record.sid());
-    if (it == session_map_.end()) {
-      MLOG(MERROR) << "Could not find session for IMSI " << record.sid()
-        << " during record aggregation";
-      continue;
-    }
-    if (record.bytes_tx() > 0 || record.bytes_rx() > 0) {
-      MLOG(MDEBUG) << "Subscriber " << record.sid() << " used "
-        << record.bytes_tx() << " tx bytes and " << record.bytes_rx()
-        << " rx bytes for rule " << record.rule_id();
-    }
-    it->second->add_used_credit(
-      record.rule_id(),
-      record.bytes_tx(),
-      record.bytes_rx());
+    aggregate_record(record);
   }
 }
 
+void LocalEnforcer::aggregate_record(const RuleRecord& record) {
+  auto it = session_map_.find(record.sid());
+  if (it == session_map_.end()) {
+    MLOG(MERROR) << "Could not find session for IMSI " << record.sid()
+      << " during record aggregation";
+    return;
+  }
+  if (record.bytes_tx() > 0 || record.bytes_rx() > 0) {
+    MLOG(MDEBUG) << "Subscriber " << record.sid() << " used "
+      << record.bytes_tx() << " tx bytes and " << record.bytes_rx()
+      << " rx bytes for rule " << record.rule_id();
+  }
+  it->second->add_used_credit(
+    record.rule_id(),
+    record.bytes_tx(),
+    record.bytes_rx());
+  mark_dirty(record.sid());
+  mark_unsaved(record.sid());
+}
+
 static void execute_actions(
     PipelinedClient& pipelined_client,
     const std::vector<std::unique_ptr<ServiceAction>>& actions) {
@@ -121,8 +200,26 @@ static void execute_actions(
 UpdateSessionRequest LocalEnforcer::collect_updates() {
   UpdateSessionRequest request;
   std::vector<std::unique_ptr<ServiceAction>> actions;
-  for (auto& session_pair : session_map_) {
-    session_pair.second->get_updates(&request, &actions);
+  std::unordered_set<std::string> dirty_sessions;
+  dirty_sessions.swap(dirty_sessions_);
+  for (const auto& imsi : dirty_sessions) {
+    auto it = session_map_.find(imsi);
+    if (it == session_map_.end()) {
+      continue;
+    }
+    auto actions_size = actions.size();
+    auto updates_size = request.updates_size() + request.usage_monitors_size();
+    it->second->get_updates(&request, &actions);
+    if (actions.size() > actions_size) {
+      // A credit that returns an action is only checked for an update at the
+      // next collection
+      mark_dirty(imsi);
+      mark_unsaved(imsi);
+    } else if (
+        request.updates_size() + request.usage_monitors_size()
+          > updates_size) {
+      mark_unsaved(imsi);
+    }
   }
   execute_actions(*pipelined_client_, actions);
   return request;
@@ -138,6 +235,8 @@ void LocalEnforcer::reset_updates(const UpdateSessionRequest& failed_request) {
     }
     it->second->get_charging_pool().reset_reporting_credit(
       update.usage().charging_key());
+    mark_dirty(update.sid());
+    mark_unsaved(update.sid());
   }
   for (const auto& update : failed_request.usage_monitors()) {
     auto it = session_map_.find(update.sid());
@@ -148,6 +247,8 @@ void LocalEnforcer::reset_updates(const UpdateSessionRequest& failed_request) {
     }
     it->second->get_monitor_pool().reset_reporting_credit(
       update.update().monitoring_key());
+    mark_dirty(update.sid());
+    mark_unsaved(update.sid());
   }
 }
 
@@ -176,15 +277,13 @@ void LocalEnforcer::schedule_static_rule_activation(
   std::vector<std::string> static_rules {static_rule.rule_id()};
   std::vector<PolicyRule> dynamic_rules;
 
-  auto delta = time_difference_from_now(static_rule.activation_time());
+  auto activation_time = TimeUtil::TimestampToSeconds(
+    static_rule.activation_time());
   MLOG(MDEBUG) << "Scheduling subscriber " << imsi << " static rule "
-    << static_rule.rule_id() << " activation in "
-    << (delta.count() / 1000) << " secs";
-  evb_->runInEventBaseThread([=]{
-    evb_->timer().scheduleTimeoutFn(
-      std::move([=] { pipelined_client_->activate_flows_for_rules(
-          imsi, ip_addr, static_rules, dynamic_rules); }),
-      delta);
+    << static_rule.rule_id() << " activation at " << activation_time;
+  timers_.add(activation_time, [=] {
+    pipelined_client_->activate_flows_for_rules(
+      imsi, ip_addr, static_rules, dynamic_rules);
   });
 }
 
@@ -195,25 +294,23 @@ void LocalEnforcer::schedule_dynamic_rule_activation(
   std::vector<std::string> static_rules;
   std::vector<PolicyRule> dynamic_rules {dynamic_rule.policy_rule()};
 
-  auto it = session_map_.find(imsi);
-  auto delta = time_difference_from_now(dynamic_rule.activation_time());
+  auto activation_time = TimeUtil::TimestampToSeconds(
+    dynamic_rule.activation_time());
   MLOG(MDEBUG) << "Scheduling subscriber " << imsi << " dynamic rule "
-    << dynamic_rule.policy_rule().id() << " activation in "
-    << (delta.count() / 1000) << " secs";
-  evb_->runInEventBaseThread([=]{
-    evb_->timer().scheduleTimeoutFn(
-      std::move([=] {
-        pipelined_client_->activate_flows_for_rules(
-          imsi, ip_addr, static_rules, dynamic_rules);
-        if (it == session_map_.end()) {
-          MLOG(MWARNING) << "Could not find session for IMSI " << imsi
-            << "during installation of dynamic rule "
-            << dynamic_rule.policy_rule().id();
-        } else {
-          it->second->insert_dynamic_rule(dynamic_rule.policy_rule());
-        }
-      }),
-      delta);
+    << dynamic_rule.policy_rule().id() << " activation at "
+    << activation_time;
+  timers_.add(activation_time, [=] {
+    pipelined_client_->activate_flows_for_rules(
+      imsi, ip_addr, static_rules, dynamic_rules);
+    auto it = session_map_.find(imsi);
+    if (it == session_map_.end()) {
+      MLOG(MWARNING) << "Could not find session for IMSI " << imsi
+        << "during installation of dynamic rule "
+        << dynamic_rule.policy_rule().id();
+    } else {
+      it->second->insert_dynamic_rule(dynamic_rule.policy_rule());
+      mark_unsaved(imsi);
+    }
   });
 }
 
@@ -223,15 +320,13 @@ void LocalEnforcer::schedule_static_rule_deactivation(
   std::vector<std::string> static_rules {static_rule.rule_id()};
   std::vector<PolicyRule> dynamic_rules;
 
-  auto delta = time_difference_from_now(static_rule.deactivation_time());
+  auto deactivation_time = TimeUtil::TimestampToSeconds(
+    static_rule.deactivation_time());
   MLOG(MDEBUG) << "Scheduling subscriber " << imsi << " static rule "
-    << static_rule.rule_id() << " deactivation in "
-    << (delta.count() / 1000) << " secs";
-  evb_->runInEventBaseThread([=]{
-    evb_->timer().scheduleTimeoutFn(
-      std::move([=] { pipelined_client_->deactivate_flows_for_rules(
-          imsi, static_rules, dynamic_rules); }),
-      delta);
+    << static_rule.rule_id() << " deactivation at " << deactivation_time;
+  timers_.add(deactivation_time, [=] {
+    pipelined_client_->deactivate_flows_for_rules(
+      imsi, static_rules, dynamic_rules);
   });
 }
 
@@ -241,27 +336,25 @@ void LocalEnforcer::schedule_dynamic_rule_deactivation(
   std::vector<std::string> static_rules;
   std::vector<PolicyRule> dynamic_rules {dynamic_rule.policy_rule()};
 
-  auto it = session_map_.find(imsi);
-  auto delta = time_difference_from_now(dynamic_rule.deactivation_time());
+  auto deactivation_time = TimeUtil::TimestampToSeconds(
+    dynamic_rule.deactivation_time());
   MLOG(MDEBUG) << "Scheduling subscriber " << imsi << " dynamic rule "
-    << dynamic_rule.policy_rule().id() << " deactivation in "
-    << (delta.count() / 1000) << " secs";
-  evb_->runInEventBaseThread([=]{
-    evb_->timer().scheduleTimeoutFn(
-      std::move([=] {
-        pipelined_client_->deactivate_flows_for_rules(
-          imsi, static_rules, dynamic_rules);
-        if (it == session_map_.end()) {
-          MLOG(MWARNING) << "Could not find session for IMSI " << imsi
-            << "during removal of dynamic rule "
-            << dynamic_rule.policy_rule().id();
-        } else {
-          PolicyRule rule_dont_care;
-          it->second->remove_dynamic_rule(
-            dynamic_rule.policy_rule().id(), &rule_dont_care);
-        }
-      }),
-      delta);
+    << dynamic_rule.policy_rule().id() << " deactivation at "
+    << deactivation_time;
+  timers_.add(deactivation_time, [=] {
+    pipelined_client_->deactivate_flows_for_rules(
+      imsi, static_rules, dynamic_rules);
+    auto it = session_map_.find(imsi);
+    if (it == session_map_.end()) {
+      MLOG(MWARNING) << "Could not find session for IMSI " << imsi
+        << "during removal of dynamic rule "
+        << dynamic_rule.policy_rule().id();
+    } else {
+      PolicyRule rule_dont_care;
+      it->second->remove_dynamic_rule(
+        dynamic_rule.policy_rule().id(), &rule_dont_care);
+      mark_unsaved(imsi);
+    }
   });
 }
 
@@ -351,6 +444,9 @@ bool LocalEnforcer::init_session_credit(
     session_state->get_monitor_pool().receive_credit(monitor);
   }
   session_map_[imsi] = std::unique_ptr<SessionState>(session_state);
+  mark_dirty(imsi);
+  mark_unsaved(imsi);
+  track_validity_timer(imsi, *session_state);
 
   auto ip_addr = session_state->get_subscriber_ip_addr();
 
@@ -407,6 +503,7 @@ void LocalEnforcer::complete_termination(
   if (session_map_.erase(imsi) == 0) {
     MLOG(MERROR) << "Terminated non existent session for " << imsi;
   }
+  mark_unsaved(imsi);
 }
 
 void LocalEnforcer::update_session_credit(
@@ -419,6 +516,9 @@ void LocalEnforcer::update_session_credit(
       return;
     }
     it->second->get_charging_pool().receive_credit(response);
+    mark_dirty(response.sid());
+    mark_unsaved(response.sid());
+    track_validity_timer(response.sid(), *it->second);
   }
   for (const auto& usage_monitor_resp : response.usage_monitor_responses()) {
     auto it = session_map_.find(usage_monitor_resp.sid());
@@ -428,6 +528,8 @@ void LocalEnforcer::update_session_credit(
       return;
     }
     it->second->get_monitor_pool().receive_credit(usage_monitor_resp);
+    mark_dirty(usage_monitor_resp.sid());
+    mark_unsaved(usage_monitor_resp.sid());
   }
 }
 
@@ -444,6 +546,7 @@ SessionTerminateRequest LocalEnforcer::terminate_subscriber(
     MLOG(MERROR)  << "Could not deactivate flows for IMSI " << imsi
       << " during termination";
   }
+  mark_unsaved(imsi);
   return it->second->terminate();
 }
 
@@ -470,13 +573,15 @@ uint64_t LocalEnforcer::get_monitor_credit(
 }
 
 ChargingReAuthAnswer::Result LocalEnforcer::init_charging_reauth(
-    ChargingReAuthRequest request) {
+    const ChargingReAuthRequest& request) {
   auto it = session_map_.find(request.sid());
   if (it == session_map_.end()) {
     MLOG(MERROR)  << "Could not find session for subscriber " << request.sid()
       << " during reauth";
     return ChargingReAuthAnswer::SESSION_NOT_FOUND;
   }
+  mark_dirty(request.sid());
+  mark_unsaved(request.sid());
   if (request.type() == ChargingReAuthRequest::SINGLE_SERVICE) {
     MLOG(MDEBUG) << "Initiating reauth of key " << request.charging_key()
       << " for subscriber " << request.sid();
@@ -488,7 +593,7 @@ ChargingReAuthAnswer::Result LocalEnforcer::init_charging_reauth(
 }
 
 void LocalEnforcer::init_policy_reauth(
-    PolicyReAuthRequest request,
+    const PolicyReAuthRequest& request,
     PolicyReAuthAnswer& answer_out) {
   auto it = session_map_.find(request.imsi());
   if (it == session_map_.end()) {
@@ -501,6 +606,7 @@ void LocalEnforcer::init_policy_reauth(
   RulesToProcess rules_to_activate;
   RulesToProcess rules_to_deactivate;
 
+  mark_unsaved(request.imsi());
   process_policy_reauth_request(
       request,
       it->second,
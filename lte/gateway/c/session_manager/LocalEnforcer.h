@@ -8,12 +8,19 @@
  */
 #pragma once
 
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <unordered_set>
+
 #include <lte/protos/session_manager.grpc.pb.h>
 #include <folly/io/async/EventBaseManager.h>
 
 #include "RuleStore.h"
 #include "PipelinedClient.h"
 #include "SessionState.h"
+#include "SessionStore.h"
+#include "TimerWheel.h"
 
 namespace magma {
 using namespace orc8r;
@@ -46,6 +53,36 @@ public:
 
   folly::EventBase& get_event_base();
 
+  /**
+   * Set the callback run when credit validity timers expire, so that the
+   * updates of the expired sessions are collected. Runs in the event base
+   * thread of the enforcer.
+   */
+  void set_on_updates_due(std::function<void()> on_updates_due);
+
+  /**
+   * Run the credit validity timers and the scheduled rule activations and
+   * deactivations due by now. Called every second from the event base thread
+   * once started.
+   */
+  void process_due_timers(std::time_t now);
+
+  /**
+   * Persist the sessions in session_store. The sessions changed since the
+   * last save are handed to the store every save_interval, from the event
+   * base thread once started.
+   */
+  void attachSessionStore(
+    std::shared_ptr<SessionStore> session_store,
+    std::chrono::milliseconds save_interval);
+
+  /**
+   * Restore the sessions read from the session store, before any request is
+   * handled. Usage that was being reported when the sessions were stored is
+   * reported again.
+   */
+  void restore_sessions(const std::vector<StoredSessionState>& sessions);
+
   /**
    * Insert a group of rule usage into the monitor and update credit manager
    * Assumes records are aggregates, as in the usages sent are cumulative and
@@ -55,6 +92,11 @@ public:
    */
   void aggregate_records(const RuleRecordTable& records);
 
+  /**
+   * Insert the usage of a single rule record, see aggregate_records
+   */
+  void aggregate_record(const RuleRecord& record);
+
   /**
    * reset_updates resets all of the charging keys being updated in
    * failed_request. This should only be called if the *entire* request fails
@@ -68,7 +110,9 @@ public:
 
   /**
    * Collect any credit keys that are either exhausted, timed out, or terminated
-   * and apply actions to the services if need be
+   * and apply actions to the services if need be. Only the sessions that were
+   * touched since the last collection (usage, credit or reauth received) or
+   * whose validity timer expired are visited.
    * @param updates_out (out) - vector to add usage updates to, if they exist
    */
   UpdateSessionRequest collect_updates();
@@ -112,10 +156,10 @@ public:
    * found, the method returns SESSION_NOT_FOUND
    */
   ChargingReAuthAnswer::Result init_charging_reauth(
-      ChargingReAuthRequest request);
+      const ChargingReAuthRequest& request);
 
   void init_policy_reauth(
-      PolicyReAuthRequest request,
+      const PolicyReAuthRequest& request,
       PolicyReAuthAnswer& answer_out);
 
 private:
@@ -126,9 +170,45 @@ private:
   std::shared_ptr<StaticRuleStore> rule_store_;
   std::shared_ptr<PipelinedClient> pipelined_client_;
   std::unordered_map<std::string, std::unique_ptr<SessionState>> session_map_;
+  // IMSIs of the sessions that may have updates or actions to collect
+  std::unordered_set<std::string> dirty_sessions_;
+  // Credit validity timers and scheduled rule activations/deactivations.
+  // Validity timers are not removed when rearmed, a session whose timer did
+  // not really expire is only visited for nothing.
+  TimerWheel timers_;
+  bool updates_due_;
+  std::function<void()> on_updates_due_;
+  std::shared_ptr<SessionStore> session_store_;
+  std::chrono::milliseconds save_interval_;
+  // IMSIs of the sessions changed since they were last saved
+  std::unordered_set<std::string> unsaved_sessions_;
   folly::EventBase* evb_;
 private:
-  void new_report();
+  /**
+   * Mark the session as needing to be checked at the next collect_updates
+   */
+  void mark_dirty(const std::string& imsi);
+
+  /**
+   * Track the earliest credit validity expiry of a session which just
+   * received credit, so that it is checked when the timer expires
+   */
+  void track_validity_timer(const std::string& imsi, SessionState& session);
+
+  void schedule_timer_tick();
+
+  /**
+   * Mark the session as changed, to be saved in the session store if any
+   */
+  void mark_unsaved(const std::string& imsi);
+
+  /**
+   * Hand the changed sessions to the session store. Sessions which are gone
+   * or terminating are removed from the store.
+   */
+  void save_sessions();
+
+  void schedule_session_save();
 
   /**
    * Process the create session response to get rules to activate/deactivate
@@ -7,8 +7,11 @@
  * of patent rights can be found in the PATENTS file in the same directory.
  */
 #include <chrono>
+#include <memory>
 #include <thread>
 
+#include <google/protobuf/arena.h>
+
 #include "LocalSessionManagerHandler.h"
 #include "magma_logging.h"
 
@@ -17,68 +20,45 @@ using grpc::Status;
 namespace magma {
 
 LocalSessionManagerHandlerImpl::LocalSessionManagerHandlerImpl(
-  LocalEnforcer* enforcer,
-  SessionCloudReporter* reporter)
-  : enforcer_(enforcer), reporter_(reporter) {}
+  ShardedEnforcer* enforcer,
+  SessionCloudReporter* reporter,
+  ReportScheduler* report_scheduler)
+  : enforcer_(enforcer),
+    reporter_(reporter),
+    report_scheduler_(report_scheduler) {}
 
 void LocalSessionManagerHandlerImpl::ReportRuleStats(
     ServerContext* context,
     const RuleRecordTable* request,
     std::function<void(Status, Void)> response_callback) {
-  auto& request_cpy = *request;
-  MLOG(MDEBUG) << "Aggregating " << request_cpy.records_size() << " records";
-  enforcer_->get_event_base().runInEventBaseThread(
-    [this, request_cpy]() {
-      enforcer_->aggregate_records(request_cpy);
-      check_usage_for_reporting();
-    }
-  );
-  response_callback(Status::OK, Void());
-}
-
-void LocalSessionManagerHandlerImpl::check_usage_for_reporting() {
-  auto request = enforcer_->collect_updates();
-  if (request.updates_size() == 0 && request.usage_monitors_size() == 0) {
-    return; // nothing to report
-  }
-  MLOG(MDEBUG) << "Sending " << request.updates_size()
-    << " charging updates and " << request.usage_monitors_size()
-    << " monitor updates to OCS and PCRF";
-
-  // report to cloud
-  reporter_->report_updates(request,
-    [this, request](Status status, UpdateSessionResponse response) {
-      if (!status.ok()) {
-        enforcer_->reset_updates(request);
-        MLOG(MERROR) << "Update of size " << request.updates_size() <<
-          " to OCS failed entirely: " << status.error_message();
-      } else {
-        MLOG(MDEBUG) << "Received updated responses from OCS and PCRF";
-        enforcer_->update_session_credit(response);
-        // Check if we need to report more updates
-        check_usage_for_reporting();
-      }
-    }
-  );
+  MLOG(MDEBUG) << "Aggregating " << request->records_size() << " records";
+  // The records are aggregated in place, the call is only completed, and the
+  // request freed, once every shard is done with them
+  enforcer_->aggregate_records(*request, [this, response_callback]() {
+    report_scheduler_->schedule_flush();
+    response_callback(Status::OK, Void());
+  });
 }
 
-static CreateSessionRequest copy_session_info2create_req(
+static CreateSessionRequest* copy_session_info2create_req(
     const LocalCreateSessionRequest* request,
-    const std::string& sid) {
+    const std::string& sid,
+    google::protobuf::Arena* arena) {
 
-  CreateSessionRequest create_request;
+  auto create_request =
+    google::protobuf::Arena::CreateMessage<CreateSessionRequest>(arena);
 
-  create_request.mutable_subscriber()->CopyFrom(request->sid());
-  create_request.set_session_id(sid);
-  create_request.set_ue_ipv4(request->ue_ipv4());
-  create_request.set_spgw_ipv4(request->spgw_ipv4());
-  create_request.set_apn(request->apn());
-  create_request.set_msisdn(request->msisdn());
-  create_request.set_imei(request->imei());
-  create_request.set_plmn_id(request->plmn_id());
-  create_request.set_imsi_plmn_id(request->imsi_plmn_id());
-  create_request.set_user_location(request->user_location());
-  create_request.mutable_qos_info()->CopyFrom(request->qos_info());
+  create_request->mutable_subscriber()->CopyFrom(request->sid());
+  create_request->set_session_id(sid);
+  create_request->set_ue_ipv4(request->ue_ipv4());
+  create_request->set_spgw_ipv4(request->spgw_ipv4());
+  create_request->set_apn(request->apn());
+  create_request->set_msisdn(request->msisdn());
+  create_request->set_imei(request->imei());
+  create_request->set_plmn_id(request->plmn_id());
+  create_request->set_imsi_plmn_id(request->imsi_plmn_id());
+  create_request->set_user_location(request->user_location());
+  create_request->mutable_qos_info()->CopyFrom(request->qos_info());
 
   return create_request;
 }
@@ -99,14 +79,27 @@ void LocalSessionManagerHandlerImpl::CreateSession(
    .imsi_plmn_id = request->imsi_plmn_id(),
    .user_location = request->user_location()
   };
+  // The request is serialized when the call starts, it only needs to live
+  // for the duration of report_create_session
+  google::protobuf::Arena arena;
   reporter_->report_create_session(
-    copy_session_info2create_req(request, sid),
+    *copy_session_info2create_req(request, sid, &arena),
     [this, imsi, sid, cfg, response_callback](
         Status status,
         CreateSessionResponse response) {
-      if (status.ok()) {
-        bool success = enforcer_->init_session_credit(imsi,
-            sid, cfg, response);
+      if (!status.ok()) {
+        MLOG(MERROR) << "Failed to initialize session in OCS for IMSI " << imsi
+          << ": " << status.error_message();
+        response_callback(status, LocalCreateSessionResponse());
+        return;
+      }
+      auto credit_response = std::make_shared<CreateSessionResponse>();
+      credit_response->Swap(&response);
+      enforcer_->run_in_shard(imsi, [imsi, sid, cfg, credit_response,
+          response_callback](LocalEnforcer& shard) {
+        auto status = Status::OK;
+        bool success = shard.init_session_credit(
+          imsi, sid, cfg, *credit_response);
         if (!success) {
           MLOG(MERROR) << "Failed to init session in Usage Monitor for IMSI "
             << imsi;
@@ -116,34 +109,36 @@ void LocalSessionManagerHandlerImpl::CreateSession(
           MLOG(MINFO) << "Successfully initialized new session in sessiond "
             << "for subscriber " << imsi;
         }
-      } else {
-        MLOG(MERROR) << "Failed to initialize session in OCS for IMSI " << imsi
-          << ": " << status.error_message();
-      }
-      response_callback(status, LocalCreateSessionResponse());
+        response_callback(status, LocalCreateSessionResponse());
+      });
     });
 }
 
 static void report_termination(
-    LocalEnforcer& enforcer,
+    ShardedEnforcer& enforcer,
     SessionCloudReporter& reporter,
     const SessionTerminateRequest& term_req,
     std::function<void(Status, LocalEndSessionResponse)> response_callback) {
+  // only the IDs are needed once the termination is reported
+  auto imsi = term_req.sid();
+  auto session_id = term_req.session_id();
   reporter.report_terminate_session(term_req,
-    [&enforcer, &reporter, term_req, response_callback](
+    [&enforcer, imsi, session_id, response_callback](
         Status status,
         SessionTerminateResponse response) {
       if (!status.ok()) {
         MLOG(MERROR) << "Failed to terminate session in controller for "
-          "subscriber " << term_req.sid() << ": " << status.error_message();
+          "subscriber " << imsi << ": " << status.error_message();
       } else {
         MLOG(MDEBUG) << "Termination successful in controller for "
-          "subscriber " << term_req.sid();
+          "subscriber " << imsi;
       }
       // No matter what, end session locally
-      enforcer.complete_termination(
-        term_req.sid(), term_req.session_id());
-      response_callback(status, LocalEndSessionResponse());
+      enforcer.run_in_shard(imsi, [imsi, session_id, status,
+          response_callback](LocalEnforcer& shard) {
+        shard.complete_termination(imsi, session_id);
+        response_callback(status, LocalEndSessionResponse());
+      });
     }
   );
 }
@@ -161,16 +156,16 @@ void LocalSessionManagerHandlerImpl::EndSession(
     ServerContext* context,
     const SubscriberID* request,
     std::function<void(Status, LocalEndSessionResponse)> response_callback) {
-  auto& request_cpy = *request;
-  enforcer_->get_event_base().runInEventBaseThread(
-    [this, request_cpy, response_callback]() {
+  auto imsi = request->id();
+  enforcer_->run_in_shard(imsi,
+    [this, imsi, response_callback](LocalEnforcer& shard) {
       try {
-        auto term_req = enforcer_->terminate_subscriber(request_cpy.id());
+        auto term_req = shard.terminate_subscriber(imsi);
         // report to cloud
         report_termination(*enforcer_, *reporter_, term_req, response_callback);
       } catch (const SessionNotFound& ex) {
         MLOG(MERROR) << "Failed to find session to terminate for subscriber "
-          << request_cpy.id();
+          << imsi;
         Status status(grpc::FAILED_PRECONDITION, "Session not found");
         response_callback(status, LocalEndSessionResponse());
       }
@@ -13,8 +13,9 @@
 #include <grpc++/grpc++.h>
 #include <lte/protos/session_manager.grpc.pb.h>
 
-#include "LocalEnforcer.h"
 #include "CloudReporter.h"
+#include "ReportScheduler.h"
+#include "ShardedEnforcer.h"
 #include "SessionID.h"
 
 using grpc::ServerContext;
@@ -63,12 +64,14 @@ public:
  */
 class LocalSessionManagerHandlerImpl : public LocalSessionManagerHandler {
 public:
-  LocalSessionManagerHandlerImpl(LocalEnforcer* monitor,
-                                 SessionCloudReporter* reporter);
+  LocalSessionManagerHandlerImpl(ShardedEnforcer* enforcer,
+                                 SessionCloudReporter* reporter,
+                                 ReportScheduler* report_scheduler);
 
   ~LocalSessionManagerHandlerImpl() {}
   /**
-   * Report flow stats from pipelined and track the usage per rule
+   * Report flow stats from pipelined and track the usage per rule. The call
+   * completes once the records are aggregated by the enforcer shards
    */
   void ReportRuleStats(
     ServerContext* context,
@@ -93,12 +96,10 @@ public:
     std::function<void(Status, LocalEndSessionResponse)> response_callback);
 
 private:
-  LocalEnforcer* enforcer_;
+  ShardedEnforcer* enforcer_;
   SessionCloudReporter* reporter_;
+  ReportScheduler* report_scheduler_;
   SessionIDGenerator id_gen_;
-
-private:
-  void check_usage_for_reporting();
 };
 
 }
@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <arpa/inet.h>
+#include <chrono>
+
+#include "MobilitydClient.h"
+#include "ServiceRegistrySingleton.h"
+#include "magma_logging.h"
+
+using grpc::ClientContext;
+using grpc::Status;
+
+namespace magma {
+
+SyncMobilitydClient::SyncMobilitydClient(
+  std::shared_ptr<grpc::Channel> channel
+) : stub_(MobilityService::NewStub(channel)) {}
+
+SyncMobilitydClient::SyncMobilitydClient()
+  : SyncMobilitydClient(
+    ServiceRegistrySingleton::Instance()
+      ->GetGrpcChannel("mobilityd", ServiceRegistrySingleton::LOCAL)) {}
+
+bool SyncMobilitydClient::get_subscriber_ipv4_table(
+    std::unordered_map<std::string, std::string>* ipv4_by_imsi) {
+  ClientContext context;
+  context.set_deadline(
+    std::chrono::system_clock::now() +
+    std::chrono::seconds(RESPONSE_TIMEOUT));
+  orc8r::Void request;
+  SubscriberIPTable table;
+  auto status = stub_->GetSubscriberIPTable(&context, request, &table);
+  if (!status.ok()) {
+    MLOG(MERROR) << "Could not get the subscriber IP table from mobilityd: "
+      << status.error_message();
+    return false;
+  }
+  for (const auto& entry : table.entries()) {
+    const auto& address = entry.ip().address();
+    if (entry.ip().version() != IPAddress::IPV4 ||
+        address.size() != sizeof(struct in_addr)) {
+      continue;
+    }
+    char ipv4[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, address.data(), ipv4, sizeof(ipv4));
+    (*ipv4_by_imsi)[entry.sid().id()] = ipv4;
+  }
+  return true;
+}
+
+}
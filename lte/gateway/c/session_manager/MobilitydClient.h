@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <lte/protos/mobilityd.grpc.pb.h>
+
+namespace magma {
+using namespace lte;
+
+/**
+ * MobilitydClient reads the IP addresses allocated by mobilityd, which keeps
+ * them until the UE detaches.
+ */
+class MobilitydClient {
+public:
+  virtual ~MobilitydClient() = default;
+
+  /**
+   * Get the IPv4 address allocated to each subscriber
+   * @param ipv4_by_imsi - filled with the dotted address of each IMSI, the
+   *   IMSIs are the bare digits
+   * @return true if mobilityd answered
+   */
+  virtual bool get_subscriber_ipv4_table(
+    std::unordered_map<std::string, std::string>* ipv4_by_imsi) = 0;
+};
+
+/**
+ * SyncMobilitydClient implements MobilitydClient with blocking calls to
+ * mobilityd. It is only meant to be used on startup.
+ */
+class SyncMobilitydClient : public MobilitydClient {
+public:
+  SyncMobilitydClient();
+
+  SyncMobilitydClient(std::shared_ptr<grpc::Channel> mobilityd_channel);
+
+  bool get_subscriber_ipv4_table(
+    std::unordered_map<std::string, std::string>* ipv4_by_imsi);
+
+private:
+  static const uint32_t RESPONSE_TIMEOUT = 6; // seconds
+  std::unique_ptr<MobilityService::Stub> stub_;
+};
+
+}
@@ -17,39 +17,37 @@ using grpc::Status;
 
 namespace { // anonymous
 
-magma::DeactivateFlowsRequest create_deactivate_req(
+void create_deactivate_req(
     const std::string& imsi,
     const std::vector<std::string>& rule_ids,
-    const std::vector<magma::PolicyRule>& dynamic_rules) {
-  magma::DeactivateFlowsRequest req;
-  req.mutable_sid()->set_id(imsi);
-  auto ids = req.mutable_rule_ids();
+    const std::vector<magma::PolicyRule>& dynamic_rules,
+    magma::DeactivateFlowsRequest* req) {
+  req->mutable_sid()->set_id(imsi);
+  auto ids = req->mutable_rule_ids();
   for (const auto& id : rule_ids) {
     ids->Add()->assign(id);
   }
   for (const auto& rule : dynamic_rules) {
     ids->Add()->assign(rule.id());
   }
-  return req;
 }
 
-magma::ActivateFlowsRequest create_activate_req(
+void create_activate_req(
     const std::string& imsi,
     const std::string& ip_addr,
     const std::vector<std::string>& static_rules,
-    const std::vector<magma::PolicyRule>& dynamic_rules) {
-  magma::ActivateFlowsRequest req;
-  req.mutable_sid()->set_id(imsi);
-  req.set_ip_addr(ip_addr);
-  auto ids = req.mutable_rule_ids();
+    const std::vector<magma::PolicyRule>& dynamic_rules,
+    magma::ActivateFlowsRequest* req) {
+  req->mutable_sid()->set_id(imsi);
+  req->set_ip_addr(ip_addr);
+  auto ids = req->mutable_rule_ids();
   for (const auto& id : static_rules) {
     ids->Add()->assign(id);
   }
-  auto mut_dyn_rules = req.mutable_dynamic_rules();
+  auto mut_dyn_rules = req->mutable_dynamic_rules();
   for (const auto& dyn_rule : dynamic_rules) {
     mut_dyn_rules->Add()->CopyFrom(dyn_rule);
   }
-  return req;
 }
 
 }  // namespace anonymous
@@ -58,7 +56,9 @@ namespace magma {
 
 AsyncPipelinedClient::AsyncPipelinedClient(
   std::shared_ptr<grpc::Channel> channel
-) : stub_(Pipelined::NewStub(channel)) {}
+) : stub_(Pipelined::NewStub(channel)),
+    batch_in_flight_(false),
+    batch_retries_(0) {}
 
 AsyncPipelinedClient::AsyncPipelinedClient()
   : AsyncPipelinedClient(
@@ -66,15 +66,10 @@ AsyncPipelinedClient::AsyncPipelinedClient()
       ->GetGrpcChannel("pipelined", ServiceRegistrySingleton::LOCAL)) {}
 
 bool AsyncPipelinedClient::deactivate_all_flows(const std::string& imsi) {
-  DeactivateFlowsRequest req;
-  req.mutable_sid()->set_id(imsi);
+  FlowUpdate update;
+  update.mutable_deactivate()->mutable_sid()->set_id(imsi);
   MLOG(MDEBUG) << "Deactivating all flows for subscriber " << imsi;
-  deactivate_flows_rpc(req, [imsi](Status status, DeactivateFlowsResult resp) {
-    if (!status.ok()) {
-      MLOG(MERROR) << "Could not deactivate flows for subscriber " << imsi
-        << ": " << status.error_message();
-    }
-  });
+  queue_update(&update);
   return true;
 }
 
@@ -82,15 +77,12 @@ bool AsyncPipelinedClient::deactivate_flows_for_rules(
     const std::string& imsi,
     const std::vector<std::string>& rule_ids,
     const std::vector<PolicyRule>& dynamic_rules) {
-  auto req = create_deactivate_req(imsi, rule_ids, dynamic_rules);
+  FlowUpdate update;
+  create_deactivate_req(
+    imsi, rule_ids, dynamic_rules, update.mutable_deactivate());
   MLOG(MDEBUG) << "Deactivating " << rule_ids.size() << " static rules and "
     << dynamic_rules.size() << " dynamic rules for subscriber " << imsi;
-  deactivate_flows_rpc(req, [imsi](Status status, DeactivateFlowsResult resp) {
-    if (!status.ok()) {
-      MLOG(MERROR) << "Could not deactivate flows for subscriber " << imsi
-        << ": " << status.error_message();
-    }
-  });
+  queue_update(&update);
   return true;
 }
 
@@ -99,35 +91,86 @@ bool AsyncPipelinedClient::activate_flows_for_rules(
     const std::string& ip_addr,
     const std::vector<std::string>& static_rules,
     const std::vector<PolicyRule>& dynamic_rules) {
-  auto req = create_activate_req(imsi, ip_addr, static_rules, dynamic_rules);
+  FlowUpdate update;
+  create_activate_req(
+    imsi, ip_addr, static_rules, dynamic_rules, update.mutable_activate());
   MLOG(MDEBUG) << "Activating " << static_rules.size() << " static rules and "
     << dynamic_rules.size() << " dynamic rules for subscriber " << imsi;
-  activate_flows_rpc(req, [imsi](Status status, ActivateFlowsResult resp) {
-    if (!status.ok()) {
-      MLOG(MERROR)  << "Could not activate flows through pipelined for UE "
-        << imsi << ": " << status.error_message();
+  queue_update(&update);
+  return true;
+}
+
+void AsyncPipelinedClient::queue_update(FlowUpdate* update) {
+  std::lock_guard<std::mutex> lock(batch_mutex_);
+  pending_updates_.add_updates()->Swap(update);
+  if (!batch_in_flight_) {
+    send_batch();
+  }
+}
+
+void AsyncPipelinedClient::send_batch() {
+  // kept until the call completes, to be sent again if it fails
+  auto batch = std::make_shared<UpdateFlowsRequest>();
+  auto pending = pending_updates_.mutable_updates();
+  if (pending->size() <= MAX_BATCH_SIZE) {
+    batch->Swap(&pending_updates_);
+  } else {
+    std::vector<FlowUpdate*> updates(MAX_BATCH_SIZE);
+    pending->ExtractSubrange(0, MAX_BATCH_SIZE, updates.data());
+    for (auto update : updates) {
+      batch->mutable_updates()->AddAllocated(update);
+    }
+  }
+  batch_in_flight_ = true;
+  MLOG(MDEBUG) << "Sending " << batch->updates_size()
+    << " flow updates to pipelined";
+  update_flows_rpc(*batch, [this, batch](
+      Status status, UpdateFlowsResult resp) {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    batch_in_flight_ = false;
+    if (status.ok()) {
+      batch_retries_ = 0;
+    } else {
+      MLOG(MERROR) << "Could not update flows through pipelined for "
+        << batch->updates_size() << " requests: " << status.error_message();
+      retry_batch(batch.get());
+    }
+    if (pending_updates_.updates_size() > 0) {
+      send_batch();
     }
   });
-  return true;
 }
 
-void AsyncPipelinedClient::deactivate_flows_rpc(
-    const DeactivateFlowsRequest& request,
-    std::function<void(Status, DeactivateFlowsResult)> callback) {
-  auto local_resp = new AsyncLocalResponse<DeactivateFlowsResult>(
-      std::move(callback),
-      RESPONSE_TIMEOUT);
-  local_resp->set_response_reader(std::move(stub_->AsyncDeactivateFlows(
-    local_resp->get_context(), request, &queue_)));
+void AsyncPipelinedClient::retry_batch(UpdateFlowsRequest* batch) {
+  if (batch_retries_ >= MAX_BATCH_RETRIES) {
+    batch_retries_ = 0;
+    for (const auto& update : batch->updates()) {
+      if (update.has_activate()) {
+        MLOG(MERROR) << "Dropping the flow activation of subscriber "
+          << update.activate().sid().id();
+      } else {
+        MLOG(MERROR) << "Dropping the flow deactivation of subscriber "
+          << update.deactivate().sid().id();
+      }
+    }
+    return;
+  }
+  batch_retries_++;
+  // the updates queued since go after the batch, to keep the order of the
+  // updates of each subscriber
+  for (auto& update : *pending_updates_.mutable_updates()) {
+    batch->add_updates()->Swap(&update);
+  }
+  pending_updates_.Swap(batch);
 }
 
-void AsyncPipelinedClient::activate_flows_rpc(
-    const ActivateFlowsRequest& request,
-    std::function<void(Status, ActivateFlowsResult)> callback) {
-  auto local_resp = new AsyncLocalResponse<ActivateFlowsResult>(
+void AsyncPipelinedClient::update_flows_rpc(
+    const UpdateFlowsRequest& request,
+    std::function<void(Status, UpdateFlowsResult)> callback) {
+  auto local_resp = new AsyncLocalResponse<UpdateFlowsResult>(
       std::move(callback),
       RESPONSE_TIMEOUT);
-  local_resp->set_response_reader(std::move(stub_->AsyncActivateFlows(
+  local_resp->set_response_reader(std::move(stub_->AsyncUpdateFlows(
     local_resp->get_context(), request, &queue_)));
 }
 
@@ -59,6 +59,11 @@ public:
 /**
  * AsyncPipelinedClient implements PipelinedClient but sends calls
  * asynchronously to pipelined.
+ * Flow updates are batched in UpdateFlows calls. While a batch is in flight,
+ * new updates are queued and sent in the next batch when it completes. With a
+ * single batch in flight, pipelined applies the updates of a subscriber in the
+ * order they were made. A batch that fails is sent again, ahead of the
+ * updates queued since, up to MAX_BATCH_RETRIES times before it is dropped.
  */
 class AsyncPipelinedClient : public GRPCReceiver, public PipelinedClient {
 public:
@@ -95,15 +100,35 @@ public:
 
 private:
   static const uint32_t RESPONSE_TIMEOUT = 6; // seconds
+  static const int MAX_BATCH_SIZE = 1000; // flow updates per UpdateFlows call
+  static const uint32_t MAX_BATCH_RETRIES = 3;
   std::unique_ptr<Pipelined::Stub> stub_;
+  std::mutex batch_mutex_;
+  // updates waiting for the batch in flight to complete
+  UpdateFlowsRequest pending_updates_;
+  bool batch_in_flight_;
+  // failed attempts of the batch at the front of pending_updates_
+  uint32_t batch_retries_;
 private:
-  void deactivate_flows_rpc(
-    const DeactivateFlowsRequest& request,
-    std::function<void(Status, DeactivateFlowsResult)> callback);
+  /**
+   * Queue a flow update, and send it right away if no batch is in flight
+   */
+  void queue_update(FlowUpdate* update);
+
+  /**
+   * Send the next batch of pending updates. batch_mutex_ must be held
+   */
+  void send_batch();
+
+  /**
+   * Put a failed batch back in front of the pending updates, or drop it if
+   * it failed too many times. batch_mutex_ must be held
+   */
+  void retry_batch(UpdateFlowsRequest* batch);
 
-  void activate_flows_rpc(
-    const ActivateFlowsRequest& request,
-    std::function<void(Status, ActivateFlowsResult)> callback);
+  void update_flows_rpc(
+    const UpdateFlowsRequest& request,
+    std::function<void(Status, UpdateFlowsResult)> callback);
 };
 
 }
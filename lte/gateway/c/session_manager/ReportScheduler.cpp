@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include "ReportScheduler.h"
+#include "magma_logging.h"
+
+namespace magma {
+
+ReportScheduler::ReportScheduler(
+  folly::EventBase* evb,
+  ShardedEnforcer* enforcer,
+  SessionCloudReporter* reporter,
+  const Config& config)
+  : evb_(evb),
+    enforcer_(enforcer),
+    reporter_(reporter),
+    config_(config),
+    flush_scheduled_(false),
+    collecting_(false),
+    flush_pending_(false),
+    inflight_requests_(0) {
+  if (config_.max_inflight_requests == 0) {
+    config_.max_inflight_requests = 1;
+  }
+}
+
+void ReportScheduler::schedule_flush() {
+  evb_->runInEventBaseThread([this]() { schedule_flush_in_evb(); });
+}
+
+void ReportScheduler::schedule_flush_in_evb() {
+  if (flush_scheduled_) {
+    // the usage will be reported by the flush already scheduled
+    return;
+  }
+  flush_scheduled_ = true;
+  evb_->timer().scheduleTimeoutFn(
+    [this]() {
+      flush_scheduled_ = false;
+      flush();
+    },
+    config_.flush_interval);
+}
+
+void ReportScheduler::flush() {
+  if (collecting_ || !queued_requests_.empty()
+      || inflight_requests_ >= config_.max_inflight_requests) {
+    // Collecting now would only queue more requests, let the sessions keep
+    // accumulating usage until there is room for it
+    flush_pending_ = true;
+    return;
+  }
+  collecting_ = true;
+  enforcer_->collect_updates([this](UpdateSessionRequest& request) {
+    // called from a shard, move back to the event base of the scheduler
+    auto collected = std::make_shared<UpdateSessionRequest>();
+    collected->Swap(&request);
+    evb_->runInEventBaseThread([this, collected]() {
+      collecting_ = false;
+      queue_batches(*collected);
+      send_queued_requests();
+    });
+  });
+}
+
+void ReportScheduler::queue_batches(UpdateSessionRequest& request) {
+  auto max_size = config_.max_batch_size;
+  uint32_t total_size =
+    request.updates_size() + request.usage_monitors_size();
+  if (total_size == 0) {
+    return; // nothing to report
+  }
+  if (max_size == 0 || total_size <= max_size) {
+    queued_requests_.emplace_back();
+    queued_requests_.back().Swap(&request);
+    return;
+  }
+  UpdateSessionRequest batch;
+  uint32_t batch_size = 0;
+  auto add_batch = [this, &batch, &batch_size]() {
+    queued_requests_.emplace_back();
+    queued_requests_.back().Swap(&batch);
+    batch.Clear();
+    batch_size = 0;
+  };
+  for (auto& update : *request.mutable_updates()) {
+    batch.add_updates()->Swap(&update);
+    if (++batch_size == max_size) {
+      add_batch();
+    }
+  }
+  for (auto& update : *request.mutable_usage_monitors()) {
+    batch.add_usage_monitors()->Swap(&update);
+    if (++batch_size == max_size) {
+      add_batch();
+    }
+  }
+  if (batch_size > 0) {
+    add_batch();
+  }
+}
+
+void ReportScheduler::send_queued_requests() {
+  while (!queued_requests_.empty()
+      && inflight_requests_ < config_.max_inflight_requests) {
+    send(queued_requests_.front());
+    queued_requests_.pop_front();
+  }
+  if (flush_pending_ && queued_requests_.empty()
+      && inflight_requests_ < config_.max_inflight_requests) {
+    flush_pending_ = false;
+    schedule_flush_in_evb();
+  }
+}
+
+void ReportScheduler::send(UpdateSessionRequest& request) {
+  MLOG(MDEBUG) << "Sending " << request.updates_size()
+    << " charging updates and " << request.usage_monitors_size()
+    << " monitor updates to OCS and PCRF";
+  inflight_requests_++;
+  // kept until the response, to reset the updates if the request fails
+  auto sent_request = std::make_shared<UpdateSessionRequest>();
+  sent_request->Swap(&request);
+  reporter_->report_updates(*sent_request,
+    [this, sent_request](
+        grpc::Status status,
+        UpdateSessionResponse response) {
+      inflight_requests_--;
+      if (!status.ok()) {
+        enforcer_->reset_updates(*sent_request);
+        MLOG(MERROR) << "Update of size " << sent_request->updates_size() <<
+          " to OCS failed entirely: " << status.error_message();
+      } else {
+        MLOG(MDEBUG) << "Received updated responses from OCS and PCRF";
+        enforcer_->update_session_credit(response);
+        // Check if we need to report more updates
+        flush_pending_ = true;
+      }
+      send_queued_requests();
+    }
+  );
+}
+
+}
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <memory>
+
+#include <folly/io/async/EventBase.h>
+
+#include "CloudReporter.h"
+#include "ShardedEnforcer.h"
+
+namespace magma {
+
+/**
+ * ReportScheduler shapes the usage updates sent to the OCS and PCRF. Instead
+ * of reporting after every usage report from pipelined, the updates are
+ * collected at most once per flush interval, so the usage of all the reports
+ * received in between is merged in the same requests. Requests are capped to
+ * a maximum batch size, and no more than a maximum number of requests are in
+ * flight at once. While the cloud is behind, the usage keeps accumulating in
+ * the sessions and is reported once a request completes.
+ *
+ * All the state of the scheduler lives in the event base of the cloud
+ * reporter, which also runs the response callbacks.
+ */
+class ReportScheduler {
+public:
+  struct Config {
+    std::chrono::milliseconds flush_interval;
+    // maximum number of charging and monitor updates per request, 0 for none
+    uint32_t max_batch_size;
+    uint32_t max_inflight_requests;
+  };
+
+  ReportScheduler(
+    folly::EventBase* evb,
+    ShardedEnforcer* enforcer,
+    SessionCloudReporter* reporter,
+    const Config& config);
+
+  /**
+   * Report the updates of the sessions at the next flush. Can be called from
+   * any thread
+   */
+  void schedule_flush();
+
+private:
+  folly::EventBase* evb_;
+  ShardedEnforcer* enforcer_;
+  SessionCloudReporter* reporter_;
+  Config config_;
+  bool flush_scheduled_;
+  bool collecting_;
+  // set when a flush had to wait for the in flight requests
+  bool flush_pending_;
+  uint32_t inflight_requests_;
+  // collected requests waiting for an in flight request to complete
+  std::deque<UpdateSessionRequest> queued_requests_;
+
+private:
+  void schedule_flush_in_evb();
+
+  void flush();
+
+  /**
+   * Split the collected updates in batches and queue them to be sent
+   */
+  void queue_batches(UpdateSessionRequest& request);
+
+  /**
+   * Send the queued requests while there is room in flight, and flush again
+   * if it was asked while the cloud was busy
+   */
+  void send_queued_requests();
+
+  /**
+   * Send request, which is moved out
+   */
+  void send(UpdateSessionRequest& request);
+};
+
+}
@@ -6,6 +6,8 @@
  * LICENSE file in the root directory of this source tree. An additional grant
  * of patent rights can be found in the PATENTS file in the same directory.
  */
+#include <algorithm>
+
 #include <glog/logging.h>
 
 #include "RuleStore.h"
@@ -19,42 +21,50 @@ namespace magma {
 template <typename KeyType>
 void PoliciesByKeyMap<KeyType>::insert(
     const KeyType& key,
-    std::shared_ptr<PolicyRule> rule_p) {
-  auto iter = rules_by_key_.find(key);
-  if (iter == rules_by_key_.end()) {
-    rules_by_key_[key] = {rule_p};
-    return;
-  }
-  iter->second.push_back(rule_p);
+    std::shared_ptr<const PolicyRule> rule_p) {
+  rules_by_key_[key].push_back(rule_p);
 }
 
 template <typename KeyType>
 void PoliciesByKeyMap<KeyType>::remove(
     const KeyType& key,
-    std::shared_ptr<PolicyRule> rule_p) {
+    std::shared_ptr<const PolicyRule> rule_p) {
   auto iter = rules_by_key_.find(key);
   if (iter == rules_by_key_.end()) {
     return;
   }
 
-  auto rules = iter->second;
+  auto& rules = iter->second;
   auto found = std::find(rules.begin(), rules.end(), rule_p);
   if (found == rules.end()) {
     return;
   }
   rules.erase(found);
+  if (rules.empty()) {
+    rules_by_key_.erase(iter);
+  }
 }
 
 template <typename KeyType>
-bool PoliciesByKeyMap<KeyType>::get_rule_ids_for_key(
-    const KeyType& key,
-    std::vector<std::string>& rules_out) {
+const typename PoliciesByKeyMap<KeyType>::RuleList*
+PoliciesByKeyMap<KeyType>::get_rules_for_key(const KeyType& key) const {
   auto iter = rules_by_key_.find(key);
   if (iter == rules_by_key_.end()) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+template <typename KeyType>
+bool PoliciesByKeyMap<KeyType>::get_rule_ids_for_key(
+    const KeyType& key,
+    std::vector<std::string>& rules_out) const {
+  auto rules = get_rules_for_key(key);
+  if (rules == nullptr) {
     return false;
   }
 
-  for (const auto& rule : iter->second) {
+  for (const auto& rule : *rules) {
     rules_out.push_back(rule->id());
   }
   return true;
@@ -63,79 +73,72 @@ bool PoliciesByKeyMap<KeyType>::get_rule_ids_for_key(
 template <typename KeyType>
 bool PoliciesByKeyMap<KeyType>::get_rule_definitions_for_key(
     const KeyType& key,
-    std::vector<PolicyRule>& rules_out) {
-  auto iter = rules_by_key_.find(key);
-  if (iter == rules_by_key_.end()) {
+    std::vector<PolicyRule>& rules_out) const {
+  auto rules = get_rules_for_key(key);
+  if (rules == nullptr) {
     return false;
   }
 
-  for (const auto& rule : iter->second) {
+  for (const auto& rule : *rules) {
     rules_out.push_back(*rule);
   }
   return true;
 }
 
-static bool should_track_charging_key(PolicyRule::TrackingType tracking_type) {
+template class PoliciesByKeyMap<uint32_t>;
+template class PoliciesByKeyMap<std::string>;
+
+bool should_track_charging_key(PolicyRule::TrackingType tracking_type) {
   return tracking_type == PolicyRule::ONLY_OCS ||
     tracking_type == PolicyRule::OCS_AND_PCRF;
 }
 
-static bool should_track_monitoring_key(
-    PolicyRule::TrackingType tracking_type) {
+bool should_track_monitoring_key(PolicyRule::TrackingType tracking_type) {
   return tracking_type == PolicyRule::ONLY_PCRF ||
     tracking_type == PolicyRule::OCS_AND_PCRF;
 }
 
-void PolicyRuleBiMap::sync_rules(const std::vector<PolicyRule>& rules) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  rules_by_rule_id_.clear();
-  rules_by_charging_key_ = PoliciesByKeyMap<uint32_t>();
-  rules_by_monitoring_key_ = PoliciesByKeyMap<std::string>();
-  for (const auto& rule : rules) {
-    auto rule_p = std::make_shared<PolicyRule>(rule);
-    rules_by_rule_id_[rule.id()] = rule_p;
-    if (should_track_charging_key(rule.tracking_type())) {
-      rules_by_charging_key_.insert(rule.rating_group(), rule_p);
-    }
-    if (should_track_monitoring_key(rule.tracking_type())) {
-      rules_by_monitoring_key_.insert(rule.monitoring_key(), rule_p);
-    }
+const PolicyRule* PolicyRuleSnapshot::get_rule(
+    const std::string& rule_id) const {
+  auto it = rules_by_rule_id_.find(rule_id);
+  if (it == rules_by_rule_id_.end()) {
+    return nullptr;
   }
+  return it->second.get();
 }
 
-void PolicyRuleBiMap::insert_rule(const PolicyRule& rule) {
-  auto rule_p = std::make_shared<PolicyRule>(rule);
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  rules_by_rule_id_[rule.id()] = rule_p;
-  if (should_track_charging_key(rule.tracking_type())) {
-    rules_by_charging_key_.insert(rule.rating_group(), rule_p);
-  }
-  if (should_track_monitoring_key(rule.tracking_type())) {
-    rules_by_monitoring_key_.insert(rule.monitoring_key(), rule_p);
-  }
+const std::unordered_map<std::string, std::shared_ptr<const PolicyRule>>&
+PolicyRuleSnapshot::get_rules_by_id() const {
+  return rules_by_rule_id_;
 }
 
-bool PolicyRuleBiMap::get_rule(const std::string& rule_id, PolicyRule* rule) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  auto it = rules_by_rule_id_.find(rule_id);
-  if (it == rules_by_rule_id_.end()) {
-    return false;
+const PoliciesByKeyMap<uint32_t>&
+PolicyRuleSnapshot::get_rules_by_charging_key() const {
+  return rules_by_charging_key_;
+}
+
+const PoliciesByKeyMap<std::string>&
+PolicyRuleSnapshot::get_rules_by_monitoring_key() const {
+  return rules_by_monitoring_key_;
+}
+
+void PolicyRuleSnapshot::insert(std::shared_ptr<const PolicyRule> rule_p) {
+  rules_by_rule_id_[rule_p->id()] = rule_p;
+  if (should_track_charging_key(rule_p->tracking_type())) {
+    rules_by_charging_key_.insert(rule_p->rating_group(), rule_p);
+  }
+  if (should_track_monitoring_key(rule_p->tracking_type())) {
+    rules_by_monitoring_key_.insert(rule_p->monitoring_key(), rule_p);
   }
-  rule->CopyFrom(*it->second);
-  return true;
 }
 
-bool PolicyRuleBiMap::remove_rule(const std::string& rule_id, PolicyRule* rule_out) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
+std::shared_ptr<const PolicyRule> PolicyRuleSnapshot::remove(
+    const std::string& rule_id) {
   auto it = rules_by_rule_id_.find(rule_id);
   if (it == rules_by_rule_id_.end()) {
-    return false;
+    return nullptr;
   }
-
   auto rule_ptr = it->second;
-  rule_out->CopyFrom(*rule_ptr);
-
-  // Remove the rule from all mappings
   rules_by_rule_id_.erase(it);
   if (should_track_charging_key(rule_ptr->tracking_type())) {
     rules_by_charging_key_.remove(rule_ptr->rating_group(), rule_ptr);
@@ -143,20 +146,94 @@ bool PolicyRuleBiMap::remove_rule(const std::string& rule_id, PolicyRule* rule_o
   if (should_track_monitoring_key(rule_ptr->tracking_type())) {
     rules_by_monitoring_key_.remove(rule_ptr->monitoring_key(), rule_ptr);
   }
+  return rule_ptr;
+}
+
+PolicyRuleBiMap::PolicyRuleBiMap()
+  : snapshot_(std::make_shared<const PolicyRuleSnapshot>()) {}
+
+std::shared_ptr<const PolicyRuleSnapshot> PolicyRuleBiMap::get_snapshot()
+    const {
+  return std::atomic_load(&snapshot_);
+}
+
+void PolicyRuleBiMap::publish(
+    std::shared_ptr<const PolicyRuleSnapshot> snapshot) {
+  std::atomic_store(&snapshot_, std::move(snapshot));
+}
+
+void PolicyRuleBiMap::sync_rules(const std::vector<PolicyRule>& rules) {
+  auto snapshot = std::make_shared<PolicyRuleSnapshot>();
+  for (const auto& rule : rules) {
+    snapshot->insert(std::make_shared<const PolicyRule>(rule));
+  }
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  publish(std::move(snapshot));
+}
+
+void PolicyRuleBiMap::apply_rule_changes(
+    const std::vector<PolicyRule>& updated_rules,
+    const std::vector<std::string>& removed_rule_ids) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  // Copying the snapshot only copies the indices, the rules are shared
+  auto snapshot = std::make_shared<PolicyRuleSnapshot>(*get_snapshot());
+  for (const auto& rule_id : removed_rule_ids) {
+    snapshot->remove(rule_id);
+  }
+  for (const auto& rule : updated_rules) {
+    snapshot->remove(rule.id());
+    snapshot->insert(std::make_shared<const PolicyRule>(rule));
+  }
+  publish(std::move(snapshot));
+}
+
+void PolicyRuleBiMap::insert_rule(const PolicyRule& rule) {
+  auto rule_p = std::make_shared<const PolicyRule>(rule);
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  auto snapshot = std::make_shared<PolicyRuleSnapshot>(*get_snapshot());
+  snapshot->insert(rule_p);
+  publish(std::move(snapshot));
+}
 
+bool PolicyRuleBiMap::get_rule(const std::string& rule_id, PolicyRule* rule) {
+  auto rule_p = get_snapshot()->get_rule(rule_id);
+  if (rule_p == nullptr) {
+    return false;
+  }
+  rule->CopyFrom(*rule_p);
+  return true;
+}
+
+void PolicyRuleBiMap::get_rules(std::vector<PolicyRule>& rules_out) {
+  auto snapshot = get_snapshot();
+  for (const auto& rule_pair : snapshot->get_rules_by_id()) {
+    rules_out.push_back(*rule_pair.second);
+  }
+}
+
+bool PolicyRuleBiMap::remove_rule(const std::string& rule_id, PolicyRule* rule_out) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  auto current = get_snapshot();
+  if (current->get_rule(rule_id) == nullptr) {
+    return false;
+  }
+  auto snapshot = std::make_shared<PolicyRuleSnapshot>(*current);
+  auto rule_ptr = snapshot->remove(rule_id);
+  rule_out->CopyFrom(*rule_ptr);
+  publish(std::move(snapshot));
   return true;
 }
 
 bool PolicyRuleBiMap::get_charging_key_for_rule_id(
     const std::string& rule_id,
     uint32_t* charging_key) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  auto it = rules_by_rule_id_.find(rule_id);
-  if (it == rules_by_rule_id_.end()) {
+  auto snapshot = get_snapshot();
+  auto rule_p = snapshot->get_rule(rule_id);
+  if (rule_p == nullptr) {
     return false;
   }
-  if (should_track_charging_key(it->second->tracking_type())) {
-    *charging_key = it->second->rating_group();
+  if (should_track_charging_key(rule_p->tracking_type())) {
+    *charging_key = rule_p->rating_group();
     return true;
   }
   return false;
@@ -165,13 +242,13 @@ bool PolicyRuleBiMap::get_charging_key_for_rule_id(
 bool PolicyRuleBiMap::get_monitoring_key_for_rule_id(
     const std::string& rule_id,
     std::string* monitoring_key) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  auto it = rules_by_rule_id_.find(rule_id);
-  if (it == rules_by_rule_id_.end()) {
+  auto snapshot = get_snapshot();
+  auto rule_p = snapshot->get_rule(rule_id);
+  if (rule_p == nullptr) {
     return false;
   }
-  if (should_track_monitoring_key(it->second->tracking_type())) {
-    monitoring_key->assign(it->second->monitoring_key());
+  if (should_track_monitoring_key(rule_p->tracking_type())) {
+    monitoring_key->assign(rule_p->monitoring_key());
     return true;
   }
   return false;
@@ -180,37 +257,29 @@ bool PolicyRuleBiMap::get_monitoring_key_for_rule_id(
 bool PolicyRuleBiMap::get_rule_ids_for_charging_key(
     uint32_t charging_key,
     std::vector<std::string>& rules_out) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  bool success = rules_by_charging_key_.get_rule_ids_for_key(
+  return get_snapshot()->get_rules_by_charging_key().get_rule_ids_for_key(
     charging_key, rules_out);
-  return success;
 }
 
 bool PolicyRuleBiMap::get_rule_definitions_for_charging_key(
     uint32_t charging_key,
     std::vector<PolicyRule>& rules_out) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  bool success = rules_by_charging_key_.get_rule_definitions_for_key(
-    charging_key, rules_out);
-  return success;
+  return get_snapshot()->get_rules_by_charging_key()
+    .get_rule_definitions_for_key(charging_key, rules_out);
 }
 
 bool PolicyRuleBiMap::get_rule_ids_for_monitoring_key(
     const std::string& monitoring_key,
     std::vector<std::string>& rules_out) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  bool success = rules_by_monitoring_key_.get_rule_ids_for_key(
+  return get_snapshot()->get_rules_by_monitoring_key().get_rule_ids_for_key(
     monitoring_key, rules_out);
-  return success;
 }
 
 bool PolicyRuleBiMap::get_rule_definitions_for_monitoring_key(
     const std::string& monitoring_key,
     std::vector<PolicyRule>& rules_out) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  bool success = rules_by_monitoring_key_.get_rule_definitions_for_key(
-    monitoring_key, rules_out);
-  return success;
+  return get_snapshot()->get_rules_by_monitoring_key()
+    .get_rule_definitions_for_key(monitoring_key, rules_out);
 }
 
 }
@@ -8,8 +8,10 @@
  */
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <lte/protos/policydb.pb.h>
 #include <lte/protos/pipelined.grpc.pb.h>
@@ -27,37 +29,107 @@ using namespace lte;
 template <typename KeyType>
 class PoliciesByKeyMap {
 public:
-  void insert(const KeyType& key, std::shared_ptr<PolicyRule> rule_p);
+  using RuleList = std::vector<std::shared_ptr<const PolicyRule>>;
 
-  void remove(const KeyType& key, std::shared_ptr<PolicyRule> rule_p);
+  void insert(const KeyType& key, std::shared_ptr<const PolicyRule> rule_p);
+
+  void remove(const KeyType& key, std::shared_ptr<const PolicyRule> rule_p);
+
+  /**
+   * Get the rules tracked with the key without copying them
+   * @returns nullptr if no rule is tracked with the key
+   */
+  const RuleList* get_rules_for_key(const KeyType& key) const;
 
   bool get_rule_ids_for_key(
     const KeyType& key,
-    std::vector<std::string>& rules_out);
+    std::vector<std::string>& rules_out) const;
 
   bool get_rule_definitions_for_key(
     const KeyType& key,
-    std::vector<PolicyRule>& rules_out);
+    std::vector<PolicyRule>& rules_out) const;
 private:
-  std::unordered_map<KeyType, std::vector<std::shared_ptr<PolicyRule>>>
-    rules_by_key_;
+  std::unordered_map<KeyType, RuleList> rules_by_key_;
+};
+
+/**
+ * PolicyRuleSnapshot is an immutable view of the rules of a PolicyRuleBiMap.
+ * Readers keep the snapshot for as long as they use the rules in it, while
+ * changes to the store publish a new snapshot. Rules are shared between the
+ * indices and between successive snapshots, never copied.
+ */
+class PolicyRuleSnapshot {
+public:
+  /**
+   * Get a rule without copying it
+   * @returns nullptr if no rule has the ID
+   */
+  const PolicyRule* get_rule(const std::string& rule_id) const;
+
+  const std::unordered_map<std::string, std::shared_ptr<const PolicyRule>>&
+  get_rules_by_id() const;
+
+  const PoliciesByKeyMap<uint32_t>& get_rules_by_charging_key() const;
+
+  const PoliciesByKeyMap<std::string>& get_rules_by_monitoring_key() const;
+
+private:
+  friend class PolicyRuleBiMap;
+
+  // rule_id -> PolicyRule
+  std::unordered_map<std::string, std::shared_ptr<const PolicyRule>>
+    rules_by_rule_id_;
+  // charging key -> [PolicyRule]
+  PoliciesByKeyMap<uint32_t> rules_by_charging_key_;
+  // monitoring key -> [PolicyRule]
+  PoliciesByKeyMap<std::string> rules_by_monitoring_key_;
+
+private:
+  void insert(std::shared_ptr<const PolicyRule> rule_p);
+
+  std::shared_ptr<const PolicyRule> remove(const std::string& rule_id);
 };
 
 /**
  * RuleChargingKeyMapper is a class for querying a bi-directional map of
  * rule_id <-> charging_key
+ *
+ * Reads never lock: they load the current snapshot, which writers replace
+ * atomically after applying their changes to a copy of it. Writers only
+ * contend with each other.
  */
 class PolicyRuleBiMap {
 public:
+  PolicyRuleBiMap();
+
+  /**
+   * Get the current snapshot of the rules, to look up several rules without
+   * copying them. The snapshot does not see changes made after this call
+   */
+  std::shared_ptr<const PolicyRuleSnapshot> get_snapshot() const;
+
   /**
    * Clear the maps and add in the given rules
    */
   virtual void sync_rules(const std::vector<PolicyRule>& rules);
 
+  /**
+   * Apply the changes of a sync: add or replace the updated rules, and remove
+   * the rules with the removed IDs. Only the changed rules are touched
+   */
+  virtual void apply_rule_changes(
+    const std::vector<PolicyRule>& updated_rules,
+    const std::vector<std::string>& removed_rule_ids);
+
   virtual void insert_rule(const PolicyRule& rule);
 
   virtual bool get_rule(const std::string& rule_id, PolicyRule* rule);
 
+  /**
+   * Copy all the rules of the store into rules_out
+   */
+  virtual void get_rules(std::vector<PolicyRule>& rules_out);
+
   // Remove a rule from the store by ID. Returns true if the rule ID was found.
   // The removed rule will be copied into rule_out
   virtual bool remove_rule(const std::string& rule_id, PolicyRule* rule_out);
@@ -98,14 +170,16 @@ public:
     std::vector<PolicyRule>& rules_out);
 
 protected:
-  std::mutex map_mutex_;
-  // rule_id -> PolicyRule
-  std::unordered_map<std::string, std::shared_ptr<PolicyRule>>
-    rules_by_rule_id_;
-  // charging key -> [PolicyRule]
-  PoliciesByKeyMap<uint32_t> rules_by_charging_key_;
-  // monitoring key -> [PolicyRule]
-  PoliciesByKeyMap<std::string> rules_by_monitoring_key_;
+  // Serializes the writers, readers never take it
+  std::mutex write_mutex_;
+  // Only accessed through std::atomic_load and std::atomic_store
+  std::shared_ptr<const PolicyRuleSnapshot> snapshot_;
+
+private:
+  /**
+   * Publish a snapshot. Expects write_mutex_ to be held
+   */
+  void publish(std::shared_ptr<const PolicyRuleSnapshot> snapshot);
 };
 
 /**
@@ -118,4 +192,11 @@ class StaticRuleStore : public PolicyRuleBiMap {};
  */
 class DynamicRuleStore : public PolicyRuleBiMap {};
 
+/**
+ * Charging and monitoring keys of a rule, as tracked by its tracking type
+ */
+bool should_track_charging_key(PolicyRule::TrackingType tracking_type);
+
+bool should_track_monitoring_key(PolicyRule::TrackingType tracking_type);
+
 }
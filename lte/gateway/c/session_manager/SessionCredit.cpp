@@ -19,14 +19,44 @@ uint64_t SessionCredit::USAGE_REPORTING_LIMIT =
 
 SessionCredit::SessionCredit(ServiceState start_state)
   : reporting_(false),
+    is_final_(false),
     reauth_state_(REAUTH_NOT_NEEDED),
     service_state_(start_state),
+    expiry_time_(std::numeric_limits<std::time_t>::max()),
     buckets_{} {}
 
 // by default, enable service
 SessionCredit::SessionCredit()
   : SessionCredit(SERVICE_ENABLED) {}
 
+SessionCredit SessionCredit::unmarshal(
+    const StoredSessionCredit& marshaled) {
+  SessionCredit credit(static_cast<ServiceState>(marshaled.service_state()));
+  credit.is_final_ = marshaled.is_final();
+  credit.reauth_state_ = static_cast<ReAuthState>(marshaled.reauth_state());
+  if (credit.reauth_state_ == REAUTH_PROCESSING) {
+    credit.reauth_state_ = REAUTH_REQUIRED;
+  }
+  credit.expiry_time_ = marshaled.expiry_time();
+  for (int i = 0; i < marshaled.buckets_size() && i < MAX_VALUES; i++) {
+    credit.buckets_[i] = marshaled.buckets(i);
+  }
+  credit.reset_reporting_credit();
+  return credit;
+}
+
+StoredSessionCredit SessionCredit::marshal() const {
+  StoredSessionCredit marshaled;
+  marshaled.set_is_final(is_final_);
+  marshaled.set_reauth_state(reauth_state_);
+  marshaled.set_service_state(service_state_);
+  marshaled.set_expiry_time(expiry_time_);
+  for (int i = 0; i < MAX_VALUES; i++) {
+    marshaled.add_buckets(buckets_[i]);
+  }
+  return marshaled;
+}
+
 void SessionCredit::set_expiry_time(uint32_t validity_time) {
   if (validity_time == 0) {
     // set as max possible time
@@ -208,6 +238,10 @@ uint64_t SessionCredit::get_credit(Bucket bucket) const {
   return buckets_[bucket];
 }
 
+std::time_t SessionCredit::get_expiry_time() const {
+  return expiry_time_;
+}
+
 bool SessionCredit::is_reauth_required() {
   return reauth_state_ == REAUTH_REQUIRED;
 }
@@ -13,6 +13,7 @@
 #include <memory>
 
 #include <lte/protos/session_manager.grpc.pb.h>
+#include <lte/protos/session_state.pb.h>
 
 #include "ServiceAction.h"
 
@@ -72,6 +73,18 @@ public:
 
   SessionCredit(ServiceState start_state);
 
+  /**
+   * unmarshal rebuilds a credit from its stored state. A credit update that
+   * was in flight when the state was stored is lost, so the credit is
+   * restored as not reporting to report this usage again.
+   */
+  static SessionCredit unmarshal(const StoredSessionCredit& marshaled);
+
+  /**
+   * marshal returns the state of the credit to be stored
+   */
+  StoredSessionCredit marshal() const;
+
   /**
    * add_used_credit increments USED_TX and USED_RX
    * as being recently updated
@@ -132,6 +145,11 @@ public:
    */
   uint64_t get_credit(Bucket bucket) const;
 
+  /**
+   * Time at which the validity timer expires, max time_t if there is none
+   */
+  std::time_t get_expiry_time() const;
+
   /**
    * Mark the credit to be in the REAUTH_REQUIRED state. The next time
    * get_update is called, this credit will report its usage.
@@ -68,7 +68,11 @@ AsyncGRPCRequest<GRPCService, RequestType, ResponseType>::
 AsyncGRPCRequest(
     ServerCompletionQueue* cq,
     GRPCService& service
-  ) : cq_(cq), service_(service), status_(PROCESS), responder_(&ctx_) {}
+  ) : cq_(cq),
+      service_(service),
+      status_(PROCESS),
+      request_(google::protobuf::Arena::CreateMessage<RequestType>(&arena_)),
+      responder_(&ctx_) {}
 
 template<class GRPCService, class RequestType, class ResponseType>
 void AsyncGRPCRequest<GRPCService, RequestType, ResponseType>::proceed() {
@@ -7,6 +7,7 @@
  * of patent rights can be found in the PATENTS file in the same directory.
  */
 #pragma once
+#include <google/protobuf/arena.h>
 #include <grpc++/grpc++.h>
 #include <lte/protos/session_manager.grpc.pb.h>
 
@@ -138,7 +139,10 @@ protected:
   enum CallStatus { PROCESS, FINISH };
   CallStatus status_;
 
-  RequestType request_;
+  // The request is parsed in the arena of the call, so that all its fields are
+  // freed at once when the call is done
+  google::protobuf::Arena arena_;
+  RequestType* request_;
   grpc::ServerAsyncResponseWriter<ResponseType> responder_;
 
   GRPCService& service_;
@@ -180,7 +184,7 @@ public:
     // of this instance. When the request is completed, it will be added to
     // cq_ again to be finished
     service_.RequestReportRuleStats(
-      &ctx_, &request_, &responder_, cq_, cq_, (void*)this);
+      &ctx_, request_, &responder_, cq_, cq_, (void*)this);
   }
 protected:
   void clone() override {
@@ -191,7 +195,7 @@ protected:
 
   void process() override {
     // Get a response from a handler and call the finish callback
-    handler_.ReportRuleStats(&ctx_, &request_, get_finish_callback());
+    handler_.ReportRuleStats(&ctx_, request_, get_finish_callback());
   }
 private:
   LocalSessionManagerHandler& handler_;
@@ -213,7 +217,7 @@ public:
       LocalSessionManagerHandler& handler)
       : AsyncGRPCRequest(cq, service), handler_(handler) {
     service_.RequestCreateSession(
-      &ctx_, &request_, &responder_, cq_, cq_, (void*)this);
+      &ctx_, request_, &responder_, cq_, cq_, (void*)this);
   }
 
 protected:
@@ -222,7 +226,7 @@ protected:
   }
 
   void process() override {
-    handler_.CreateSession(&ctx_, &request_, get_finish_callback());
+    handler_.CreateSession(&ctx_, request_, get_finish_callback());
   }
 private:
   LocalSessionManagerHandler& handler_;
@@ -244,7 +248,7 @@ public:
       LocalSessionManagerHandler& handler)
       : AsyncGRPCRequest(cq, service), handler_(handler) {
     service_.RequestEndSession(
-      &ctx_, &request_, &responder_, cq_, cq_, (void*)this);
+      &ctx_, request_, &responder_, cq_, cq_, (void*)this);
   }
 
 protected:
@@ -253,7 +257,7 @@ protected:
   }
 
   void process() override {
-    handler_.EndSession(&ctx_, &request_, get_finish_callback());
+    handler_.EndSession(&ctx_, request_, get_finish_callback());
   }
 private:
   LocalSessionManagerHandler& handler_;
@@ -275,7 +279,7 @@ public:
       SessionProxyResponderHandler& handler)
       : AsyncGRPCRequest(cq, service), handler_(handler) {
     service_.RequestChargingReAuth(
-      &ctx_, &request_, &responder_, cq_, cq_, (void*)this);
+      &ctx_, request_, &responder_, cq_, cq_, (void*)this);
   }
 
 protected:
@@ -284,7 +288,7 @@ protected:
   }
 
   void process() override {
-    handler_.ChargingReAuth(&ctx_, &request_, get_finish_callback());
+    handler_.ChargingReAuth(&ctx_, request_, get_finish_callback());
   }
 private:
   SessionProxyResponderHandler& handler_;
@@ -307,7 +311,7 @@ public:
       SessionProxyResponderHandler& handler)
       : AsyncGRPCRequest(cq, service), handler_(handler) {
     service_.RequestPolicyReAuth(
-      &ctx_, &request_, &responder_, cq_, cq_, (void*)this);
+      &ctx_, request_, &responder_, cq_, cq_, (void*)this);
   }
 
 protected:
@@ -316,7 +320,7 @@ protected:
   }
 
   void process() override {
-    handler_.PolicyReAuth(&ctx_, &request_, get_finish_callback());
+    handler_.PolicyReAuth(&ctx_, request_, get_finish_callback());
   }
 private:
   SessionProxyResponderHandler& handler_;
@@ -17,16 +17,16 @@ using grpc::Status;
 namespace magma {
 
 SessionProxyResponderHandlerImpl::SessionProxyResponderHandlerImpl(
-  LocalEnforcer* enforcer) : enforcer_(enforcer) {}
+  ShardedEnforcer* enforcer) : enforcer_(enforcer) {}
 
 void SessionProxyResponderHandlerImpl::ChargingReAuth(
     ServerContext* context,
     const ChargingReAuthRequest* request,
     std::function<void(Status, ChargingReAuthAnswer)> response_callback) {
-  auto& request_cpy = *request;
-  enforcer_->get_event_base().runInEventBaseThread(
-    [this, request_cpy, response_callback]() {
-      auto result = enforcer_->init_charging_reauth(request_cpy);
+  // The request lives in the arena of the call until the response is sent
+  enforcer_->run_in_shard(request->sid(),
+    [request, response_callback](LocalEnforcer& shard) {
+      auto result = shard.init_charging_reauth(*request);
       ChargingReAuthAnswer ans;
       ans.set_result(result);
       response_callback(Status::OK, ans);
@@ -38,11 +38,10 @@ void SessionProxyResponderHandlerImpl::PolicyReAuth(
     ServerContext* context,
     const PolicyReAuthRequest* request,
     std::function<void(Status, PolicyReAuthAnswer)> response_callback) {
-  auto& request_cpy = *request;
-  enforcer_->get_event_base().runInEventBaseThread(
-    [this, request_cpy, response_callback]() {
+  enforcer_->run_in_shard(request->imsi(),
+    [request, response_callback](LocalEnforcer& shard) {
       PolicyReAuthAnswer ans;
-      enforcer_->init_policy_reauth(request_cpy, ans);
+      shard.init_policy_reauth(*request, ans);
       response_callback(Status::OK, ans);
     }
   );
@@ -13,7 +13,7 @@
 #include <grpc++/grpc++.h>
 #include <lte/protos/session_manager.grpc.pb.h>
 
-#include "LocalEnforcer.h"
+#include "ShardedEnforcer.h"
 
 using grpc::ServerContext;
 using grpc::Status;
@@ -47,7 +47,7 @@ public:
  */
 class SessionProxyResponderHandlerImpl : public SessionProxyResponderHandler {
 public:
-  SessionProxyResponderHandlerImpl(LocalEnforcer* monitor);
+  SessionProxyResponderHandlerImpl(ShardedEnforcer* enforcer);
 
   ~SessionProxyResponderHandlerImpl() {}
 
@@ -69,7 +69,7 @@ public:
       std::function<void(Status, PolicyReAuthAnswer)> response_callback);
 
 private:
-  LocalEnforcer* enforcer_;
+  ShardedEnforcer* enforcer_;
 };
 
 }
@@ -49,30 +49,60 @@ bool SessionRules::remove_dynamic_rule(
   return dynamic_rules_.remove_rule(rule_id, rule_out);
 }
 
+void SessionRules::get_dynamic_rules(std::vector<PolicyRule>& rules_out) {
+  dynamic_rules_.get_rules(rules_out);
+}
+
 /**
- * For the charging key, get any applicable rules from the static rule set
- * and the dynamic rule set
+ * Add the rules tracked with key in the snapshots of the stores to the action.
+ * Static rules are added by ID. The action outlives the snapshots, so the
+ * dynamic rules are copied into it, once.
  */
+template <typename KeyType>
+static void add_rules_for_key(
+    ServiceAction& action,
+    const PoliciesByKeyMap<KeyType>& static_rules,
+    const PoliciesByKeyMap<KeyType>& dynamic_rules,
+    const KeyType& key) {
+  auto static_list = static_rules.get_rules_for_key(key);
+  if (static_list != nullptr) {
+    auto rule_ids = action.get_mutable_rule_ids();
+    for (const auto& rule : *static_list) {
+      rule_ids->push_back(rule->id());
+    }
+  }
+  auto dynamic_list = dynamic_rules.get_rules_for_key(key);
+  if (dynamic_list != nullptr) {
+    auto definitions = action.get_mutable_rule_definitions();
+    definitions->reserve(definitions->size() + dynamic_list->size());
+    for (const auto& rule : *dynamic_list) {
+      definitions->push_back(*rule);
+    }
+  }
+}
+
 void SessionRules::add_rules_to_action(
     ServiceAction& action,
     uint32_t charging_key) {
-  static_rules_.get_rule_ids_for_charging_key(
-    charging_key,
-    *action.get_mutable_rule_ids());
-  dynamic_rules_.get_rule_definitions_for_charging_key(
-    charging_key,
-    *action.get_mutable_rule_definitions());
+  auto static_snapshot = static_rules_.get_snapshot();
+  auto dynamic_snapshot = dynamic_rules_.get_snapshot();
+  add_rules_for_key(
+    action,
+    static_snapshot->get_rules_by_charging_key(),
+    dynamic_snapshot->get_rules_by_charging_key(),
+    charging_key);
 }
 
 void SessionRules::add_rules_to_action(
     ServiceAction& action,
     std::string monitoring_key) {
-  static_rules_.get_rule_ids_for_monitoring_key(
-    monitoring_key,
-    *action.get_mutable_rule_ids());
-  dynamic_rules_.get_rule_definitions_for_monitoring_key(
-    monitoring_key,
-    *action.get_mutable_rule_definitions());
+  auto static_snapshot = static_rules_.get_snapshot();
+  auto dynamic_snapshot = dynamic_rules_.get_snapshot();
+  add_rules_for_key(
+    action,
+    static_snapshot->get_rules_by_monitoring_key(),
+    dynamic_snapshot->get_rules_by_monitoring_key(),
+    monitoring_key);
 }
 
 }
@@ -32,6 +32,8 @@ public:
 
   bool remove_dynamic_rule(const std::string& rule_id, PolicyRule* rule_out);
 
+  void get_dynamic_rules(std::vector<PolicyRule>& rules_out);
+
   void add_rules_to_action(ServiceAction& action, uint32_t charging_key);
   void add_rules_to_action(ServiceAction& action, std::string monitoring_key);
 private:
@@ -26,7 +26,55 @@ SessionState::SessionState(
     curr_state_(SESSION_ACTIVE), session_rules_(rule_store),
     charging_pool_(imsi), monitor_pool_(imsi) {}
 
-void SessionState::new_report() {
+std::unique_ptr<SessionState> SessionState::unmarshal(
+    const StoredSessionState& marshaled,
+    StaticRuleStore& rule_store) {
+  const auto& stored_cfg = marshaled.config();
+  SessionState::Config cfg =
+  {.ue_ipv4 = stored_cfg.ue_ipv4(),
+   .spgw_ipv4 = stored_cfg.spgw_ipv4(),
+   .msisdn = stored_cfg.msisdn(),
+   .apn = stored_cfg.apn(),
+   .imei = stored_cfg.imei(),
+   .plmn_id = stored_cfg.plmn_id(),
+   .imsi_plmn_id = stored_cfg.imsi_plmn_id(),
+   .user_location = stored_cfg.user_location()
+  };
+  auto session = std::make_unique<SessionState>(
+    marshaled.imsi(), marshaled.session_id(), cfg, rule_store);
+  session->request_number_ = marshaled.request_number();
+  session->charging_pool_ = ChargingCreditPool::unmarshal(
+    marshaled.imsi(), marshaled.charging_pool());
+  session->monitor_pool_ = UsageMonitoringCreditPool::unmarshal(
+    marshaled.imsi(), marshaled.monitor_pool());
+  for (const auto& rule : marshaled.dynamic_rules()) {
+    session->insert_dynamic_rule(rule);
+  }
+  return session;
+}
+
+StoredSessionState SessionState::marshal() {
+  StoredSessionState marshaled;
+  marshaled.set_imsi(imsi_);
+  marshaled.set_session_id(session_id_);
+  marshaled.set_request_number(request_number_);
+  auto stored_cfg = marshaled.mutable_config();
+  stored_cfg->set_ue_ipv4(config_.ue_ipv4);
+  stored_cfg->set_spgw_ipv4(config_.spgw_ipv4);
+  stored_cfg->set_msisdn(config_.msisdn);
+  stored_cfg->set_apn(config_.apn);
+  stored_cfg->set_imei(config_.imei);
+  stored_cfg->set_plmn_id(config_.plmn_id);
+  stored_cfg->set_imsi_plmn_id(config_.imsi_plmn_id);
+  stored_cfg->set_user_location(config_.user_location);
+  *marshaled.mutable_charging_pool() = charging_pool_.marshal();
+  *marshaled.mutable_monitor_pool() = monitor_pool_.marshal();
+  std::vector<PolicyRule> dynamic_rules;
+  session_rules_.get_dynamic_rules(dynamic_rules);
+  for (const auto& rule : dynamic_rules) {
+    marshaled.add_dynamic_rules()->CopyFrom(rule);
+  }
+  return marshaled;
 }
 
 void SessionState::add_used_credit(
@@ -169,4 +217,12 @@ std::string SessionState::get_subscriber_ip_addr() {
   return config_.ue_ipv4;
 }
 
+bool SessionState::is_active() {
+  return curr_state_ == SESSION_ACTIVE;
+}
+
+std::time_t SessionState::get_next_expiry_time() {
+  return charging_pool_.get_next_expiry_time();
+}
+
 }
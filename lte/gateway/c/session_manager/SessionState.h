@@ -39,10 +39,16 @@ public:
     StaticRuleStore& rule_store);
 
   /**
-   * new_report unmarks all credits before an update, to tell if any credits
-   * were not in the latest report
+   * unmarshal rebuilds an active session from its stored state
    */
-  void new_report();
+  static std::unique_ptr<SessionState> unmarshal(
+    const StoredSessionState& marshaled,
+    StaticRuleStore& rule_store);
+
+  /**
+   * marshal returns the state of the session to be stored
+   */
+  StoredSessionState marshal();
 
   /**
    * add_used_credit adds used TX/RX bytes to a particular charging key
@@ -80,6 +86,16 @@ public:
 
   std::string get_subscriber_ip_addr();
 
+  /**
+   * Returns false once the session started terminating
+   */
+  bool is_active();
+
+  /**
+   * Returns the earliest validity timer expiry of the charging credits
+   */
+  std::time_t get_next_expiry_time();
+
 
 private:
   enum State {
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <chrono>
+#include <thread>
+
+#include "SessionStore.h"
+#include "Serializers.h"
+#include "ServiceConfigLoader.h"
+#include "magma_logging.h"
+
+namespace magma {
+
+SessionStore::SessionStore(std::shared_ptr<cpp_redis::client> client)
+  : client_(client),
+    session_map_(
+      client,
+      "sessiond:sessions",
+      get_proto_serializer(),
+      get_proto_deserializer()),
+    is_running_(true) {}
+
+bool SessionStore::try_redis_connect() {
+  if (client_->is_connected()) {
+    return true;
+  }
+  ServiceConfigLoader loader;
+  auto config = loader.load_service_config("redis");
+  auto port = config["port"].as<uint32_t>();
+  try {
+    client_->connect("127.0.0.1", port, [](
+        const std::string& host,
+        std::size_t port,
+        cpp_redis::client::connect_state status) {
+      if (status == cpp_redis::client::connect_state::dropped) {
+        MLOG(MERROR) << "Session store disconnected from " << host << ":"
+          << port;
+      }
+    });
+    return client_->is_connected();
+  } catch (const cpp_redis::redis_error& e) {
+    MLOG(MERROR) << "Session store could not connect to redis: " << e.what();
+    return false;
+  }
+}
+
+std::vector<StoredSessionState> SessionStore::read_sessions() {
+  std::vector<StoredSessionState> sessions;
+  if (!try_redis_connect()) {
+    MLOG(MERROR) << "Could not read stored sessions, starting without them";
+    return sessions;
+  }
+  std::vector<std::string> failed_keys;
+  auto result = session_map_.getall(sessions, &failed_keys);
+  if (result != SUCCESS) {
+    MLOG(MERROR) << "Failed to read stored sessions because map error "
+      << result;
+    return sessions;
+  }
+  for (const auto& imsi : failed_keys) {
+    MLOG(MERROR) << "Dropping unreadable stored session for " << imsi;
+    session_map_.remove(imsi);
+  }
+  MLOG(MINFO) << "Read " << sessions.size() << " stored sessions";
+  return sessions;
+}
+
+void SessionStore::write_session(StoredSessionState&& session) {
+  auto imsi = session.imsi();
+  auto session_p = std::make_unique<StoredSessionState>(std::move(session));
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_[imsi] = std::move(session_p);
+  }
+  queue_cv_.notify_one();
+}
+
+void SessionStore::remove_session(const std::string& imsi) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_[imsi] = nullptr;
+  }
+  queue_cv_.notify_one();
+}
+
+bool SessionStore::write_changes(const SessionChanges& changes) {
+  if (!try_redis_connect()) {
+    return false;
+  }
+  // Write the whole batch in two commands instead of one per session
+  std::unordered_map<std::string, StoredSessionState> writes;
+  std::vector<std::string> removals;
+  for (const auto& change : changes) {
+    if (change.second == nullptr) {
+      removals.push_back(change.first);
+    } else {
+      writes.emplace(change.first, *change.second);
+    }
+  }
+  try {
+    auto result = session_map_.multi_set(writes);
+    if (result != SUCCESS) {
+      MLOG(MERROR) << "Failed to store " << writes.size()
+        << " sessions because map error " << result;
+    }
+    result = session_map_.multi_remove(removals);
+    if (result != SUCCESS) {
+      MLOG(MERROR) << "Failed to remove " << removals.size()
+        << " sessions because map error " << result;
+    }
+  } catch (const cpp_redis::redis_error& e) {
+    // Connection lost, writing the changes again is harmless
+    MLOG(MERROR) << "Session store could not write to redis: " << e.what();
+    return false;
+  }
+  return true;
+}
+
+void SessionStore::write_loop() {
+  while (true) {
+    SessionChanges changes;
+    bool is_running;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this] { return !queue_.empty() || !is_running_; });
+      if (queue_.empty()) {
+        return;
+      }
+      changes.swap(queue_);
+      is_running = is_running_;
+    }
+    if (write_changes(changes)) {
+      continue;
+    }
+    if (!is_running) {
+      MLOG(MERROR) << "Dropping " << changes.size()
+        << " session changes, redis is unreachable";
+      return;
+    }
+    {
+      // Put the changes back, unless a newer change of the session is queued
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      for (auto& change : changes) {
+        queue_.emplace(change.first, std::move(change.second));
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(RECONNECT_INTERVAL_SEC));
+  }
+}
+
+void SessionStore::stop() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    is_running_ = false;
+  }
+  queue_cv_.notify_one();
+}
+
+std::vector<std::string> find_detached_sessions(
+    const std::vector<StoredSessionState>& sessions,
+    const std::unordered_map<std::string, std::string>& ipv4_by_imsi) {
+  static const std::string IMSI_PREFIX = "IMSI";
+  std::vector<std::string> detached;
+  for (const auto& session : sessions) {
+    auto imsi = session.imsi();
+    if (imsi.compare(0, IMSI_PREFIX.size(), IMSI_PREFIX) == 0) {
+      imsi = imsi.substr(IMSI_PREFIX.size());
+    }
+    auto it = ipv4_by_imsi.find(imsi);
+    if (it == ipv4_by_imsi.end() ||
+        it->second != session.config().ue_ipv4()) {
+      detached.push_back(session.imsi());
+    }
+  }
+  return detached;
+}
+
+}
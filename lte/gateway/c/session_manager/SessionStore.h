@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lte/protos/session_state.pb.h>
+
+#include "RedisMap.hpp"
+
+namespace magma {
+using namespace lte;
+
+/**
+ * SessionStore persists the state of the sessions in redis, so that sessiond
+ * can restore them after a restart instead of creating them again in the
+ * OCS and PCRF. Writes happen behind the event loop, in the thread running
+ * write_loop. Only the latest queued state of a session is written.
+ */
+class SessionStore {
+public:
+  SessionStore(std::shared_ptr<cpp_redis::client> client);
+
+  /**
+   * Read all the stored sessions. This blocks on redis and is meant to be
+   * called once on startup.
+   */
+  std::vector<StoredSessionState> read_sessions();
+
+  /**
+   * Queue the state of a session to be written, replacing any state of the
+   * same session which was not written yet
+   */
+  void write_session(StoredSessionState&& session);
+
+  /**
+   * Queue the removal of a session from the store
+   */
+  void remove_session(const std::string& imsi);
+
+  /**
+   * Write the queued changes to redis until stop is called. The changes
+   * queued before stop are still written. Blocks
+   */
+  void write_loop();
+
+  void stop();
+
+private:
+  // IMSI -> state to write, nullptr if the session has to be removed
+  using SessionChanges =
+    std::unordered_map<std::string, std::unique_ptr<StoredSessionState>>;
+
+  static const int RECONNECT_INTERVAL_SEC = 1;
+
+  std::shared_ptr<cpp_redis::client> client_;
+  RedisMap<StoredSessionState> session_map_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  SessionChanges queue_;
+  bool is_running_;
+
+private:
+  bool try_redis_connect();
+
+  /**
+   * Write changes to redis. Returns false if redis could not be reached, in
+   * which case the changes have to be written again
+   */
+  bool write_changes(const SessionChanges& changes);
+};
+
+/**
+ * Get the IMSIs of the stored sessions whose UE detached while sessiond was
+ * down: mobilityd no longer allocates the IP of the session to the UE.
+ * @param ipv4_by_imsi - IPs allocated by mobilityd, by IMSI without the
+ *   "IMSI" prefix of the sessiond IMSIs
+ */
+std::vector<std::string> find_detached_sessions(
+  const std::vector<StoredSessionState>& sessions,
+  const std::unordered_map<std::string, std::string>& ipv4_by_imsi);
+
+}
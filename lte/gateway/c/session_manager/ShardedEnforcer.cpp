@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "ShardedEnforcer.h"
+#include "magma_logging.h"
+
+namespace magma {
+
+ShardedEnforcer::ShardedEnforcer(
+    size_t num_shards,
+    std::shared_ptr<StaticRuleStore> rule_store,
+    std::shared_ptr<PipelinedClient> pipelined_client) {
+  for (size_t i = 0; i < std::max(num_shards, (size_t) 1); i++) {
+    auto evb = std::make_unique<folly::EventBase>();
+    auto shard = std::make_shared<LocalEnforcer>(rule_store, pipelined_client);
+    shard->attachEventBase(evb.get());
+    event_bases_.push_back(std::move(evb));
+    shards_.push_back(shard);
+  }
+}
+
+ShardedEnforcer::ShardedEnforcer(
+    std::vector<std::shared_ptr<LocalEnforcer>> shards)
+  : shards_(shards) {}
+
+size_t ShardedEnforcer::get_num_shards() const {
+  return shards_.size();
+}
+
+size_t ShardedEnforcer::get_shard_index(const std::string& imsi) const {
+  return std::hash<std::string>()(imsi) % shards_.size();
+}
+
+LocalEnforcer& ShardedEnforcer::get_shard(size_t index) {
+  return *shards_[index];
+}
+
+LocalEnforcer& ShardedEnforcer::get_shard_for_imsi(const std::string& imsi) {
+  return *shards_[get_shard_index(imsi)];
+}
+
+void ShardedEnforcer::run_in_shard(
+    const std::string& imsi,
+    std::function<void(LocalEnforcer&)> fn) {
+  auto shard = shards_[get_shard_index(imsi)];
+  shard->get_event_base().runInEventBaseThread([shard, fn]() {
+    fn(*shard);
+  });
+}
+
+void ShardedEnforcer::attachSessionStore(
+    std::shared_ptr<SessionStore> session_store,
+    std::chrono::milliseconds save_interval) {
+  for (auto& shard : shards_) {
+    shard->attachSessionStore(session_store, save_interval);
+  }
+}
+
+void ShardedEnforcer::restore_sessions(
+    const std::vector<StoredSessionState>& sessions) {
+  std::vector<std::vector<StoredSessionState>> shard_sessions(shards_.size());
+  for (const auto& session : sessions) {
+    shard_sessions[get_shard_index(session.imsi())].push_back(session);
+  }
+  for (size_t i = 0; i < shards_.size(); i++) {
+    shards_[i]->restore_sessions(shard_sessions[i]);
+  }
+}
+
+void ShardedEnforcer::start() {
+  for (size_t i = 0; i < event_bases_.size(); i++) {
+    auto shard = shards_[i];
+    threads_.emplace_back([shard, i]() {
+      MLOG(MINFO) << "Started enforcer shard " << i;
+      shard->start();
+    });
+  }
+}
+
+void ShardedEnforcer::stop() {
+  for (size_t i = 0; i < event_bases_.size(); i++) {
+    shards_[i]->stop();
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+std::vector<std::vector<const RuleRecord*>> ShardedEnforcer::split_records(
+    const RuleRecordTable& records) const {
+  std::vector<std::vector<const RuleRecord*>> shard_records(shards_.size());
+  for (const auto& record : records.records()) {
+    shard_records[get_shard_index(record.sid())].push_back(&record);
+  }
+  return shard_records;
+}
+
+std::vector<UpdateSessionRequest> ShardedEnforcer::split_request(
+    const UpdateSessionRequest& request) const {
+  std::vector<UpdateSessionRequest> shard_requests(shards_.size());
+  for (const auto& update : request.updates()) {
+    shard_requests[get_shard_index(update.sid())].add_updates()->CopyFrom(
+      update);
+  }
+  for (const auto& update : request.usage_monitors()) {
+    shard_requests[get_shard_index(update.sid())].add_usage_monitors()
+      ->CopyFrom(update);
+  }
+  return shard_requests;
+}
+
+std::vector<UpdateSessionResponse> ShardedEnforcer::split_response(
+    const UpdateSessionResponse& response) const {
+  std::vector<UpdateSessionResponse> shard_responses(shards_.size());
+  for (const auto& credit : response.responses()) {
+    shard_responses[get_shard_index(credit.sid())].add_responses()->CopyFrom(
+      credit);
+  }
+  for (const auto& monitor : response.usage_monitor_responses()) {
+    shard_responses[get_shard_index(monitor.sid())]
+      .add_usage_monitor_responses()->CopyFrom(monitor);
+  }
+  return shard_responses;
+}
+
+void ShardedEnforcer::set_on_updates_due(
+    std::function<void()> on_updates_due) {
+  for (auto& shard : shards_) {
+    shard->set_on_updates_due(on_updates_due);
+  }
+}
+
+void ShardedEnforcer::aggregate_records(
+    const RuleRecordTable& records,
+    std::function<void()> callback) {
+  if (shards_.size() == 1) {
+    auto shard = shards_[0];
+    shard->get_event_base().runInEventBaseThread(
+      [shard, &records, callback]() {
+        shard->aggregate_records(records);
+        callback();
+      });
+    return;
+  }
+  auto shard_records = std::make_shared<
+    std::vector<std::vector<const RuleRecord*>>>(split_records(records));
+  auto remaining_shards = std::make_shared<std::atomic<size_t>>(0);
+  for (const auto& records_of_shard : *shard_records) {
+    if (!records_of_shard.empty()) {
+      (*remaining_shards)++;
+    }
+  }
+  if (*remaining_shards == 0) {
+    callback();
+    return;
+  }
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if ((*shard_records)[i].empty()) {
+      continue;
+    }
+    auto shard = shards_[i];
+    shard->get_event_base().runInEventBaseThread(
+      [shard, i, shard_records, remaining_shards, callback]() {
+        for (const auto record : (*shard_records)[i]) {
+          shard->aggregate_record(*record);
+        }
+        if (--(*remaining_shards) == 0) {
+          callback();
+        }
+      });
+  }
+}
+
+void ShardedEnforcer::collect_updates(
+    std::function<void(UpdateSessionRequest&)> callback) {
+  struct MergedUpdates {
+    std::mutex mutex;
+    size_t remaining_shards;
+    UpdateSessionRequest request;
+  };
+  auto merged = std::make_shared<MergedUpdates>();
+  merged->remaining_shards = shards_.size();
+  for (auto& shard : shards_) {
+    shard->get_event_base().runInEventBaseThread([shard, merged, callback]() {
+      auto request = shard->collect_updates();
+      bool is_last;
+      {
+        std::lock_guard<std::mutex> lock(merged->mutex);
+        if (merged->request.updates_size() == 0
+            && merged->request.usage_monitors_size() == 0) {
+          merged->request.Swap(&request);
+        } else {
+          // move the updates over instead of deep copying them
+          for (auto& update : *request.mutable_updates()) {
+            merged->request.add_updates()->Swap(&update);
+          }
+          for (auto& update : *request.mutable_usage_monitors()) {
+            merged->request.add_usage_monitors()->Swap(&update);
+          }
+        }
+        is_last = --merged->remaining_shards == 0;
+      }
+      if (is_last) {
+        callback(merged->request);
+      }
+    });
+  }
+}
+
+void ShardedEnforcer::update_session_credit(
+    const UpdateSessionResponse& response) {
+  auto shard_responses = split_response(response);
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (shard_responses[i].responses_size() == 0
+        && shard_responses[i].usage_monitor_responses_size() == 0) {
+      continue;
+    }
+    auto shard = shards_[i];
+    auto& shard_response = shard_responses[i];
+    shard->get_event_base().runInEventBaseThread([shard, shard_response]() {
+      shard->update_session_credit(shard_response);
+    });
+  }
+}
+
+void ShardedEnforcer::reset_updates(
+    const UpdateSessionRequest& failed_request) {
+  auto shard_requests = split_request(failed_request);
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (shard_requests[i].updates_size() == 0
+        && shard_requests[i].usage_monitors_size() == 0) {
+      continue;
+    }
+    auto shard = shards_[i];
+    auto& shard_request = shard_requests[i];
+    shard->get_event_base().runInEventBaseThread([shard, shard_request]() {
+      shard->reset_updates(shard_request);
+    });
+  }
+}
+
+}
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/io/async/EventBase.h>
+
+#include "LocalEnforcer.h"
+
+namespace magma {
+
+/**
+ * ShardedEnforcer spreads the sessions over several LocalEnforcers, each one
+ * running on its own event base thread. A session always lives in the shard
+ * picked by the hash of its IMSI, so the shards share no session state and
+ * the requests for different subscribers are processed in parallel.
+ *
+ * Requests that concern several subscribers are split by shard, and the
+ * updates collected from the shards are merged back into a single request.
+ */
+class ShardedEnforcer {
+public:
+  /**
+   * Create num_shards enforcers, each with its own event base
+   */
+  ShardedEnforcer(
+    size_t num_shards,
+    std::shared_ptr<StaticRuleStore> rule_store,
+    std::shared_ptr<PipelinedClient> pipelined_client);
+
+  /**
+   * Shard over enforcers which already have their event base attached.
+   * start and stop are then up to the caller
+   */
+  ShardedEnforcer(std::vector<std::shared_ptr<LocalEnforcer>> shards);
+
+  size_t get_num_shards() const;
+
+  size_t get_shard_index(const std::string& imsi) const;
+
+  LocalEnforcer& get_shard(size_t index);
+
+  LocalEnforcer& get_shard_for_imsi(const std::string& imsi);
+
+  /**
+   * Run fn with the shard of imsi, in the event base thread of the shard
+   */
+  void run_in_shard(
+    const std::string& imsi,
+    std::function<void(LocalEnforcer&)> fn);
+
+  void attachSessionStore(
+    std::shared_ptr<SessionStore> session_store,
+    std::chrono::milliseconds save_interval);
+
+  /**
+   * Restore each stored session in its shard. Must be called before start
+   */
+  void restore_sessions(const std::vector<StoredSessionState>& sessions);
+
+  /**
+   * Start the event base thread of every shard created by this class.
+   * Does not block
+   */
+  void start();
+
+  /**
+   * Stop the shards started by start and wait for their threads
+   */
+  void stop();
+
+  /**
+   * Set the callback run by a shard when the validity timers of some of its
+   * sessions expire. Must be set before the shards are started
+   */
+  void set_on_updates_due(std::function<void()> on_updates_due);
+
+  /**
+   * Aggregate the records of each shard in the event base of the shard. The
+   * records are not copied, they must stay valid until callback is called
+   * from the event base thread of the last shard to finish aggregating.
+   */
+  void aggregate_records(
+    const RuleRecordTable& records,
+    std::function<void()> callback);
+
+  /**
+   * Collect the updates of all the shards and merge them in one request.
+   * callback is called with the merged request, from the event base thread
+   * of the last shard to finish collecting. The request is only valid during
+   * the call, callback takes it over with Swap to keep it
+   */
+  void collect_updates(std::function<void(UpdateSessionRequest&)> callback);
+
+  /**
+   * Hand the credit of each subscriber to its shard
+   */
+  void update_session_credit(const UpdateSessionResponse& response);
+
+  /**
+   * Reset the updates of each subscriber in its shard
+   */
+  void reset_updates(const UpdateSessionRequest& failed_request);
+
+private:
+  std::vector<std::shared_ptr<LocalEnforcer>> shards_;
+  // Only set for the shards created by this class
+  std::vector<std::unique_ptr<folly::EventBase>> event_bases_;
+  std::vector<std::thread> threads_;
+
+private:
+  std::vector<std::vector<const RuleRecord*>> split_records(
+    const RuleRecordTable& records) const;
+
+  std::vector<UpdateSessionRequest> split_request(
+    const UpdateSessionRequest& request) const;
+
+  std::vector<UpdateSessionResponse> split_response(
+    const UpdateSessionResponse& response) const;
+};
+
+}
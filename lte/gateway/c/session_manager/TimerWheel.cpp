@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <algorithm>
+
+#include "TimerWheel.h"
+
+namespace magma {
+
+TimerWheel::TimerWheel(size_t num_slots)
+  : slots_(std::max(num_slots, (size_t) 1)),
+    last_advance_(std::time(nullptr) - 1),
+    size_(0) {}
+
+void TimerWheel::add(std::time_t deadline, std::function<void()> callback) {
+  // a timer that is already due runs at the next advance
+  deadline = std::max(deadline, last_advance_ + 1);
+  slots_[deadline % slots_.size()].push_back(
+    Timer{.deadline = deadline, .callback = std::move(callback)});
+  size_++;
+}
+
+size_t TimerWheel::advance(std::time_t now) {
+  if (now <= last_advance_) {
+    return 0;
+  }
+  // After a full turn every slot has been visited once
+  auto num_slots = (std::time_t) slots_.size();
+  auto seconds = std::min(now - last_advance_, num_slots);
+  std::vector<std::function<void()>> due_callbacks;
+  for (std::time_t t = now - seconds + 1; t <= now; t++) {
+    auto& slot = slots_[t % num_slots];
+    auto not_due = std::partition(slot.begin(), slot.end(),
+      [now](const Timer& timer) { return timer.deadline > now; });
+    for (auto it = not_due; it != slot.end(); it++) {
+      due_callbacks.push_back(std::move(it->callback));
+    }
+    slot.erase(not_due, slot.end());
+  }
+  last_advance_ = now;
+  size_ -= due_callbacks.size();
+  // Run the callbacks once the wheel is consistent, as they may add timers
+  for (auto& callback : due_callbacks) {
+    callback();
+  }
+  return due_callbacks.size();
+}
+
+size_t TimerWheel::size() const {
+  return size_;
+}
+
+}
@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <ctime>
+#include <functional>
+#include <vector>
+
+namespace magma {
+
+/**
+ * TimerWheel is a hashed timing wheel with one slot per second. A timer is
+ * hashed into the slot of its deadline, so adding one is O(1). Advancing the
+ * wheel only visits the slots of the seconds that went by, and runs the
+ * timers of those slots that are due. Timers that are more than a turn of the
+ * wheel away stay in their slot until their turn comes.
+ *
+ * TimerWheel is not thread safe, it is meant to be owned and advanced by one
+ * event base.
+ */
+class TimerWheel {
+public:
+  static const size_t DEFAULT_NUM_SLOTS = 512;
+
+  TimerWheel(size_t num_slots = DEFAULT_NUM_SLOTS);
+
+  /**
+   * Run callback once the wheel is advanced to deadline, in seconds since
+   * epoch. A deadline which already passed runs at the next advance
+   */
+  void add(std::time_t deadline, std::function<void()> callback);
+
+  /**
+   * Run the timers due by now. Callbacks may add timers
+   * @returns the number of timers which ran
+   */
+  size_t advance(std::time_t now);
+
+  size_t size() const;
+
+private:
+  struct Timer {
+    std::time_t deadline;
+    std::function<void()> callback;
+  };
+
+  std::vector<std::vector<Timer>> slots_;
+  // every timer with a deadline up to this time already ran
+  std::time_t last_advance_;
+  size_t size_;
+};
+
+}
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+namespace {
+
+std::atomic<uint64_t> allocations(0);
+
+}
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace magma {
+
+AllocationCounter::AllocationCounter() : start_(get_total_allocations()) {}
+
+uint64_t AllocationCounter::get_allocations() const {
+  return get_total_allocations() - start_;
+}
+
+void AllocationCounter::report(
+    benchmark::State& state,
+    const char* name) const {
+  state.counters[name] = benchmark::Counter(
+    get_allocations(), benchmark::Counter::kAvgIterations);
+}
+
+uint64_t AllocationCounter::get_total_allocations() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+namespace magma {
+
+/**
+ * AllocationCounter counts the heap allocations made while it is in scope.
+ * The global operator new is replaced in AllocationCounter.cpp, so it must
+ * only be linked in benchmark binaries.
+ */
+class AllocationCounter {
+public:
+  AllocationCounter();
+
+  uint64_t get_allocations() const;
+
+  /**
+   * Report the allocations counted per iteration of the benchmark
+   */
+  void report(benchmark::State& state, const char* name = "allocs") const;
+
+  static uint64_t get_total_allocations();
+
+private:
+  uint64_t start_;
+};
+
+}
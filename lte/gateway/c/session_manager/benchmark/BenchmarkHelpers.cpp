@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "BenchmarkHelpers.h"
+
+namespace magma {
+
+NoopPipelinedClient::NoopPipelinedClient() : num_calls_(0) {}
+
+bool NoopPipelinedClient::deactivate_all_flows(const std::string& imsi) {
+  num_calls_++;
+  return true;
+}
+
+bool NoopPipelinedClient::deactivate_flows_for_rules(
+    const std::string& imsi,
+    const std::vector<std::string>& rule_ids,
+    const std::vector<PolicyRule>& dynamic_rules) {
+  num_calls_++;
+  return true;
+}
+
+bool NoopPipelinedClient::activate_flows_for_rules(
+    const std::string& imsi,
+    const std::string& ip_addr,
+    const std::vector<std::string>& static_rules,
+    const std::vector<PolicyRule>& dynamic_rules) {
+  num_calls_++;
+  return true;
+}
+
+uint64_t NoopPipelinedClient::get_num_calls() const {
+  return num_calls_;
+}
+
+void LatencyRecorder::record(std::chrono::nanoseconds latency) {
+  latencies_.push_back(latency);
+  sorted_ = false;
+}
+
+void LatencyRecorder::merge(const LatencyRecorder& other) {
+  latencies_.insert(
+    latencies_.end(), other.latencies_.begin(), other.latencies_.end());
+  sorted_ = false;
+}
+
+size_t LatencyRecorder::get_count() const {
+  return latencies_.size();
+}
+
+std::chrono::nanoseconds LatencyRecorder::get_percentile(double percentile) {
+  if (latencies_.empty()) {
+    return std::chrono::nanoseconds(0);
+  }
+  if (!sorted_) {
+    std::sort(latencies_.begin(), latencies_.end());
+    sorted_ = true;
+  }
+  auto rank = (size_t) std::ceil(percentile / 100 * latencies_.size());
+  return latencies_[std::min(std::max(rank, (size_t) 1), latencies_.size())
+    - 1];
+}
+
+std::string bench_imsi(uint32_t index) {
+  char imsi[32];
+  snprintf(imsi, sizeof(imsi), "IMSI001010%09u", index);
+  return imsi;
+}
+
+void insert_bench_rules(StaticRuleStore& rule_store, uint32_t num_keys) {
+  for (uint32_t key = 1; key <= num_keys; key++) {
+    PolicyRule rule;
+    rule.set_id("rule" + std::to_string(key));
+    rule.set_rating_group(key);
+    rule.set_tracking_type(PolicyRule::ONLY_OCS);
+    rule_store.insert_rule(rule);
+  }
+}
+
+static void create_bench_credit(
+    const std::string& imsi,
+    uint32_t charging_key,
+    uint64_t volume,
+    CreditUpdateResponse* response) {
+  auto credit = response->mutable_credit();
+  credit->mutable_granted_units()->mutable_total()->set_volume(volume);
+  credit->mutable_granted_units()->mutable_total()->set_is_valid(true);
+  credit->set_type(ChargingCredit::BYTES);
+  response->set_success(true);
+  response->set_sid(imsi);
+  response->set_charging_key(charging_key);
+  response->set_type(CreditUpdateResponse::UPDATE);
+}
+
+void create_bench_session_response(
+    const std::string& imsi,
+    uint32_t num_keys,
+    uint64_t volume,
+    CreateSessionResponse* response) {
+  for (uint32_t key = 1; key <= num_keys; key++) {
+    create_bench_credit(imsi, key, volume, response->add_credits());
+    response->add_static_rules()->set_rule_id("rule" + std::to_string(key));
+  }
+}
+
+void create_bench_update_response(
+    const UpdateSessionRequest& request,
+    uint64_t volume,
+    UpdateSessionResponse* response) {
+  for (const auto& update : request.updates()) {
+    create_bench_credit(
+      update.sid(),
+      update.usage().charging_key(),
+      volume,
+      response->add_responses());
+  }
+}
+
+void create_bench_report(
+    uint32_t first,
+    uint32_t num_sessions,
+    uint32_t num_keys,
+    uint64_t bytes_tx,
+    RuleRecordTable* table) {
+  for (uint32_t i = first; i < first + num_sessions; i++) {
+    auto imsi = bench_imsi(i);
+    for (uint32_t key = 1; key <= num_keys; key++) {
+      auto record = table->add_records();
+      record->set_sid(imsi);
+      record->set_rule_id("rule" + std::to_string(key));
+      record->set_bytes_tx(bytes_tx);
+    }
+  }
+}
+
+}
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <lte/protos/session_manager.pb.h>
+
+#include "PipelinedClient.h"
+#include "RuleStore.h"
+
+namespace magma {
+using namespace lte;
+
+/**
+ * NoopPipelinedClient stands in for pipelined in benchmarks. Every call
+ * succeeds, and is only counted.
+ */
+class NoopPipelinedClient : public PipelinedClient {
+public:
+  NoopPipelinedClient();
+
+  bool deactivate_all_flows(const std::string& imsi) override;
+
+  bool deactivate_flows_for_rules(
+    const std::string& imsi,
+    const std::vector<std::string>& rule_ids,
+    const std::vector<PolicyRule>& dynamic_rules) override;
+
+  bool activate_flows_for_rules(
+    const std::string& imsi,
+    const std::string& ip_addr,
+    const std::vector<std::string>& static_rules,
+    const std::vector<PolicyRule>& dynamic_rules) override;
+
+  uint64_t get_num_calls() const;
+
+private:
+  std::atomic<uint64_t> num_calls_;
+};
+
+/**
+ * LatencyRecorder keeps the latencies of a run to report its percentiles.
+ * Not thread safe, each client thread records in its own recorder, and the
+ * recorders are merged at the end of the run.
+ */
+class LatencyRecorder {
+public:
+  void record(std::chrono::nanoseconds latency);
+
+  void merge(const LatencyRecorder& other);
+
+  size_t get_count() const;
+
+  /**
+   * @param percentile - between 0 and 100
+   * @returns the latency below which percentile % of the latencies are
+   */
+  std::chrono::nanoseconds get_percentile(double percentile);
+
+private:
+  std::vector<std::chrono::nanoseconds> latencies_;
+  bool sorted_ = true;
+};
+
+/**
+ * IMSI of the index-th synthetic subscriber
+ */
+std::string bench_imsi(uint32_t index);
+
+/**
+ * Insert num_keys static rules named "rule<key>", charged on keys 1 to
+ * num_keys
+ */
+void insert_bench_rules(StaticRuleStore& rule_store, uint32_t num_keys);
+
+/**
+ * Fill a create session response granting volume on keys 1 to num_keys, and
+ * installing the rules inserted by insert_bench_rules
+ */
+void create_bench_session_response(
+  const std::string& imsi,
+  uint32_t num_keys,
+  uint64_t volume,
+  CreateSessionResponse* response);
+
+/**
+ * Fill an update response granting volume to every update of request
+ */
+void create_bench_update_response(
+  const UpdateSessionRequest& request,
+  uint64_t volume,
+  UpdateSessionResponse* response);
+
+/**
+ * Add a record of bytes_tx on every rule of num_keys, for the subscribers
+ * first to first + num_sessions - 1
+ */
+void create_bench_report(
+  uint32_t first,
+  uint32_t num_sessions,
+  uint32_t num_keys,
+  uint64_t bytes_tx,
+  RuleRecordTable* table);
+
+}
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkHelpers.h"
+#include "LocalEnforcer.h"
+
+/**
+ * LocalEnforcer benchmarks, run with 1k to 200k sessions in the enforcer.
+ * Each benchmark reports the operations per second as items_per_second, and
+ * the heap allocations per operation.
+ */
+namespace magma {
+
+static const uint32_t NUM_KEYS = 2;
+static const uint64_t GRANTED_VOLUME = 1024 * 1024;
+// number of subscribers in a usage report from pipelined
+static const uint32_t REPORT_SIZE = 1000;
+
+static const SessionState::Config bench_cfg =
+  {.ue_ipv4 = "192.168.128.11", .spgw_ipv4 = "192.168.60.142"};
+
+static std::unique_ptr<LocalEnforcer> create_enforcer(uint32_t num_sessions) {
+  auto rule_store = std::make_shared<StaticRuleStore>();
+  insert_bench_rules(*rule_store, NUM_KEYS);
+  auto enforcer = std::make_unique<LocalEnforcer>(
+    rule_store, std::make_shared<NoopPipelinedClient>());
+  for (uint32_t i = 0; i < num_sessions; i++) {
+    auto imsi = bench_imsi(i);
+    CreateSessionResponse response;
+    create_bench_session_response(imsi, NUM_KEYS, GRANTED_VOLUME, &response);
+    enforcer->init_session_credit(imsi, imsi + "-1", bench_cfg, response);
+  }
+  return enforcer;
+}
+
+/**
+ * Session churn: end a session and create it again
+ */
+static void BM_CreateEndSession(benchmark::State& state) {
+  uint32_t num_sessions = state.range(0);
+  auto enforcer = create_enforcer(num_sessions);
+  std::vector<CreateSessionResponse> responses(num_sessions);
+  for (uint32_t i = 0; i < num_sessions; i++) {
+    create_bench_session_response(
+      bench_imsi(i), NUM_KEYS, GRANTED_VOLUME, &responses[i]);
+  }
+  uint32_t next = 0;
+  AllocationCounter counter;
+  for (auto _ : state) {
+    auto imsi = bench_imsi(next);
+    auto term_req = enforcer->terminate_subscriber(imsi);
+    enforcer->complete_termination(imsi, term_req.session_id());
+    enforcer->init_session_credit(
+      imsi, imsi + "-1", bench_cfg, responses[next]);
+    next = (next + 1) % num_sessions;
+  }
+  state.SetItemsProcessed(state.iterations());
+  counter.report(state);
+}
+BENCHMARK(BM_CreateEndSession)
+  ->Arg(1000)->Arg(10000)->Arg(100000)->Arg(200000);
+
+/**
+ * Aggregate a usage report which does not exhaust any credit
+ */
+static void BM_AggregateRecords(benchmark::State& state) {
+  uint32_t num_sessions = state.range(0);
+  auto enforcer = create_enforcer(num_sessions);
+  auto report_size = std::min(REPORT_SIZE, num_sessions);
+  std::vector<RuleRecordTable> reports;
+  for (uint32_t first = 0; first + report_size <= num_sessions;
+       first += report_size) {
+    reports.emplace_back();
+    create_bench_report(first, report_size, NUM_KEYS, 1, &reports.back());
+  }
+  size_t next = 0;
+  AllocationCounter counter;
+  for (auto _ : state) {
+    enforcer->aggregate_records(reports[next]);
+    next = (next + 1) % reports.size();
+  }
+  state.SetItemsProcessed(state.iterations() * report_size * NUM_KEYS);
+  counter.report(state, "allocs_per_report");
+}
+BENCHMARK(BM_AggregateRecords)
+  ->Arg(1000)->Arg(10000)->Arg(100000)->Arg(200000);
+
+/**
+ * Full report cycle: aggregate a report exhausting the credit of its
+ * subscribers, collect the updates and receive new credit from the cloud
+ */
+static void BM_ReportCollectUpdate(benchmark::State& state) {
+  uint32_t num_sessions = state.range(0);
+  auto enforcer = create_enforcer(num_sessions);
+  auto report_size = std::min(REPORT_SIZE, num_sessions);
+  std::vector<RuleRecordTable> reports;
+  for (uint32_t first = 0; first + report_size <= num_sessions;
+       first += report_size) {
+    reports.emplace_back();
+    // credit is exhausted once the usage goes over the granted volume
+    create_bench_report(
+      first, report_size, NUM_KEYS, 2 * GRANTED_VOLUME, &reports.back());
+  }
+  // the new sessions are all checked once, outside of the measure
+  enforcer->collect_updates();
+  size_t next = 0;
+  uint64_t num_updates = 0;
+  AllocationCounter counter;
+  for (auto _ : state) {
+    enforcer->aggregate_records(reports[next]);
+    auto request = enforcer->collect_updates();
+    UpdateSessionResponse response;
+    create_bench_update_response(request, GRANTED_VOLUME, &response);
+    enforcer->update_session_credit(response);
+    num_updates += request.updates_size();
+    next = (next + 1) % reports.size();
+  }
+  state.SetItemsProcessed(state.iterations() * report_size * NUM_KEYS);
+  state.counters["updates_per_report"] = benchmark::Counter(
+    num_updates, benchmark::Counter::kAvgIterations);
+  counter.report(state, "allocs_per_report");
+}
+BENCHMARK(BM_ReportCollectUpdate)
+  ->Arg(1000)->Arg(10000)->Arg(100000)->Arg(200000);
+
+/**
+ * Collect updates when no session changed, which should not depend on the
+ * number of sessions
+ */
+static void BM_CollectIdleUpdates(benchmark::State& state) {
+  auto enforcer = create_enforcer(state.range(0));
+  enforcer->collect_updates();
+  AllocationCounter counter;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(enforcer->collect_updates());
+  }
+  state.SetItemsProcessed(state.iterations());
+  counter.report(state);
+}
+BENCHMARK(BM_CollectIdleUpdates)
+  ->Arg(1000)->Arg(10000)->Arg(100000)->Arg(200000);
+
+/**
+ * Charging reauth of one key, followed by its update and new credit
+ */
+static void BM_ChargingReAuth(benchmark::State& state) {
+  uint32_t num_sessions = state.range(0);
+  auto enforcer = create_enforcer(num_sessions);
+  enforcer->collect_updates();
+  uint32_t next = 0;
+  AllocationCounter counter;
+  for (auto _ : state) {
+    ChargingReAuthRequest reauth;
+    reauth.set_sid(bench_imsi(next));
+    reauth.set_charging_key(1);
+    reauth.set_type(ChargingReAuthRequest::SINGLE_SERVICE);
+    enforcer->init_charging_reauth(reauth);
+    auto request = enforcer->collect_updates();
+    UpdateSessionResponse response;
+    create_bench_update_response(request, GRANTED_VOLUME, &response);
+    enforcer->update_session_credit(response);
+    next = (next + 1) % num_sessions;
+  }
+  state.SetItemsProcessed(state.iterations());
+  counter.report(state);
+}
+BENCHMARK(BM_ChargingReAuth)
+  ->Arg(1000)->Arg(10000)->Arg(100000)->Arg(200000);
+
+}
+
+BENCHMARK_MAIN();
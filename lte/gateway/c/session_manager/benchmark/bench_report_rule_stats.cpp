@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <folly/io/async/EventBase.h>
+#include <google/protobuf/arena.h>
+#include <grpc++/grpc++.h>
+#include <lte/protos/session_manager.pb.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkHelpers.h"
+#include "CloudReporter.h"
+#include "LocalSessionManagerHandler.h"
+#include "ReportScheduler.h"
+#include "ShardedEnforcer.h"
+
+/**
+ * Allocations made by sessiond to receive a usage report from pipelined, and
+ * to merge the updates collected from the enforcer shards. The benchmarks
+ * drive the ReportRuleStats handler and the ShardedEnforcer of sessiond, with
+ * pipelined replaced by a no-op client.
+ */
+namespace magma {
+using namespace lte;
+
+static const size_t NUM_SHARDS = 4;
+static const uint32_t NUM_KEYS = 2;
+// large enough for the reports of a run to never exhaust it
+static const uint64_t GRANTED_VOLUME = 1ull << 40;
+
+static const SessionState::Config bench_cfg =
+  {.ue_ipv4 = "192.168.128.11", .spgw_ipv4 = "192.168.60.142"};
+
+/**
+ * BenchEnforcer runs the enforcer shards with num_sessions sessions, each
+ * granted GRANTED_VOLUME on every key
+ */
+class BenchEnforcer {
+public:
+  explicit BenchEnforcer(uint32_t num_sessions)
+    : rule_store_(std::make_shared<StaticRuleStore>()) {
+    insert_bench_rules(*rule_store_, NUM_KEYS);
+    enforcer_ = std::make_unique<ShardedEnforcer>(
+      NUM_SHARDS, rule_store_, std::make_shared<NoopPipelinedClient>());
+    enforcer_->start();
+    for (uint32_t i = 0; i < num_sessions; i++) {
+      auto imsi = bench_imsi(i);
+      shard_imsis_.emplace(enforcer_->get_shard_index(imsi), imsi);
+      run_in_shard_and_wait(imsi, [imsi](LocalEnforcer& shard) {
+        CreateSessionResponse response;
+        create_bench_session_response(
+          imsi, NUM_KEYS, GRANTED_VOLUME, &response);
+        shard.init_session_credit(imsi, imsi + "-1", bench_cfg, response);
+      });
+    }
+  }
+
+  ~BenchEnforcer() {
+    enforcer_->stop();
+  }
+
+  ShardedEnforcer& get() {
+    return *enforcer_;
+  }
+
+  /**
+   * Wait for the work queued in every shard so far to be done
+   */
+  void wait_for_shards() {
+    for (const auto& shard_imsi : shard_imsis_) {
+      run_in_shard_and_wait(shard_imsi.second, [](LocalEnforcer& shard) {});
+    }
+  }
+
+  UpdateSessionRequest collect_updates() {
+    UpdateSessionRequest merged;
+    std::promise<void> done;
+    enforcer_->collect_updates([&merged, &done](UpdateSessionRequest& request) {
+      merged.Swap(&request);
+      done.set_value();
+    });
+    done.get_future().wait();
+    return merged;
+  }
+
+private:
+  std::shared_ptr<StaticRuleStore> rule_store_;
+  std::unique_ptr<ShardedEnforcer> enforcer_;
+  // a subscriber of each shard used, to wait for the shard
+  std::map<size_t, std::string> shard_imsis_;
+
+private:
+  void run_in_shard_and_wait(
+      const std::string& imsi,
+      std::function<void(LocalEnforcer&)> fn) {
+    std::promise<void> done;
+    enforcer_->run_in_shard(imsi, [&done, fn](LocalEnforcer& shard) {
+      fn(shard);
+      done.set_value();
+    });
+    done.get_future().wait();
+  }
+};
+
+/**
+ * ReportRuleStats of a report of state.range(0) records, NUM_KEYS for each
+ * of its sessions. The call completes once every shard has
+ * aggregated its records. With state.range(1) set, the report is parsed in an
+ * arena as SessionManagerServer does, otherwise on the heap as it used to be.
+ */
+static void BM_ReportRuleStats(benchmark::State& state) {
+  uint32_t num_sessions = state.range(0) / NUM_KEYS;
+  bool use_arena = state.range(1) != 0;
+  BenchEnforcer enforcer(num_sessions);
+
+  // no credit is exhausted, so nothing is ever sent to the cloud
+  folly::EventBase evb;
+  auto flush_interval = std::chrono::milliseconds(100);
+  SessionCloudReporter reporter(&evb, grpc::CreateChannel(
+    "127.0.0.1:1", grpc::InsecureChannelCredentials()));
+  ReportScheduler report_scheduler(&evb, &enforcer.get(), &reporter,
+    ReportScheduler::Config{
+      .flush_interval = flush_interval,
+      .max_batch_size = 1000,
+      .max_inflight_requests = 4,
+    });
+  LocalSessionManagerHandlerImpl handler(
+    &enforcer.get(), &reporter, &report_scheduler);
+  std::thread evb_thread([&evb]() { evb.loopForever(); });
+
+  RuleRecordTable report;
+  create_bench_report(0, num_sessions, NUM_KEYS, 1, &report);
+  auto serialized = report.SerializeAsString();
+
+  auto report_rule_stats = [&handler](const RuleRecordTable* request) {
+    std::promise<void> done;
+    handler.ReportRuleStats(nullptr, request,
+      [&done](grpc::Status status, Void response) { done.set_value(); });
+    done.get_future().wait();
+  };
+  AllocationCounter counter;
+  for (auto _ : state) {
+    if (use_arena) {
+      google::protobuf::Arena arena;
+      auto request =
+        google::protobuf::Arena::CreateMessage<RuleRecordTable>(&arena);
+      request->ParseFromString(serialized);
+      report_rule_stats(request);
+    } else {
+      RuleRecordTable request;
+      request.ParseFromString(serialized);
+      report_rule_stats(&request);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * report.records_size());
+  counter.report(state);
+
+  // let the last flush scheduled by the calls run before the scheduler goes
+  std::this_thread::sleep_for(3 * flush_interval);
+  evb.terminateLoopSoon();
+  evb_thread.join();
+}
+BENCHMARK(BM_ReportRuleStats)
+  ->Args({100, 0})->Args({100, 1})
+  ->Args({1000, 0})->Args({1000, 1})
+  ->Args({10000, 0})->Args({10000, 1})
+  ->UseRealTime();
+
+/**
+ * ShardedEnforcer::collect_updates of state.range(0) charging updates, merged
+ * from the NUM_SHARDS shards. Between iterations, the updates are reset so
+ * that they are collected again.
+ */
+static void BM_CollectShardUpdates(benchmark::State& state) {
+  uint32_t num_sessions = state.range(0);
+  BenchEnforcer enforcer(num_sessions);
+  // exhaust the credit of the first key of every session
+  RuleRecordTable report;
+  create_bench_report(0, num_sessions, 1, 2 * GRANTED_VOLUME, &report);
+  std::promise<void> aggregated;
+  enforcer.get().aggregate_records(report, [&aggregated]() {
+    aggregated.set_value();
+  });
+  aggregated.get_future().wait();
+
+  uint64_t allocations = 0;
+  uint64_t num_updates = 0;
+  for (auto _ : state) {
+    AllocationCounter counter;
+    auto request = enforcer.collect_updates();
+    allocations += counter.get_allocations();
+    num_updates += request.updates_size();
+
+    state.PauseTiming();
+    enforcer.get().reset_updates(request);
+    enforcer.wait_for_shards();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(num_updates);
+  state.counters["allocs"] = benchmark::Counter(
+    allocations, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_CollectShardUpdates)
+  ->Arg(100)->Arg(1000)->Arg(10000)
+  ->UseRealTime();
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,325 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <getopt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/io/async/EventBase.h>
+#include <grpc++/grpc++.h>
+#include <lte/protos/session_manager.grpc.pb.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkHelpers.h"
+#include "CloudReporter.h"
+#include "ReportScheduler.h"
+#include "SessionManagerServer.h"
+#include "ShardedEnforcer.h"
+
+/**
+ * sessiond_loadgen runs sessiond in process, with pipelined replaced by a no-op
+ * client and the OCS/PCRF by a fake controller which grants credit to every
+ * request. Client threads then drive the local gRPC services of sessiond
+ * through the phases of a load test:
+ * 1) create all the sessions
+ * 2) report usage for all the sessions, for a number of rounds
+ * 3) charging reauth of some sessions
+ * 4) churn: end and create again some sessions
+ * 5) end all the sessions
+ * For each phase, the throughput, p50/p99 latency and the heap allocations
+ * per call are printed.
+ */
+namespace magma {
+using namespace lte;
+
+static const uint32_t NUM_KEYS = 2;
+static const uint64_t GRANTED_VOLUME = 1024 * 1024;
+
+struct LoadConfig {
+  uint32_t sessions;
+  uint32_t threads;
+  uint32_t report_rounds;
+  uint32_t report_size;
+  uint32_t reauths;
+  uint32_t churn;
+  uint32_t shards;
+};
+
+/**
+ * FakeCentralController grants credit to every session and update
+ */
+class FakeCentralController final : public CentralSessionController::Service {
+public:
+  grpc::Status CreateSession(
+      grpc::ServerContext* context,
+      const CreateSessionRequest* request,
+      CreateSessionResponse* response) override {
+    create_bench_session_response(
+      request->subscriber().id(), NUM_KEYS, GRANTED_VOLUME, response);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status UpdateSession(
+      grpc::ServerContext* context,
+      const UpdateSessionRequest* request,
+      UpdateSessionResponse* response) override {
+    create_bench_update_response(*request, GRANTED_VOLUME, response);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status TerminateSession(
+      grpc::ServerContext* context,
+      const SessionTerminateRequest* request,
+      SessionTerminateResponse* response) override {
+    response->set_sid(request->sid());
+    response->set_session_id(request->session_id());
+    return grpc::Status::OK;
+  }
+};
+
+/**
+ * Run num_calls calls of call over the client threads, and print the
+ * statistics of the phase
+ */
+static void run_phase(
+    const std::string& name,
+    const LoadConfig& config,
+    uint32_t num_calls,
+    std::function<bool(uint32_t index)> call) {
+  std::vector<LatencyRecorder> recorders(config.threads);
+  std::vector<uint32_t> failures(config.threads, 0);
+  std::vector<std::thread> threads;
+  AllocationCounter counter;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t t = 0; t < config.threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (uint32_t i = t; i < num_calls; i += config.threads) {
+        auto call_start = std::chrono::steady_clock::now();
+        if (!call(i)) {
+          failures[t]++;
+        }
+        recorders[t].record(std::chrono::steady_clock::now() - call_start);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  LatencyRecorder latencies;
+  uint32_t num_failures = 0;
+  for (uint32_t t = 0; t < config.threads; t++) {
+    latencies.merge(recorders[t]);
+    num_failures += failures[t];
+  }
+  auto to_us = [](std::chrono::nanoseconds latency) {
+    return std::chrono::duration<double, std::micro>(latency).count();
+  };
+  printf("%-14s %9u calls %8.2f s %10.1f calls/s  p50 %9.1f us  "
+         "p99 %9.1f us  %8.1f allocs/call  %u failed\n",
+    name.c_str(),
+    num_calls,
+    elapsed.count(),
+    num_calls / elapsed.count(),
+    to_us(latencies.get_percentile(50)),
+    to_us(latencies.get_percentile(99)),
+    num_calls > 0 ? (double) counter.get_allocations() / num_calls : 0,
+    num_failures);
+}
+
+static int run_load(const LoadConfig& config) {
+  // fake controller, standing in for the OCS and PCRF behind the cloud
+  FakeCentralController controller;
+  int cloud_port = 0;
+  grpc::ServerBuilder cloud_builder;
+  cloud_builder.AddListeningPort(
+    "127.0.0.1:0", grpc::InsecureServerCredentials(), &cloud_port);
+  cloud_builder.RegisterService(&controller);
+  auto cloud_server = cloud_builder.BuildAndStart();
+
+  folly::EventBase evb;
+  auto rule_store = std::make_shared<StaticRuleStore>();
+  insert_bench_rules(*rule_store, NUM_KEYS);
+  auto pipelined_client = std::make_shared<NoopPipelinedClient>();
+  ShardedEnforcer enforcer(config.shards, rule_store, pipelined_client);
+  SessionCloudReporter reporter(&evb, grpc::CreateChannel(
+    "127.0.0.1:" + std::to_string(cloud_port),
+    grpc::InsecureChannelCredentials()));
+  ReportScheduler report_scheduler(&evb, &enforcer, &reporter,
+    ReportScheduler::Config{
+      .flush_interval = std::chrono::milliseconds(100),
+      .max_batch_size = 1000,
+      .max_inflight_requests = 4,
+    });
+  enforcer.set_on_updates_due([&report_scheduler]() {
+    report_scheduler.schedule_flush();
+  });
+
+  // sessiond local services
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(
+    "127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+  LocalSessionManagerAsyncService local_service(
+    builder.AddCompletionQueue(),
+    std::make_unique<LocalSessionManagerHandlerImpl>(
+      &enforcer, &reporter, &report_scheduler));
+  SessionProxyResponderAsyncService proxy_service(
+    builder.AddCompletionQueue(),
+    std::make_unique<SessionProxyResponderHandlerImpl>(&enforcer));
+  builder.RegisterService(&local_service);
+  builder.RegisterService(&proxy_service);
+  auto server = builder.BuildAndStart();
+
+  std::thread reporter_thread([&]() { reporter.rpc_response_loop(); });
+  std::thread local_thread([&]() { local_service.wait_for_requests(); });
+  std::thread proxy_thread([&]() { proxy_service.wait_for_requests(); });
+  std::thread evb_thread([&]() { evb.loopForever(); });
+  enforcer.start();
+
+  auto channel = grpc::CreateChannel(
+    "127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials());
+  auto local_stub = LocalSessionManager::NewStub(channel);
+  auto proxy_stub = SessionProxyResponder::NewStub(channel);
+
+  auto create_session = [&](uint32_t index) {
+    grpc::ClientContext context;
+    LocalCreateSessionRequest request;
+    LocalCreateSessionResponse response;
+    request.mutable_sid()->set_id(bench_imsi(index));
+    request.set_ue_ipv4("192.168.128.11");
+    request.set_spgw_ipv4("192.168.60.142");
+    request.set_apn("magma.ipv4");
+    return local_stub->CreateSession(&context, request, &response).ok();
+  };
+  auto end_session = [&](uint32_t index) {
+    grpc::ClientContext context;
+    SubscriberID request;
+    LocalEndSessionResponse response;
+    request.set_id(bench_imsi(index));
+    return local_stub->EndSession(&context, request, &response).ok();
+  };
+
+  printf("sessiond load: %u sessions, %u client threads, %u shards\n",
+    config.sessions, config.threads, config.shards);
+
+  run_phase("create", config, config.sessions, create_session);
+
+  auto report_size = std::max(std::min(config.report_size, config.sessions), 1u);
+  auto reports_per_round = (config.sessions + report_size - 1) / report_size;
+  std::vector<RuleRecordTable> reports(reports_per_round);
+  for (uint32_t r = 0; r < reports_per_round; r++) {
+    auto first = r * report_size;
+    create_bench_report(
+      first,
+      std::min(report_size, config.sessions - first),
+      NUM_KEYS,
+      GRANTED_VOLUME / 4,
+      &reports[r]);
+  }
+  run_phase("report", config, config.report_rounds * reports_per_round,
+    [&](uint32_t index) {
+      grpc::ClientContext context;
+      Void response;
+      return local_stub->ReportRuleStats(
+        &context, reports[index % reports_per_round], &response).ok();
+    });
+
+  run_phase("reauth", config, config.reauths, [&](uint32_t index) {
+    grpc::ClientContext context;
+    ChargingReAuthRequest request;
+    ChargingReAuthAnswer answer;
+    request.set_sid(bench_imsi(index % config.sessions));
+    request.set_charging_key(1);
+    request.set_type(ChargingReAuthRequest::SINGLE_SERVICE);
+    return proxy_stub->ChargingReAuth(&context, request, &answer).ok();
+  });
+
+  run_phase("churn", config, config.churn, [&](uint32_t index) {
+    auto session = index % config.sessions;
+    return end_session(session) && create_session(session);
+  });
+
+  run_phase("end", config, config.sessions, end_session);
+
+  printf("pipelined calls: %lu\n",
+    (unsigned long) pipelined_client->get_num_calls());
+
+  server->Shutdown();
+  local_service.stop();
+  proxy_service.stop();
+  local_thread.join();
+  proxy_thread.join();
+  enforcer.stop();
+  evb.terminateLoopSoon();
+  evb_thread.join();
+  reporter.stop();
+  reporter_thread.join();
+  cloud_server->Shutdown();
+  return 0;
+}
+
+static void usage(const char* name) {
+  fprintf(stderr,
+    "Usage: %s [--sessions N] [--threads N] [--rounds N] [--report-size N]\n"
+    "          [--reauths N] [--churn N] [--shards N]\n", name);
+}
+
+}
+
+int main(int argc, char** argv) {
+  magma::LoadConfig config = {
+    .sessions = 10000,
+    .threads = 4,
+    .report_rounds = 5,
+    .report_size = 1000,
+    .reauths = 1000,
+    .churn = 1000,
+    .shards = 1,
+  };
+  static const struct option options[] = {
+    {"sessions", required_argument, nullptr, 's'},
+    {"threads", required_argument, nullptr, 't'},
+    {"rounds", required_argument, nullptr, 'r'},
+    {"report-size", required_argument, nullptr, 'p'},
+    {"reauths", required_argument, nullptr, 'a'},
+    {"churn", required_argument, nullptr, 'c'},
+    {"shards", required_argument, nullptr, 'n'},
+    {nullptr, 0, nullptr, 0},
+  };
+  int opt;
+  while ((opt = getopt_long(argc, argv, "", options, nullptr)) != -1) {
+    uint32_t value = optarg ? std::strtoul(optarg, nullptr, 10) : 0;
+    switch (opt) {
+      case 's': config.sessions = value; break;
+      case 't': config.threads = value; break;
+      case 'r': config.report_rounds = value; break;
+      case 'p': config.report_size = value; break;
+      case 'a': config.reauths = value; break;
+      case 'c': config.churn = value; break;
+      case 'n': config.shards = value; break;
+      default:
+        magma::usage(argv[0]);
+        return 1;
+    }
+  }
+  if (config.sessions == 0 || config.threads == 0) {
+    magma::usage(argv[0]);
+    return 1;
+  }
+  return magma::run_load(config);
+}
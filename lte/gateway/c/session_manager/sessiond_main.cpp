@@ -7,19 +7,24 @@
  * of patent rights can be found in the PATENTS file in the same directory.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 #include <lte/protos/mconfig/mconfigs.pb.h>
 
 #include "SessionManagerServer.h"
-#include "LocalEnforcer.h"
+#include "ShardedEnforcer.h"
 #include "CloudReporter.h"
+#include "ReportScheduler.h"
 #include "MagmaService.h"
 #include "ServiceRegistrySingleton.h"
 #include "PolicyLoader.h"
 #include "MConfigLoader.h"
 #include "magma_logging.h"
 #include "SessionCredit.h"
+#include "SessionStore.h"
+#include "MobilitydClient.h"
 
 #define SESSIOND_SERVICE "sessiond"
 #define SESSION_PROXY_SERVICE "session_proxy"
@@ -72,6 +77,72 @@ static const std::shared_ptr<grpc::Channel> get_controller_channel(
                                    grpc::ChannelArguments{});
 }
 
+static bool session_store_enabled(const YAML::Node& config) {
+  return config["session_store_enabled"].IsDefined() &&
+    config["session_store_enabled"].as<bool>();
+}
+
+static std::chrono::milliseconds get_session_store_save_interval(
+    const YAML::Node& config) {
+  if (!config["session_store_save_interval_ms"].IsDefined()) {
+    return std::chrono::milliseconds(100);
+  }
+  return std::chrono::milliseconds(
+    config["session_store_save_interval_ms"].as<uint32_t>());
+}
+
+/**
+ * Get the stored sessions of the UEs which detached while sessiond was down.
+ * All the sessions are kept if mobilityd cannot be reached
+ */
+static std::vector<std::string> get_detached_sessions(
+    const std::vector<magma::StoredSessionState>& sessions) {
+  if (sessions.empty()) {
+    return {};
+  }
+  std::unordered_map<std::string, std::string> ipv4_by_imsi;
+  magma::SyncMobilitydClient mobilityd_client;
+  if (!mobilityd_client.get_subscriber_ipv4_table(&ipv4_by_imsi)) {
+    MLOG(MERROR) << "Keeping all the stored sessions, mobilityd is unreachable";
+    return {};
+  }
+  return magma::find_detached_sessions(sessions, ipv4_by_imsi);
+}
+
+static size_t get_enforcer_shards(const YAML::Node& config) {
+  if (!config["enforcer_shards"].IsDefined()) {
+    return 1;
+  }
+  auto shards = config["enforcer_shards"].as<uint32_t>();
+  if (shards == 0) {
+    // one shard per core
+    shards = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  return shards;
+}
+
+static magma::ReportScheduler::Config get_report_scheduler_config(
+    const YAML::Node& config) {
+  magma::ReportScheduler::Config scheduler_config = {
+    .flush_interval = std::chrono::milliseconds(100),
+    .max_batch_size = 1000,
+    .max_inflight_requests = 4,
+  };
+  if (config["report_flush_interval_ms"].IsDefined()) {
+    scheduler_config.flush_interval = std::chrono::milliseconds(
+      config["report_flush_interval_ms"].as<uint32_t>());
+  }
+  if (config["report_max_batch_size"].IsDefined()) {
+    scheduler_config.max_batch_size =
+      config["report_max_batch_size"].as<uint32_t>();
+  }
+  if (config["report_max_inflight_requests"].IsDefined()) {
+    scheduler_config.max_inflight_requests =
+      config["report_max_inflight_requests"].as<uint32_t>();
+  }
+  return scheduler_config;
+}
+
 static uint32_t get_log_verbosity(const YAML::Node& config) {
     if(!config["log_level"].IsDefined()) {
         return MINFO;
@@ -117,8 +188,10 @@ int main (int argc, char* argv[]) {
   auto rule_store = std::make_shared<magma::StaticRuleStore>();
   magma::PolicyLoader policy_loader;
   std::thread policy_loader_thread([&]() {
-    policy_loader.start_loop([&](std::vector<magma::PolicyRule>rules) {
-      rule_store->sync_rules(rules);
+    policy_loader.start_loop([&](
+        const std::vector<magma::PolicyRule>& updated_rules,
+        const std::vector<std::string>& removed_rule_ids) {
+      rule_store->apply_rule_changes(updated_rules, removed_rule_ids);
     }, config["rule_update_inteval_sec"].as<uint32_t>());
     policy_loader.stop();
   });
@@ -132,7 +205,27 @@ int main (int argc, char* argv[]) {
   auto reporting_limit = config["usage_reporting_limit_bytes"].as<uint64_t>();
   magma::SessionCredit::USAGE_REPORTING_LIMIT = reporting_limit;
 
-  auto monitor = magma::LocalEnforcer(rule_store, pipelined_client);
+  magma::ShardedEnforcer monitor(
+    get_enforcer_shards(config), rule_store, pipelined_client);
+  MLOG(MINFO) << "Running " << monitor.get_num_shards() << " enforcer shards";
+
+  // restore the sessions before any request is served
+  std::shared_ptr<magma::SessionStore> session_store;
+  std::thread session_store_thread;
+  std::vector<std::string> detached_sessions;
+  if (session_store_enabled(config)) {
+    session_store = std::make_shared<magma::SessionStore>(
+      std::make_shared<cpp_redis::client>());
+    auto stored_sessions = session_store->read_sessions();
+    monitor.restore_sessions(stored_sessions);
+    detached_sessions = get_detached_sessions(stored_sessions);
+    monitor.attachSessionStore(
+      session_store, get_session_store_save_interval(config));
+    session_store_thread = std::thread([&]() {
+      MLOG(MINFO) << "Started session store thread";
+      session_store->write_loop();
+    });
+  }
 
   magma::SessionCloudReporter reporter(evb, get_controller_channel(config));
   std::thread reporter_thread([&]() {
@@ -140,9 +233,30 @@ int main (int argc, char* argv[]) {
     reporter.rpc_response_loop();
   });
 
+  magma::ReportScheduler report_scheduler(
+    evb, &monitor, &reporter, get_report_scheduler_config(config));
+  // report the sessions whose credit validity expired
+  monitor.set_on_updates_due([&report_scheduler]() {
+    report_scheduler.schedule_flush();
+  });
+
   magma::service303::MagmaService server(SESSIOND_SERVICE, SESSIOND_VERSION);
   auto local_handler = std::make_unique<magma::LocalSessionManagerHandlerImpl>(
-    &monitor, &reporter);
+    &monitor, &reporter, &report_scheduler);
+  // End the sessions of the UEs which detached while sessiond was down. The
+  // terminations are queued in the shards before any request is served
+  for (const auto& imsi : detached_sessions) {
+    MLOG(MINFO) << "Ending the stored session of detached subscriber " << imsi;
+    magma::SubscriberID sid;
+    sid.set_id(imsi);
+    local_handler->EndSession(nullptr, &sid, [imsi](
+        grpc::Status status, magma::LocalEndSessionResponse response) {
+      if (!status.ok()) {
+        MLOG(MERROR) << "Failed to end the stored session of " << imsi << ": "
+          << status.error_message();
+      }
+    });
+  }
   auto proxy_handler = std::make_unique<magma::SessionProxyResponderHandlerImpl>(
     &monitor);
 
@@ -165,10 +279,16 @@ int main (int argc, char* argv[]) {
     proxy_service.stop(); // stop queue after server shuts down
   });
 
-  // Block on main monitor (to keep evb in this thread)
-  monitor.attachEventBase(evb);
+  // The shards run on their own threads, the main event base runs the
+  // callbacks of the cloud reporter
   monitor.start();
+  evb->loopForever();
   server.Stop();
+  monitor.stop();
+  if (session_store != nullptr) {
+    session_store->stop();
+    session_store_thread.join();
+  }
 
   reporter_thread.join();
   local_thread.join();
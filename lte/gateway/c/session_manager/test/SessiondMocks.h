@@ -34,6 +34,7 @@ MockPipelined() : Pipelined::Service() {
   ON_CALL(*this, AddRule(_,_,_)).WillByDefault(Return(Status::OK));
   ON_CALL(*this, ActivateFlows(_,_,_)).WillByDefault(Return(Status::OK));
   ON_CALL(*this, DeactivateFlows(_,_,_)).WillByDefault(Return(Status::OK));
+  ON_CALL(*this, UpdateFlows(_,_,_)).WillByDefault(Return(Status::OK));
 }
 
 MOCK_METHOD3(AddRule, Status(grpc::ServerContext*,
@@ -45,6 +46,9 @@ MOCK_METHOD3(ActivateFlows, Status(grpc::ServerContext*,
 MOCK_METHOD3(DeactivateFlows, Status(grpc::ServerContext*,
   const DeactivateFlowsRequest*,
   DeactivateFlowsResult*));
+MOCK_METHOD3(UpdateFlows, Status(grpc::ServerContext*,
+  const UpdateFlowsRequest*,
+  UpdateFlowsResult*));
 };
 
 class MockPipelinedClient : public PipelinedClient {
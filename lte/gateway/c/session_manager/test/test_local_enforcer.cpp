@@ -12,7 +12,6 @@
 #include <time.h>
 
 #include <gtest/gtest.h>
-#include <folly/io/async/EventBaseManager.h>
 
 #include "MagmaService.h"
 #include "ProtobufCreators.h"
@@ -178,6 +177,37 @@ TEST_F(LocalEnforcerTest, test_collect_updates) {
   EXPECT_EQ(local_enforcer->get_charging_credit("IMSI1", 1, REPORTING_TX), 2048);
 }
 
+TEST_F(LocalEnforcerTest, test_collect_updates_after_failed_report) {
+  CreateSessionResponse response;
+  create_update_response("IMSI1", 1, 1024, response.mutable_credits()->Add());
+  local_enforcer->init_session_credit("IMSI1", "1234", test_cfg, response);
+  CreateSessionResponse response2;
+  create_update_response("IMSI2", 1, 1024, response2.mutable_credits()->Add());
+  local_enforcer->init_session_credit("IMSI2", "4321", test_cfg, response2);
+  insert_static_rule(1, "", "rule1");
+
+  RuleRecordTable table;
+  auto record_list = table.mutable_records();
+  create_rule_record("IMSI1", "rule1", 1024, 2048, record_list->Add());
+  local_enforcer->aggregate_records(table);
+
+  auto session_update = local_enforcer->collect_updates();
+  EXPECT_EQ(session_update.updates_size(), 1);
+  EXPECT_EQ(session_update.updates(0).sid(), "IMSI1");
+
+  // Nothing new was reported, and IMSI1 is still reporting
+  auto empty_update = local_enforcer->collect_updates();
+  EXPECT_EQ(empty_update.updates_size(), 0);
+
+  // The report failed, so the usage has to be collected again
+  local_enforcer->reset_updates(session_update);
+  auto retry_update = local_enforcer->collect_updates();
+  EXPECT_EQ(retry_update.updates_size(), 1);
+  EXPECT_EQ(retry_update.updates(0).sid(), "IMSI1");
+  EXPECT_EQ(retry_update.updates(0).usage().bytes_rx(), 1024);
+  EXPECT_EQ(retry_update.updates(0).usage().bytes_tx(), 2048);
+}
+
 TEST_F(LocalEnforcerTest, test_update_session_credit) {
   insert_static_rule(1, "", "rule1");
 
@@ -454,9 +484,6 @@ TEST_F(LocalEnforcerTest, test_installing_rules_with_activation_time) {
   activation_time->set_seconds(time(NULL) - SECONDS_A_DAY);
   static_rule->set_rule_id("rule6");
 
-  folly::EventBase* evb = folly::EventBaseManager::get()->getEventBase();
-  local_enforcer->attachEventBase(evb);
-
   // expect calling activate_flows_for_rules for activating rules instantly
   // dynamic rules: rule1, rule3
   // static rules: rule4, rule6
@@ -480,7 +507,8 @@ TEST_F(LocalEnforcerTest, test_installing_rules_with_activation_time) {
     .Times(1)
     .WillOnce(testing::Return(true));
   local_enforcer->init_session_credit("IMSI1", "1234", test_cfg, response);
-  delete evb;
+  // the scheduled activations run once their time comes
+  local_enforcer->process_due_timers(time(NULL) + SECONDS_A_DAY);
 }
 
 TEST_F(LocalEnforcerTest, test_usage_monitors) {
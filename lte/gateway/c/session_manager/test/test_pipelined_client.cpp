@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "ServiceRegistrySingleton.h"
+#include "PipelinedClient.h"
+#include "MagmaService.h"
+#include "SessiondMocks.h"
+
+using ::testing::Test;
+using ::testing::_;
+using ::testing::InSequence;
+using grpc::Status;
+
+namespace magma {
+
+class PipelinedClientTest : public ::testing::Test {
+protected:
+
+  /**
+   * Create magma service and run in separate thread
+   */
+  virtual void SetUp() {
+    auto channel = ServiceRegistrySingleton::Instance()->GetGrpcChannel(
+      "test_service", ServiceRegistrySingleton::LOCAL);
+    magma_service = std::make_shared<service303::MagmaService>(
+      "test_service", "1.0");
+    mock_pipelined = std::make_shared<MockPipelined>();
+    magma_service->AddServiceToServer(mock_pipelined.get());
+
+    client = std::make_shared<AsyncPipelinedClient>(channel);
+
+    std::thread client_thread([&]() {
+      std::cout << "Started client thread\n";
+      client->rpc_response_loop();
+      std::cout << "Stopped client thread\n";
+    });
+
+    std::thread pipelined_thread([&]() {
+      std::cout << "Started pipelined thread\n";
+      magma_service->Start();
+      magma_service->WaitForShutdown();
+      std::cout << "Stopped pipelined thread\n";
+    });
+
+    // wait for server to start
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    client_thread.detach();
+    pipelined_thread.detach();
+  }
+
+  virtual void TearDown() {
+    magma_service->Stop();
+    client->stop();
+  }
+
+protected:
+  std::shared_ptr<service303::MagmaService> magma_service;
+  std::shared_ptr<MockPipelined> mock_pipelined;
+  std::shared_ptr<AsyncPipelinedClient> client;
+};
+
+MATCHER_P(CheckBatchSize, size, "") {
+  auto request = static_cast<const UpdateFlowsRequest*>(arg);
+  return request->updates_size() == size;
+}
+
+ACTION_P(WaitForFuture, future_p) {
+  future_p->wait();
+  return Status::OK;
+}
+
+ACTION_P2(SetPromise, promise_p, request_p) {
+  *request_p = *arg1;
+  promise_p->set_value();
+  return Status::OK;
+}
+
+ACTION_P(FailAfterFuture, future_p) {
+  future_p->wait();
+  return Status(grpc::StatusCode::UNAVAILABLE, "pipelined down");
+}
+
+ACTION_P(FailAndSetPromise, promise_p) {
+  promise_p->set_value();
+  return Status(grpc::StatusCode::UNAVAILABLE, "pipelined down");
+}
+
+ACTION(Fail) {
+  return Status(grpc::StatusCode::UNAVAILABLE, "pipelined down");
+}
+
+// Updates made while a batch is in flight are sent in order in the next batch
+TEST_F(PipelinedClientTest, test_batch_while_in_flight) {
+  std::promise<void> release_promise, batch_promise;
+  auto release_future = release_promise.get_future().share();
+  UpdateFlowsRequest second_batch;
+  {
+    InSequence dummy;
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(1), _))
+      .Times(1)
+      .WillOnce(WaitForFuture(&release_future));
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(3), _))
+      .Times(1)
+      .WillOnce(SetPromise(&batch_promise, &second_batch));
+  }
+
+  client->activate_flows_for_rules("IMSI1", "192.168.128.11", {"rule1"}, {});
+  // queued while the first batch is in flight
+  client->deactivate_flows_for_rules("IMSI1", {"rule1"}, {});
+  client->activate_flows_for_rules("IMSI2", "192.168.128.12", {"rule2"}, {});
+  client->deactivate_all_flows("IMSI1");
+  release_promise.set_value();
+
+  auto status = batch_promise.get_future().wait_for(std::chrono::seconds(1));
+  ASSERT_EQ(status, std::future_status::ready);
+  EXPECT_TRUE(second_batch.updates(0).has_deactivate());
+  EXPECT_EQ(second_batch.updates(0).deactivate().sid().id(), "IMSI1");
+  EXPECT_EQ(second_batch.updates(0).deactivate().rule_ids_size(), 1);
+  EXPECT_TRUE(second_batch.updates(1).has_activate());
+  EXPECT_EQ(second_batch.updates(1).activate().sid().id(), "IMSI2");
+  EXPECT_TRUE(second_batch.updates(2).has_deactivate());
+  EXPECT_EQ(second_batch.updates(2).deactivate().rule_ids_size(), 0);
+}
+
+// A failed batch is sent again, ahead of the updates queued meanwhile
+TEST_F(PipelinedClientTest, test_batch_retried_on_failure) {
+  std::promise<void> release_promise, batch_promise;
+  auto release_future = release_promise.get_future().share();
+  UpdateFlowsRequest retried_batch;
+  {
+    InSequence dummy;
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(1), _))
+      .Times(1)
+      .WillOnce(FailAfterFuture(&release_future));
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(3), _))
+      .Times(1)
+      .WillOnce(SetPromise(&batch_promise, &retried_batch));
+  }
+
+  client->activate_flows_for_rules("IMSI1", "192.168.128.11", {"rule1"}, {});
+  // queued while the first batch is in flight
+  client->deactivate_flows_for_rules("IMSI1", {"rule1"}, {});
+  client->activate_flows_for_rules("IMSI2", "192.168.128.12", {"rule2"}, {});
+  release_promise.set_value();
+
+  auto status = batch_promise.get_future().wait_for(std::chrono::seconds(1));
+  ASSERT_EQ(status, std::future_status::ready);
+  EXPECT_TRUE(retried_batch.updates(0).has_activate());
+  EXPECT_EQ(retried_batch.updates(0).activate().sid().id(), "IMSI1");
+  EXPECT_TRUE(retried_batch.updates(1).has_deactivate());
+  EXPECT_EQ(retried_batch.updates(1).deactivate().sid().id(), "IMSI1");
+  EXPECT_TRUE(retried_batch.updates(2).has_activate());
+  EXPECT_EQ(retried_batch.updates(2).activate().sid().id(), "IMSI2");
+}
+
+// A batch that keeps failing is dropped after its retries, 3 of them
+TEST_F(PipelinedClientTest, test_batch_dropped_after_retries) {
+  std::promise<void> dropped_promise, batch_promise;
+  UpdateFlowsRequest next_batch;
+  {
+    InSequence dummy;
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(1), _))
+      .Times(3)
+      .WillRepeatedly(Fail());
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(1), _))
+      .Times(1)
+      .WillOnce(FailAndSetPromise(&dropped_promise));
+    EXPECT_CALL(*mock_pipelined, UpdateFlows(_, CheckBatchSize(1), _))
+      .Times(1)
+      .WillOnce(SetPromise(&batch_promise, &next_batch));
+  }
+
+  client->activate_flows_for_rules("IMSI1", "192.168.128.11", {"rule1"}, {});
+  auto status = dropped_promise.get_future().wait_for(std::chrono::seconds(1));
+  ASSERT_EQ(status, std::future_status::ready);
+
+  // sent on its own, whether queued before or after the batch is dropped
+  client->activate_flows_for_rules("IMSI2", "192.168.128.12", {"rule2"}, {});
+  status = batch_promise.get_future().wait_for(std::chrono::seconds(1));
+  ASSERT_EQ(status, std::future_status::ready);
+  EXPECT_EQ(next_batch.updates(0).activate().sid().id(), "IMSI2");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+}
@@ -0,0 +1,272 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "ProtobufCreators.h"
+#include "ReportScheduler.h"
+#include "ServiceRegistrySingleton.h"
+#include "SessiondMocks.h"
+#include "magma_logging.h"
+
+using ::testing::Test;
+
+namespace magma {
+
+const SessionState::Config test_cfg =
+    {.ue_ipv4 = "127.0.0.1", .spgw_ipv4 = "128.0.0.1"};
+
+const size_t NUM_SUBSCRIBERS = 8;
+
+/**
+ * FakeSessionCloudReporter keeps the reported requests instead of sending
+ * them, so that the test decides when and how each of them completes
+ */
+class FakeSessionCloudReporter : public SessionCloudReporter {
+public:
+  using Callback = std::function<void(grpc::Status, UpdateSessionResponse)>;
+
+  explicit FakeSessionCloudReporter(folly::EventBase* evb)
+    : SessionCloudReporter(
+        evb,
+        ServiceRegistrySingleton::Instance()->GetGrpcChannel(
+          "test_service", ServiceRegistrySingleton::LOCAL)),
+      evb_(evb) {}
+
+  void report_updates(
+      const UpdateSessionRequest& request,
+      Callback callback) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back(request);
+      callbacks_.push_back(callback);
+    }
+    cv_.notify_all();
+  }
+
+  /**
+   * Wait until num_requests requests were reported in total
+   */
+  bool wait_for_requests(size_t num_requests) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
+      return requests_.size() >= num_requests;
+    });
+  }
+
+  size_t get_num_requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_.size();
+  }
+
+  UpdateSessionRequest get_request(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_.at(index);
+  }
+
+  /**
+   * Complete the request at index, in the event base of the scheduler
+   */
+  void complete_request(size_t index, grpc::Status status) {
+    Callback callback;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      callback = callbacks_.at(index);
+    }
+    std::promise<void> done;
+    evb_->runInEventBaseThread([&done, callback, status]() {
+      callback(status, UpdateSessionResponse());
+      done.set_value();
+    });
+    done.get_future().wait();
+  }
+
+private:
+  folly::EventBase* evb_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<UpdateSessionRequest> requests_;
+  std::vector<Callback> callbacks_;
+};
+
+class ReportSchedulerTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    rule_store = std::make_shared<StaticRuleStore>();
+    PolicyRule rule;
+    rule.set_id("rule1");
+    rule.set_rating_group(1);
+    rule.set_tracking_type(PolicyRule::ONLY_OCS);
+    rule_store->insert_rule(rule);
+
+    enforcer = std::make_unique<ShardedEnforcer>(
+      2, rule_store, std::make_shared<MockPipelinedClient>());
+    enforcer->start();
+    reporter = std::make_unique<FakeSessionCloudReporter>(&evb);
+    evb_thread = std::thread([this]() { evb.loopForever(); });
+
+    // give each subscriber 1024 bytes of credit, and use all of it so that
+    // every session has an update to report
+    RuleRecordTable table;
+    for (size_t i = 0; i < NUM_SUBSCRIBERS; i++) {
+      auto imsi = "IMSI" + std::to_string(i);
+      std::promise<void> done;
+      enforcer->run_in_shard(imsi, [&done, imsi](LocalEnforcer& shard) {
+        CreateSessionResponse response;
+        create_update_response(
+          imsi, 1, 1024, response.mutable_credits()->Add());
+        shard.init_session_credit(imsi, imsi + "-1", test_cfg, response);
+        done.set_value();
+      });
+      done.get_future().wait();
+      create_rule_record(imsi, "rule1", 1024, 1024, table.mutable_records()->Add());
+      imsis.insert(imsi);
+    }
+    std::promise<void> aggregated;
+    enforcer->aggregate_records(table, [&aggregated]() {
+      aggregated.set_value();
+    });
+    aggregated.get_future().wait();
+  }
+
+  virtual void TearDown() {
+    // the scheduler is destroyed in the event base, after its last callback
+    std::promise<void> done;
+    evb.runInEventBaseThread([this, &done]() {
+      scheduler.reset();
+      done.set_value();
+    });
+    done.get_future().wait();
+    evb.terminateLoopSoon();
+    evb_thread.join();
+    enforcer->stop();
+  }
+
+  void start_scheduler(const ReportScheduler::Config& config) {
+    scheduler = std::make_unique<ReportScheduler>(
+      &evb, enforcer.get(), reporter.get(), config);
+  }
+
+  std::set<std::string> get_reported_sids() {
+    std::set<std::string> sids;
+    for (size_t i = 0; i < reporter->get_num_requests(); i++) {
+      for (const auto& update : reporter->get_request(i).updates()) {
+        EXPECT_TRUE(sids.insert(update.sid()).second);
+      }
+    }
+    return sids;
+  }
+
+protected:
+  folly::EventBase evb;
+  std::thread evb_thread;
+  std::shared_ptr<StaticRuleStore> rule_store;
+  std::unique_ptr<ShardedEnforcer> enforcer;
+  std::unique_ptr<FakeSessionCloudReporter> reporter;
+  std::unique_ptr<ReportScheduler> scheduler;
+  std::set<std::string> imsis;
+};
+
+TEST_F(ReportSchedulerTest, test_flush_interval) {
+  auto flush_interval = std::chrono::milliseconds(200);
+  start_scheduler({
+    .flush_interval = flush_interval,
+    .max_batch_size = 0,
+    .max_inflight_requests = 4,
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  scheduler->schedule_flush();
+  scheduler->schedule_flush();
+  scheduler->schedule_flush();
+  ASSERT_TRUE(reporter->wait_for_requests(1));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, flush_interval);
+
+  // the flushes asked before the timer fired are reported together
+  std::this_thread::sleep_for(2 * flush_interval);
+  EXPECT_EQ(reporter->get_num_requests(), 1);
+  EXPECT_EQ(get_reported_sids(), imsis);
+}
+
+TEST_F(ReportSchedulerTest, test_batch_splitting) {
+  start_scheduler({
+    .flush_interval = std::chrono::milliseconds(10),
+    .max_batch_size = 3,
+    .max_inflight_requests = 10,
+  });
+
+  scheduler->schedule_flush();
+  ASSERT_TRUE(reporter->wait_for_requests(3));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(reporter->get_num_requests(), 3);
+  EXPECT_EQ(reporter->get_request(0).updates_size(), 3);
+  EXPECT_EQ(reporter->get_request(1).updates_size(), 3);
+  EXPECT_EQ(reporter->get_request(2).updates_size(), 2);
+  EXPECT_EQ(get_reported_sids(), imsis);
+}
+
+TEST_F(ReportSchedulerTest, test_max_inflight_requests) {
+  start_scheduler({
+    .flush_interval = std::chrono::milliseconds(10),
+    .max_batch_size = 1,
+    .max_inflight_requests = 2,
+  });
+
+  scheduler->schedule_flush();
+  ASSERT_TRUE(reporter->wait_for_requests(2));
+  // the other batches wait for a request to complete
+  scheduler->schedule_flush();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(reporter->get_num_requests(), 2);
+
+  // every completed request makes room for exactly one more
+  for (size_t i = 0; i < NUM_SUBSCRIBERS - 2; i++) {
+    reporter->complete_request(i, grpc::Status::OK);
+    ASSERT_TRUE(reporter->wait_for_requests(i + 3));
+    EXPECT_EQ(reporter->get_num_requests(), i + 3);
+  }
+  EXPECT_EQ(get_reported_sids(), imsis);
+}
+
+TEST_F(ReportSchedulerTest, test_failed_request_reported_again) {
+  start_scheduler({
+    .flush_interval = std::chrono::milliseconds(10),
+    .max_batch_size = 0,
+    .max_inflight_requests = 1,
+  });
+
+  scheduler->schedule_flush();
+  ASSERT_TRUE(reporter->wait_for_requests(1));
+  reporter->complete_request(0, grpc::Status::CANCELLED);
+
+  scheduler->schedule_flush();
+  ASSERT_TRUE(reporter->wait_for_requests(2));
+  std::set<std::string> sids;
+  for (const auto& update : reporter->get_request(1).updates()) {
+    sids.insert(update.sid());
+  }
+  EXPECT_EQ(sids, imsis);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = 1;
+  FLAGS_v = 10;
+  return RUN_ALL_TESTS();
+}
+
+}
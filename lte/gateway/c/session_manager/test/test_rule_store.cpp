@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "PolicyLoader.h"
+#include "RuleStore.h"
+#include "magma_logging.h"
+
+using ::testing::Test;
+
+namespace magma {
+
+class RuleStoreTest : public ::testing::Test {
+protected:
+  PolicyRule create_rule(
+      const std::string& rule_id,
+      uint32_t rating_group,
+      const std::string& m_key) {
+    PolicyRule rule;
+    rule.set_id(rule_id);
+    rule.set_rating_group(rating_group);
+    rule.set_monitoring_key(m_key);
+    rule.set_tracking_type(PolicyRule::OCS_AND_PCRF);
+    return rule;
+  }
+
+protected:
+  StaticRuleStore rule_store;
+};
+
+TEST_F(RuleStoreTest, test_apply_rule_changes) {
+  rule_store.apply_rule_changes(
+    {create_rule("rule1", 1, "m1"), create_rule("rule2", 1, "m2")}, {});
+
+  std::vector<std::string> rule_ids;
+  EXPECT_TRUE(rule_store.get_rule_ids_for_charging_key(1, rule_ids));
+  EXPECT_EQ(rule_ids.size(), 2);
+
+  // rule1 moves to another charging key, rule2 is removed
+  rule_store.apply_rule_changes({create_rule("rule1", 2, "m1")}, {"rule2"});
+
+  rule_ids.clear();
+  EXPECT_FALSE(rule_store.get_rule_ids_for_charging_key(1, rule_ids));
+  EXPECT_TRUE(rule_store.get_rule_ids_for_charging_key(2, rule_ids));
+  EXPECT_EQ(rule_ids, std::vector<std::string>{"rule1"});
+
+  rule_ids.clear();
+  EXPECT_FALSE(rule_store.get_rule_ids_for_monitoring_key("m2", rule_ids));
+
+  uint32_t charging_key;
+  EXPECT_TRUE(rule_store.get_charging_key_for_rule_id("rule1", &charging_key));
+  EXPECT_EQ(charging_key, 2);
+  PolicyRule rule;
+  EXPECT_FALSE(rule_store.get_rule("rule2", &rule));
+}
+
+TEST_F(RuleStoreTest, test_sync_rules) {
+  rule_store.insert_rule(create_rule("rule1", 1, "m1"));
+  rule_store.sync_rules({create_rule("rule2", 2, "m2")});
+
+  std::vector<PolicyRule> rules;
+  rule_store.get_rules(rules);
+  EXPECT_EQ(rules.size(), 1);
+  EXPECT_EQ(rules[0].id(), "rule2");
+
+  std::vector<std::string> rule_ids;
+  EXPECT_FALSE(rule_store.get_rule_ids_for_charging_key(1, rule_ids));
+  EXPECT_TRUE(rule_store.get_rule_ids_for_monitoring_key("m2", rule_ids));
+}
+
+TEST_F(RuleStoreTest, test_snapshot_unchanged_by_writes) {
+  rule_store.insert_rule(create_rule("rule1", 1, "m1"));
+  auto snapshot = rule_store.get_snapshot();
+
+  rule_store.apply_rule_changes({create_rule("rule2", 1, "m2")}, {"rule1"});
+
+  // The snapshot taken before the change still sees the old rules
+  EXPECT_NE(snapshot->get_rule("rule1"), nullptr);
+  EXPECT_EQ(snapshot->get_rule("rule2"), nullptr);
+  auto rules = snapshot->get_rules_by_charging_key().get_rules_for_key(1);
+  ASSERT_NE(rules, nullptr);
+  EXPECT_EQ(rules->size(), 1);
+  EXPECT_EQ((*rules)[0]->id(), "rule1");
+
+  auto new_snapshot = rule_store.get_snapshot();
+  EXPECT_EQ(new_snapshot->get_rule("rule1"), nullptr);
+  ASSERT_NE(new_snapshot->get_rule("rule2"), nullptr);
+  EXPECT_EQ(new_snapshot->get_rule("rule2")->monitoring_key(), "m2");
+}
+
+TEST_F(RuleStoreTest, test_sync_bad_rule) {
+  std::unordered_map<std::string, std::string> synced_rules;
+  std::unordered_map<std::string, std::string> serialized_rules;
+  std::vector<PolicyRule> updated_rules;
+  std::vector<std::string> removed_rule_ids;
+  auto sync = [&]() {
+    updated_rules.clear();
+    removed_rule_ids.clear();
+    diff_serialized_rules(
+      synced_rules, serialized_rules, updated_rules, removed_rule_ids);
+    rule_store.apply_rule_changes(updated_rules, removed_rule_ids);
+  };
+  auto good_rule1 = create_rule("rule1", 1, "m1").SerializeAsString();
+
+  serialized_rules["rule1"] = good_rule1;
+  serialized_rules["rule2"] = create_rule("rule2", 2, "m2").SerializeAsString();
+  sync();
+  EXPECT_EQ(updated_rules.size(), 2);
+  EXPECT_EQ(synced_rules.size(), 2);
+
+  // rule1 changes to a value that does not deserialize, its previous version
+  // is removed and it is not synced
+  serialized_rules = synced_rules;
+  serialized_rules["rule1"] = "\xff";
+  sync();
+  EXPECT_TRUE(updated_rules.empty());
+  EXPECT_EQ(removed_rule_ids, std::vector<std::string>{"rule1"});
+  EXPECT_EQ(synced_rules.count("rule1"), 0);
+  PolicyRule rule;
+  EXPECT_FALSE(rule_store.get_rule("rule1", &rule));
+  EXPECT_TRUE(rule_store.get_rule("rule2", &rule));
+
+  // Retried at every sync, nothing is removed twice
+  serialized_rules = synced_rules;
+  serialized_rules["rule1"] = "\xff";
+  sync();
+  EXPECT_TRUE(updated_rules.empty());
+  EXPECT_TRUE(removed_rule_ids.empty());
+
+  // Once fixed, the rule is back
+  serialized_rules = synced_rules;
+  serialized_rules["rule1"] = good_rule1;
+  sync();
+  ASSERT_EQ(updated_rules.size(), 1);
+  EXPECT_EQ(updated_rules[0].id(), "rule1");
+  EXPECT_TRUE(removed_rule_ids.empty());
+  EXPECT_TRUE(rule_store.get_rule("rule1", &rule));
+  EXPECT_EQ(synced_rules.size(), 2);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  FLAGS_v = 10;
+  return RUN_ALL_TESTS();
+}
+
+}
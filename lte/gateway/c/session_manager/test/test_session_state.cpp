@@ -270,6 +270,46 @@ TEST_F(SessionStateTest, test_reauth_all) {
   EXPECT_EQ(reauth_res, ChargingReAuthAnswer::UPDATE_NOT_NEEDED);
 }
 
+TEST_F(SessionStateTest, test_marshal_unmarshal) {
+  insert_rule(1, "m1", "rule1", true);
+  insert_rule(2, "", "dyn_rule1", false);
+
+  receive_credit_from_ocs(1, 1024);
+  receive_credit_from_ocs(2, 1024);
+  receive_credit_from_pcrf("m1", 1024, MonitoringLevel::PCC_RULE_LEVEL);
+  receive_credit_from_pcrf("m2", 1024, MonitoringLevel::SESSION_LEVEL);
+
+  session_state->add_used_credit("rule1", 2000, 1000);
+  UpdateSessionRequest update;
+  std::vector<std::unique_ptr<ServiceAction>> actions;
+  session_state->get_updates(&update, &actions);
+  EXPECT_EQ(update.updates_size(), 1);
+  session_state->add_used_credit("dyn_rule1", 10, 20);
+
+  auto restored = SessionState::unmarshal(
+    session_state->marshal(), *rule_store);
+  EXPECT_EQ(restored->get_session_id(), "session");
+  EXPECT_EQ(restored->get_subscriber_ip_addr(), "127.0.0.1");
+  auto& charging_pool = restored->get_charging_pool();
+  EXPECT_EQ(charging_pool.get_credit(1, ALLOWED_TOTAL), 1024);
+  EXPECT_EQ(charging_pool.get_credit(1, USED_TX), 2000);
+  EXPECT_EQ(charging_pool.get_credit(2, USED_RX), 20);
+  // The update in flight is not restored
+  EXPECT_EQ(charging_pool.get_credit(1, REPORTING_TX), 0);
+  auto& monitor_pool = restored->get_monitor_pool();
+  EXPECT_EQ(monitor_pool.get_credit("m1", USED_TX), 2000);
+  EXPECT_EQ(*monitor_pool.get_session_level_key(), "m2");
+
+  // The dynamic rule is restored, and the usage is reported again
+  restored->add_used_credit("dyn_rule1", 10, 20);
+  EXPECT_EQ(charging_pool.get_credit(2, USED_RX), 40);
+  UpdateSessionRequest restored_update;
+  restored->get_updates(&restored_update, &actions);
+  EXPECT_EQ(restored_update.updates_size(), 1);
+  EXPECT_EQ(restored_update.updates(0).usage().charging_key(), 1);
+  EXPECT_EQ(restored_update.updates(0).usage().bytes_tx(), 2000);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   FLAGS_logtostderr = 1;
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "FakeRedisTcpClient.h"
+#include "LocalEnforcer.h"
+#include "ProtobufCreators.h"
+#include "SessiondMocks.h"
+#include "SessionState.h"
+#include "SessionStore.h"
+#include "magma_logging.h"
+
+using ::testing::Test;
+
+namespace magma {
+
+class SessionStoreTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    rule_store = std::make_shared<StaticRuleStore>();
+    PolicyRule rule;
+    rule.set_id("rule1");
+    rule.set_rating_group(1);
+    rule.set_tracking_type(PolicyRule::ONLY_OCS);
+    rule_store->insert_rule(rule);
+
+    tcp_client = std::make_shared<FakeRedisTcpClient>();
+    session_store = std::make_shared<SessionStore>(
+      make_fake_redis_client(tcp_client));
+  }
+
+  StoredSessionState create_stored_session(
+      const std::string& imsi,
+      const std::string& ue_ipv4,
+      uint64_t volume) {
+    SessionState session(
+      imsi, imsi + "-1", {.ue_ipv4 = ue_ipv4}, *rule_store);
+    CreditUpdateResponse charge_resp;
+    create_update_response(imsi, 1, volume, &charge_resp);
+    session.get_charging_pool().receive_credit(charge_resp);
+    session.add_used_credit("rule1", 10, 20);
+    return session.marshal();
+  }
+
+  // Run the write loop until the queued changes are written
+  void write_queued_changes() {
+    std::thread write_thread([this]() { session_store->write_loop(); });
+    session_store->stop();
+    write_thread.join();
+  }
+
+protected:
+  std::shared_ptr<StaticRuleStore> rule_store;
+  std::shared_ptr<FakeRedisTcpClient> tcp_client;
+  std::shared_ptr<SessionStore> session_store;
+};
+
+TEST_F(SessionStoreTest, test_write_read_sessions) {
+  session_store->write_session(
+    create_stored_session("IMSI1", "192.168.128.1", 1024));
+  session_store->write_session(
+    create_stored_session("IMSI2", "192.168.128.2", 2048));
+  write_queued_changes();
+
+  auto sessions = session_store->read_sessions();
+  ASSERT_EQ(sessions.size(), 2);
+  std::sort(sessions.begin(), sessions.end(),
+    [](const StoredSessionState& a, const StoredSessionState& b) {
+      return a.imsi() < b.imsi();
+    });
+  EXPECT_EQ(sessions[0].imsi(), "IMSI1");
+  EXPECT_EQ(sessions[0].session_id(), "IMSI1-1");
+  EXPECT_EQ(sessions[0].config().ue_ipv4(), "192.168.128.1");
+  EXPECT_EQ(sessions[1].imsi(), "IMSI2");
+
+  auto restored = SessionState::unmarshal(sessions[1], *rule_store);
+  auto& charging_pool = restored->get_charging_pool();
+  EXPECT_EQ(charging_pool.get_credit(1, ALLOWED_TOTAL), 2048);
+  EXPECT_EQ(charging_pool.get_credit(1, USED_RX), 10);
+  EXPECT_EQ(charging_pool.get_credit(1, USED_TX), 20);
+}
+
+TEST_F(SessionStoreTest, test_latest_change_written) {
+  session_store->write_session(
+    create_stored_session("IMSI1", "192.168.128.1", 1024));
+  session_store->write_session(
+    create_stored_session("IMSI1", "192.168.128.1", 4096));
+  session_store->write_session(
+    create_stored_session("IMSI2", "192.168.128.2", 2048));
+  session_store->remove_session("IMSI2");
+  write_queued_changes();
+
+  auto sessions = session_store->read_sessions();
+  ASSERT_EQ(sessions.size(), 1);
+  auto restored = SessionState::unmarshal(sessions[0], *rule_store);
+  EXPECT_EQ(restored->get_charging_pool().get_credit(1, ALLOWED_TOTAL), 4096);
+}
+
+TEST_F(SessionStoreTest, test_unreadable_session_dropped) {
+  session_store->write_session(
+    create_stored_session("IMSI1", "192.168.128.1", 1024));
+  write_queued_changes();
+  tcp_client->set_raw("sessiond:sessions", "IMSI2", "not a session");
+
+  auto sessions = session_store->read_sessions();
+  ASSERT_EQ(sessions.size(), 1);
+  EXPECT_EQ(sessions[0].imsi(), "IMSI1");
+  EXPECT_EQ(session_store->read_sessions().size(), 1);
+}
+
+TEST_F(SessionStoreTest, test_restore_sessions) {
+  // 20 bytes used out of 16, the session has an update to report
+  session_store->write_session(
+    create_stored_session("IMSI1", "192.168.128.1", 16));
+  session_store->write_session(
+    create_stored_session("IMSI2", "192.168.128.2", 1024));
+  session_store->remove_session("IMSI2");
+  write_queued_changes();
+
+  LocalEnforcer enforcer(rule_store, std::make_shared<MockPipelinedClient>());
+  enforcer.restore_sessions(session_store->read_sessions());
+  EXPECT_EQ(enforcer.get_charging_credit("IMSI1", 1, ALLOWED_TOTAL), 16);
+  EXPECT_EQ(enforcer.get_charging_credit("IMSI1", 1, USED_TX), 20);
+  EXPECT_EQ(enforcer.get_charging_credit("IMSI2", 1, ALLOWED_TOTAL), 0);
+
+  auto update = enforcer.collect_updates();
+  ASSERT_EQ(update.updates_size(), 1);
+  EXPECT_EQ(update.updates(0).sid(), "IMSI1");
+  EXPECT_EQ(update.updates(0).usage().bytes_tx(), 20);
+}
+
+TEST_F(SessionStoreTest, test_find_detached_sessions) {
+  std::vector<StoredSessionState> sessions = {
+    create_stored_session("IMSI1", "192.168.128.1", 1024),
+    create_stored_session("IMSI2", "192.168.128.2", 1024),
+    create_stored_session("IMSI3", "192.168.128.3", 1024),
+  };
+  std::unordered_map<std::string, std::string> ipv4_by_imsi = {
+    {"1", "192.168.128.1"},
+    // detached and attached again with another IP
+    {"2", "192.168.128.20"},
+  };
+
+  auto detached = find_detached_sessions(sessions, ipv4_by_imsi);
+  std::sort(detached.begin(), detached.end());
+  EXPECT_EQ(detached, std::vector<std::string>({"IMSI2", "IMSI3"}));
+  EXPECT_TRUE(find_detached_sessions({}, ipv4_by_imsi).empty());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = 1;
+  FLAGS_v = 10;
+  return RUN_ALL_TESTS();
+}
+
+}
@@ -23,6 +23,8 @@
 #include "SessionManagerServer.h"
 #include "SessiondMocks.h"
 #include "LocalEnforcer.h"
+#include "ReportScheduler.h"
+#include "ShardedEnforcer.h"
 
 using ::testing::Test;
 using ::testing::_;
@@ -49,18 +51,27 @@ protected:
     insert_static_rule(rule_store, 2, "rule3");
 
     monitor = std::make_shared<LocalEnforcer>(rule_store, pipelined_client);
+    monitor->attachEventBase(evb);
+    enforcer = std::make_shared<ShardedEnforcer>(
+      std::vector<std::shared_ptr<LocalEnforcer>>{monitor});
     reporter = std::make_shared<SessionCloudReporter>(evb, test_channel);
+    report_scheduler = std::make_shared<ReportScheduler>(
+      evb, enforcer.get(), reporter.get(), ReportScheduler::Config{
+        .flush_interval = std::chrono::milliseconds(0),
+        .max_batch_size = 0,
+        .max_inflight_requests = 1,
+      });
 
     local_service = std::make_shared<service303::MagmaService>(
       "sessiond", "1.0");
     session_manager = std::make_shared<LocalSessionManagerAsyncService>(
       local_service->GetNewCompletionQueue(),
       std::make_unique<LocalSessionManagerHandlerImpl>(
-        monitor.get(), reporter.get()));
+        enforcer.get(), reporter.get(), report_scheduler.get()));
 
     proxy_responder = std::make_shared<SessionProxyResponderAsyncService>(
       local_service->GetNewCompletionQueue(),
-      std::make_unique<SessionProxyResponderHandlerImpl>(monitor.get()));
+      std::make_unique<SessionProxyResponderHandlerImpl>(enforcer.get()));
 
     local_service->AddServiceToServer(session_manager.get());
     local_service->AddServiceToServer(proxy_responder.get());
@@ -82,7 +93,6 @@ protected:
     }).detach();
     std::thread([&]() {
       std::cout << "Started monitor thread\n";
-      monitor->attachEventBase(evb);
       monitor->start();
     }).detach();
     std::thread([&]() {
@@ -132,7 +142,9 @@ protected:
   std::shared_ptr<MockCentralController> controller_mock;
   std::shared_ptr<MockPipelined> pipelined_mock;
   std::shared_ptr<LocalEnforcer> monitor;
+  std::shared_ptr<ShardedEnforcer> enforcer;
   std::shared_ptr<SessionCloudReporter> reporter;
+  std::shared_ptr<ReportScheduler> report_scheduler;
   std::shared_ptr<LocalSessionManagerAsyncService> session_manager;
   std::shared_ptr<SessionProxyResponderAsyncService> proxy_responder;
   std::shared_ptr<service303::MagmaService> local_service;
@@ -166,13 +178,19 @@ MATCHER_P(CheckTerminate, imsi, "") {
 }
 
 MATCHER_P2(CheckActivateFlows, imsi, rule_count, "") {
-  auto request = static_cast<const ActivateFlowsRequest*>(arg);
-  return request->sid().id() == imsi && request->rule_ids_size() == rule_count;
+  auto request = static_cast<const UpdateFlowsRequest*>(arg);
+  if (request->updates_size() != 1 || !request->updates(0).has_activate()) {
+    return false;
+  }
+  auto& activate = request->updates(0).activate();
+  return activate.sid().id() == imsi && activate.rule_ids_size() == rule_count;
 }
 
 MATCHER_P(CheckDeactivateFlows, imsi, "") {
-  auto request = static_cast<const DeactivateFlowsRequest*>(arg);
-  return request->sid().id() == imsi;
+  auto request = static_cast<const UpdateFlowsRequest*>(arg);
+  return request->updates_size() == 1
+    && request->updates(0).has_deactivate()
+    && request->updates(0).deactivate().sid().id() == imsi;
 }
 
 ACTION_P2(SetEndPromise, promise_p, status) {
@@ -213,7 +231,7 @@ TEST_F(SessiondTest, end_to_end_success) {
                                testing::Return(grpc::Status::OK)));
 
     EXPECT_CALL(*pipelined_mock,
-      ActivateFlows(
+      UpdateFlows(
         testing::_,
         CheckActivateFlows("IMSI1", 3),
         testing::_))
@@ -237,7 +255,7 @@ TEST_F(SessiondTest, end_to_end_success) {
 
     // Expect flows to be deactivated before final update is sent out
     EXPECT_CALL(*pipelined_mock,
-      DeactivateFlows(
+      UpdateFlows(
         testing::_,
         CheckDeactivateFlows("IMSI1"),
         testing::_))
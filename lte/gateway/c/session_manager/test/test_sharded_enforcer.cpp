@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <set>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "ProtobufCreators.h"
+#include "SessiondMocks.h"
+#include "ShardedEnforcer.h"
+#include "magma_logging.h"
+
+using ::testing::Test;
+
+namespace magma {
+
+const SessionState::Config test_cfg =
+    {.ue_ipv4 = "127.0.0.1", .spgw_ipv4 = "128.0.0.1"};
+
+const size_t NUM_SHARDS = 4;
+const size_t NUM_SUBSCRIBERS = 32;
+
+class ShardedEnforcerTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    rule_store = std::make_shared<StaticRuleStore>();
+    PolicyRule rule;
+    rule.set_id("rule1");
+    rule.set_rating_group(1);
+    rule.set_tracking_type(PolicyRule::ONLY_OCS);
+    rule_store->insert_rule(rule);
+
+    pipelined_client = std::make_shared<MockPipelinedClient>();
+    enforcer = std::make_unique<ShardedEnforcer>(
+      NUM_SHARDS, rule_store, pipelined_client);
+    enforcer->start();
+
+    for (size_t i = 0; i < NUM_SUBSCRIBERS; i++) {
+      imsis.push_back("IMSI" + std::to_string(i));
+    }
+    // give each subscriber 1024 bytes of credit
+    for (const auto& imsi : imsis) {
+      run_in_shard_and_wait(imsi, [imsi](LocalEnforcer& shard) {
+        CreateSessionResponse response;
+        create_update_response(
+          imsi, 1, 1024, response.mutable_credits()->Add());
+        shard.init_session_credit(imsi, imsi + "-1", test_cfg, response);
+      });
+    }
+  }
+
+  virtual void TearDown() {
+    enforcer->stop();
+  }
+
+  void run_in_shard_and_wait(
+      const std::string& imsi,
+      std::function<void(LocalEnforcer&)> fn) {
+    std::promise<void> done;
+    enforcer->run_in_shard(imsi, [&done, fn](LocalEnforcer& shard) {
+      fn(shard);
+      done.set_value();
+    });
+    done.get_future().wait();
+  }
+
+  uint64_t get_charging_credit(const std::string& imsi, Bucket bucket) {
+    uint64_t credit;
+    run_in_shard_and_wait(imsi, [&credit, imsi, bucket](LocalEnforcer& shard) {
+      credit = shard.get_charging_credit(imsi, 1, bucket);
+    });
+    return credit;
+  }
+
+  void aggregate_records(const RuleRecordTable& table) {
+    std::promise<void> done;
+    enforcer->aggregate_records(table, [&done]() { done.set_value(); });
+    done.get_future().wait();
+  }
+
+  UpdateSessionRequest collect_updates() {
+    UpdateSessionRequest merged;
+    std::promise<void> done;
+    enforcer->collect_updates([&merged, &done](UpdateSessionRequest& request) {
+      merged.Swap(&request);
+      done.set_value();
+    });
+    done.get_future().wait();
+    return merged;
+  }
+
+  std::set<std::string> get_update_sids(const UpdateSessionRequest& request) {
+    std::set<std::string> sids;
+    for (const auto& update : request.updates()) {
+      EXPECT_TRUE(sids.insert(update.sid()).second);
+    }
+    return sids;
+  }
+
+protected:
+  std::shared_ptr<StaticRuleStore> rule_store;
+  std::shared_ptr<MockPipelinedClient> pipelined_client;
+  std::unique_ptr<ShardedEnforcer> enforcer;
+  std::vector<std::string> imsis;
+};
+
+TEST_F(ShardedEnforcerTest, test_sessions_spread_over_shards) {
+  EXPECT_EQ(enforcer->get_num_shards(), NUM_SHARDS);
+  std::set<size_t> used_shards;
+  for (const auto& imsi : imsis) {
+    auto index = enforcer->get_shard_index(imsi);
+    EXPECT_LT(index, NUM_SHARDS);
+    EXPECT_EQ(index, enforcer->get_shard_index(imsi));
+    used_shards.insert(index);
+  }
+  // the other tests only cover the splitting if several shards are used
+  EXPECT_GT(used_shards.size(), 1u);
+}
+
+TEST_F(ShardedEnforcerTest, test_aggregate_records) {
+  RuleRecordTable table;
+  for (size_t i = 0; i < imsis.size(); i++) {
+    create_rule_record(
+      imsis[i], "rule1", i, 2 * i, table.mutable_records()->Add());
+  }
+  aggregate_records(table);
+
+  for (size_t i = 0; i < imsis.size(); i++) {
+    EXPECT_EQ(get_charging_credit(imsis[i], USED_RX), i);
+    EXPECT_EQ(get_charging_credit(imsis[i], USED_TX), 2 * i);
+  }
+
+  // empty tables complete right away
+  aggregate_records(RuleRecordTable());
+}
+
+TEST_F(ShardedEnforcerTest, test_collect_updates) {
+  // exhaust the credit of every other subscriber
+  RuleRecordTable table;
+  std::set<std::string> exhausted;
+  for (size_t i = 0; i < imsis.size(); i += 2) {
+    create_rule_record(
+      imsis[i], "rule1", 1024, 1024, table.mutable_records()->Add());
+    exhausted.insert(imsis[i]);
+  }
+  aggregate_records(table);
+
+  auto request = collect_updates();
+  EXPECT_EQ(get_update_sids(request), exhausted);
+  for (const auto& update : request.updates()) {
+    EXPECT_EQ(update.usage().bytes_rx(), 1024);
+    EXPECT_EQ(update.usage().bytes_tx(), 1024);
+  }
+
+  // the updates are in flight, nothing more to collect
+  EXPECT_EQ(collect_updates().updates_size(), 0);
+
+  // once reset, the failed updates are collected again from every shard
+  enforcer->reset_updates(request);
+  EXPECT_EQ(get_update_sids(collect_updates()), exhausted);
+}
+
+TEST_F(ShardedEnforcerTest, test_update_session_credit) {
+  RuleRecordTable table;
+  for (const auto& imsi : imsis) {
+    create_rule_record(imsi, "rule1", 1024, 1024, table.mutable_records()->Add());
+  }
+  aggregate_records(table);
+  auto request = collect_updates();
+  EXPECT_EQ(request.updates_size(), imsis.size());
+
+  UpdateSessionResponse response;
+  for (size_t i = 0; i < imsis.size(); i++) {
+    create_update_response(
+      imsis[i], 1, 1024 * (i + 1), response.mutable_responses()->Add());
+  }
+  enforcer->update_session_credit(response);
+
+  for (size_t i = 0; i < imsis.size(); i++) {
+    EXPECT_EQ(
+      get_charging_credit(imsis[i], ALLOWED_TOTAL), 1024 + 1024 * (i + 1));
+    EXPECT_EQ(get_charging_credit(imsis[i], REPORTING_TX), 0);
+    EXPECT_EQ(get_charging_credit(imsis[i], REPORTED_TX), 1024);
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = 1;
+  FLAGS_v = 10;
+  return RUN_ALL_TESTS();
+}
+
+}
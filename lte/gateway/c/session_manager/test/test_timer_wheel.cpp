@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <time.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "TimerWheel.h"
+#include "magma_logging.h"
+
+using ::testing::Test;
+
+namespace magma {
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    now = time(NULL);
+  }
+
+protected:
+  TimerWheel wheel{8};
+  std::time_t now;
+};
+
+TEST_F(TimerWheelTest, test_runs_due_timers) {
+  std::vector<int> fired;
+  wheel.add(now + 2, [&fired] { fired.push_back(2); });
+  wheel.add(now + 1, [&fired] { fired.push_back(1); });
+  wheel.add(now + 5, [&fired] { fired.push_back(5); });
+  EXPECT_EQ(wheel.size(), 3);
+
+  EXPECT_EQ(wheel.advance(now), 0);
+  EXPECT_EQ(wheel.advance(now + 2), 2);
+  EXPECT_EQ(fired, std::vector<int>({1, 2}));
+  EXPECT_EQ(wheel.size(), 1);
+
+  // advancing backwards does nothing
+  EXPECT_EQ(wheel.advance(now + 1), 0);
+  EXPECT_EQ(wheel.advance(now + 5), 1);
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST_F(TimerWheelTest, test_past_deadline_runs_next_advance) {
+  int fired = 0;
+  wheel.advance(now);
+  wheel.add(now - 100, [&fired] { fired++; });
+  EXPECT_EQ(wheel.advance(now + 1), 1);
+  EXPECT_EQ(fired, 1);
+}
+
+TEST_F(TimerWheelTest, test_deadline_beyond_one_turn) {
+  int fired = 0;
+  wheel.advance(now);
+  // same slot as now + 3, but two turns later
+  wheel.add(now + 19, [&fired] { fired++; });
+  EXPECT_EQ(wheel.advance(now + 3), 0);
+  EXPECT_EQ(wheel.advance(now + 11), 0);
+  EXPECT_EQ(wheel.advance(now + 18), 0);
+  EXPECT_EQ(wheel.advance(now + 19), 1);
+  EXPECT_EQ(fired, 1);
+}
+
+TEST_F(TimerWheelTest, test_skip_more_than_one_turn) {
+  int fired = 0;
+  wheel.advance(now);
+  for (int i = 1; i <= 30; i++) {
+    wheel.add(now + i, [&fired] { fired++; });
+  }
+  EXPECT_EQ(wheel.advance(now + 100), 30);
+  EXPECT_EQ(fired, 30);
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST_F(TimerWheelTest, test_callback_adds_timer) {
+  int fired = 0;
+  wheel.advance(now);
+  wheel.add(now + 1, [this, &fired] {
+    fired++;
+    // rearm at a time that is already due, runs at the next advance
+    wheel.add(now + 1, [&fired] { fired++; });
+  });
+  EXPECT_EQ(wheel.advance(now + 1), 1);
+  EXPECT_EQ(wheel.size(), 1);
+  EXPECT_EQ(wheel.advance(now + 2), 1);
+  EXPECT_EQ(fired, 2);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  FLAGS_v = 10;
+  return RUN_ALL_TESTS();
+}
+
+}
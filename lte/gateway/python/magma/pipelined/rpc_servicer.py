@@ -21,6 +21,8 @@ from lte.protos.pipelined_pb2 import (
     ActivateFlowsRequest,
     AllTableAssignments,
     TableAssignment,
+    UpdateFlowsRequest,
+    UpdateFlowsResult,
 )
 from lte.protos.policydb_pb2 import PolicyRule
 from magma.pipelined.app.dpi import DPIController
@@ -176,6 +178,48 @@ class PipelinedRpcServicer(pipelined_pb2_grpc.PipelinedServicer):
                 request.sid.id)
         self._enforcer_app.deactivate_rules(request.sid.id, request.rule_ids)
 
+    def UpdateFlows(self, request, context):
+        """
+        Activate and deactivate flows for many subscribers, in order
+        """
+        if not self._service_manager.is_app_enabled(
+                EnforcementController.APP_NAME):
+            context.set_code(grpc.StatusCode.UNAVAILABLE)
+            context.set_details('Service not enabled!')
+            return None
+
+        fut = Future()  # type: Future[UpdateFlowsResult]
+        self._loop.call_soon_threadsafe(self._update_flows, request, fut)
+        return fut.result()
+
+    def _update_flows(self, request: UpdateFlowsRequest,
+                      fut: 'Future[UpdateFlowsResult]') -> None:
+        logging.debug('Updating flows for %d requests', len(request.updates))
+        try:
+            result = self._apply_flow_updates(request)
+        except Exception as e:  # pylint: disable=broad-except
+            # UpdateFlows waits on fut, it must not be left unset
+            logging.error('Failed to update flows: %s', e)
+            fut.set_exception(e)
+            return
+        fut.set_result(result)
+
+    def _apply_flow_updates(self, request: UpdateFlowsRequest
+                            ) -> UpdateFlowsResult:
+        """
+        Apply the updates one after the other in the event loop, so that the
+        updates of a subscriber are applied in the order sessiond sent them.
+        """
+        result = UpdateFlowsResult()
+        for update in request.updates:
+            if update.HasField('activate'):
+                activate_fut = Future()  # type: Future[ActivateFlowsResult]
+                self._activate_flows(update.activate, activate_fut)
+                result.activate_results.extend([activate_fut.result()])
+            elif update.HasField('deactivate'):
+                self._deactivate_flows(update.deactivate)
+        return result
+
     def GetPolicyUsage(self, request, context):
         """
         Get policy usage stats
@@ -8,6 +8,10 @@
  */
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <cpp_redis/cpp_redis>
 
 namespace magma {
@@ -36,6 +40,18 @@ class ObjectMap {
     ObjectType& object_out) = 0;
 
   virtual ObjectMapResult getall(std::vector<ObjectType>& values_out) = 0;
+
+  virtual ObjectMapResult remove(const std::string& key) = 0;
+
+  virtual ObjectMapResult multi_set(
+    const std::unordered_map<std::string, ObjectType>& objects) = 0;
+
+  virtual ObjectMapResult multi_get(
+    const std::vector<std::string>& keys,
+    std::unordered_map<std::string, ObjectType>& objects_out) = 0;
+
+  virtual ObjectMapResult multi_remove(
+    const std::vector<std::string>& keys) = 0;
 };
 
 }
@@ -8,6 +8,12 @@
  */
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+
 #include "ObjectMap.h"
 #include "magma_logging.h"
 
@@ -16,19 +22,39 @@ namespace magma {
 /**
  * RedisMap stores objects using the redis hash structure. This map requires a
  * serializer and deserializer to store objects as strings in the redis store
+ *
+ * The synchronous operations block for one round trip each, the multi_*
+ * variants batch many keys into a single command.
+ *
+ * The *_async operations only queue their command and return a future of its
+ * result, completed from the redis client thread. The first of them queued in
+ * a tick of the event loop schedules a single commit at the end of the tick
+ * with the scheduler given to the map, so all the commands queued in the same
+ * tick are pipelined to redis in one write. Without a scheduler, the queued
+ * commands are sent by flush. A synchronous operation also sends the commands
+ * queued before it.
  */
 template <typename ObjectType>
 class RedisMap : public ObjectMap<ObjectType> {
 public:
+  /**
+   * Runs a function at the end of the current tick of the event loop, e.g.
+   * [evb](std::function<void()> f) { evb->runInLoop(std::move(f)); }
+   */
+  using TickScheduler = std::function<void(std::function<void()>)>;
+
   RedisMap(
     std::shared_ptr<cpp_redis::client> client,
     const std::string& hash,
     std::function<bool(const ObjectType&, std::string&)> serializer,
-    std::function<bool(const std::string&, ObjectType&)> deserializer)
+    std::function<bool(const std::string&, ObjectType&)> deserializer,
+    TickScheduler schedule_commit = nullptr)
     : client_(client),
       hash_(hash),
       serializer_(serializer),
-      deserializer_(deserializer) {}
+      deserializer_(deserializer),
+      schedule_commit_(schedule_commit),
+      is_commit_scheduled_(std::make_shared<std::atomic<bool>>(false)) {}
 
   /**
    * set serializes the object passed into a string and stores it at the key.
@@ -127,11 +153,279 @@ public:
     return SUCCESS;
   }
 
+  /**
+   * getall_serialized returns every key of the map with its value as stored,
+   * without deserializing it. This lets callers find out which values changed
+   * before paying for their deserialization
+   */
+  ObjectMapResult getall_serialized(
+    std::unordered_map<std::string, std::string>& values_out) {
+    auto hgetall_future = client_->hgetall(hash_);
+    client_->sync_commit();
+    auto reply = hgetall_future.get();
+    if (reply.is_error()) {
+      MLOG(MERROR) << "unable to perform hgetall command";
+      return CLIENT_ERROR;
+    } else if (reply.is_null()) {
+      return SUCCESS;
+    }
+    const auto& array = reply.as_array();
+    for (size_t i = 0; i + 1 < array.size(); i += 2) {
+      if (!array[i].is_string() || !array[i + 1].is_string()) {
+        MLOG(MERROR) << "Non string key or value found";
+        continue;
+      }
+      values_out[array[i].as_string()] = array[i + 1].as_string();
+    }
+    return SUCCESS;
+  }
+
+  /**
+   * remove deletes the object located at key. Removing a key that does not
+   * exist is not an error
+   */
+  ObjectMapResult remove(const std::string& key) override {
+    std::vector<std::string> keys = {key};
+    auto hdel_future = client_->hdel(hash_, keys);
+    client_->sync_commit();
+    if (hdel_future.get().is_error()) {
+      MLOG(MERROR) << "Error removing value in redis for key " << key;
+      return CLIENT_ERROR;
+    }
+    return SUCCESS;
+  }
+
+  /**
+   * multi_set serializes the objects and stores them with a single command.
+   * Nothing is stored if any of the objects fails to serialize
+   */
+  ObjectMapResult multi_set(
+      const std::unordered_map<std::string, ObjectType>& objects) override {
+    if (objects.empty()) {
+      return SUCCESS;
+    }
+    std::vector<std::pair<std::string, std::string>> field_values;
+    auto result = serialize_all(objects, field_values);
+    if (result != SUCCESS) {
+      return result;
+    }
+    auto hmset_future = client_->hmset(hash_, field_values);
+    client_->sync_commit();
+    if (hmset_future.get().is_error()) {
+      MLOG(MERROR) << "Error setting " << objects.size()
+        << " values in redis";
+      return CLIENT_ERROR;
+    }
+    return SUCCESS;
+  }
+
+  /**
+   * multi_get returns the objects located at keys with a single command.
+   * Keys that were not found, or whose values could not be deserialized, are
+   * left out of objects_out
+   */
+  ObjectMapResult multi_get(
+      const std::vector<std::string>& keys,
+      std::unordered_map<std::string, ObjectType>& objects_out) override {
+    if (keys.empty()) {
+      return SUCCESS;
+    }
+    auto hmget_future = client_->hmget(hash_, keys);
+    client_->sync_commit();
+    auto reply = hmget_future.get();
+    if (reply.is_error()) {
+      MLOG(MERROR) << "Unable to get " << keys.size() << " values";
+      return CLIENT_ERROR;
+    }
+    const auto& array = reply.as_array();
+    for (size_t i = 0; i < array.size() && i < keys.size(); i++) {
+      if (array[i].is_null()) {
+        continue;
+      } else if (!array[i].is_string()) {
+        MLOG(MERROR) << "Value was not string for key " << keys[i];
+        continue;
+      }
+      ObjectType obj;
+      if (!deserializer_(array[i].as_string(), obj)) {
+        MLOG(MERROR) << "Failed to deserialize key " << keys[i];
+        continue;
+      }
+      objects_out[keys[i]] = std::move(obj);
+    }
+    return SUCCESS;
+  }
+
+  /**
+   * multi_remove deletes the objects located at keys with a single command
+   */
+  ObjectMapResult multi_remove(const std::vector<std::string>& keys) override {
+    if (keys.empty()) {
+      return SUCCESS;
+    }
+    auto hdel_future = client_->hdel(hash_, keys);
+    client_->sync_commit();
+    if (hdel_future.get().is_error()) {
+      MLOG(MERROR) << "Error removing " << keys.size() << " values in redis";
+      return CLIENT_ERROR;
+    }
+    return SUCCESS;
+  }
+
+  std::future<ObjectMapResult> set_async(
+      const std::string& key,
+      const ObjectType& object) {
+    std::string value;
+    if (!serializer_(object, value)) {
+      MLOG(MERROR) << "Unable to serialize value for key " << key;
+      return make_ready_future(SERIALIZE_FAIL);
+    }
+    auto promise = std::make_shared<std::promise<ObjectMapResult>>();
+    auto future = promise->get_future();
+    client_->hset(hash_, key, value, [key, promise](cpp_redis::reply& reply) {
+      if (reply.is_error()) {
+        MLOG(MERROR) << "Error setting value in redis for key " << key;
+        promise->set_value(CLIENT_ERROR);
+        return;
+      }
+      promise->set_value(SUCCESS);
+    });
+    commit_at_end_of_tick();
+    return future;
+  }
+
+  /**
+   * The object of the result is only meaningful if the result is SUCCESS
+   */
+  std::future<std::pair<ObjectMapResult, ObjectType>> get_async(
+      const std::string& key) {
+    auto promise =
+      std::make_shared<std::promise<std::pair<ObjectMapResult, ObjectType>>>();
+    auto future = promise->get_future();
+    auto deserializer = deserializer_;
+    client_->hget(hash_, key, [key, promise, deserializer](
+        cpp_redis::reply& reply) {
+      ObjectType obj;
+      auto result = SUCCESS;
+      if (reply.is_null()) {
+        result = KEY_NOT_FOUND;
+      } else if (reply.is_error()) {
+        MLOG(MERROR) << "Unable to get value for key " << key;
+        result = CLIENT_ERROR;
+      } else if (!reply.is_string()) {
+        MLOG(MERROR) << "Value was not string for key " << key;
+        result = INCORRECT_VALUE_TYPE;
+      } else if (!deserializer(reply.as_string(), obj)) {
+        MLOG(MERROR) << "Failed to deserialize key " << key;
+        result = DESERIALIZE_FAIL;
+      }
+      promise->set_value(std::make_pair(result, std::move(obj)));
+    });
+    commit_at_end_of_tick();
+    return future;
+  }
+
+  std::future<ObjectMapResult> remove_async(const std::string& key) {
+    return multi_remove_async({key});
+  }
+
+  std::future<ObjectMapResult> multi_set_async(
+      const std::unordered_map<std::string, ObjectType>& objects) {
+    std::vector<std::pair<std::string, std::string>> field_values;
+    auto result = serialize_all(objects, field_values);
+    if (result != SUCCESS || objects.empty()) {
+      return make_ready_future(result);
+    }
+    auto promise = std::make_shared<std::promise<ObjectMapResult>>();
+    auto future = promise->get_future();
+    auto count = objects.size();
+    client_->hmset(hash_, field_values, [count, promise](
+        cpp_redis::reply& reply) {
+      if (reply.is_error()) {
+        MLOG(MERROR) << "Error setting " << count << " values in redis";
+        promise->set_value(CLIENT_ERROR);
+        return;
+      }
+      promise->set_value(SUCCESS);
+    });
+    commit_at_end_of_tick();
+    return future;
+  }
+
+  std::future<ObjectMapResult> multi_remove_async(
+      const std::vector<std::string>& keys) {
+    if (keys.empty()) {
+      return make_ready_future(SUCCESS);
+    }
+    auto promise = std::make_shared<std::promise<ObjectMapResult>>();
+    auto future = promise->get_future();
+    auto count = keys.size();
+    client_->hdel(hash_, keys, [count, promise](cpp_redis::reply& reply) {
+      if (reply.is_error()) {
+        MLOG(MERROR) << "Error removing " << count << " values in redis";
+        promise->set_value(CLIENT_ERROR);
+        return;
+      }
+      promise->set_value(SUCCESS);
+    });
+    commit_at_end_of_tick();
+    return future;
+  }
+
+  /**
+   * flush sends the asynchronous commands queued so far in a single write,
+   * without waiting for their replies
+   */
+  void flush() {
+    client_->commit();
+  }
+
+private:
+  static std::future<ObjectMapResult> make_ready_future(
+      ObjectMapResult result) {
+    std::promise<ObjectMapResult> promise;
+    promise.set_value(result);
+    return promise.get_future();
+  }
+
+  // Only the first command queued in a tick schedules the commit. The flag is
+  // cleared before committing, so a command queued while the commit is
+  // running schedules the next one.
+  void commit_at_end_of_tick() {
+    if (!schedule_commit_ || is_commit_scheduled_->exchange(true)) {
+      return;
+    }
+    auto client = client_;
+    auto is_commit_scheduled = is_commit_scheduled_;
+    schedule_commit_([client, is_commit_scheduled]() {
+      *is_commit_scheduled = false;
+      client->commit();
+    });
+  }
+
+  ObjectMapResult serialize_all(
+      const std::unordered_map<std::string, ObjectType>& objects,
+      std::vector<std::pair<std::string, std::string>>& field_values_out) {
+    field_values_out.reserve(objects.size());
+    for (const auto& object_pair : objects) {
+      std::string value;
+      if (!serializer_(object_pair.second, value)) {
+        MLOG(MERROR) << "Unable to serialize value for key "
+          << object_pair.first;
+        return SERIALIZE_FAIL;
+      }
+      field_values_out.emplace_back(object_pair.first, std::move(value));
+    }
+    return SUCCESS;
+  }
+
 private:
   std::shared_ptr<cpp_redis::client> client_;
   std::string hash_;
   std::function<bool(const ObjectType&, std::string&)> serializer_;
   std::function<bool(const std::string&, ObjectType&)> deserializer_;
+  TickScheduler schedule_commit_;
+  // Shared with the scheduled commit, which may run after the map is gone
+  std::shared_ptr<std::atomic<bool>> is_commit_scheduled_;
 };
 
 }
@@ -14,12 +14,18 @@
 
 namespace magma {
 
-static bool try_redis_connect(cpp_redis::client& client) {
+// Published by policydb after it updates the rules hash
+static const char* RULES_UPDATE_CHANNEL = "policydb:rules:stream_update";
+
+static uint32_t get_redis_port() {
   ServiceConfigLoader loader;
   auto config = loader.load_service_config("redis");
-  auto port = config["port"].as<uint32_t>();
+  return config["port"].as<uint32_t>();
+}
+
+static bool try_redis_connect(cpp_redis::client& client) {
   try {
-    client.connect("127.0.0.1", port, [](
+    client.connect("127.0.0.1", get_redis_port(), [](
         const std::string& host,
         std::size_t port,
         cpp_redis::client::connect_state status) {
@@ -34,44 +40,136 @@ static bool try_redis_connect(cpp_redis::client& client) {
   }
 }
 
+void diff_serialized_rules(
+    std::unordered_map<std::string, std::string>& synced_rules,
+    std::unordered_map<std::string, std::string>& serialized_rules,
+    std::vector<PolicyRule>& updated_rules,
+    std::vector<std::string>& removed_rule_ids) {
+  auto deserialize = get_proto_deserializer();
+  std::vector<std::string> bad_rule_ids;
+  for (const auto& rule_pair : serialized_rules) {
+    auto it = synced_rules.find(rule_pair.first);
+    if (it != synced_rules.end() && it->second == rule_pair.second) {
+      continue;
+    }
+    PolicyRule rule;
+    if (!deserialize(rule_pair.second, rule)) {
+      MLOG(MERROR) << "Unable to deserialize rule " << rule_pair.first;
+      bad_rule_ids.push_back(rule_pair.first);
+      continue;
+    }
+    updated_rules.push_back(std::move(rule));
+  }
+  // Not synced, so retried at the next sync, and their previous version
+  // is removed below as the full rebuild of the store used to drop them
+  for (const auto& rule_id : bad_rule_ids) {
+    serialized_rules.erase(rule_id);
+  }
+  for (const auto& rule_pair : synced_rules) {
+    if (serialized_rules.find(rule_pair.first) == serialized_rules.end()) {
+      removed_rule_ids.push_back(rule_pair.first);
+    }
+  }
+  synced_rules.swap(serialized_rules);
+}
+
+/**
+ * Compare the rules in redis with the ones of the previous sync, and only
+ * deserialize the rules that were added or changed
+ */
 static void do_loop(
     cpp_redis::client& client,
     RedisMap<PolicyRule>& policy_map,
-    std::function<void(std::vector<PolicyRule>)>& processor) {
+    std::unordered_map<std::string, std::string>& synced_rules,
+    RuleChangeProcessor& processor) {
   if (!client.is_connected()) {
     if (!try_redis_connect(client)) {
       return;
     }
     MLOG(MINFO) << "Connected to redis server";
   }
-  std::vector<PolicyRule> rules;
-  auto result = policy_map.getall(rules);
+  std::unordered_map<std::string, std::string> serialized_rules;
+  auto result = policy_map.getall_serialized(serialized_rules);
   if (result != SUCCESS) {
     MLOG(MERROR) << "Failed to get rules from map because map error " << result;
     return;
   }
-  processor(rules);
-  MLOG(MDEBUG) << "Rules synced";
+
+  std::vector<PolicyRule> updated_rules;
+  std::vector<std::string> removed_rule_ids;
+  diff_serialized_rules(
+    synced_rules, serialized_rules, updated_rules, removed_rule_ids);
+  if (updated_rules.empty() && removed_rule_ids.empty()) {
+    return;
+  }
+  processor(updated_rules, removed_rule_ids);
+  MLOG(MDEBUG) << "Rules synced, " << updated_rules.size() << " updated and "
+    << removed_rule_ids.size() << " removed";
+}
+
+void PolicyLoader::try_subscribe(cpp_redis::subscriber& subscriber) {
+  try {
+    subscriber.connect("127.0.0.1", get_redis_port(), [](
+        const std::string& host,
+        std::size_t port,
+        cpp_redis::subscriber::connect_state status) {
+      if (status == cpp_redis::subscriber::connect_state::dropped) {
+        MLOG(MERROR) << "Subscriber disconnected from " << host << ":" << port;
+      }
+    });
+    subscriber.subscribe(RULES_UPDATE_CHANNEL, [this](
+        const std::string& channel,
+        const std::string& message) {
+      notify_update();
+    });
+    subscriber.commit();
+  } catch (const cpp_redis::redis_error& e) {
+    MLOG(MERROR) << "Could not subscribe to rule updates: " << e.what();
+  }
+}
+
+void PolicyLoader::notify_update() {
+  {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    update_notified_ = true;
+  }
+  update_cv_.notify_one();
 }
 
 void PolicyLoader::start_loop(
-    std::function<void(std::vector<PolicyRule>)> processor,
+    RuleChangeProcessor processor,
     uint32_t loop_interval_seconds) {
   is_running_ = true;
+  update_notified_ = false;
   auto client = std::make_shared<cpp_redis::client>();
   auto policy_map = RedisMap<PolicyRule>(
     client,
     "policydb:rules",
     get_proto_serializer(),
     get_proto_deserializer());
+  std::unordered_map<std::string, std::string> synced_rules;
+  cpp_redis::subscriber subscriber;
   while (is_running_) {
-    do_loop(*client, policy_map, processor);
-    std::this_thread::sleep_for(std::chrono::seconds(loop_interval_seconds));
+    if (!subscriber.is_connected()) {
+      // Subscribe before syncing, so no update is missed in between
+      try_subscribe(subscriber);
+    }
+    do_loop(*client, policy_map, synced_rules, processor);
+    std::unique_lock<std::mutex> lock(update_mutex_);
+    update_cv_.wait_for(
+      lock,
+      std::chrono::seconds(loop_interval_seconds),
+      [this] { return update_notified_ || !is_running_; });
+    update_notified_ = false;
   }
 }
 
 void PolicyLoader::stop() {
-  is_running_ = false;
+  {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    is_running_ = false;
+  }
+  update_cv_.notify_one();
 }
 
 }
@@ -7,26 +7,56 @@
  * of patent rights can be found in the PATENTS file in the same directory.
  */
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <cpp_redis/cpp_redis>
 #include <lte/protos/policydb.pb.h>
 
 namespace magma {
 using namespace lte;
+
+/**
+ * Called with the rules that were added or changed, and the IDs of the rules
+ * that were removed since the previous call
+ */
+using RuleChangeProcessor = std::function<void(
+  const std::vector<PolicyRule>& updated_rules,
+  const std::vector<std::string>& removed_rule_ids)>;
+
+/**
+ * Compare serialized_rules, read from redis, with synced_rules, the rules of
+ * the previous sync, both by rule ID. The rules added or changed are
+ * deserialized into updated_rules, the IDs of the rules gone are added to
+ * removed_rule_ids, and synced_rules takes the content of serialized_rules.
+ * A rule that fails to deserialize is left out of synced_rules, to be
+ * retried at the next sync, and its previous version is removed.
+ */
+void diff_serialized_rules(
+  std::unordered_map<std::string, std::string>& synced_rules,
+  std::unordered_map<std::string, std::string>& serialized_rules,
+  std::vector<PolicyRule>& updated_rules,
+  std::vector<std::string>& removed_rule_ids);
+
 /**
- * PolicyLoader is used to sync policies with Redis every so often
+ * PolicyLoader is used to sync policies with Redis. It syncs when policydb
+ * publishes an update notification, and every so often in case a
+ * notification was missed. Only the changes since the previous sync are
+ * deserialized and passed on.
  */
 class PolicyLoader {
 public:
 
   /**
-   * start_loop is the main function to call to initiate a load loop. Based on
-   * the given loop interval length, this function will load the policies from
-   * redis, and call the processor callback.
+   * start_loop is the main function to call to initiate a load loop. This
+   * function loads the policies from redis when notified of an update, or
+   * after loop_interval_seconds without a notification, and calls the
+   * processor callback with the changes, if any.
    */
-  void start_loop(
-    std::function<void(std::vector<PolicyRule>)> processor,
-    uint32_t loop_interval_seconds);
+  void start_loop(RuleChangeProcessor processor, uint32_t loop_interval_seconds);
 
   /**
    * Stop the config loop on the next loop
@@ -34,5 +64,13 @@ public:
   void stop();
 private:
   std::atomic<bool> is_running_;
+  std::mutex update_mutex_;
+  std::condition_variable update_cv_;
+  bool update_notified_;
+
+private:
+  void try_subscribe(cpp_redis::subscriber& subscriber);
+
+  void notify_update();
 };
 }
@@ -0,0 +1,265 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cpp_redis/cpp_redis>
+
+namespace magma {
+
+/**
+ * FakeRedisTcpClient stands for the connection of a cpp_redis client to a
+ * redis server. It answers the hash commands used by RedisMap from memory,
+ * so that the maps can be tested without a server. Replies are delivered
+ * from a thread of their own, as a real connection does.
+ */
+class FakeRedisTcpClient : public cpp_redis::network::tcp_client_iface {
+public:
+  ~FakeRedisTcpClient() {
+    disconnect(true);
+  }
+
+  void connect(
+      const std::string& addr,
+      std::uint32_t port,
+      std::uint32_t timeout_msecs) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_connected_) {
+      return;
+    }
+    is_connected_ = true;
+    is_running_ = true;
+    reply_thread_ = std::thread([this]() { reply_loop(); });
+  }
+
+  void disconnect(bool wait_for_removal) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_connected_ = false;
+      is_running_ = false;
+    }
+    cv_.notify_one();
+    if (reply_thread_.joinable()) {
+      reply_thread_.join();
+    }
+  }
+
+  bool is_connected() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return is_connected_;
+  }
+
+  void async_read(read_request& request) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      read_callback_ = request.async_read_callback;
+    }
+    cv_.notify_one();
+  }
+
+  void async_write(write_request& request) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      write_count_++;
+      size_t pos = 0;
+      std::vector<std::string> command;
+      while (parse_command(request.buffer, pos, command)) {
+        pending_replies_ += run_command(command);
+      }
+    }
+    cv_.notify_one();
+    if (request.async_write_callback) {
+      write_result result = {true, request.buffer.size()};
+      request.async_write_callback(result);
+    }
+  }
+
+  void set_on_disconnection_handler(
+      const disconnection_handler_t& disconnection_handler) override {}
+
+  /**
+   * Answer every following command with an error
+   */
+  void set_failing(bool is_failing) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_failing_ = is_failing;
+  }
+
+  /**
+   * Store a raw value in a hash, bypassing the serializer of the map
+   */
+  void set_raw(
+      const std::string& hash,
+      const std::string& field,
+      const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hashes_[hash][field] = value;
+  }
+
+  /**
+   * Number of writes on the connection, one per commit of the client
+   */
+  size_t get_write_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_count_;
+  }
+
+private:
+  using Hash = std::map<std::string, std::string>;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread reply_thread_;
+  bool is_connected_ = false;
+  bool is_running_ = false;
+  bool is_failing_ = false;
+  size_t write_count_ = 0;
+  async_read_callback_t read_callback_;
+  std::string pending_replies_;
+  std::map<std::string, Hash> hashes_;
+
+private:
+  void reply_loop() {
+    while (true) {
+      async_read_callback_t callback;
+      read_result result = {true, {}};
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] {
+          return !is_running_ ||
+            (read_callback_ && !pending_replies_.empty());
+        });
+        if (!is_running_) {
+          return;
+        }
+        result.buffer.assign(pending_replies_.begin(), pending_replies_.end());
+        pending_replies_.clear();
+        // the callback asks for the next read itself
+        callback.swap(read_callback_);
+      }
+      callback(result);
+    }
+  }
+
+  // Parse the next command, an array of bulk strings, at pos of buffer
+  static bool parse_command(
+      const std::vector<char>& buffer,
+      size_t& pos,
+      std::vector<std::string>& command_out) {
+    std::string line;
+    if (!read_line(buffer, pos, line) || line.empty() || line[0] != '*') {
+      return false;
+    }
+    auto count = std::stoul(line.substr(1));
+    command_out.clear();
+    for (size_t i = 0; i < count; i++) {
+      if (!read_line(buffer, pos, line) || line.empty() || line[0] != '$') {
+        return false;
+      }
+      auto length = std::stoul(line.substr(1));
+      if (pos + length + 2 > buffer.size()) {
+        return false;
+      }
+      command_out.emplace_back(&buffer[pos], length);
+      pos += length + 2;
+    }
+    return true;
+  }
+
+  static bool read_line(
+      const std::vector<char>& buffer,
+      size_t& pos,
+      std::string& line_out) {
+    for (size_t end = pos; end + 1 < buffer.size(); end++) {
+      if (buffer[end] == '\r' && buffer[end + 1] == '\n') {
+        line_out.assign(&buffer[pos], end - pos);
+        pos = end + 2;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static std::string bulk(const std::string& value) {
+    return "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+  }
+
+  static std::string integer(size_t value) {
+    return ":" + std::to_string(value) + "\r\n";
+  }
+
+  static std::string array_header(size_t size) {
+    return "*" + std::to_string(size) + "\r\n";
+  }
+
+  std::string run_command(const std::vector<std::string>& command) {
+    static const std::string NIL = "$-1\r\n";
+    if (is_failing_) {
+      return "-ERR fake failure\r\n";
+    }
+    const auto& name = command[0];
+    if (command.size() < 2) {
+      return "-ERR wrong number of arguments\r\n";
+    }
+    auto& hash = hashes_[command[1]];
+    if (name == "HSET" && command.size() == 4) {
+      auto is_new = hash.count(command[2]) == 0;
+      hash[command[2]] = command[3];
+      return integer(is_new ? 1 : 0);
+    } else if (name == "HMSET" && command.size() % 2 == 0) {
+      for (size_t i = 2; i < command.size(); i += 2) {
+        hash[command[i]] = command[i + 1];
+      }
+      return "+OK\r\n";
+    } else if (name == "HGET" && command.size() == 3) {
+      auto it = hash.find(command[2]);
+      return it == hash.end() ? NIL : bulk(it->second);
+    } else if (name == "HMGET") {
+      auto reply = array_header(command.size() - 2);
+      for (size_t i = 2; i < command.size(); i++) {
+        auto it = hash.find(command[i]);
+        reply += it == hash.end() ? NIL : bulk(it->second);
+      }
+      return reply;
+    } else if (name == "HGETALL") {
+      auto reply = array_header(hash.size() * 2);
+      for (const auto& field : hash) {
+        reply += bulk(field.first) + bulk(field.second);
+      }
+      return reply;
+    } else if (name == "HDEL") {
+      size_t removed = 0;
+      for (size_t i = 2; i < command.size(); i++) {
+        removed += hash.erase(command[i]);
+      }
+      return integer(removed);
+    }
+    return "-ERR unknown command '" + name + "'\r\n";
+  }
+};
+
+/**
+ * Create a redis client connected to a FakeRedisTcpClient
+ */
+inline std::shared_ptr<cpp_redis::client> make_fake_redis_client(
+    std::shared_ptr<FakeRedisTcpClient> tcp_client) {
+  auto client = std::make_shared<cpp_redis::client>(tcp_client);
+  client->connect("127.0.0.1", 6379);
+  return client;
+}
+
+}
@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <gtest/gtest.h>
+
+#include "FakeRedisTcpClient.h"
+#include "RedisMap.hpp"
+
+using ::testing::Test;
+
+namespace magma {
+
+// "unserializable" and "corrupted" stand for values the serializers reject
+static bool serialize(const std::string& object, std::string& value_out) {
+  value_out = object;
+  return object != "unserializable";
+}
+
+static bool deserialize(const std::string& value, std::string& object_out) {
+  object_out = value;
+  return value != "corrupted";
+}
+
+class RedisMapTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    tcp_client = std::make_shared<FakeRedisTcpClient>();
+    map = std::make_unique<RedisMap<std::string>>(
+      make_fake_redis_client(tcp_client),
+      "test_hash",
+      serialize,
+      deserialize);
+  }
+
+protected:
+  std::shared_ptr<FakeRedisTcpClient> tcp_client;
+  std::unique_ptr<RedisMap<std::string>> map;
+};
+
+TEST_F(RedisMapTest, test_set_get_remove) {
+  std::string value;
+  EXPECT_EQ(map->get("key1", value), KEY_NOT_FOUND);
+
+  EXPECT_EQ(map->set("key1", "value1"), SUCCESS);
+  EXPECT_EQ(map->get("key1", value), SUCCESS);
+  EXPECT_EQ(value, "value1");
+
+  EXPECT_EQ(map->remove("key1"), SUCCESS);
+  EXPECT_EQ(map->get("key1", value), KEY_NOT_FOUND);
+  // removing a missing key is not an error
+  EXPECT_EQ(map->remove("key1"), SUCCESS);
+
+  EXPECT_EQ(map->set("key1", "unserializable"), SERIALIZE_FAIL);
+  tcp_client->set_raw("test_hash", "key2", "corrupted");
+  EXPECT_EQ(map->get("key2", value), DESERIALIZE_FAIL);
+}
+
+TEST_F(RedisMapTest, test_multi_set_get) {
+  EXPECT_EQ(map->multi_set({
+    {"key1", "value1"},
+    {"key2", "value2"},
+    {"key3", "value3"},
+  }), SUCCESS);
+  EXPECT_EQ(map->multi_set({}), SUCCESS);
+
+  std::unordered_map<std::string, std::string> values;
+  EXPECT_EQ(map->multi_get({"key1", "missing", "key3"}, values), SUCCESS);
+  EXPECT_EQ(values.size(), 2);
+  EXPECT_EQ(values["key1"], "value1");
+  EXPECT_EQ(values["key3"], "value3");
+
+  // values which fail to deserialize are left out
+  tcp_client->set_raw("test_hash", "key2", "corrupted");
+  values.clear();
+  EXPECT_EQ(map->multi_get({"key1", "key2"}, values), SUCCESS);
+  EXPECT_EQ(values.size(), 1);
+  EXPECT_EQ(values.count("key2"), 0);
+
+  values.clear();
+  EXPECT_EQ(map->multi_get({}, values), SUCCESS);
+  EXPECT_TRUE(values.empty());
+}
+
+TEST_F(RedisMapTest, test_multi_set_serialize_fail) {
+  EXPECT_EQ(map->multi_set({
+    {"key1", "value1"},
+    {"key2", "unserializable"},
+  }), SERIALIZE_FAIL);
+
+  // nothing is stored
+  std::vector<std::string> values;
+  EXPECT_EQ(map->getall(values), SUCCESS);
+  EXPECT_TRUE(values.empty());
+}
+
+TEST_F(RedisMapTest, test_multi_remove) {
+  EXPECT_EQ(map->multi_set({
+    {"key1", "value1"},
+    {"key2", "value2"},
+    {"key3", "value3"},
+  }), SUCCESS);
+  EXPECT_EQ(map->multi_remove({"key1", "missing", "key3"}), SUCCESS);
+  EXPECT_EQ(map->multi_remove({}), SUCCESS);
+
+  std::vector<std::string> values;
+  EXPECT_EQ(map->getall(values), SUCCESS);
+  EXPECT_EQ(values, std::vector<std::string>({"value2"}));
+}
+
+TEST_F(RedisMapTest, test_getall) {
+  EXPECT_EQ(map->multi_set({
+    {"key1", "value1"},
+    {"key2", "value2"},
+  }), SUCCESS);
+  tcp_client->set_raw("test_hash", "key3", "corrupted");
+
+  std::vector<std::string> values;
+  std::vector<std::string> failed_keys;
+  EXPECT_EQ(map->getall(values, &failed_keys), SUCCESS);
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values, std::vector<std::string>({"value1", "value2"}));
+  EXPECT_EQ(failed_keys, std::vector<std::string>({"key3"}));
+
+  std::unordered_map<std::string, std::string> serialized;
+  EXPECT_EQ(map->getall_serialized(serialized), SUCCESS);
+  EXPECT_EQ(serialized.size(), 3);
+  EXPECT_EQ(serialized["key1"], "value1");
+  EXPECT_EQ(serialized["key3"], "corrupted");
+}
+
+TEST_F(RedisMapTest, test_client_error) {
+  tcp_client->set_failing(true);
+
+  std::string value;
+  std::vector<std::string> values;
+  std::unordered_map<std::string, std::string> objects;
+  EXPECT_EQ(map->set("key1", "value1"), CLIENT_ERROR);
+  EXPECT_EQ(map->get("key1", value), CLIENT_ERROR);
+  EXPECT_EQ(map->getall(values), CLIENT_ERROR);
+  EXPECT_EQ(map->remove("key1"), CLIENT_ERROR);
+  EXPECT_EQ(map->multi_set({{"key1", "value1"}}), CLIENT_ERROR);
+  EXPECT_EQ(map->multi_get({"key1"}, objects), CLIENT_ERROR);
+  EXPECT_EQ(map->multi_remove({"key1"}), CLIENT_ERROR);
+}
+
+/**
+ * The async commands queued in a tick are sent in a single write, committed
+ * once at the end of the tick
+ */
+TEST_F(RedisMapTest, test_async_pipelined_per_tick) {
+  const int nb_sets = 100;
+  // a connection of its own, a fake connection serves a single client
+  auto async_tcp_client = std::make_shared<FakeRedisTcpClient>();
+  std::vector<std::function<void()>> end_of_tick;
+  RedisMap<std::string> async_map(
+    make_fake_redis_client(async_tcp_client),
+    "test_hash",
+    serialize,
+    deserialize,
+    [&end_of_tick](std::function<void()> f) {
+      end_of_tick.push_back(std::move(f));
+    });
+
+  auto writes = async_tcp_client->get_write_count();
+  std::vector<std::future<ObjectMapResult>> set_results;
+  for (int i = 0; i < nb_sets; i++) {
+    set_results.push_back(async_map.set_async(
+      "key" + std::to_string(i), "value" + std::to_string(i)));
+  }
+  // nothing is sent before the end of the tick
+  EXPECT_EQ(end_of_tick.size(), 1);
+  EXPECT_EQ(async_tcp_client->get_write_count(), writes);
+  end_of_tick[0]();
+  end_of_tick.clear();
+  EXPECT_EQ(async_tcp_client->get_write_count(), writes + 1);
+  for (auto& result : set_results) {
+    EXPECT_EQ(result.get(), SUCCESS);
+  }
+
+  // the next tick schedules its own commit
+  auto get_result = async_map.get_async("key1");
+  auto missing_result = async_map.get_async("missing");
+  auto remove_result = async_map.multi_remove_async({"key2", "key3"});
+  EXPECT_EQ(end_of_tick.size(), 1);
+  end_of_tick[0]();
+  end_of_tick.clear();
+  EXPECT_EQ(async_tcp_client->get_write_count(), writes + 2);
+  auto value = get_result.get();
+  EXPECT_EQ(value.first, SUCCESS);
+  EXPECT_EQ(value.second, "value1");
+  EXPECT_EQ(missing_result.get().first, KEY_NOT_FOUND);
+  EXPECT_EQ(remove_result.get(), SUCCESS);
+
+  std::vector<std::string> values;
+  EXPECT_EQ(async_map.getall(values), SUCCESS);
+  EXPECT_EQ(values.size(), nb_sets - 2);
+
+  // failing before queuing a command does not schedule a commit
+  EXPECT_EQ(async_map.set_async("key1", "unserializable").get(),
+    SERIALIZE_FAIL);
+  EXPECT_EQ(async_map.multi_set_async({}).get(), SUCCESS);
+  EXPECT_TRUE(end_of_tick.empty());
+}
+
+TEST_F(RedisMapTest, test_async_flush) {
+  // without a scheduler the commands are sent by flush
+  auto set_result = map->multi_set_async({
+    {"key1", "value1"},
+    {"key2", "value2"},
+  });
+  auto writes = tcp_client->get_write_count();
+  map->flush();
+  EXPECT_EQ(tcp_client->get_write_count(), writes + 1);
+  EXPECT_EQ(set_result.get(), SUCCESS);
+
+  tcp_client->set_failing(true);
+  auto remove_result = map->remove_async("key1");
+  map->flush();
+  EXPECT_EQ(remove_result.get(), CLIENT_ERROR);
+}
+
+}